@@ -40,6 +40,7 @@ int32_t tscHandleMultivnodeInsert(SSqlObj *pSql);
 
 void tscBuildResFromSubqueries(SSqlObj *pSql);
 void **doSetResultRowData(SSqlObj *pSql, bool finalResult);
+int32_t doSetResultColumnData(SSqlObj *pSql);
 
 #ifdef __cplusplus
 }
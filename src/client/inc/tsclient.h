@@ -276,6 +276,9 @@ typedef struct {
   char **               buffer;  // Buffer used to put multibytes encoded using unicode (wchar_t)
   SColumnIndex *        pColumnIndex;
   SArithmeticSupport*   pArithSup;   // support the arithmetic expression calculation on agg functions
+  TAOS_COLUMN *         pColumns;    // columns handed out by taos_fetch_block_columns
+  char **               colBuffer;   // null bitmap, lengths and calculated values of each column in pColumns
+  int32_t               colBufRows;  // rows the buffers in colBuffer are allocated for
   
   struct SLocalReducer *pLocalReducer;
 } SSqlRes;
@@ -364,6 +367,7 @@ void tscQueueAsyncRes(SSqlObj *pSql);
 void tscQueueAsyncError(void(*fp), void *param, int32_t code);
 
 int tscProcessLocalCmd(SSqlObj *pSql);
+int32_t tscDecodeRetrieveRsp(SSqlObj *pSql);
 int tscCfgDynamicOptions(char *msg);
 int taos_retrieve(TAOS_RES *res);
 
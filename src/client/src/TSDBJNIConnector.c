@@ -72,6 +72,10 @@ jmethodID g_rowdataSetStringFp;
 jmethodID g_rowdataSetTimestampFp;
 jmethodID g_rowdataSetByteArrayFp;
 
+jclass    g_blockdataClass;
+jmethodID g_blockdataSetNumOfRowsFp;
+jmethodID g_blockdataSetColumnFp;
+
 #define JNI_SUCCESS          0
 #define JNI_TDENGINE_ERROR  -1
 #define JNI_CONNECTION_NULL -2
@@ -129,6 +133,13 @@ void jniGetGlobalMethod(JNIEnv *env) {
   g_rowdataSetByteArrayFp = (*env)->GetMethodID(env, g_rowdataClass, "setByteArray", "(I[B)V");
   (*env)->DeleteLocalRef(env, rowdataClass);
 
+  jclass blockdataClass = (*env)->FindClass(env, "com/taosdata/jdbc/TSDBResultSetBlockData");
+  g_blockdataClass = (*env)->NewGlobalRef(env, blockdataClass);
+  g_blockdataSetNumOfRowsFp = (*env)->GetMethodID(env, g_blockdataClass, "setNumOfRows", "(I)V");
+  g_blockdataSetColumnFp = (*env)->GetMethodID(env, g_blockdataClass, "setColumn",
+                                               "(ILjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)V");
+  (*env)->DeleteLocalRef(env, blockdataClass);
+
   atomic_store_32(&__init, 2);
   jniTrace("native method register finished");
 }
@@ -537,6 +548,75 @@ JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_fetchRowImp(JNIEn
   return JNI_SUCCESS;
 }
 
+/*
+ * The columns of a block are handed out as direct ByteBuffers on the buffers of the result set, which are valid until
+ * the next fetch or the result set is freed.
+ */
+JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_fetchBlockImp(JNIEnv *env, jobject jobj, jlong con,
+                                                                             jlong res, jobject blockobj) {
+  TAOS *tscon = (TAOS *)con;
+  if (tscon == NULL) {
+    jniError("jobj:%p, connection is closed", jobj);
+    return JNI_CONNECTION_NULL;
+  }
+
+  TAOS_RES *result = (TAOS_RES *)res;
+  if (result == NULL) {
+    jniError("jobj:%p, conn:%p, resultset is null", jobj, tscon);
+    return JNI_RESULT_SET_NULL;
+  }
+
+  int num_fields = taos_num_fields(result);
+  if (num_fields == 0) {
+    jniError("jobj:%p, conn:%p, resultset:%p, fields size is %d", jobj, tscon, res, num_fields);
+    return JNI_NUM_OF_FIELDS_0;
+  }
+
+  TAOS_COLUMN *columns = NULL;
+  int          numOfRows = taos_fetch_block_columns(result, &columns);
+  if (numOfRows < 0) {
+    jniError("jobj:%p, conn:%p, resultset:%p, failed to fetch block, code:%s", jobj, tscon, res, tstrerror(terrno));
+    return JNI_TDENGINE_ERROR;
+  } else if (numOfRows == 0) {
+    int tserrno = taos_errno(result);
+    if (tserrno == 0) {
+      jniTrace("jobj:%p, conn:%p, resultset:%p, fields size is %d, fetch block to the end", jobj, tscon, res, num_fields);
+      return JNI_FETCH_END;
+    } else {
+      jniTrace("jobj:%p, conn:%p, interruptted query", jobj, tscon);
+      return JNI_RESULT_SET_NULL;
+    }
+  }
+
+  (*env)->CallVoidMethod(env, blockobj, g_blockdataSetNumOfRowsFp, (jint)numOfRows);
+
+  for (int i = 0; i < num_fields; i++) {
+    TAOS_COLUMN *pCol = &columns[i];
+
+    jobject data = (*env)->NewDirectByteBuffer(env, pCol->data, (jlong)numOfRows * pCol->bytes);
+    jobject nulls = (*env)->NewDirectByteBuffer(env, pCol->nullBitmap, (numOfRows + 7) / 8);
+    jobject lengths = NULL;
+    if (pCol->length != NULL) {
+      lengths = (*env)->NewDirectByteBuffer(env, pCol->length, (jlong)numOfRows * sizeof(int));
+    }
+
+    if (data == NULL || nulls == NULL || (pCol->length != NULL && lengths == NULL)) {
+      jniError("jobj:%p, conn:%p, resultset:%p, direct buffer is not supported", jobj, tscon, res);
+      return JNI_OUT_OF_MEMORY;
+    }
+
+    (*env)->CallVoidMethod(env, blockobj, g_blockdataSetColumnFp, (jint)i, data, nulls, lengths);
+
+    (*env)->DeleteLocalRef(env, data);
+    (*env)->DeleteLocalRef(env, nulls);
+    if (lengths != NULL) {
+      (*env)->DeleteLocalRef(env, lengths);
+    }
+  }
+
+  return JNI_SUCCESS;
+}
+
 JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_closeConnectionImp(JNIEnv *env, jobject jobj,
                                                                                   jlong con) {
   TAOS *tscon = (TAOS *)con;
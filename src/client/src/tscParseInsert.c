@@ -34,6 +34,11 @@
 
 #include "tdataformat.h"
 
+#if defined(__GNUC__) && !defined(_TD_ARM_)
+#include <immintrin.h>
+#define TSC_SIMD_PARSE
+#endif
+
 enum {
   TSDB_USE_SERVER_TS = 0,
   TSDB_USE_CLI_TS = 1,
@@ -501,6 +506,305 @@ int tsParseOneRowData(char **str, STableDataBlocks *pDataBlocks, SSchema schema[
   return rowSize;
 }
 
+/*
+ * The fast path of the values clause. The plain literals of one row, e.g., (1500000000000, 10, 2.5, 'abc'), are
+ * converted into the data block without the tokenizer. Anything else, e.g., now, '?', the strings with escape
+ * characters, or the values out of range, makes it give up, and the row is parsed again by tsParseOneRowData, which
+ * reports the errors if any.
+ */
+#define TSC_MAX_SLOW_ROWS 4
+
+static const double tscPowOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static FORCE_INLINE char *tscSkipSpace(char *p) {
+  while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\f') {
+    p++;
+  }
+
+  return p;
+}
+
+// the first quotation mark delim, backslash or the terminating zero from p
+static char *tscFindStringEnd(char *p, char delim) {
+#ifdef TSC_SIMD_PARSE
+  // The bytes before the first 16-byte boundary are checked one by one, so nothing before the string is loaded. The
+  // aligned loads from there may read up to 15 bytes beyond the terminating zero, but never beyond the 16-byte block
+  // holding it, which lies in the same page.
+  while (((uintptr_t)p & 15) != 0) {
+    if (*p == delim || *p == '\\' || *p == 0) return p;
+    p++;
+  }
+
+  const __m128i vdelim = _mm_set1_epi8(delim);
+  const __m128i vslash = _mm_set1_epi8('\\');
+  const __m128i vzero = _mm_setzero_si128();
+
+  while (1) {
+    __m128i v = _mm_load_si128((const __m128i *)p);
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, vdelim), _mm_cmpeq_epi8(v, vslash)), _mm_cmpeq_epi8(v, vzero));
+
+    uint32_t bits = (uint32_t)_mm_movemask_epi8(m);
+    if (bits != 0) {
+      return p + __builtin_ctz(bits);
+    }
+
+    p += 16;
+  }
+#else
+  while (*p != delim && *p != '\\' && *p != 0) {
+    p++;
+  }
+
+  return p;
+#endif
+}
+
+// the decimal integer of at most 18 digits with an optional sign, which never overflows an int64_t
+static FORCE_INLINE char *tscParseInteger(char *p, int64_t *value) {
+  bool neg = (*p == '-');
+  if (*p == '-' || *p == '+') {
+    p++;
+  }
+
+  char *   s = p;
+  uint64_t v = 0;
+  while (*p >= '0' && *p <= '9') {
+    v = v * 10 + (*p - '0');
+    p++;
+  }
+
+  if (p == s || p - s > 18) {
+    return NULL;
+  }
+
+  *value = neg ? -(int64_t)v : (int64_t)v;
+  return p;
+}
+
+/*
+ * The decimal float whose significant digits are exact in a double, and whose exponent is in [-22, 22], so that one
+ * multiplication or division by the exact power of ten gives the correctly rounded value, the same one of strtod.
+ */
+static char *tscParseFloat(char *p, double *value) {
+  bool neg = (*p == '-');
+  if (*p == '-' || *p == '+') {
+    p++;
+  }
+
+  uint64_t m = 0;
+  int32_t  digits = 0;  // the significant digits, the leading zeros excluded
+  char *   s = p;
+  while (*p >= '0' && *p <= '9') {
+    m = m * 10 + (*p - '0');
+    digits += (m != 0);
+    p++;
+  }
+
+  int32_t numOfInt = (int32_t)(p - s);
+  int32_t numOfFrac = 0;
+  if (*p == '.') {
+    s = ++p;
+    while (*p >= '0' && *p <= '9') {
+      m = m * 10 + (*p - '0');
+      digits += (m != 0);
+      p++;
+    }
+
+    numOfFrac = (int32_t)(p - s);
+    if (numOfFrac == 0) {  // 1. is not a float number of the tokenizer
+      return NULL;
+    }
+  }
+
+  if (numOfInt + numOfFrac == 0 || digits > 15) {
+    return NULL;
+  }
+
+  int32_t exp = 0;
+  if (*p == 'e' || *p == 'E') {
+    char *e = p + 1;
+    bool  negExp = (*e == '-');
+    if (*e == '-' || *e == '+') {
+      e++;
+    }
+
+    s = e;
+    while (*e >= '0' && *e <= '9' && e - s < 4) {
+      exp = exp * 10 + (*e - '0');
+      e++;
+    }
+
+    if (e == s || (*e >= '0' && *e <= '9')) {
+      return NULL;
+    }
+
+    exp = negExp ? -exp : exp;
+    p = e;
+  }
+
+  exp -= numOfFrac;
+  if (exp < -22 || exp > 22) {
+    return NULL;
+  }
+
+  double dv = (double)m;
+  dv = (exp < 0) ? dv / tscPowOf10[-exp] : dv * tscPowOf10[exp];
+  *value = neg ? -dv : dv;
+  return p;
+}
+
+// convert the literal at p into payload, return the position after it, or NULL to leave it to tsParseOneColumnData
+static char *tsParseOneColumnDataFast(SSchema *pSchema, char *p, char *payload, bool primaryKey) {
+  int64_t iv = 0;
+  double  dv = 0;
+
+  if ((*p == 'n' || *p == 'N') && strncasecmp(p, TSDB_DATA_NULL_STR_L, 4) == 0) {
+    if (primaryKey) {
+      return NULL;
+    }
+
+    if (pSchema->type == TSDB_DATA_TYPE_BINARY || pSchema->type == TSDB_DATA_TYPE_NCHAR) {
+      setVardataNull(payload, pSchema->type);
+    } else {
+      setNull(payload, pSchema->type, pSchema->bytes);
+    }
+
+    return p + 4;
+  }
+
+  switch (pSchema->type) {
+    case TSDB_DATA_TYPE_BOOL:
+      if (strncmp(p, "true", 4) == 0) {
+        *(uint8_t *)payload = TSDB_TRUE;
+        return p + 4;
+      } else if (strncmp(p, "false", 5) == 0) {
+        *(uint8_t *)payload = TSDB_FALSE;
+        return p + 5;
+      } else if ((p = tscParseInteger(p, &iv)) != NULL) {
+        *(uint8_t *)payload = (int8_t)((iv == 0) ? TSDB_FALSE : TSDB_TRUE);
+      }
+      return p;
+
+    case TSDB_DATA_TYPE_TINYINT:
+      if ((p = tscParseInteger(p, &iv)) == NULL || iv > INT8_MAX || iv <= INT8_MIN) {
+        return NULL;
+      }
+      *((int8_t *)payload) = (int8_t)iv;
+      return p;
+
+    case TSDB_DATA_TYPE_SMALLINT:
+      if ((p = tscParseInteger(p, &iv)) == NULL || iv > INT16_MAX || iv <= INT16_MIN) {
+        return NULL;
+      }
+      *((int16_t *)payload) = (int16_t)iv;
+      return p;
+
+    case TSDB_DATA_TYPE_INT:
+      if ((p = tscParseInteger(p, &iv)) == NULL || iv > INT32_MAX || iv <= INT32_MIN) {
+        return NULL;
+      }
+      *((int32_t *)payload) = (int32_t)iv;
+      return p;
+
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      if ((p = tscParseInteger(p, &iv)) != NULL) {
+        *((int64_t *)payload) = iv;
+      }
+      return p;
+
+    case TSDB_DATA_TYPE_FLOAT:
+      if ((p = tscParseFloat(p, &dv)) != NULL) {
+        *((float *)payload) = (float)dv;
+      }
+      return p;
+
+    case TSDB_DATA_TYPE_DOUBLE:
+      if ((p = tscParseFloat(p, &dv)) != NULL) {
+        *((double *)payload) = dv;
+      }
+      return p;
+
+    case TSDB_DATA_TYPE_BINARY:
+    case TSDB_DATA_TYPE_NCHAR: {
+      if (*p != '\'' && *p != '"') {
+        return NULL;
+      }
+
+      char *end = tscFindStringEnd(p + 1, *p);
+      if (*end != *p || end[1] == *p) {  // the escape characters and the doubled quotation marks
+        return NULL;
+      }
+
+      int32_t len = (int32_t)(end - p - 1);
+      if (pSchema->type == TSDB_DATA_TYPE_BINARY) {
+        if (len + VARSTR_HEADER_SIZE > pSchema->bytes) {
+          return NULL;
+        }
+
+        STR_WITH_SIZE_TO_VARSTR(payload, p + 1, len);
+      } else {
+        size_t output = 0;
+        if (!taosMbsToUcs4(p + 1, len, varDataVal(payload), pSchema->bytes - VARSTR_HEADER_SIZE, &output)) {
+          return NULL;
+        }
+
+        varDataSetLen(payload, output);
+      }
+
+      return end + 1;
+    }
+
+    default:
+      return NULL;
+  }
+}
+
+/*
+ * Parse one row of the values of all columns by the fast path, *str is after the left parenthesis, and the right one is
+ * consumed too. Return the row size, or 0 if the row shall be parsed again by tsParseOneRowData.
+ */
+static int32_t tsParseOneRowDataFast(char **str, STableDataBlocks *pDataBlocks, SSchema schema[],
+                                     SParsedDataColInfo *spd) {
+  char *payload = pDataBlocks->pData + pDataBlocks->size;
+  char *primaryKey = NULL;
+  char *p = *str;
+
+  int32_t rowSize = 0;
+  for (int32_t i = 0; i < spd->numOfAssignedCols; ++i) {
+    char *   start = payload + spd->elems[i].offset;
+    int16_t  colIndex = spd->elems[i].colIndex;
+    SSchema *pSchema = schema + colIndex;
+    rowSize += pSchema->bytes;
+
+    bool isPrimaryKey = (colIndex == PRIMARYKEY_TIMESTAMP_COL_INDEX);
+    if (isPrimaryKey) {
+      primaryKey = start;
+    }
+
+    p = tsParseOneColumnDataFast(pSchema, tscSkipSpace(p), start, isPrimaryKey);
+    if (p == NULL) {
+      return 0;
+    }
+
+    p = tscSkipSpace(p);
+    if (*p != ((i == spd->numOfAssignedCols - 1) ? ')' : ',')) {
+      return 0;
+    }
+
+    p++;
+  }
+
+  // it leaves the state of the data block untouched if it fails, so the error is reported by tsParseOneRowData
+  if (primaryKey == NULL || tsCheckTimestamp(pDataBlocks, primaryKey) != TSDB_CODE_SUCCESS) {
+    return 0;
+  }
+
+  *str = p;
+  return rowSize;
+}
+
 static int32_t rowDataCompar(const void *lhs, const void *rhs) {
   TSKEY left = *(TSKEY *)lhs;
   TSKEY right = *(TSKEY *)rhs;
@@ -530,6 +834,11 @@ int tsParseValues(char **str, STableDataBlocks *pDataBlock, STableMeta *pTableMe
     return -1;
   }
 
+  // the fast path fills the values of all columns only, the null values of the others are set by tsParseOneRowData,
+  // and it is not tried any more if the rows are parsed again one after another, e.g., all of them use now
+  bool    fastPath = (spd->numOfAssignedCols == spd->numOfCols);
+  int32_t numOfSlowRows = 0;
+
   while (1) {
     index = 0;
     sToken = tStrGetToken(*str, &index, false, 0, NULL);
@@ -548,7 +857,19 @@ int tsParseValues(char **str, STableDataBlocks *pDataBlock, STableMeta *pTableMe
       maxRows = tSize;
     }
 
-    int32_t len = tsParseOneRowData(str, pDataBlock, pSchema, spd, error, precision, code, tmpTokenBuf);
+    int32_t len = fastPath ? tsParseOneRowDataFast(str, pDataBlock, pSchema, spd) : 0;
+    if (len > 0) {  // the right parenthesis has been consumed
+      pDataBlock->size += len;
+      numOfRows++;
+      numOfSlowRows = 0;
+      continue;
+    }
+
+    if (fastPath && (++numOfSlowRows) >= TSC_MAX_SLOW_ROWS) {
+      fastPath = false;
+    }
+
+    len = tsParseOneRowData(str, pDataBlock, pSchema, spd, error, precision, code, tmpTokenBuf);
     if (len <= 0) {  // error message has been set in tsParseOneRowData
       return -1;
     }
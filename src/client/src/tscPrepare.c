@@ -22,8 +22,12 @@
 #include "tstrbuild.h"
 #include "tscLog.h"
 #include "tscSubquery.h"
+#include "tschemautil.h"
+#include "tstoken.h"
+#include "hash.h"
 
 int tsParseInsertSql(SSqlObj *pSql);
+int validateTableName(char *tblName, int len);
 
 ////////////////////////////////////////////////////////////////////////////////
 // functions for normal statement preparation
@@ -47,11 +51,22 @@ typedef struct SNormalStmt {
 //
 //} SInsertStmt;
 
+// insertion into the tables set by taos_stmt_set_tbname, the data block of each table is kept in pCmd->pDataBlocks,
+// and indexed by the table uid in pCmd->pTableList until the execution.
+typedef struct SMultiTbStmt {
+  uint16_t          numOfTags;   // number of the tag parameters, 0 if the tables are not created from a super table
+  uint16_t          numOfCols;   // number of the value parameters
+  bool              pendingRow;  // a row is bound to pBlock but not added to the batch yet
+  STableDataBlocks* pBlock;      // data block of the table set, NULL if it has not been created since the execution
+} SMultiTbStmt;
+
 typedef struct STscStmt {
   bool isInsert;
+  bool multiTbInsert;
   STscObj* taos;
   SSqlObj* pSql;
   SNormalStmt normal;
+  SMultiTbStmt mtb;
 } STscStmt;
 
 
@@ -463,6 +478,543 @@ static int insertStmtExecute(STscStmt* stmt) {
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// functions for insertion into multiple tables, "insert into ? [using stable tags(?, ...)] values(?, ...)"
+
+static bool isMultiTbInsert(char* sql) {
+  int32_t index = 0;
+  tStrGetToken(sql, &index, false, 0, NULL);  // insert or import
+
+  SSQLToken sToken = tStrGetToken(sql, &index, false, 0, NULL);
+  if (sToken.type != TK_INTO) {
+    return false;
+  }
+
+  sToken = tStrGetToken(sql, &index, false, 0, NULL);
+  return sToken.type == TK_QUESTION;
+}
+
+// "(?, ?, ...)"
+static int multiTbStmtCountParams(SSqlCmd* pCmd, char* sql, int32_t* index, uint16_t* numOfParams) {
+  SSQLToken sToken = tStrGetToken(sql, index, false, 0, NULL);
+  if (sToken.type != TK_LP) {
+    return tscInvalidSQLErrMsg(pCmd->payload, "( expected", sToken.z);
+  }
+
+  *numOfParams = 0;
+  while (1) {
+    sToken = tStrGetToken(sql, index, false, 0, NULL);
+    if (sToken.type == TK_RP) {
+      break;
+    }
+
+    if (sToken.type != TK_QUESTION) {
+      return tscInvalidSQLErrMsg(pCmd->payload, "only parameters are allowed", sToken.z);
+    }
+
+    ++(*numOfParams);
+  }
+
+  if (*numOfParams == 0) {
+    return tscInvalidSQLErrMsg(pCmd->payload, "parameter expected", sToken.z);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int multiTbStmtPrepare(STscStmt* pStmt) {
+  SSqlObj*      pSql = pStmt->pSql;
+  SSqlCmd*      pCmd = &pSql->cmd;
+  SMultiTbStmt* mtb = &pStmt->mtb;
+
+  if (!pSql->pTscObj->writeAuth) {
+    return TSDB_CODE_TSC_NO_WRITE_AUTH;
+  }
+
+  char* sql = pSql->sqlstr;
+  pSql->sqlstr = NULL;
+  tscPartiallyFreeSqlObj(pSql);
+  pSql->sqlstr = sql;
+
+  memset(mtb, 0, sizeof(SMultiTbStmt));
+
+  // the payload keeps the tags to create the tables, see doParseInsertSql
+  int32_t code = tscAllocPayload(pCmd, TSDB_PAYLOAD_SIZE + 2048);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+  pCmd->payloadLen = 0;
+
+  pCmd->command = TSDB_SQL_INSERT;
+  SQueryInfo* pQueryInfo = NULL;
+  tscGetQueryInfoDetailSafely(pCmd, pCmd->clauseIndex, &pQueryInfo);
+  TSDB_QUERY_SET_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_INSERT | TSDB_QUERY_TYPE_STMT_INSERT);
+
+  // the table set is at the first position of the pTableMetaInfo list, and the super table at the second
+  tscAddEmptyMetaInfo(pQueryInfo);
+
+  pCmd->pTableList = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false);
+  pCmd->pDataBlocks = tscCreateBlockArrayList();
+  if (pCmd->pTableList == NULL || pCmd->pDataBlocks == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  int32_t index = 0;
+  for (int32_t i = 0; i < 3; ++i) {  // insert into ?
+    tStrGetToken(sql, &index, false, 0, NULL);
+  }
+
+  STableMetaInfo* pSTableMetaInfo = NULL;
+  SSQLToken       sToken = tStrGetToken(sql, &index, false, 0, NULL);
+  if (sToken.type == TK_USING) {
+    sToken = tStrGetToken(sql, &index, false, 0, NULL);
+    if (validateTableName(sToken.z, sToken.n) != TSDB_CODE_SUCCESS) {
+      return tscInvalidSQLErrMsg(pCmd->payload, "super table name invalid", sToken.z);
+    }
+
+    pSTableMetaInfo = tscAddEmptyMetaInfo(pQueryInfo);
+    code = tscSetTableFullName(pSTableMetaInfo, &sToken, pSql);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+
+    code = tscGetTableMetaSync(pSql, pSTableMetaInfo, false);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+
+    if (!UTIL_TABLE_IS_SUPER_TABLE(pSTableMetaInfo)) {
+      return tscInvalidSQLErrMsg(pCmd->payload, "create table only from super table is allowed", sToken.z);
+    }
+
+    sToken = tStrGetToken(sql, &index, false, 0, NULL);
+    if (sToken.type != TK_TAGS) {
+      return tscInvalidSQLErrMsg(pCmd->payload, "keyword TAGS expected", sToken.z);
+    }
+
+    code = multiTbStmtCountParams(pCmd, sql, &index, &mtb->numOfTags);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+
+    if (mtb->numOfTags != tscGetNumOfTags(pSTableMetaInfo->pTableMeta)) {
+      return tscInvalidSQLErrMsg(pCmd->payload, "number of tags mismatch", NULL);
+    }
+
+    sToken = tStrGetToken(sql, &index, false, 0, NULL);
+  }
+
+  if (sToken.type != TK_VALUES) {
+    return tscInvalidSQLErrMsg(pCmd->payload, "keyword VALUES is expected", sToken.z);
+  }
+
+  code = multiTbStmtCountParams(pCmd, sql, &index, &mtb->numOfCols);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  if (pSTableMetaInfo != NULL && mtb->numOfCols != tscGetNumOfColumns(pSTableMetaInfo->pTableMeta)) {
+    return tscInvalidSQLErrMsg(pCmd->payload, "number of values mismatch", NULL);
+  }
+
+  sToken = tStrGetToken(sql, &index, false, 0, NULL);
+  if (sToken.n != 0) {
+    return tscInvalidSQLErrMsg(pCmd->payload, "only one table is allowed", sToken.z);
+  }
+
+  pCmd->parseFinished = 1;
+  return TSDB_CODE_SUCCESS;
+}
+
+// the STagData to create the table set from the super table, it is kept in the payload as the sql string does
+static int multiTbStmtSetTagData(STscStmt* pStmt, TAOS_BIND* tags) {
+  SSqlCmd*        pCmd = &pStmt->pSql->cmd;
+  STableMetaInfo* pSTableMetaInfo = tscGetTableMetaInfoFromCmd(pCmd, pCmd->clauseIndex, 1);
+  SSchema*        pTagSchema = tscGetTableTagSchema(pSTableMetaInfo->pTableMeta);
+
+  STagData* pTag = (STagData*)pCmd->payload;
+  tstrncpy(pTag->name, pSTableMetaInfo->name, sizeof(pTag->name));
+
+  int32_t dataLen = 0;
+  for (int32_t i = 0; i < pStmt->mtb.numOfTags; ++i) {
+    SParamInfo param = {.idx = i, .type = pTagSchema[i].type, .bytes = pTagSchema[i].bytes, .offset = dataLen};
+
+    int code = doBindParam(pTag->data, &param, tags + i);
+    if (code != TSDB_CODE_SUCCESS) {
+      tscTrace("tag %d: type mismatch or invalid", i);
+      return code;
+    }
+
+    dataLen += pTagSchema[i].bytes;
+  }
+
+  pTag->dataLen = htonl(dataLen);
+  pCmd->payloadLen = sizeof(pTag->name) + sizeof(pTag->dataLen) + dataLen;
+  return TSDB_CODE_SUCCESS;
+}
+
+// the data block of the table set, which is created by the first binding since the table is set or the execution
+static int multiTbStmtGetBlock(STscStmt* pStmt, STableDataBlocks** pBlock) {
+  SSqlObj*      pSql = pStmt->pSql;
+  SSqlCmd*      pCmd = &pSql->cmd;
+  SMultiTbStmt* mtb = &pStmt->mtb;
+
+  if (mtb->pBlock != NULL) {
+    *pBlock = mtb->pBlock;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  STableMetaInfo* pTableMetaInfo = tscGetTableMetaInfoFromCmd(pCmd, pCmd->clauseIndex, 0);
+  STableMeta*     pTableMeta = pTableMetaInfo->pTableMeta;
+  if (pTableMeta == NULL) {
+    tscError("%p the table to insert into is not set", pSql);
+    return TSDB_CODE_TSC_APP_ERROR;
+  }
+
+  STableComInfo tinfo = tscGetTableInfo(pTableMeta);
+  if (tinfo.numOfColumns != mtb->numOfCols) {
+    tscError("%p table %s has %d columns, while %d values are bound", pSql, pTableMetaInfo->name, tinfo.numOfColumns,
+             mtb->numOfCols);
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  int32_t code = tscGetDataBlockFromList(pCmd->pTableList, pCmd->pDataBlocks, pTableMeta->uid, TSDB_DEFAULT_PAYLOAD_SIZE,
+                                         sizeof(SSubmitBlk), tinfo.rowSize, pTableMetaInfo->name, pTableMeta, pBlock);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  STableDataBlocks* pDataBlock = *pBlock;
+  if (pDataBlock->numOfParams == 0) {  // the block is a new one, the values are bound to all the columns in order
+    SSchema* pSchema = tscGetTableSchema(pTableMeta);
+
+    uint32_t offset = 0;
+    for (int32_t i = 0; i < tinfo.numOfColumns; ++i) {
+      SParamInfo* param = tscAddParamToDataBlock(pDataBlock, pSchema[i].type, tinfo.precision, pSchema[i].bytes, offset);
+      if (param == NULL) {
+        return TSDB_CODE_TSC_OUT_OF_MEMORY;
+      }
+
+      param->idx = i;
+      offset += pSchema[i].bytes;
+    }
+
+    SSubmitBlk* pSubmit = (SSubmitBlk*)pDataBlock->pData;
+    pSubmit->tid = pTableMeta->sid;
+    pSubmit->uid = pTableMeta->uid;
+    pSubmit->sversion = pTableMeta->sversion;
+
+    pDataBlock->vgId = pTableMeta->vgroupInfo.vgId;
+    pDataBlock->numOfTables = 1;
+  }
+
+  mtb->pBlock = pDataBlock;
+  return TSDB_CODE_SUCCESS;
+}
+
+// make room for numOfRows rows following the rows added to the block
+static int multiTbStmtReserveRows(STableDataBlocks* pBlock, int32_t numOfRows) {
+  SSubmitBlk* pSubmit = (SSubmitBlk*)pBlock->pData;
+  if (pSubmit->numOfRows + numOfRows > INT16_MAX) {
+    tscError("too many rows of table %s in one batch, execute the statement first", pBlock->tableId);
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  uint32_t size = pBlock->size + numOfRows * pBlock->rowSize;
+  if (size > pBlock->nAllocSize) {
+    const double factor = 1.5;
+    void* tmp = realloc(pBlock->pData, (uint32_t)(size * factor));
+    if (tmp == NULL) {
+      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+    pBlock->pData = (char*)tmp;
+    pBlock->nAllocSize = (uint32_t)(size * factor);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// add the rows bound following the rows of the block, the block keeps ordered if the timestamps are ascending
+static void multiTbStmtAddRows(STableDataBlocks* pBlock, int32_t numOfRows) {
+  char* row = pBlock->pData + pBlock->size;
+  for (int32_t i = 0; i < numOfRows; ++i, row += pBlock->rowSize) {
+    TSKEY key = *(TSKEY*)row;
+    if (key <= pBlock->prevTS) {
+      pBlock->ordered = false;
+    }
+    pBlock->prevTS = key;
+  }
+
+  pBlock->size += numOfRows * pBlock->rowSize;
+  ((SSubmitBlk*)pBlock->pData)->numOfRows += numOfRows;
+}
+
+// bind the values of a parameter to numOfRows rows starting from data
+static int doBindColumn(char* data, int32_t rowSize, SParamInfo* param, TAOS_MULTI_BIND* bind) {
+  if (bind->buffer_type != param->type) {
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  char* p = data + param->offset;
+  char* val = bind->buffer;
+
+  if (param->type != TSDB_DATA_TYPE_BINARY && param->type != TSDB_DATA_TYPE_NCHAR) {
+    if (bind->buffer_length < param->bytes) {
+      return TSDB_CODE_TSC_INVALID_VALUE;
+    }
+
+    for (int32_t i = 0; i < bind->num; ++i, p += rowSize, val += bind->buffer_length) {
+      if (bind->is_null != NULL && bind->is_null[i]) {
+        setNull(p, param->type, param->bytes);
+      } else {
+        memcpy(p, val, param->bytes);
+      }
+    }
+
+    return TSDB_CODE_SUCCESS;
+  }
+
+  if (bind->length == NULL) {
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  for (int32_t i = 0; i < bind->num; ++i, p += rowSize, val += bind->buffer_length) {
+    if (bind->is_null != NULL && bind->is_null[i]) {
+      setVardataNull(p, param->type);
+      continue;
+    }
+
+    if (param->type == TSDB_DATA_TYPE_BINARY) {
+      if (bind->length[i] < 0 || bind->length[i] > param->bytes - VARSTR_HEADER_SIZE) {
+        return TSDB_CODE_TSC_INVALID_VALUE;
+      }
+      STR_WITH_SIZE_TO_VARSTR(p, val, bind->length[i]);
+    } else {
+      size_t output = 0;
+      if (!taosMbsToUcs4(val, bind->length[i], varDataVal(p), param->bytes - VARSTR_HEADER_SIZE, &output)) {
+        return TSDB_CODE_TSC_INVALID_VALUE;
+      }
+      varDataSetLen(p, output);
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int multiTbStmtAddBatch(STscStmt* pStmt) {
+  SMultiTbStmt* mtb = &pStmt->mtb;
+  if (mtb->pendingRow) {
+    multiTbStmtAddRows(mtb->pBlock, 1);
+    mtb->pendingRow = false;
+  }
+  return TSDB_CODE_SUCCESS;
+}
+
+static int multiTbStmtSetTable(STscStmt* pStmt, const char* name, TAOS_BIND* tags) {
+  SSqlObj*      pSql = pStmt->pSql;
+  SSqlCmd*      pCmd = &pSql->cmd;
+  SMultiTbStmt* mtb = &pStmt->mtb;
+
+  multiTbStmtAddBatch(pStmt);
+  mtb->pBlock = NULL;
+
+  char   tbName[TSDB_TABLE_ID_LEN] = {0};
+  size_t len = strlen(name);
+  if (len == 0 || len >= sizeof(tbName)) {
+    return TSDB_CODE_TSC_INVALID_TABLE_ID_LENGTH;
+  }
+
+  strtolower(tbName, name);
+  if (validateTableName(tbName, (int)len) != TSDB_CODE_SUCCESS) {
+    return tscInvalidSQLErrMsg(pCmd->payload, "table name invalid", tbName);
+  }
+
+  STableMetaInfo* pTableMetaInfo = tscGetTableMetaInfoFromCmd(pCmd, pCmd->clauseIndex, 0);
+  SSQLToken       sToken = {.n = (uint32_t)len, .type = TK_ID, .z = tbName};
+
+  int32_t code = tscSetTableFullName(pTableMetaInfo, &sToken, pSql);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  // the tags are sent to create the table if the table meta is not in the cache
+  bool autoCreate = (tags != NULL && mtb->numOfTags > 0);
+  if (autoCreate) {
+    code = multiTbStmtSetTagData(pStmt, tags);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  } else {
+    pCmd->payloadLen = 0;
+  }
+
+  code = tscGetTableMetaSync(pSql, pTableMetaInfo, autoCreate);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  if (UTIL_TABLE_IS_SUPER_TABLE(pTableMetaInfo)) {
+    return tscInvalidSQLErrMsg(pCmd->payload, "insert data into super table is not supported", NULL);
+  }
+
+  STableDataBlocks* pBlock = NULL;
+  return multiTbStmtGetBlock(pStmt, &pBlock);
+}
+
+static int multiTbStmtBindParam(STscStmt* pStmt, TAOS_BIND* bind) {
+  STableDataBlocks* pBlock = NULL;
+
+  int code = multiTbStmtGetBlock(pStmt, &pBlock);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  if (bind[0].is_null != NULL && *bind[0].is_null) {
+    return TSDB_CODE_TSC_INVALID_VALUE;  // the timestamp is the primary key
+  }
+
+  code = multiTbStmtReserveRows(pBlock, 1);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  // the row binded last is replaced if it is not added to the batch yet
+  char* data = pBlock->pData + pBlock->size;
+  for (uint32_t j = 0; j < pBlock->numOfParams; ++j) {
+    SParamInfo* param = pBlock->params + j;
+    code = doBindParam(data, param, bind + param->idx);
+    if (code != TSDB_CODE_SUCCESS) {
+      tscTrace("param %d: type mismatch or invalid", param->idx);
+      return code;
+    }
+  }
+
+  pStmt->mtb.pendingRow = true;
+  return TSDB_CODE_SUCCESS;
+}
+
+static int multiTbStmtBindParamBatch(STscStmt* pStmt, TAOS_MULTI_BIND* bind) {
+  multiTbStmtAddBatch(pStmt);
+
+  STableDataBlocks* pBlock = NULL;
+
+  int code = multiTbStmtGetBlock(pStmt, &pBlock);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  int32_t numOfRows = bind[0].num;
+  for (int32_t i = 0; i < pStmt->mtb.numOfCols; ++i) {
+    if (bind[i].num != numOfRows || numOfRows <= 0) {
+      return TSDB_CODE_TSC_INVALID_VALUE;
+    }
+  }
+
+  if (bind[0].is_null != NULL) {
+    for (int32_t i = 0; i < numOfRows; ++i) {
+      if (bind[0].is_null[i]) {
+        return TSDB_CODE_TSC_INVALID_VALUE;  // the timestamp is the primary key
+      }
+    }
+  }
+
+  code = multiTbStmtReserveRows(pBlock, numOfRows);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  char* data = pBlock->pData + pBlock->size;
+  for (uint32_t j = 0; j < pBlock->numOfParams; ++j) {
+    SParamInfo* param = pBlock->params + j;
+    code = doBindColumn(data, pBlock->rowSize, param, bind + param->idx);
+    if (code != TSDB_CODE_SUCCESS) {
+      tscTrace("param %d: type mismatch or invalid", param->idx);
+      return code;
+    }
+  }
+
+  multiTbStmtAddRows(pBlock, numOfRows);
+  return TSDB_CODE_SUCCESS;
+}
+
+// drop all the rows bound, and start over the data blocks
+static int multiTbStmtReset(STscStmt* pStmt) {
+  SSqlCmd* pCmd = &pStmt->pSql->cmd;
+
+  pStmt->mtb.pendingRow = false;
+  pStmt->mtb.pBlock = NULL;
+
+  taosHashCleanup(pCmd->pTableList);
+  pCmd->pTableList = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false);
+
+  tscDestroyBlockArrayList(pCmd->pDataBlocks);
+  pCmd->pDataBlocks = tscCreateBlockArrayList();
+
+  if (pCmd->pTableList == NULL || pCmd->pDataBlocks == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+  return TSDB_CODE_SUCCESS;
+}
+
+static int multiTbStmtExecute(STscStmt* pStmt) {
+  SSqlObj* pSql = pStmt->pSql;
+  SSqlCmd* pCmd = &pSql->cmd;
+  SSqlRes* pRes = &pSql->res;
+
+  multiTbStmtAddBatch(pStmt);
+
+  // the tables set without any rows bound are not submitted
+  SDataBlockList* pList = pCmd->pDataBlocks;
+  uint32_t        numOfBlocks = 0;
+  for (uint32_t i = 0; i < pList->nSize; ++i) {
+    STableDataBlocks* pBlock = pList->pData[i];
+    if (((SSubmitBlk*)pBlock->pData)->numOfRows == 0) {
+      tscDestroyDataBlock(pBlock);
+    } else {
+      pList->pData[numOfBlocks++] = pBlock;
+    }
+  }
+  pList->nSize = numOfBlocks;
+
+  if (numOfBlocks == 0) {
+    multiTbStmtReset(pStmt);
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  // the blocks of the tables are merged into one submit block for each vgroup, which replaces pCmd->pDataBlocks
+  int code = tscMergeTableDataBlocks(pSql, pList);
+  if (code != TSDB_CODE_SUCCESS) {
+    multiTbStmtReset(pStmt);
+    return code;
+  }
+
+  pRes->numOfRows = 0;
+  pRes->numOfTotal = 0;
+  pRes->numOfClauseTotal = 0;
+
+  // the sub-queries copy the command, and they shall not free the table list of the statement
+  taosHashCleanup(pCmd->pTableList);
+  pCmd->pTableList = NULL;
+
+  pRes->qhandle = 0;
+  tfree(pSql->pSubs);
+  pSql->numOfSubs = 0;
+
+  pSql->cmd.insertType = 0;
+  pSql->fetchFp    = waitForQueryRsp;
+  pSql->fp         = (void(*)())tscHandleMultivnodeInsert;
+
+  tscDoQuery(pSql);
+
+  // wait for the callback function to post the semaphore
+  tsem_wait(&pSql->rspSem);
+  code = pRes->code;
+
+  // the rows of the next batch are bound to new data blocks
+  multiTbStmtReset(pStmt);
+  return code;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // interface functions
 
@@ -538,6 +1090,10 @@ int taos_stmt_prepare(TAOS_STMT* stmt, const char* sql, unsigned long length) {
 
   if (tscIsInsertData(pSql->sqlstr)) {  
     pStmt->isInsert = true;
+    pStmt->multiTbInsert = isMultiTbInsert(pSql->sqlstr);
+    if (pStmt->multiTbInsert) {
+      return multiTbStmtPrepare(pStmt);
+    }
     
     pSql->cmd.numOfParams = 0;
     pSql->cmd.batchSize   = 0;
@@ -553,9 +1109,23 @@ int taos_stmt_prepare(TAOS_STMT* stmt, const char* sql, unsigned long length) {
   }
 
   pStmt->isInsert = false;
+  pStmt->multiTbInsert = false;
   return normalStmtPrepare(pStmt);
 }
 
+int taos_stmt_set_tbname_tags(TAOS_STMT* stmt, const char* name, TAOS_BIND* tags) {
+  STscStmt* pStmt = (STscStmt*)stmt;
+  if (!pStmt->multiTbInsert) {
+    tscError("%p the table can be set only for the statement of \"insert into ? ...\"", pStmt->pSql);
+    return TSDB_CODE_COM_OPS_NOT_SUPPORT;
+  }
+  return multiTbStmtSetTable(pStmt, name, tags);
+}
+
+int taos_stmt_set_tbname(TAOS_STMT* stmt, const char* name) {
+  return taos_stmt_set_tbname_tags(stmt, name, NULL);
+}
+
 int taos_stmt_close(TAOS_STMT* stmt) {
   STscStmt* pStmt = (STscStmt*)stmt;
   if (!pStmt->isInsert) {
@@ -577,14 +1147,28 @@ int taos_stmt_close(TAOS_STMT* stmt) {
 
 int taos_stmt_bind_param(TAOS_STMT* stmt, TAOS_BIND* bind) {
   STscStmt* pStmt = (STscStmt*)stmt;
+  if (pStmt->multiTbInsert) {
+    return multiTbStmtBindParam(pStmt, bind);
+  }
   if (pStmt->isInsert) {
     return insertStmtBindParam(pStmt, bind);
   }
   return normalStmtBindParam(pStmt, bind);
 }
 
+int taos_stmt_bind_param_batch(TAOS_STMT* stmt, TAOS_MULTI_BIND* bind) {
+  STscStmt* pStmt = (STscStmt*)stmt;
+  if (pStmt->multiTbInsert) {
+    return multiTbStmtBindParamBatch(pStmt, bind);
+  }
+  return TSDB_CODE_COM_OPS_NOT_SUPPORT;
+}
+
 int taos_stmt_add_batch(TAOS_STMT* stmt) {
   STscStmt* pStmt = (STscStmt*)stmt;
+  if (pStmt->multiTbInsert) {
+    return multiTbStmtAddBatch(pStmt);
+  }
   if (pStmt->isInsert) {
     return insertStmtAddBatch(pStmt);
   }
@@ -593,6 +1177,9 @@ int taos_stmt_add_batch(TAOS_STMT* stmt) {
 
 int taos_stmt_reset(TAOS_STMT* stmt) {
   STscStmt* pStmt = (STscStmt*)stmt;
+  if (pStmt->multiTbInsert) {
+    return multiTbStmtReset(pStmt);
+  }
   if (pStmt->isInsert) {
     return insertStmtReset(pStmt);
   }
@@ -602,7 +1189,9 @@ int taos_stmt_reset(TAOS_STMT* stmt) {
 int taos_stmt_execute(TAOS_STMT* stmt) {
   int ret = 0;
   STscStmt* pStmt = (STscStmt*)stmt;
-  if (pStmt->isInsert) {
+  if (pStmt->multiTbInsert) {
+    ret = multiTbStmtExecute(pStmt);
+  } else if (pStmt->isInsert) {
     ret = insertStmtExecute(pStmt);
   } else {
     char* sql = normalStmtBuildSql(pStmt);
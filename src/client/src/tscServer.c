@@ -22,6 +22,7 @@
 #include "tscUtil.h"
 #include "tschemautil.h"
 #include "tsclient.h"
+#include "tscompression.h"
 #include "tsocket.h"
 #include "ttime.h"
 #include "ttimer.h"
@@ -645,6 +646,7 @@ int tscBuildQueryMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
   pQueryMsg->numOfTags      = htonl(numOfTags);
   pQueryMsg->tagNameRelType = htons(pQueryInfo->tagCond.relType);
   pQueryMsg->queryType      = htons(pQueryInfo->type);
+  pQueryMsg->compressColData = htonl(tsCompressColData);
   
   size_t numOfOutput = tscSqlExprNumOfExprs(pQueryInfo);
   pQueryMsg->numOfOutput = htons(numOfOutput);
@@ -2252,6 +2254,105 @@ int tscProcessQueryRsp(SSqlObj *pSql) {
   return 0;
 }
 
+/*
+ * The result columns encoded by the vnode are decoded into a new rsp of the raw layout, which replaces the received one.
+ */
+int32_t tscDecodeRetrieveRsp(SSqlObj *pSql) {
+  SSqlRes *          pRes = &pSql->res;
+  SRetrieveTableRsp *pRetrieve = (SRetrieveTableRsp *)pRes->pRsp;
+  char *             end = pRes->pRsp + pRes->rspLen;
+  int32_t            numOfRows = (int32_t)pRes->numOfRows;
+
+  char *p = pRetrieve->data;
+  if (numOfRows <= 0 || p + sizeof(int32_t) > end) {
+    tscError("%p invalid retrieve rsp, rows:%d length:%d", pSql, numOfRows, pRes->rspLen);
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  int32_t numOfCols = htonl(*(int32_t *)p);
+  p += sizeof(int32_t);
+
+  // every column must lie within the rsp, and an unencoded one must hold exactly the values of all rows
+  int64_t size = 0;
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    SRetrieveColumn *pCol = (SRetrieveColumn *)p;
+    if (p + sizeof(SRetrieveColumn) > end || pCol->type <= TSDB_DATA_TYPE_NULL || pCol->type > TSDB_DATA_TYPE_NCHAR) {
+      tscError("%p invalid column:%d in retrieve rsp", pSql, i);
+      return TSDB_CODE_TSC_INVALID_VALUE;
+    }
+
+    int32_t len = htonl(pCol->len);
+    int64_t rawLen = (int64_t)htons(pCol->bytes) * numOfRows;
+    if (len < 0 || len > end - pCol->data || rawLen <= 0 ||
+        (pCol->comp == NO_COMPRESSION && len != rawLen) ||
+        (pCol->comp == ONE_STAGE_COMP && (len == 0 || tDataTypeDesc[pCol->type].decompFunc == NULL)) ||
+        (pCol->comp != NO_COMPRESSION && pCol->comp != ONE_STAGE_COMP)) {
+      tscError("%p invalid column:%d in retrieve rsp, comp:%d bytes:%d len:%d", pSql, i, pCol->comp,
+               htons(pCol->bytes), len);
+      return TSDB_CODE_TSC_INVALID_VALUE;
+    }
+
+    // the string codec exits on a wrong indicator, and copies the values it does not compress without a bound
+    bool isString = (pCol->type == TSDB_DATA_TYPE_BINARY || pCol->type == TSDB_DATA_TYPE_NCHAR);
+    if (pCol->comp == ONE_STAGE_COMP && isString &&
+        (pCol->data[0] < 0 || pCol->data[0] > 1 || (pCol->data[0] == 0 && len - 1 != rawLen))) {
+      tscError("%p invalid string column:%d in retrieve rsp, len:%d", pSql, i, len);
+      return TSDB_CODE_TSC_INVALID_VALUE;
+    }
+
+    size += rawLen;
+    p += sizeof(SRetrieveColumn) + len;
+  }
+
+  int32_t tailLen = (int32_t)(end - p);  // the table id list after the columns
+  if (size + tailLen > INT32_MAX - sizeof(SRetrieveTableRsp)) {
+    tscError("%p invalid retrieve rsp, %" PRId64 " bytes of columns", pSql, size);
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  int32_t rspLen = (int32_t)(sizeof(SRetrieveTableRsp) + size + tailLen);
+  char *  pRsp = malloc(rspLen);
+  if (pRsp == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  memcpy(pRsp, pRetrieve, sizeof(SRetrieveTableRsp));
+  ((SRetrieveTableRsp *)pRsp)->compressed = 0;
+
+  char *data = ((SRetrieveTableRsp *)pRsp)->data;
+  p = pRetrieve->data + sizeof(int32_t);
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    SRetrieveColumn *pCol = (SRetrieveColumn *)p;
+    int32_t          len = htonl(pCol->len);
+    int32_t          rawLen = htons(pCol->bytes) * numOfRows;
+
+    if (pCol->comp == NO_COMPRESSION) {
+      memcpy(data, pCol->data, len);
+    } else {
+      int32_t decodedLen =
+          (*tDataTypeDesc[pCol->type].decompFunc)(pCol->data, len, numOfRows, data, rawLen, pCol->comp, NULL, 0);
+      if (decodedLen != rawLen) {
+        tscError("%p failed to decode column:%d in retrieve rsp, %d bytes decoded, %d expected", pSql, i, decodedLen,
+                 rawLen);
+        free(pRsp);
+        return TSDB_CODE_TSC_INVALID_VALUE;
+      }
+    }
+
+    data += rawLen;
+    p += sizeof(SRetrieveColumn) + len;
+  }
+
+  memcpy(data, p, tailLen);
+  tscTrace("%p retrieve rsp of %d rows decoded, %d bytes received, %d bytes decoded", pSql, numOfRows, pRes->rspLen,
+           rspLen);
+
+  free(pRes->pRsp);
+  pRes->pRsp = pRsp;
+  pRes->rspLen = rspLen;
+  return TSDB_CODE_SUCCESS;
+}
+
 int tscProcessRetrieveRspFromNode(SSqlObj *pSql) {
   SSqlRes *pRes = &pSql->res;
   SSqlCmd *pCmd = &pSql->cmd;
@@ -2263,6 +2364,17 @@ int tscProcessRetrieveRspFromNode(SSqlObj *pSql) {
   pRes->offset    = htobe64(pRetrieve->offset);
   pRes->useconds  = htobe64(pRetrieve->useconds);
   pRes->completed = (pRetrieve->completed == 1);
+
+  if (pRetrieve->compressed && pRes->numOfRows > 0) {
+    int32_t code = tscDecodeRetrieveRsp(pSql);
+    if (code != TSDB_CODE_SUCCESS) {
+      pRes->code = code;
+      return code;
+    }
+
+    pRetrieve = (SRetrieveTableRsp *)pRes->pRsp;
+  }
+
   pRes->data      = pRetrieve->data;
   
   SQueryInfo* pQueryInfo = tscGetQueryInfoDetail(pCmd, pCmd->clauseIndex);
@@ -2313,7 +2425,7 @@ int tscProcessRetrieveRspFromLocal(SSqlObj *pSql) {
 
 void tscTableMetaCallBack(void *param, TAOS_RES *res, int code);
 
-static int32_t getTableMetaFromMgmt(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo) {
+static int32_t doGetTableMetaFromMgmt(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, void (*fp)()) {
   SSqlObj *pNew = calloc(1, sizeof(SSqlObj));
   if (NULL == pNew) {
     tscError("%p malloc failed for new sqlobj to get table meta", pSql);
@@ -2345,7 +2457,7 @@ static int32_t getTableMetaFromMgmt(SSqlObj *pSql, STableMetaInfo *pTableMetaInf
   pNew->cmd.payloadLen = pSql->cmd.payloadLen;
   tscTrace("%p new pSqlObj:%p to get tableMeta, auto create:%d", pSql, pNew, pNew->cmd.autoCreated);
 
-  pNew->fp = tscTableMetaCallBack;
+  pNew->fp = fp;
   pNew->param = pSql;
 
   int32_t code = tscProcessSql(pNew);
@@ -2356,6 +2468,17 @@ static int32_t getTableMetaFromMgmt(SSqlObj *pSql, STableMetaInfo *pTableMetaInf
   return code;
 }
 
+static int32_t getTableMetaFromMgmt(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo) {
+  return doGetTableMetaFromMgmt(pSql, pTableMetaInfo, tscTableMetaCallBack);
+}
+
+static void tscTableMetaSyncCallBack(void *param, TAOS_RES *res, int code) {
+  SSqlObj *pSql = (SSqlObj *)param;
+
+  pSql->res.code = (code < 0) ? code : TSDB_CODE_SUCCESS;
+  sem_post(&pSql->rspSem);
+}
+
 int32_t tscGetTableMeta(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo) {
   assert(strlen(pTableMetaInfo->name) != 0);
 
@@ -2381,6 +2504,35 @@ int tscGetMeterMetaEx(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, bool create
   return tscGetTableMeta(pSql, pTableMetaInfo);
 }
 
+/**
+ * get the table meta into the cache and wait for it, the parsing or the submission of pSql is not resumed
+ * afterwards. Only for the callers who wait on pSql->rspSem themselves, such as the prepared statements.
+ */
+int32_t tscGetTableMetaSync(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, bool createIfNotExists) {
+  pSql->cmd.autoCreated = createIfNotExists;
+  if (pTableMetaInfo->pTableMeta != NULL) {
+    taosCacheRelease(tscCacheHandle, (void **)&(pTableMetaInfo->pTableMeta), false);
+  }
+
+  pTableMetaInfo->pTableMeta = (STableMeta *)taosCacheAcquireByName(tscCacheHandle, pTableMetaInfo->name);
+  if (pTableMetaInfo->pTableMeta != NULL) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int32_t code = doGetTableMetaFromMgmt(pSql, pTableMetaInfo, tscTableMetaSyncCallBack);
+  if (code == TSDB_CODE_TSC_ACTION_IN_PROGRESS) {
+    sem_wait(&pSql->rspSem);
+    code = pSql->res.code;
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  pTableMetaInfo->pTableMeta = (STableMeta *)taosCacheAcquireByName(tscCacheHandle, pTableMetaInfo->name);
+  return (pTableMetaInfo->pTableMeta != NULL) ? TSDB_CODE_SUCCESS : TSDB_CODE_TSC_APP_ERROR;
+}
+
 /**
  * retrieve table meta from mnode, and update the local table meta cache.
  * @param pSql          sql object
@@ -374,23 +374,11 @@ int taos_fetch_block_impl(TAOS_RES *res, TAOS_ROW *rows) {
   return (pQueryInfo->order.order == TSDB_ORDER_DESC) ? pRes->numOfRows : -pRes->numOfRows;
 }
 
-TAOS_ROW taos_fetch_row(TAOS_RES *res) {
-  SSqlObj *pSql = (SSqlObj *)res;
-  if (pSql == NULL || pSql->signature != pSql) {
-    terrno = TSDB_CODE_TSC_DISCONNECTED;
-    return NULL;
-  }
-  
+// current data set are exhausted, fetch more data from node
+static void fetchNextBlock(SSqlObj *pSql) {
   SSqlCmd *pCmd = &pSql->cmd;
   SSqlRes *pRes = &pSql->res;
-  
-  if (pRes->qhandle == 0 ||
-      pCmd->command == TSDB_SQL_RETRIEVE_EMPTY_RESULT ||
-      pCmd->command == TSDB_SQL_INSERT) {
-    return NULL;
-  }
-  
-  // current data set are exhausted, fetch more data from node
+
   if (pRes->row >= pRes->numOfRows && (pRes->completed != true || hasMoreVnodesToTry(pSql)) &&
       (pCmd->command == TSDB_SQL_RETRIEVE ||
        pCmd->command == TSDB_SQL_RETRIEVE_LOCALMERGE ||
@@ -404,13 +392,65 @@ TAOS_ROW taos_fetch_row(TAOS_RES *res) {
        pCmd->command == TSDB_SQL_SERV_VERSION ||
        pCmd->command == TSDB_SQL_CLI_VERSION ||
        pCmd->command == TSDB_SQL_CURRENT_USER )) {
-    taos_fetch_rows_a(res, waitForRetrieveRsp, pSql->pTscObj);
+    taos_fetch_rows_a(pSql, waitForRetrieveRsp, pSql->pTscObj);
     sem_wait(&pSql->rspSem);
   }
+}
+
+TAOS_ROW taos_fetch_row(TAOS_RES *res) {
+  SSqlObj *pSql = (SSqlObj *)res;
+  if (pSql == NULL || pSql->signature != pSql) {
+    terrno = TSDB_CODE_TSC_DISCONNECTED;
+    return NULL;
+  }
   
+  SSqlCmd *pCmd = &pSql->cmd;
+  SSqlRes *pRes = &pSql->res;
+  
+  if (pRes->qhandle == 0 ||
+      pCmd->command == TSDB_SQL_RETRIEVE_EMPTY_RESULT ||
+      pCmd->command == TSDB_SQL_INSERT) {
+    return NULL;
+  }
+  
+  fetchNextBlock(pSql);
   return doSetResultRowData(pSql, true);
 }
 
+int taos_fetch_block_columns(TAOS_RES *res, TAOS_COLUMN **columns) {
+  SSqlObj *pSql = (SSqlObj *)res;
+  *columns = NULL;
+
+  if (pSql == NULL || pSql->signature != pSql) {
+    terrno = TSDB_CODE_TSC_DISCONNECTED;
+    return 0;
+  }
+
+  SSqlCmd *pCmd = &pSql->cmd;
+  SSqlRes *pRes = &pSql->res;
+
+  if (pRes->qhandle == 0 ||
+      pCmd->command == TSDB_SQL_RETRIEVE_EMPTY_RESULT ||
+      pCmd->command == TSDB_SQL_INSERT) {
+    return 0;
+  }
+
+  // the rows of a join query are put together from the subqueries one at a time
+  if (pCmd->command == TSDB_SQL_TABLE_JOIN_RETRIEVE) {
+    terrno = TSDB_CODE_TSC_APP_ERROR;
+    return -1;
+  }
+
+  fetchNextBlock(pSql);
+
+  int32_t numOfRows = doSetResultColumnData(pSql);
+  if (numOfRows > 0) {
+    *columns = pRes->pColumns;
+  }
+
+  return numOfRows;
+}
+
 int taos_fetch_block(TAOS_RES *res, TAOS_ROW *rows) {
 #if 0
   SSqlObj *pSql = (SSqlObj *)res;
@@ -2002,6 +2002,124 @@ void **doSetResultRowData(SSqlObj *pSql, bool finalResult) {
   return pRes->tsrow;
 }
 
+static int32_t getColumnBufSize(TAOS_COLUMN *pCol, bool arithmetic, int32_t numOfRows) {
+  int32_t size = (numOfRows + 63) / 64 * sizeof(uint64_t);  // the lengths and values after it are kept aligned
+  if (pCol->type == TSDB_DATA_TYPE_BINARY || pCol->type == TSDB_DATA_TYPE_NCHAR) {
+    size += numOfRows * sizeof(int32_t);
+  }
+
+  return arithmetic ? size + numOfRows * pCol->bytes : size;
+}
+
+/*
+ * The rows left in current block handed out as columns. The values of a column are already kept one after another in
+ * pRes->data, so only the null bitmaps, the lengths of BINARY and NCHAR values and the arithmetic expressions are
+ * prepared, a column at a time.
+ */
+int32_t doSetResultColumnData(SSqlObj *pSql) {
+  SSqlCmd *pCmd = &pSql->cmd;
+  SSqlRes *pRes = &pSql->res;
+
+  int32_t numOfRows = (int32_t)(pRes->numOfRows - pRes->row);
+  if (numOfRows <= 0) {
+    return 0;
+  }
+
+  SQueryInfo *pQueryInfo = tscGetQueryInfoDetail(pCmd, pCmd->clauseIndex);
+  int32_t     numOfCols = pRes->numOfCols;
+  assert(numOfCols == tscNumOfFields(pQueryInfo));
+
+  if (pRes->pColumns == NULL) {
+    pRes->pColumns = calloc(numOfCols, sizeof(TAOS_COLUMN));
+    pRes->colBuffer = calloc(numOfCols, POINTER_BYTES);
+    if (pRes->pColumns == NULL || pRes->colBuffer == NULL) {
+      tfree(pRes->pColumns);
+      tfree(pRes->colBuffer);
+      terrno = TSDB_CODE_TSC_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  // the buffers of all columns are allocated for the same number of rows
+  bool    grow = numOfRows > pRes->colBufRows;
+  int32_t capacity = grow ? numOfRows : pRes->colBufRows;
+
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    SFieldSupInfo *pSup = tscFieldInfoGetSupp(&pQueryInfo->fieldsInfo, i);
+    TAOS_FIELD *   pField = tscFieldInfoGetField(&pQueryInfo->fieldsInfo, i);
+    TAOS_COLUMN *  pCol = &pRes->pColumns[i];
+    bool           arithmetic = (pSup->pArithExprInfo != NULL);
+
+    pCol->type = pField->type;
+    pCol->bytes = (pSup->pSqlExpr != NULL) ? pSup->pSqlExpr->resBytes : pField->bytes;
+
+    if (grow) {
+      char *buf = realloc(pRes->colBuffer[i], getColumnBufSize(pCol, arithmetic, capacity));
+      if (buf == NULL) {
+        for (int32_t k = 0; k < numOfCols; ++k) {
+          tfree(pRes->colBuffer[k]);
+        }
+
+        pRes->colBufRows = 0;
+        terrno = TSDB_CODE_TSC_OUT_OF_MEMORY;
+        return -1;
+      }
+      pRes->colBuffer[i] = buf;
+    }
+
+    char *buf = pRes->colBuffer[i];
+    pCol->nullBitmap = (uint8_t *)buf;
+    buf += (capacity + 63) / 64 * sizeof(uint64_t);
+
+    pCol->length = NULL;
+    if (pCol->type == TSDB_DATA_TYPE_BINARY || pCol->type == TSDB_DATA_TYPE_NCHAR) {
+      pCol->length = (int *)buf;
+      buf += capacity * sizeof(int32_t);
+    }
+
+    if (pSup->pSqlExpr != NULL) {
+      pCol->data = pRes->data + pSup->pSqlExpr->offset * pRes->numOfRows + pRes->row * pCol->bytes;
+    } else if (arithmetic) {
+      // calculate the expression of the whole block at once
+      if (pRes->pArithSup == NULL) {
+        SArithmeticSupport *sas = (SArithmeticSupport *) calloc(1, sizeof(SArithmeticSupport));
+        sas->numOfCols  = tscSqlExprNumOfExprs(pQueryInfo);
+        sas->exprList   = pQueryInfo->exprList;
+        sas->data       = calloc(sas->numOfCols, POINTER_BYTES);
+
+        pRes->pArithSup = sas;
+      }
+
+      pRes->pArithSup->offset = 0;
+      pRes->pArithSup->pArithExpr = pSup->pArithExprInfo;
+      for (int32_t k = 0; k < pRes->pArithSup->numOfCols; ++k) {
+        SSqlExpr *pExpr = tscSqlExprGet(pQueryInfo, k);
+        pRes->pArithSup->data[k] = (pRes->data + pRes->numOfRows * pExpr->offset) + pRes->row * pExpr->resBytes;
+      }
+
+      pCol->data = buf;
+      tExprTreeCalcTraverse(pSup->pArithExprInfo->pExpr, numOfRows, pCol->data, pRes->pArithSup, TSDB_ORDER_ASC,
+                            getArithemicInputSrc);
+    }
+
+    memset(pCol->nullBitmap, 0, (numOfRows + 7) / 8);
+    char *pData = pCol->data;
+    for (int32_t j = 0; j < numOfRows; ++j, pData += pCol->bytes) {
+      if (isNull(pData, pCol->type)) {
+        pCol->nullBitmap[j >> 3] |= (1u << (j & 7));
+      }
+
+      if (pCol->length != NULL) {
+        pCol->length[j] = varDataLen(pData);
+      }
+    }
+  }
+
+  pRes->colBufRows = capacity;
+  pRes->row = (int32_t)pRes->numOfRows;
+  return numOfRows;
+}
+
 static UNUSED_FUNC bool tscHashRemainDataInSubqueryResultSet(SSqlObj *pSql) {
   bool     hasData = true;
   SSqlCmd *pCmd = &pSql->cmd;
@@ -291,6 +291,16 @@ int32_t tscCreateResPointerInfo(SSqlRes* pRes, SQueryInfo* pQueryInfo) {
 }
 
 void tscDestroyResPointerInfo(SSqlRes* pRes) {
+  if (pRes->colBuffer != NULL) {
+    for (int i = 0; i < pRes->numOfCols; i++) {
+      tfree(pRes->colBuffer[i]);
+    }
+  }
+
+  tfree(pRes->colBuffer);
+  tfree(pRes->pColumns);
+  pRes->colBufRows = 0;
+
   if (pRes->buffer != NULL) { // free all buffers containing the multibyte string
     for (int i = 0; i < pRes->numOfCols; i++) {
       tfree(pRes->buffer[i]);
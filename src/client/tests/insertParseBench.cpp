@@ -0,0 +1,207 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <string>
+
+#include "tsclient.h"
+#include "tscUtil.h"
+#include "tstoken.h"
+#include "ttokendef.h"
+
+extern "C" {
+int tsParseOneRowData(char **str, STableDataBlocks *pDataBlocks, SSchema schema[], SParsedDataColInfo *spd, char *error,
+                      int16_t timePrec, int32_t *code, char *tmpTokenBuf);
+int tsParseValues(char **str, STableDataBlocks *pDataBlock, STableMeta *pTableMeta, int maxRows,
+                  SParsedDataColInfo *spd, char *error, int32_t *code, char *tmpTokenBuf);
+}
+
+/*
+ * Parse throughput of the values clause of insert statements, in MB/s of sql string. tsParseValues, which tries the
+ * fast path of the plain literals first, is compared with the rows parsed by tsParseOneRowData only, the way all rows
+ * were parsed before, and the data blocks of both shall be the same.
+ *
+ * usage: insertParseBench [rowsPerSql] [rounds]
+ */
+
+namespace {
+
+typedef struct {
+  uint8_t type;
+  int16_t bytes;
+} SBenchCol;
+
+const SBenchCol benchCols[] = {
+    {TSDB_DATA_TYPE_TIMESTAMP, 8}, {TSDB_DATA_TYPE_INT, 4},     {TSDB_DATA_TYPE_BIGINT, 8},
+    {TSDB_DATA_TYPE_FLOAT, 4},     {TSDB_DATA_TYPE_DOUBLE, 8},  {TSDB_DATA_TYPE_SMALLINT, 2},
+    {TSDB_DATA_TYPE_BOOL, 1},      {TSDB_DATA_TYPE_BINARY, 18}, {TSDB_DATA_TYPE_NCHAR, 66},
+};
+
+const int numOfCols = sizeof(benchCols) / sizeof(benchCols[0]);
+
+typedef struct {
+  const char *name;
+  bool        escaped;  // the binary values with escape characters are left to the tokenizer
+} SBenchCase;
+
+int64_t nowUs() {
+  struct timeval t = {0};
+  gettimeofday(&t, NULL);
+  return t.tv_sec * 1000000L + t.tv_usec;
+}
+
+std::string genValues(const SBenchCase *pCase, int numOfRows) {
+  std::string sql;
+  char        buf[512];
+
+  for (int i = 0; i < numOfRows; ++i) {
+    const char *quote = pCase->escaped ? "b\\'" : "b";
+    snprintf(buf, sizeof(buf), "(%" PRId64 ", %d, %" PRId64 ", %.2f, %.6f, %s, %s, '%s%d', \"n%d\") ",
+             1500000000000L + i * 1000L, i * 7 - 3000, (int64_t)i * 1000003L, i * 0.25, i / 3.0,
+             (i % 10 == 0) ? "null" : "-12", (i % 2 == 0) ? "true" : "false", quote, i % 100, i % 1000);
+    sql += buf;
+  }
+
+  return sql;
+}
+
+STableMeta *createTableMeta(SParsedDataColInfo *spd) {
+  STableMeta *pTableMeta = (STableMeta *)calloc(1, sizeof(STableMeta) + sizeof(SSchema) * numOfCols);
+  pTableMeta->tableInfo.numOfColumns = numOfCols;
+  pTableMeta->tableInfo.precision = TSDB_TIME_PRECISION_MILLI;
+
+  memset(spd, 0, sizeof(SParsedDataColInfo));
+  spd->numOfCols = numOfCols;
+  spd->numOfAssignedCols = numOfCols;
+
+  int32_t offset = 0;
+  for (int i = 0; i < numOfCols; ++i) {
+    SSchema *pSchema = &pTableMeta->schema[i];
+    pSchema->type = benchCols[i].type;
+    pSchema->bytes = benchCols[i].bytes;
+    pSchema->colId = i;
+    snprintf(pSchema->name, sizeof(pSchema->name), "c%d", i);
+
+    spd->hasVal[i] = true;
+    spd->elems[i].colIndex = i;
+    spd->elems[i].offset = offset;
+    offset += pSchema->bytes;
+  }
+
+  pTableMeta->tableInfo.rowSize = offset;
+  return pTableMeta;
+}
+
+void resetDataBlock(STableDataBlocks *pBlock) {
+  pBlock->size = sizeof(SSubmitBlk);
+  pBlock->ordered = true;
+  pBlock->prevTS = INT64_MIN;
+  pBlock->tsSource = -1;
+  memset(pBlock->pData, 0, pBlock->nAllocSize);
+}
+
+// all rows are parsed by the tokenizer and tsParseOneRowData
+int parseByTokens(char *sql, STableDataBlocks *pBlock, STableMeta *pTableMeta, SParsedDataColInfo *spd, char *error,
+                  char *tmpTokenBuf) {
+  int32_t code = 0;
+  int     numOfRows = 0;
+
+  while (1) {
+    int32_t   index = 0;
+    SSQLToken sToken = tStrGetToken(sql, &index, false, 0, NULL);
+    if (sToken.n == 0 || sToken.type != TK_LP) break;
+    sql += index;
+
+    int32_t len = tsParseOneRowData(&sql, pBlock, pTableMeta->schema, spd, error, TSDB_TIME_PRECISION_MILLI, &code,
+                                    tmpTokenBuf);
+    if (len <= 0) return -1;
+    pBlock->size += len;
+
+    index = 0;
+    sToken = tStrGetToken(sql, &index, false, 0, NULL);
+    sql += index;
+    if (sToken.type != TK_RP) return -1;
+    numOfRows++;
+  }
+
+  return numOfRows;
+}
+
+int parseByValues(char *sql, STableDataBlocks *pBlock, STableMeta *pTableMeta, SParsedDataColInfo *spd, char *error,
+                  char *tmpTokenBuf) {
+  int32_t code = 0;
+  int32_t maxRows = (int32_t)(pBlock->nAllocSize - pBlock->headerSize) / pTableMeta->tableInfo.rowSize;
+  return tsParseValues(&sql, pBlock, pTableMeta, maxRows, spd, error, &code, tmpTokenBuf);
+}
+
+typedef int (*__parse_fn_t)(char *sql, STableDataBlocks *pBlock, STableMeta *pTableMeta, SParsedDataColInfo *spd,
+                            char *error, char *tmpTokenBuf);
+
+double runCase(__parse_fn_t fp, std::string &sql, int numOfRows, int rounds, STableDataBlocks *pBlock,
+               STableMeta *pTableMeta, SParsedDataColInfo *spd) {
+  char error[512] = {0};
+  char tmpTokenBuf[4096] = {0};
+
+  int64_t elapsed = 0;
+  for (int r = 0; r < rounds; ++r) {
+    resetDataBlock(pBlock);
+
+    int64_t st = nowUs();
+    int     rows = fp(&sql[0], pBlock, pTableMeta, spd, error, tmpTokenBuf);
+    elapsed += nowUs() - st;
+
+    if (rows != numOfRows) {
+      printf("failed to parse the values, rows:%d, expected:%d, error:%s\n", rows, numOfRows, error);
+      exit(1);
+    }
+  }
+
+  return sql.size() * (double)rounds / (elapsed > 0 ? elapsed : 1);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int numOfRows = (argc > 1) ? atoi(argv[1]) : 1000;
+  int rounds = (argc > 2) ? atoi(argv[2]) : 2000;
+  if (numOfRows <= 0 || numOfRows > INT16_MAX || rounds <= 0) {
+    printf("usage: %s [rowsPerSql] [rounds], rowsPerSql shall be in [1, 32767]\n", argv[0]);
+    return 1;
+  }
+
+  SParsedDataColInfo spd;
+  STableMeta *       pTableMeta = createTableMeta(&spd);
+  int32_t            rowSize = pTableMeta->tableInfo.rowSize;
+
+  STableDataBlocks blocks[2];
+  for (int i = 0; i < 2; ++i) {
+    memset(&blocks[i], 0, sizeof(STableDataBlocks));
+    blocks[i].headerSize = sizeof(SSubmitBlk);
+    blocks[i].rowSize = rowSize;
+    blocks[i].nAllocSize = sizeof(SSubmitBlk) + rowSize * (numOfRows + 10);
+    blocks[i].pData = (char *)malloc(blocks[i].nAllocSize);
+  }
+
+  SBenchCase cases[] = {{"plain", false}, {"escaped", true}};
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    std::string sql = genValues(&cases[c], numOfRows);
+
+    double tokenMBps = runCase(parseByTokens, sql, numOfRows, rounds, &blocks[0], pTableMeta, &spd);
+    double valueMBps = runCase(parseByValues, sql, numOfRows, rounds, &blocks[1], pTableMeta, &spd);
+
+    bool same = (blocks[0].size == blocks[1].size) &&
+                (memcmp(blocks[0].pData + sizeof(SSubmitBlk), blocks[1].pData + sizeof(SSubmitBlk),
+                        blocks[0].size - sizeof(SSubmitBlk)) == 0);
+    printf("%-8s rows:%d, sql:%zu bytes, tokenizer:%.1f MB/s, values:%.1f MB/s, speedup:%.2f, %s\n", cases[c].name,
+           numOfRows, sql.size(), tokenMBps, valueMBps, valueMBps / tokenMBps, same ? "same rows" : "DIFFERENT ROWS");
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    free(blocks[i].pData);
+  }
+
+  free(pTableMeta);
+  return 0;
+}
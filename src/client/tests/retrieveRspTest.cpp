@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tsclient.h"
+#include "qExecutor.h"
+#include "tscompression.h"
+
+namespace {
+
+const int32_t numOfRows = 1000;
+
+typedef struct {
+  int16_t type;
+  int16_t bytes;
+} SColDesc;
+
+const SColDesc cols[] = {
+    {TSDB_DATA_TYPE_TIMESTAMP, 8}, {TSDB_DATA_TYPE_BOOL, 1},   {TSDB_DATA_TYPE_TINYINT, 1},
+    {TSDB_DATA_TYPE_SMALLINT, 2},  {TSDB_DATA_TYPE_INT, 4},    {TSDB_DATA_TYPE_BIGINT, 8},
+    {TSDB_DATA_TYPE_FLOAT, 4},     {TSDB_DATA_TYPE_DOUBLE, 8}, {TSDB_DATA_TYPE_BINARY, 18},
+    {TSDB_DATA_TYPE_NCHAR, 42},
+};
+const int32_t numOfCols = sizeof(cols) / sizeof(cols[0]);
+
+// the result of a query, every 7th row of a column is NULL
+class SQueryResult {
+ public:
+  SQueryResult(int32_t compressColData) {
+    memset(&query, 0, sizeof(query));
+    query.numOfOutput = numOfCols;
+    query.compressColData = compressColData;
+    query.pSelectExpr = (SExprInfo *)calloc(numOfCols, sizeof(SExprInfo));
+    query.sdata = (tFilePage **)calloc(numOfCols, POINTER_BYTES);
+
+    for (int32_t i = 0; i < numOfCols; ++i) {
+      query.pSelectExpr[i].type = cols[i].type;
+      query.pSelectExpr[i].bytes = cols[i].bytes;
+      query.sdata[i] = (tFilePage *)calloc(1, sizeof(tFilePage) + cols[i].bytes * numOfRows);
+      query.sdata[i]->num = numOfRows;
+
+      for (int32_t j = 0; j < numOfRows; ++j) {
+        char *val = query.sdata[i]->data + cols[i].bytes * j;
+        if (j % 7 == 3 && IS_VAR_DATA_TYPE(cols[i].type)) {
+          setVardataNull(val, cols[i].type);
+          continue;
+        } else if (j % 7 == 3) {
+          setNull(val, cols[i].type, cols[i].bytes);
+          continue;
+        }
+
+        switch (cols[i].type) {
+          case TSDB_DATA_TYPE_TIMESTAMP:
+            *(int64_t *)val = 1537146000000L + j * 1000L + (j % 3);
+            break;
+          case TSDB_DATA_TYPE_BOOL:
+            *(int8_t *)val = j % 2;
+            break;
+          case TSDB_DATA_TYPE_TINYINT:
+            *(int8_t *)val = j % 100 - 50;
+            break;
+          case TSDB_DATA_TYPE_SMALLINT:
+            *(int16_t *)val = j * 3 - 1000;
+            break;
+          case TSDB_DATA_TYPE_INT:
+            *(int32_t *)val = j * j - 20000;
+            break;
+          case TSDB_DATA_TYPE_BIGINT:
+            *(int64_t *)val = (int64_t)j * 1000000007L;
+            break;
+          case TSDB_DATA_TYPE_FLOAT:
+            *(float *)val = j * 0.25f - 7.5f;
+            break;
+          case TSDB_DATA_TYPE_DOUBLE:
+            *(double *)val = j / 3.0;
+            break;
+          case TSDB_DATA_TYPE_BINARY:
+          case TSDB_DATA_TYPE_NCHAR:
+            // the length prefix and the value of a var string, the rest of the column is left zero
+            varDataSetLen(val, snprintf((char *)varDataVal(val), cols[i].bytes - VARSTR_HEADER_SIZE, "value%d", j % 10));
+            break;
+        }
+      }
+    }
+  }
+
+  ~SQueryResult() {
+    for (int32_t i = 0; i < numOfCols; ++i) {
+      free(query.sdata[i]);
+    }
+
+    free(query.sdata);
+    free(query.pSelectExpr);
+  }
+
+  int32_t rawSize() {
+    int32_t size = 0;
+    for (int32_t i = 0; i < numOfCols; ++i) {
+      size += cols[i].bytes * numOfRows;
+    }
+
+    return size;
+  }
+
+  SQuery query;
+};
+
+const char tail[] = "table id list";
+
+// encode the result into a retrieve rsp, which is followed by the tail like the table id list of a vnode rsp
+void encodeRsp(SQueryResult *pResult, SSqlObj *pSql) {
+  int32_t size = sizeof(SRetrieveTableRsp) + sizeof(int32_t) + pResult->rawSize() +
+                 (sizeof(SRetrieveColumn) + COMP_OVERFLOW_BYTES) * numOfCols + sizeof(tail);
+
+  SRetrieveTableRsp *pRsp = (SRetrieveTableRsp *)calloc(1, size);
+  pRsp->numOfRows = htonl(numOfRows);
+  pRsp->compressed = 1;
+
+  char *end = doEncodeQueryResult(&pResult->query, numOfRows, pRsp->data);
+  memcpy(end, tail, sizeof(tail));
+  end += sizeof(tail);
+
+  memset(pSql, 0, sizeof(SSqlObj));
+  pSql->res.pRsp = (char *)pRsp;
+  pSql->res.rspLen = (int32_t)(end - (char *)pRsp);
+  pSql->res.numOfRows = numOfRows;
+}
+
+void checkDecodedRsp(SQueryResult *pResult, SSqlObj *pSql) {
+  SRetrieveTableRsp *pRsp = (SRetrieveTableRsp *)pSql->res.pRsp;
+  ASSERT_EQ(pRsp->compressed, 0);
+  ASSERT_EQ(pSql->res.rspLen, sizeof(SRetrieveTableRsp) + pResult->rawSize() + sizeof(tail));
+
+  char *data = pRsp->data;
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    int32_t len = cols[i].bytes * numOfRows;
+    EXPECT_EQ(memcmp(data, pResult->query.sdata[i]->data, len), 0) << "column " << i;
+
+    for (int32_t j = 3; j < numOfRows; j += 7) {
+      EXPECT_TRUE(isNull(data + cols[i].bytes * j, cols[i].type)) << "column " << i << " row " << j;
+    }
+
+    data += len;
+  }
+
+  EXPECT_STREQ(data, tail);
+}
+
+SRetrieveColumn *getColumn(SSqlObj *pSql, int32_t index) {
+  char *p = ((SRetrieveTableRsp *)pSql->res.pRsp)->data + sizeof(int32_t);
+  for (int32_t i = 0; i < index; ++i) {
+    p += sizeof(SRetrieveColumn) + htonl(((SRetrieveColumn *)p)->len);
+  }
+
+  return (SRetrieveColumn *)p;
+}
+
+}  // namespace
+
+// Every column is encoded by the codec of its type, and decoded back into the raw layout
+TEST(RetrieveRspTest, encodeAllColumns) {
+  SQueryResult result(0);
+  SSqlObj      sql;
+  encodeRsp(&result, &sql);
+
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    EXPECT_EQ(getColumn(&sql, i)->comp, ONE_STAGE_COMP) << "column " << i;
+  }
+
+  ASSERT_LT(sql.res.rspLen, sizeof(SRetrieveTableRsp) + result.rawSize());
+  ASSERT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_SUCCESS);
+  checkDecodedRsp(&result, &sql);
+  free(sql.res.pRsp);
+}
+
+// The columns no larger than the threshold are copied, the others are encoded
+TEST(RetrieveRspTest, encodeColumnsOverThreshold) {
+  int32_t     threshold = 4 * numOfRows;
+  SQueryResult result(threshold);
+  SSqlObj      sql;
+  encodeRsp(&result, &sql);
+
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    int8_t comp = (cols[i].bytes * numOfRows > threshold) ? ONE_STAGE_COMP : NO_COMPRESSION;
+    EXPECT_EQ(getColumn(&sql, i)->comp, comp) << "column " << i;
+  }
+
+  ASSERT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_SUCCESS);
+  checkDecodedRsp(&result, &sql);
+  free(sql.res.pRsp);
+}
+
+// A column of a length out of the rsp, or not matching the rows, fails the decode and leaves the rsp as received
+TEST(RetrieveRspTest, invalidColumnLength) {
+  SQueryResult result(4 * numOfRows);
+  int32_t      lens[] = {-1, 1 << 30};
+
+  for (size_t k = 0; k < sizeof(lens) / sizeof(lens[0]); ++k) {
+    SSqlObj sql;
+    encodeRsp(&result, &sql);
+
+    char *pRsp = sql.res.pRsp;
+    getColumn(&sql, 4)->len = htonl(lens[k]);
+    EXPECT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_TSC_INVALID_VALUE);
+    EXPECT_EQ(sql.res.pRsp, pRsp);
+    free(sql.res.pRsp);
+  }
+
+  // the copied column of tinyint holds one value less than the rows
+  SSqlObj sql;
+  encodeRsp(&result, &sql);
+  SRetrieveColumn *pCol = getColumn(&sql, 2);
+  ASSERT_EQ(pCol->comp, NO_COMPRESSION);
+  pCol->len = htonl(numOfRows - 1);
+  EXPECT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_TSC_INVALID_VALUE);
+  free(sql.res.pRsp);
+
+  // the rsp is cut in the middle of the last column
+  encodeRsp(&result, &sql);
+  sql.res.rspLen = (int32_t)(getColumn(&sql, numOfCols - 1)->data - sql.res.pRsp) + 10;
+  EXPECT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_TSC_INVALID_VALUE);
+  free(sql.res.pRsp);
+}
+
+// An encoded column decoded into fewer values than the rows fails the decode
+TEST(RetrieveRspTest, decodedLengthMismatch) {
+  SQueryResult result(0);
+  SSqlObj      sql;
+
+  // the encoded binary column of the rsp holds the values of half the rows
+  int32_t            bytes = cols[8].bytes;
+  SRetrieveTableRsp *pRsp = (SRetrieveTableRsp *)calloc(1, sizeof(SRetrieveTableRsp) + result.rawSize() * 2);
+  pRsp->numOfRows = htonl(numOfRows);
+  pRsp->compressed = 1;
+  *(int32_t *)pRsp->data = htonl(1);
+
+  SRetrieveColumn *pCol = (SRetrieveColumn *)(pRsp->data + sizeof(int32_t));
+  pCol->type = TSDB_DATA_TYPE_BINARY;
+  pCol->comp = ONE_STAGE_COMP;
+  pCol->bytes = htons(bytes);
+  int32_t len = tsCompressString(result.query.sdata[8]->data, bytes * numOfRows / 2, numOfRows / 2, pCol->data,
+                                 bytes * numOfRows + COMP_OVERFLOW_BYTES, ONE_STAGE_COMP, NULL, 0);
+  ASSERT_EQ(pCol->data[0], 1);
+  pCol->len = htonl(len);
+
+  memset(&sql, 0, sizeof(SSqlObj));
+  sql.res.pRsp = (char *)pRsp;
+  sql.res.rspLen = (int32_t)(pCol->data + len - (char *)pRsp);
+  sql.res.numOfRows = numOfRows;
+
+  EXPECT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_TSC_INVALID_VALUE);
+  EXPECT_EQ(sql.res.pRsp, (char *)pRsp);
+  free(sql.res.pRsp);
+}
+
+// A string column copied by the codec must hold exactly the values of all rows
+TEST(RetrieveRspTest, invalidStringColumn) {
+  SQueryResult result(0);
+  SSqlObj      sql;
+  encodeRsp(&result, &sql);
+
+  SRetrieveColumn *pCol = getColumn(&sql, 8);
+  pCol->data[0] = 0;
+  EXPECT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_TSC_INVALID_VALUE);
+
+  pCol->data[0] = 2;
+  EXPECT_EQ(tscDecodeRetrieveRsp(&sql), TSDB_CODE_TSC_INVALID_VALUE);
+  free(sql.res.pRsp);
+}
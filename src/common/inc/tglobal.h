@@ -68,6 +68,9 @@ extern int32_t tsTableMetaKeepTimer;
 
 extern float    tsNumOfThreadsPerCore;
 extern float    tsRatioOfQueryThreads;
+extern int32_t  tsQueryTimeSlice;
+extern int32_t  tsParallelQueryThreads;
+extern int32_t  tsTagIndexColumns;
 extern char     tsPublicIp[];
 extern char     tsPrivateIp[];
 extern int16_t  tsNumOfVnodesPerCore;
@@ -76,15 +79,23 @@ extern uint32_t tsPublicIpInt;
 
 extern int32_t tsCacheBlockSize;
 extern int32_t tsBlocksPerVnode;
+extern int32_t tsBlockCacheSize;
 extern int32_t tsMaxTablePerVnode;
 extern int16_t tsDaysPerFile;
 extern int32_t tsDaysToKeep;
 extern int32_t tsMinRowsInFileBlock;
 extern int32_t tsMaxRowsInFileBlock;
 extern int16_t tsCommitTime;  // seconds
+extern int32_t tsCommitThreads;
+extern int32_t tsMemTableType;
+extern int32_t tsCompactInterval;
+extern int32_t tsCompactRatio;
+extern int32_t tsCompactIoLimit;
 extern int32_t tsTimePrecision;
 extern int16_t tsCompression;
 extern int16_t tsWAL;
+extern int32_t tsWalFlushWindow;
+extern int32_t tsWalRestoreThreads;
 extern int32_t tsReplications;
 
 extern int16_t tsAffectedRowsMod;
@@ -112,6 +123,7 @@ extern int32_t tsEnableMonitorModule;
 extern int32_t tsRestRowLimit;
 extern int32_t tsMaxSQLStringLen;
 extern int32_t tsCompressMsgSize;
+extern int32_t tsCompressColData;
 extern int32_t tsMaxNumOfOrderedResults;
 
 extern char tsSocketType[4];
@@ -80,6 +80,9 @@ int32_t tsRpcMaxTime = 600;      // seconds;
 
 float   tsNumOfThreadsPerCore = 1.0;
 float   tsRatioOfQueryThreads = 0.5;
+int32_t tsQueryTimeSlice = TSDB_DEFAULT_QUERY_TIME_SLICE;  // ms
+int32_t tsParallelQueryThreads = TSDB_DEFAULT_PARALLEL_QUERY_THREADS;
+int32_t tsTagIndexColumns = TSDB_DEFAULT_TAG_INDEX_COLUMNS;
 int16_t tsNumOfVnodesPerCore = 8;
 int16_t tsNumOfTotalVnodes = TSDB_INVALID_VNODE_NUM;
 
@@ -91,14 +94,24 @@ int32_t tsMaxTablePerVnode = TSDB_DEFAULT_TABLES;
 
 int32_t tsCacheBlockSize = TSDB_DEFAULT_CACHE_BLOCK_SIZE;
 int32_t tsBlocksPerVnode = TSDB_DEFAULT_TOTAL_BLOCKS;
+int32_t tsBlockCacheSize = TSDB_DEFAULT_BLOCK_CACHE_SIZE;
 int16_t tsDaysPerFile    = TSDB_DEFAULT_DAYS_PER_FILE;
 int32_t tsDaysToKeep     = TSDB_DEFAULT_KEEP;
 int32_t tsMinRowsInFileBlock = TSDB_DEFAULT_MIN_ROW_FBLOCK;
 int32_t tsMaxRowsInFileBlock = TSDB_DEFAULT_MAX_ROW_FBLOCK;
 int16_t tsCommitTime    = TSDB_DEFAULT_COMMIT_TIME;  // seconds
+int32_t tsCommitThreads = TSDB_DEFAULT_COMMIT_THREADS;
+int32_t tsMemTableType  = TSDB_DEFAULT_MEM_TABLE_TYPE;
+
+// background compaction of the file groups
+int32_t tsCompactInterval = TSDB_DEFAULT_COMPACT_INTERVAL;  // seconds between the compaction rounds
+int32_t tsCompactRatio    = TSDB_DEFAULT_COMPACT_RATIO;     // percent
+int32_t tsCompactIoLimit  = TSDB_DEFAULT_COMPACT_IO_LIMIT;  // MB per second
 int32_t tsTimePrecision = TSDB_DEFAULT_PRECISION;
 int16_t tsCompression   = TSDB_DEFAULT_COMP_LEVEL;
 int16_t tsWAL           = TSDB_DEFAULT_WAL_LEVEL;
+int32_t tsWalFlushWindow = TSDB_DEFAULT_WAL_FLUSH_WINDOW;  // ms
+int32_t tsWalRestoreThreads = TSDB_DEFAULT_WAL_RESTORE_THREADS;
 int32_t tsReplications  = TSDB_DEFAULT_REPLICA_NUM;
 
 /**
@@ -158,6 +171,13 @@ int32_t tsMaxNumOfOrderedResults = 100000;
  */
 int32_t tsCompressMsgSize = -1;
 
+/*
+ * denote if the client asks the vnodes to encode the result columns in retrieve rsp with the codec of each type.
+ * -1: no column is encoded
+ * other values: the result columns larger than tsCompressColData bytes in a retrieve rsp are encoded
+ */
+int32_t tsCompressColData = -1;
+
 // use UDP by default[option: udp, tcp]
 char tsSocketType[4] = "udp";
 
@@ -400,6 +420,36 @@ static void doInitGlobalConfig() {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "queryTimeSlice";
+  cfg.ptr = &tsQueryTimeSlice;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_QUERY_TIME_SLICE;
+  cfg.maxValue = TSDB_MAX_QUERY_TIME_SLICE;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MS;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "parallelQueryThreads";
+  cfg.ptr = &tsParallelQueryThreads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_PARALLEL_QUERY_THREADS;
+  cfg.maxValue = TSDB_MAX_PARALLEL_QUERY_THREADS;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "tagIndexColumns";
+  cfg.ptr = &tsTagIndexColumns;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_TAG_INDEX_COLUMNS;
+  cfg.maxValue = TSDB_MAX_TAG_INDEX_COLUMNS;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "numOfVnodesPerCore";
   cfg.ptr = &tsNumOfVnodesPerCore;
   cfg.valType = TAOS_CFG_VTYPE_INT16;
@@ -633,6 +683,16 @@ static void doInitGlobalConfig() {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "blockCacheSize";
+  cfg.ptr = &tsBlockCacheSize;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_BLOCK_CACHE_SIZE;
+  cfg.maxValue = TSDB_MAX_BLOCK_CACHE_SIZE;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_Mb;
+  taosInitConfigOption(cfg);
+
   cfg.option = "days";
   cfg.ptr = &tsDaysPerFile;
   cfg.valType = TAOS_CFG_VTYPE_INT16;
@@ -683,6 +743,56 @@ static void doInitGlobalConfig() {
   cfg.unitType = TAOS_CFG_UTYPE_SECOND;
   taosInitConfigOption(cfg);
 
+  cfg.option = "commitThreads";
+  cfg.ptr = &tsCommitThreads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_COMMIT_THREADS;
+  cfg.maxValue = TSDB_MAX_COMMIT_THREADS;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "memTableType";
+  cfg.ptr = &tsMemTableType;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MEM_TABLE_SKIPLIST;
+  cfg.maxValue = TSDB_MEM_TABLE_APPEND;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "compactInterval";
+  cfg.ptr = &tsCompactInterval;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_COMPACT_INTERVAL;
+  cfg.maxValue = TSDB_MAX_COMPACT_INTERVAL;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_SECOND;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "compactRatio";
+  cfg.ptr = &tsCompactRatio;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_COMPACT_RATIO;
+  cfg.maxValue = TSDB_MAX_COMPACT_RATIO;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_PERCENT;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "compactIoLimit";
+  cfg.ptr = &tsCompactIoLimit;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_COMPACT_IO_LIMIT;
+  cfg.maxValue = TSDB_MAX_COMPACT_IO_LIMIT;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_Mb;
+  taosInitConfigOption(cfg);
+
   cfg.option = "comp";
   cfg.ptr = &tsCompression;
   cfg.valType = TAOS_CFG_VTYPE_INT16;
@@ -703,6 +813,26 @@ static void doInitGlobalConfig() {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "walFlushWindow";
+  cfg.ptr = &tsWalFlushWindow;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_WAL_FLUSH_WINDOW;
+  cfg.maxValue = TSDB_MAX_WAL_FLUSH_WINDOW;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MS;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "walRestoreThreads";
+  cfg.ptr = &tsWalRestoreThreads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_WAL_RESTORE_THREADS;
+  cfg.maxValue = TSDB_MAX_WAL_RESTORE_THREADS;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "replica";
   cfg.ptr = &tsReplications;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -785,6 +915,16 @@ static void doInitGlobalConfig() {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "compressColData";
+  cfg.ptr = &tsCompressColData;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = -1;
+  cfg.maxValue = 100000000;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_BYTE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "maxSQLLength";
   cfg.ptr = &tsMaxSQLStringLen;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -245,6 +245,15 @@ public class TSDBJNIConnector {
 
     private native int fetchRowImp(long connection, long resultSet, TSDBResultSetRowData rowData);
 
+    /**
+     * Get the columns of one block, the buffers of which are valid until the next fetch
+     */
+    public int fetchBlock(long resultSet, TSDBResultSetBlockData blockData) {
+        return this.fetchBlockImp(this.taos, resultSet, blockData);
+    }
+
+    private native int fetchBlockImp(long connection, long resultSet, TSDBResultSetBlockData blockData);
+
     /**
      * Execute close operation from C to release connection pointer by JNI
      *
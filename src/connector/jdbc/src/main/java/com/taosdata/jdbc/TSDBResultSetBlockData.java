@@ -0,0 +1,116 @@
+/***************************************************************************
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+package com.taosdata.jdbc;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.Charset;
+import java.sql.Timestamp;
+
+/**
+ * The columns of one block of rows. The buffers are direct ones on the memory of the native result set, which are
+ * valid until the next fetch of the result set or the result set is freed.
+ */
+public class TSDBResultSetBlockData {
+	private static final Charset UCS4 = Charset.forName("UTF-32LE");
+
+	private int numOfRows = 0;
+	private ByteBuffer[] data = null;
+	private ByteBuffer[] nulls = null;
+	private ByteBuffer[] lengths = null;
+	private int[] bytes = null;
+
+	public TSDBResultSetBlockData(int colSize) {
+		this.data = new ByteBuffer[colSize];
+		this.nulls = new ByteBuffer[colSize];
+		this.lengths = new ByteBuffer[colSize];
+		this.bytes = new int[colSize];
+	}
+
+	public void setNumOfRows(int numOfRows) {
+		this.numOfRows = numOfRows;
+	}
+
+	public int getNumOfRows() {
+		return this.numOfRows;
+	}
+
+	public void setColumn(int col, ByteBuffer data, ByteBuffer nulls, ByteBuffer lengths) {
+		this.data[col] = data.order(ByteOrder.nativeOrder());
+		this.nulls[col] = nulls;
+		this.lengths[col] = (lengths == null) ? null : lengths.order(ByteOrder.nativeOrder());
+		this.bytes[col] = data.capacity() / this.numOfRows;
+	}
+
+	public ByteBuffer getColumnData(int col) {
+		return this.data[col];
+	}
+
+	public boolean wasNull(int col, int row) {
+		return (this.nulls[col].get(row >> 3) & (1 << (row & 7))) != 0;
+	}
+
+	public boolean getBoolean(int col, int row) {
+		return this.data[col].get(row) == 1;
+	}
+
+	public byte getByte(int col, int row) {
+		return this.data[col].get(row);
+	}
+
+	public short getShort(int col, int row) {
+		return this.data[col].getShort(row * 2);
+	}
+
+	public int getInt(int col, int row) {
+		return this.data[col].getInt(row * 4);
+	}
+
+	public long getLong(int col, int row) {
+		return this.data[col].getLong(row * 8);
+	}
+
+	public float getFloat(int col, int row) {
+		return this.data[col].getFloat(row * 4);
+	}
+
+	public double getDouble(int col, int row) {
+		return this.data[col].getDouble(row * 8);
+	}
+
+	public Timestamp getTimestamp(int col, int row) {
+		return new Timestamp(getLong(col, row));
+	}
+
+	/**
+	 * The content of a BINARY or NCHAR value, it is in UCS-4 for NCHAR
+	 */
+	public byte[] getBytes(int col, int row) {
+		byte[] value = new byte[this.lengths[col].getInt(row * 4)];
+
+		ByteBuffer buf = this.data[col].duplicate();
+		buf.position(row * this.bytes[col] + 2);
+		buf.get(value);
+		return value;
+	}
+
+	public String getString(int col, int row, int srcType) {
+		if (srcType == TSDBConstants.TSDB_DATA_TYPE_NCHAR) {
+			return new String(getBytes(col, row), UCS4);
+		} else {
+			return new String(getBytes(col, row));
+		}
+	}
+}
@@ -23,6 +23,7 @@ extern "C" {
 int32_t dnodeInitVnodeWrite();
 void    dnodeCleanupVnodeWrite();
 void    dnodeDispatchToVnodeWriteQueue(SRpcMsg *pMsg);
+void    dnodeLogVnodeWriteStatis(bool closing);
 
 #ifdef __cplusplus
 }
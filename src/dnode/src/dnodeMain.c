@@ -17,6 +17,7 @@
 #include "os.h"
 #include "taos.h"
 #include "tutil.h"
+#include "tscompression.h"
 #include "tconfig.h"
 #include "tglobal.h"
 #include "dnode.h"
@@ -91,6 +92,7 @@ int32_t dnodeInitSystem() {
   tscEmbedded  = 1;
   taosBlockSIGPIPE();
   taosResolveCRC();
+  taosResolveDecompress(TAOS_SIMD_AVX2);
   taosInitGlobalCfg();
   taosReadGlobalLogCfg();
   taosSetCoreDump();
@@ -599,6 +599,8 @@ static void dnodeSendStatusMsg(void *handle, void *tmrId) {
     return;
   }
 
+  dnodeLogVnodeWriteStatis(false);
+
   int32_t contLen = sizeof(SDMStatusMsg) + TSDB_MAX_VNODES * sizeof(SVnodeLoad);
   SDMStatusMsg *pStatus = rpcMallocCont(contLen);
   if (pStatus == NULL) {
@@ -44,9 +44,16 @@ static void  dnodeHandleIdleReadWorker(SReadWorker *);
 // module global variable
 static SReadWorkerPool readPool;
 static taos_qset       readQset;
+static taos_queue      readBatchQueue;  // queries yielded after their time slice, read after the queries of vnodes
 
 int32_t dnodeInitVnodeRead() {
   readQset = taosOpenQset();
+  if (readQset == NULL) return -1;
+
+  readBatchQueue = taosOpenQueue();
+  if (readBatchQueue == NULL) return -1;
+  taosSetQueueLowPriority(readBatchQueue);
+  taosAddIntoQset(readQset, readBatchQueue, NULL);
 
   readPool.min = 2;
   readPool.max = tsNumOfCores * tsNumOfThreadsPerCore;
@@ -79,6 +86,7 @@ void dnodeCleanupVnodeRead() {
   }
 
   free(readPool.readWorker);
+  taosCloseQueue(readBatchQueue);
   taosCloseQset(readQset);
 
   dPrint("dnode read is closed");
@@ -181,9 +189,27 @@ static void dnodeContinueExecuteQuery(void* pVnode, void* qhandle, SReadMsg *pMs
   taosWriteQitem(queue, TAOS_QTYPE_RPC, pRead);
 }
 
+// the query used up its time slice, it goes on as a batch query behind the queries waiting in the vnode queues
+static void dnodeYieldExecuteQuery(void* pVnode, void* qhandle, SReadMsg *pMsg) {
+  SReadMsg *pRead = (SReadMsg *)taosAllocateQitem(sizeof(SReadMsg));
+  pRead->rpcMsg      = pMsg->rpcMsg;
+  pRead->pCont       = qhandle;
+  pRead->contLen     = 0;
+  pRead->pVnode      = pVnode;
+  pRead->rspRet.rsp  = pMsg->rspRet.rsp;  // response of the query msg, if it is not sent yet
+  pRead->rspRet.len  = pMsg->rspRet.len;
+
+  taosWriteQitem(readBatchQueue, TAOS_QTYPE_RPC, pRead);
+}
+
 void dnodeSendRpcReadRsp(void *pVnode, SReadMsg *pRead, int32_t code) {
   if (code == TSDB_CODE_VND_ACTION_IN_PROGRESS) return;
   if (code == TSDB_CODE_VND_ACTION_NEED_REPROCESSED) {
+    if (pRead->rpcMsg.msgType == TSDB_MSG_TYPE_QUERY) {
+      dnodeYieldExecuteQuery(pVnode, pRead->rspRet.qhandle, pRead);
+      return;
+    }
+
     dnodeContinueExecuteQuery(pVnode, pRead->rspRet.qhandle, pRead);
     code = TSDB_CODE_SUCCESS;
   }
@@ -210,6 +236,8 @@ static void *dnodeProcessReadQueue(void *param) {
       break;
     }
 
+    if (pVnode == NULL) pVnode = pReadMsg->pVnode;
+
     dTrace("%p, msg:%s will be processed in vread queue", pReadMsg->rpcMsg.ahandle, taosMsg[pReadMsg->rpcMsg.msgType]);
     int32_t code = vnodeProcessRead(pVnode, pReadMsg);
     dnodeSendRpcReadRsp(pVnode, pReadMsg, code);
@@ -18,12 +18,14 @@
 #include "taosmsg.h"
 #include "taoserror.h"
 #include "tutil.h"
+#include "ttime.h"
 #include "tqueue.h"
 #include "trpc.h"
 #include "tsdb.h"
 #include "twal.h"
 #include "tdataformat.h"
 #include "tglobal.h"
+#include "dnode.h"
 #include "vnode.h"
 #include "dnodeInt.h"
 #include "dnodeVWrite.h"
@@ -31,11 +33,29 @@
 
 typedef struct {
   taos_qall  qall;
-  taos_qset  qset;      // queue set
-  pthread_t  thread;    // thread
-  int32_t    workerId;  // worker ID
+  pthread_t  thread;      // thread
+  int32_t    workerId;    // worker ID
+  taos_qset  flushQset;   // batches waiting for the WAL flush
+  taos_queue flushQueue;
+  taos_qall  flushQall;
+  pthread_t  flushThread; // flushes the WAL and responds for the batches
+  SVWriteWorkerStatis statis;
 } SWriteWorker;
 
+typedef struct {
+  int32_t  type;
+  void    *item;
+} SWriteItem;
+
+typedef struct SWriteBatch {
+  struct SWriteBatch *next;
+  void      *pVnode;
+  int64_t    stime;      // us when the batch is handed to the flusher
+  int32_t    code;       // result of the WAL flush
+  int32_t    numOfMsgs;
+  SWriteItem items[];
+} SWriteBatch;
+
 typedef struct {
   SRspRet  rspRet;
   void    *pCont;
@@ -43,21 +63,40 @@ typedef struct {
   SRpcMsg  rpcMsg;
 } SWriteMsg;
 
+/*
+ * The write queues of all the vnodes are in one queue set. A worker claims a vnode queue with the messages
+ * in it and gives up the claim once they are written, so the messages of a vnode are written in order and
+ * by one worker at a time, while an idle worker takes over the vnodes queued behind a busy one.
+ */
 typedef struct {
   int32_t        max;        // max number of workers
-  int32_t        nextId;     // from 0 to max-1, cyclic
+  int32_t        num;        // number of launched workers
+  int8_t         stop;
+  int64_t        startTime;  // us when the pool is opened, for the utilization of the workers
+  taos_qset      qset;       // write queues of all the vnodes
   SWriteWorker  *writeWorker;
 } SWriteWorkerPool;
 
 static void *dnodeProcessWriteQueue(void *param);
-static void  dnodeHandleIdleWorker(SWriteWorker *pWorker);
+static void *dnodeFlushWriteQueue(void *param);
+static int32_t dnodeOpenWriteFlusher(SWriteWorker *pWorker);
+static void  dnodeCloseWriteFlusher(SWriteWorker *pWorker);
+static int32_t dnodeLaunchWriteWorker(SWriteWorker *pWorker);
+static void  dnodeUpdateWriteStatis(SWriteWorker *pWorker, int32_t numOfMsgs, int64_t stime);
 
 SWriteWorkerPool wWorkerPool;
 
 int32_t dnodeInitVnodeWrite() {
   wWorkerPool.max = tsNumOfCores;
+  wWorkerPool.startTime = taosGetTimestampUs();
+  wWorkerPool.qset = taosOpenQset();
+  if (wWorkerPool.qset == NULL) return -1;
+
   wWorkerPool.writeWorker = (SWriteWorker *)calloc(sizeof(SWriteWorker), wWorkerPool.max);
-  if (wWorkerPool.writeWorker == NULL) return -1;
+  if (wWorkerPool.writeWorker == NULL) {
+    taosCloseQset(wWorkerPool.qset);
+    return -1;
+  }
 
   for (int32_t i = 0; i < wWorkerPool.max; ++i) {
     wWorkerPool.writeWorker[i].workerId = i;
@@ -68,22 +107,20 @@ int32_t dnodeInitVnodeWrite() {
 }
 
 void dnodeCleanupVnodeWrite() {
-  for (int32_t i = 0; i < wWorkerPool.max; ++i) {
-    SWriteWorker *pWorker =  wWorkerPool.writeWorker + i;
-    if (pWorker->thread) {
-      taosQsetThreadResume(pWorker->qset);
-    }
+  wWorkerPool.stop = 1;
+  for (int32_t i = 0; i < wWorkerPool.num; ++i) {
+    taosQsetThreadResume(wWorkerPool.qset);
   }
   
-  for (int32_t i = 0; i < wWorkerPool.max; ++i) {
+  for (int32_t i = 0; i < wWorkerPool.num; ++i) {
     SWriteWorker *pWorker =  wWorkerPool.writeWorker + i;
-    if (pWorker->thread) {
-      pthread_join(pWorker->thread, NULL);
-      taosFreeQall(pWorker->qall);
-      taosCloseQset(pWorker->qset);
-    }
+    pthread_join(pWorker->thread, NULL);
+    taosFreeQall(pWorker->qall);
+    dnodeCloseWriteFlusher(pWorker);
   }
 
+  dnodeLogVnodeWriteStatis(true);
+  taosCloseQset(wWorkerPool.qset);
   free(wWorkerPool.writeWorker);
   dPrint("dnode write is closed");
 }
@@ -123,50 +160,55 @@ void dnodeDispatchToVnodeWriteQueue(SRpcMsg *pMsg) {
 }
 
 void *dnodeAllocateVnodeWqueue(void *pVnode) {
-  SWriteWorker *pWorker = wWorkerPool.writeWorker + wWorkerPool.nextId;
   void *queue = taosOpenQueue();
   if (queue == NULL) return NULL;
 
-  if (pWorker->qset == NULL) {
-    pWorker->qset = taosOpenQset();
-    if (pWorker->qset == NULL) {
-      taosCloseQueue(queue);
-      return NULL;
-    }
-
-    taosAddIntoQset(pWorker->qset, queue, pVnode);
-    pWorker->qall = taosAllocateQall();
-    if (pWorker->qall == NULL) {
-      taosCloseQset(pWorker->qset);
+  // one more worker for each vnode, up to the number of cores
+  if (wWorkerPool.num < wWorkerPool.max) {
+    SWriteWorker *pWorker = wWorkerPool.writeWorker + wWorkerPool.num;
+    if (dnodeLaunchWriteWorker(pWorker) == 0) {
+      wWorkerPool.num++;
+    } else if (wWorkerPool.num == 0) {
       taosCloseQueue(queue);
       return NULL;
     }
-    pthread_attr_t thAttr;
-    pthread_attr_init(&thAttr);
-    pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
-
-    if (pthread_create(&pWorker->thread, &thAttr, dnodeProcessWriteQueue, pWorker) != 0) {
-      dError("failed to create thread to process read queue, reason:%s", strerror(errno));
-      taosFreeQall(pWorker->qall);
-      taosCloseQset(pWorker->qset);
-      taosCloseQueue(queue);
-      queue = NULL;
-    } else {
-      dTrace("write worker:%d is launched", pWorker->workerId);
-      wWorkerPool.nextId = (wWorkerPool.nextId + 1) % wWorkerPool.max;
-    }
-
-    pthread_attr_destroy(&thAttr);
-  } else {
-    taosAddIntoQset(pWorker->qset, queue, pVnode);
-    wWorkerPool.nextId = (wWorkerPool.nextId + 1) % wWorkerPool.max;
   }
 
+  taosAddIntoQset(wWorkerPool.qset, queue, pVnode);
   dTrace("pVnode:%p, write queue:%p is allocated", pVnode, queue);
 
   return queue;
 }
 
+static int32_t dnodeLaunchWriteWorker(SWriteWorker *pWorker) {
+  pWorker->qall = taosAllocateQall();
+  if (pWorker->qall == NULL) return -1;
+
+  if (dnodeOpenWriteFlusher(pWorker) < 0) {
+    taosFreeQall(pWorker->qall);
+    pWorker->qall = NULL;
+    return -1;
+  }
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  int32_t code = pthread_create(&pWorker->thread, &thAttr, dnodeProcessWriteQueue, pWorker);
+  pthread_attr_destroy(&thAttr);
+
+  if (code != 0) {
+    dError("failed to create thread to process write queue, reason:%s", strerror(errno));
+    dnodeCloseWriteFlusher(pWorker);
+    taosFreeQall(pWorker->qall);
+    pWorker->qall = NULL;
+    return -1;
+  }
+
+  dTrace("write worker:%d is launched", pWorker->workerId);
+  return 0;
+}
+
 void dnodeFreeVnodeWqueue(void *wqueue) {
   taosCloseQueue(wqueue);
 
@@ -192,6 +234,35 @@ void dnodeSendRpcVnodeWriteRsp(void *pVnode, void *param, int32_t code) {
   vnodeRelease(pVnode);
 }
 
+// write out the client messages [start, end) of the batch appended into the WAL, then process them
+static void dnodeApplyWriteMsgs(void *pVnode, SWriteBatch *pBatch, int32_t start, int32_t end) {
+  if (start >= end) return;
+
+  int32_t code = walWriteOut(vnodeGetWal(pVnode));
+
+  for (int32_t i = start; i < end; ++i) {
+    SWriteMsg *pWrite = (SWriteMsg *)pBatch->items[i].item;
+    SWalHead  *pHead = (SWalHead *)(pWrite->pCont - sizeof(SWalHead));
+
+    if (pWrite->rpcMsg.code > 0) {
+      pWrite->rpcMsg.code = 0;  // it is already written
+    } else if (pWrite->rpcMsg.code == 0) {
+      pWrite->rpcMsg.code = (code != 0) ? code : vnodeApplyWrite(pVnode, TAOS_QTYPE_RPC, pHead, pWrite);
+    }
+  }
+}
+
+static void dnodeFinishWriteMsg(void *pVnode, int type, void *item, int32_t flushCode) {
+  if (type == TAOS_QTYPE_RPC) {
+    SWriteMsg *pWrite = (SWriteMsg *)item;
+    if (flushCode != 0 && pWrite->rpcMsg.code == 0) pWrite->rpcMsg.code = flushCode;
+    dnodeSendRpcVnodeWriteRsp(pVnode, item, pWrite->rpcMsg.code);
+  } else {
+    taosFreeQitem(item);
+    vnodeRelease(pVnode);
+  }
+}
+
 static void *dnodeProcessWriteQueue(void *param) {
   SWriteWorker *pWorker = (SWriteWorker *)param;
   SWriteMsg    *pWrite;
@@ -199,14 +270,23 @@ static void *dnodeProcessWriteQueue(void *param) {
   int32_t       numOfMsgs;
   int           type;
   void         *pVnode, *item;
+  taos_queue    queue;
 
   while (1) {
-    numOfMsgs = taosReadAllQitemsFromQset(pWorker->qset, pWorker->qall, &pVnode);
+    numOfMsgs = taosClaimAllQitemsFromQset(wWorkerPool.qset, pWorker->qall, &pVnode, &queue);
     if (numOfMsgs == 0) {
+      if (!wWorkerPool.stop) continue;
       dTrace("dnodeProcessWriteQueee: got no message from qset, exiting...");
       break;
     }
 
+    int64_t stime = taosGetTimestampUs();
+
+    // the client messages are appended into the WAL without being copied, and written out with one writev before
+    // they are processed, since processing changes them in place. A message of another type ends the run of them.
+    SWriteBatch *pBatch = taosAllocateQitem(sizeof(SWriteBatch) + sizeof(SWriteItem) * numOfMsgs);
+    int32_t      start = 0;  // the first message appended but not processed yet
+
     for (int32_t i = 0; i < numOfMsgs; ++i) {
       pWrite = NULL;
       taosGetQitem(pWorker->qall, &type, &item);
@@ -221,41 +301,190 @@ static void *dnodeProcessWriteQueue(void *param) {
         pHead = (SWalHead *)item;
       }
 
-      int32_t code = vnodeProcessWrite(pVnode, type, pHead, item);
-      if (pWrite) pWrite->rpcMsg.code = code;
+      if (pBatch == NULL) {
+        int32_t code = vnodeProcessWrite(pVnode, type, pHead, item);
+        if (pWrite) pWrite->rpcMsg.code = code;
+        continue;
+      }
+
+      pBatch->items[i].type = type;
+      pBatch->items[i].item = item;
+
+      if (pWrite) {
+        pWrite->rpcMsg.code = vnodeAppendWrite(pVnode, pHead);
+        continue;
+      }
+
+      dnodeApplyWriteMsgs(pVnode, pBatch, start, i);
+      start = i + 1;
+      vnodeProcessWrite(pVnode, type, pHead, item);
     }
 
-    walFsync(vnodeGetWal(pVnode));
+    if (pBatch) dnodeApplyWriteMsgs(pVnode, pBatch, start, numOfMsgs);
 
-    // browse all items, and process them one by one
-    taosResetQitems(pWorker->qall);
-    for (int32_t i = 0; i < numOfMsgs; ++i) {
-      taosGetQitem(pWorker->qall, &type, &item);
-      if (type == TAOS_QTYPE_RPC) {
-        pWrite = (SWriteMsg *)item;
-        dnodeSendRpcVnodeWriteRsp(pVnode, item, pWrite->rpcMsg.code); 
-      } else {
-        taosFreeQitem(item);
-        vnodeRelease(pVnode);
+    // the messages are written to the vnode, another worker may take its next batch
+    taosReleaseQueueClaim(wWorkerPool.qset, queue);
+    dnodeUpdateWriteStatis(pWorker, numOfMsgs, stime);
+
+    // the messages are in the WAL file, the flusher syncs it with the batches of other vnodes and responds, so
+    // this worker goes on with the next batch while the WAL is synced
+    if (pBatch == NULL) {
+      taosResetQitems(pWorker->qall);
+      int32_t code = walFsync(vnodeGetWal(pVnode));
+      for (int32_t i = 0; i < numOfMsgs; ++i) {
+        taosGetQitem(pWorker->qall, &type, &item);
+        dnodeFinishWriteMsg(pVnode, type, item, code);
       }
+      continue;
     }
+
+    pBatch->pVnode = pVnode;
+    pBatch->stime = taosGetTimestampUs();
+    pBatch->code = 0;
+    pBatch->numOfMsgs = numOfMsgs;
+
+    taosWriteQitem(pWorker->flushQueue, TAOS_QTYPE_RPC, pBatch);
   }
 
   return NULL;
 }
 
-UNUSED_FUNC
-static void dnodeHandleIdleWorker(SWriteWorker *pWorker) {
-  int32_t num = taosGetQueueNumber(pWorker->qset);
+static void *dnodeFlushWriteQueue(void *param) {
+  SWriteWorker *pWorker = (SWriteWorker *)param;
+  SWriteBatch  *pHead, *pTail, *pBatch;
+  int32_t       num;
+  int           type;
+  void         *ahandle, *item;
 
-  if (num > 0) {
-     usleep(30000);
-     sched_yield();
-  } else {
-     taosFreeQall(pWorker->qall);
-     taosCloseQset(pWorker->qset);
-     pWorker->qset = NULL;
-     dTrace("write worker:%d is released", pWorker->workerId);
-     pthread_exit(NULL);
+  while (1) {
+    pHead = pTail = NULL;
+    num = taosReadAllQitemsFromQset(pWorker->flushQset, pWorker->flushQall, &ahandle);
+    if (num == 0) {
+      dTrace("dnodeFlushWriteQueue: got no batch from qset, exiting...");
+      break;
+    }
+
+    for (int32_t round = 0; num > 0; ++round) {
+      for (int32_t i = 0; i < num; ++i) {
+        taosGetQitem(pWorker->flushQall, &type, &item);
+        pBatch = (SWriteBatch *)item;
+        pBatch->next = NULL;
+        if (pTail) {
+          pTail->next = pBatch;
+        } else {
+          pHead = pBatch;
+        }
+        pTail = pBatch;
+      }
+
+      // wait till the window of the first batch closes, then take all the batches arrived in the meantime
+      num = 0;
+      if (round == 0 && tsWalFlushWindow > 0) {
+        int64_t wait = pHead->stime + tsWalFlushWindow * 1000 - taosGetTimestampUs();
+        if (wait > 0) usleep(wait);
+        if (taosGetQsetItemsNumber(pWorker->flushQset) > 0) {
+          num = taosReadAllQitemsFromQset(pWorker->flushQset, pWorker->flushQall, &ahandle);
+        }
+      }
+    }
+
+    // one flush for each vnode, however many batches it has
+    for (pBatch = pHead; pBatch; pBatch = pBatch->next) {
+      SWriteBatch *pPrev = pHead;
+      while (pPrev != pBatch && pPrev->pVnode != pBatch->pVnode) pPrev = pPrev->next;
+      pBatch->code = (pPrev != pBatch) ? pPrev->code : walFsync(vnodeGetWal(pBatch->pVnode));
+    }
+
+    while (pHead) {
+      pBatch = pHead;
+      pHead = pHead->next;
+      for (int32_t k = 0; k < pBatch->numOfMsgs; ++k) {
+        dnodeFinishWriteMsg(pBatch->pVnode, pBatch->items[k].type, pBatch->items[k].item, pBatch->code);
+      }
+      taosFreeQitem(pBatch);
+    }
+  }
+
+  return NULL;
+}
+
+static int32_t dnodeOpenWriteFlusher(SWriteWorker *pWorker) {
+  pWorker->flushQset = taosOpenQset();
+  pWorker->flushQueue = taosOpenQueue();
+  pWorker->flushQall = taosAllocateQall();
+  if (pWorker->flushQset == NULL || pWorker->flushQueue == NULL || pWorker->flushQall == NULL) {
+    dnodeCloseWriteFlusher(pWorker);
+    return -1;
   }
+
+  taosAddIntoQset(pWorker->flushQset, pWorker->flushQueue, NULL);
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  int32_t code = pthread_create(&pWorker->flushThread, &thAttr, dnodeFlushWriteQueue, pWorker);
+  pthread_attr_destroy(&thAttr);
+
+  if (code != 0) {
+    dError("failed to create thread to flush write queue, reason:%s", strerror(errno));
+    pWorker->flushThread = 0;
+    dnodeCloseWriteFlusher(pWorker);
+    return -1;
+  }
+
+  return 0;
+}
+
+static void dnodeCloseWriteFlusher(SWriteWorker *pWorker) {
+  if (pWorker->flushThread) {
+    taosQsetThreadResume(pWorker->flushQset);
+    pthread_join(pWorker->flushThread, NULL);
+    pWorker->flushThread = 0;
+  }
+
+  taosCloseQueue(pWorker->flushQueue);
+  taosCloseQset(pWorker->flushQset);
+  taosFreeQall(pWorker->flushQall);
+  pWorker->flushQueue = NULL;
+  pWorker->flushQset = NULL;
+  pWorker->flushQall = NULL;
+}
+
+static void dnodeUpdateWriteStatis(SWriteWorker *pWorker, int32_t numOfMsgs, int64_t stime) {
+  SVWriteWorkerStatis *pStatis = &pWorker->statis;
+
+  pStatis->batches++;
+  pStatis->msgs += numOfMsgs;
+  if (numOfMsgs > pStatis->maxBatch) pStatis->maxBatch = numOfMsgs;
+  pStatis->busyTime += taosGetTimestampUs() - stime;
+}
+
+int32_t dnodeGetVnodeWriteStatis(SVWriteWorkerStatis *pStatis, int32_t maxWorkers, int32_t *queueDepth) {
+  int32_t num = MIN(wWorkerPool.num, maxWorkers);
+  for (int32_t i = 0; i < num; ++i) {
+    pStatis[i] = wWorkerPool.writeWorker[i].statis;
+  }
+
+  *queueDepth = taosGetQsetItemsNumber(wWorkerPool.qset);
+  return num;
+}
+
+void dnodeLogVnodeWriteStatis(bool closing) {
+  int64_t elapsed = taosGetTimestampUs() - wWorkerPool.startTime;
+  if (elapsed <= 0) return;
+
+  for (int32_t i = 0; i < wWorkerPool.num; ++i) {
+    SVWriteWorkerStatis *pStatis = &wWorkerPool.writeWorker[i].statis;
+    char                 info[128];
+    snprintf(info, sizeof(info), "utilization:%.2f%% batches:%" PRId64 " msgs:%" PRId64 " maxBatch:%d",
+             pStatis->busyTime * 100.0 / elapsed, pStatis->batches, pStatis->msgs, pStatis->maxBatch);
+    if (closing) {
+      dPrint("write worker:%d, %s", i, info);
+    } else {
+      dTrace("write worker:%d, %s", i, info);
+    }
+  }
+
+  dTrace("write workers:%d, queued msgs:%d", wWorkerPool.num, taosGetQsetItemsNumber(wWorkerPool.qset));
 }
@@ -26,8 +26,17 @@ typedef struct {
   int32_t queryReqNum;
   int32_t submitReqNum;
   int32_t httpReqNum;
+  int64_t blockCacheHits;
+  int64_t blockCacheMisses;
 } SDnodeStatisInfo;
 
+typedef struct {
+  int64_t busyTime;  // us spent writing the batches
+  int64_t batches;   // number of vnode batches written
+  int64_t msgs;
+  int32_t maxBatch;  // messages of the largest batch
+} SVWriteWorkerStatis;
+
 typedef enum {
   TSDB_DNODE_RUN_STATUS_INITIALIZE,
   TSDB_DNODE_RUN_STATUS_RUNING,
@@ -36,6 +45,7 @@ typedef enum {
 
 SDnodeRunStatus dnodeGetRunStatus();
 SDnodeStatisInfo dnodeGetStatisInfo();
+int32_t dnodeGetVnodeWriteStatis(SVWriteWorkerStatis *pStatis, int32_t maxWorkers, int32_t *queueDepth);
 
 bool    dnodeIsFirstDeploy();
 char *  dnodeGetMnodeMasterEp();
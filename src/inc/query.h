@@ -43,9 +43,16 @@ void qDestroyQueryInfo(qinfo_t qinfo);
  * which are decided according to the tag or table name query conditions
  *
  * @param qinfo
- * @return
+ * @param timeSlice ms the execution may take before it yields, 0 to run until the results are ready
+ * @param numOfThreads threads to scan the tables of a super table aggregation, 0 or 1 to scan them in the caller
+ * @return true if the execution yields, and the query needs to be executed again to produce the results
+ */
+bool qTableQuery(qinfo_t qinfo, int32_t timeSlice, int32_t numOfThreads);
+
+/**
+ * Stop the threads shared by the parallel table scans, they are created again by the next parallel scan
  */
-void qTableQuery(qinfo_t qinfo);
+void qCleanupScanThreads();
 
 /**
  * Retrieve the produced results information, if current query is not paused or completed,
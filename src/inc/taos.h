@@ -58,6 +58,18 @@ typedef struct taosField {
   short    bytes;
 } TAOS_FIELD;
 
+/*
+ * A column of the rows fetched in a block. The values are kept one after another, bytes each, as they are retrieved,
+ * and a BINARY or NCHAR value is the 2 bytes length followed by the content, which is in UCS-4 for NCHAR.
+ */
+typedef struct taosColumn {
+  uint8_t  type;
+  short    bytes;       // width of a value in data
+  char    *data;
+  uint8_t *nullBitmap;  // bit (row % 8) of byte (row / 8) is set if the value of the row is NULL
+  int     *length;      // length of the content of each BINARY or NCHAR value, NULL for the other types
+} TAOS_COLUMN;
+
 #ifdef _TD_GO_DLL_
   #define DLL_EXPORT    __declspec(dllexport)
 #else
@@ -80,9 +92,28 @@ typedef struct TAOS_BIND {
   int *          error;        // unused
 } TAOS_BIND;
 
+// the values of one parameter of many rows, for binding the rows a column at a time
+typedef struct TAOS_MULTI_BIND {
+  int       buffer_type;
+  void *    buffer;         // num values, value i is at buffer + i * buffer_length
+  uintptr_t buffer_length;  // width of each value in buffer
+  int32_t * length;         // length of each BINARY or NCHAR value
+  char *    is_null;        // value i is NULL if is_null[i] is not 0, NULL if there is no NULL value
+  int       num;            // number of rows
+} TAOS_MULTI_BIND;
+
 TAOS_STMT *taos_stmt_init(TAOS *taos);
 int        taos_stmt_prepare(TAOS_STMT *stmt, const char *sql, unsigned long length);
+
+// for "insert into ? [using stable tags(?, ...)] values(?, ...)", set the table the following rows are bound to,
+// the table is created from the super table with the tags if it does not exist.
+int        taos_stmt_set_tbname(TAOS_STMT *stmt, const char *name);
+int        taos_stmt_set_tbname_tags(TAOS_STMT *stmt, const char *name, TAOS_BIND *tags);
+
 int        taos_stmt_bind_param(TAOS_STMT *stmt, TAOS_BIND *bind);
+
+// bind the rows of all the value parameters of the table set, a column per element of bind
+int        taos_stmt_bind_param_batch(TAOS_STMT *stmt, TAOS_MULTI_BIND *bind);
 int        taos_stmt_add_batch(TAOS_STMT *stmt);
 int        taos_stmt_execute(TAOS_STMT *stmt);
 TAOS_RES * taos_stmt_use_result(TAOS_STMT *stmt);
@@ -101,6 +132,9 @@ DLL_EXPORT int taos_print_row(char *str, TAOS_ROW row, TAOS_FIELD *fields, int n
 DLL_EXPORT void taos_stop_query(TAOS_RES *res);
 
 int taos_fetch_block(TAOS_RES *res, TAOS_ROW *rows);
+
+// the columns of the next block of rows, valid until the next fetch, -1 for the join queries which are fetched by rows
+DLL_EXPORT int taos_fetch_block_columns(TAOS_RES *res, TAOS_COLUMN **columns);
 int taos_validate_sql(TAOS *taos, const char *sql);
 
 int* taos_fetch_lengths(TAOS_RES *res);
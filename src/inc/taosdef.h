@@ -266,6 +266,10 @@ void tsDataSwap(void *pLeft, void *pRight, int32_t type, int32_t size);
 #define TSDB_MAX_TOTAL_BLOCKS           10000
 #define TSDB_DEFAULT_TOTAL_BLOCKS       4
 
+#define TSDB_MIN_BLOCK_CACHE_SIZE       0       // 0 means no cache of decompressed file blocks
+#define TSDB_MAX_BLOCK_CACHE_SIZE       4096    // 4GB for each vnode
+#define TSDB_DEFAULT_BLOCK_CACHE_SIZE   16
+
 #define TSDB_MIN_TABLES                 4
 #define TSDB_MAX_TABLES                 200000
 #define TSDB_DEFAULT_TABLES             1000
@@ -290,6 +294,26 @@ void tsDataSwap(void *pLeft, void *pRight, int32_t type, int32_t size);
 #define TSDB_MAX_COMMIT_TIME            40960
 #define TSDB_DEFAULT_COMMIT_TIME        3600
 
+#define TSDB_MIN_COMMIT_THREADS         1
+#define TSDB_MAX_COMMIT_THREADS         16
+#define TSDB_DEFAULT_COMMIT_THREADS     1       // file groups are committed one by one
+
+#define TSDB_MIN_COMPACT_INTERVAL       0       // 0 means no background compaction of the file groups
+#define TSDB_MAX_COMPACT_INTERVAL       86400   // 1 day
+#define TSDB_DEFAULT_COMPACT_INTERVAL   600
+
+#define TSDB_MIN_COMPACT_RATIO          1       // percent of sub-blocks or garbage to compact a file group
+#define TSDB_MAX_COMPACT_RATIO          100
+#define TSDB_DEFAULT_COMPACT_RATIO      20
+
+#define TSDB_MIN_COMPACT_IO_LIMIT       0       // 0 means no limit on the compaction I/O
+#define TSDB_MAX_COMPACT_IO_LIMIT       1024    // MB per second
+#define TSDB_DEFAULT_COMPACT_IO_LIMIT   32
+
+#define TSDB_MEM_TABLE_SKIPLIST         0       // every row is put into the skiplist of the table
+#define TSDB_MEM_TABLE_APPEND           1       // in-order rows are appended to the row buffer of the table
+#define TSDB_DEFAULT_MEM_TABLE_TYPE     TSDB_MEM_TABLE_APPEND
+
 #define TSDB_MIN_PRECISION              TSDB_TIME_PRECISION_MILLI
 #define TSDB_MAX_PRECISION              TSDB_TIME_PRECISION_NANO
 #define TSDB_DEFAULT_PRECISION          TSDB_TIME_PRECISION_MILLI
@@ -302,6 +326,26 @@ void tsDataSwap(void *pLeft, void *pRight, int32_t type, int32_t size);
 #define TSDB_MAX_WAL_LEVEL              2
 #define TSDB_DEFAULT_WAL_LEVEL          1
 
+#define TSDB_MIN_WAL_FLUSH_WINDOW       0       // ms to collect more writes into one WAL flush, 0 to flush at once
+#define TSDB_MAX_WAL_FLUSH_WINDOW       100
+#define TSDB_DEFAULT_WAL_FLUSH_WINDOW   0
+
+#define TSDB_MIN_WAL_RESTORE_THREADS    0       // 0 means the WAL is restored through the write queue of the vnode
+#define TSDB_MAX_WAL_RESTORE_THREADS    64
+#define TSDB_DEFAULT_WAL_RESTORE_THREADS 0
+
+#define TSDB_MIN_QUERY_TIME_SLICE       0       // ms a query runs before it yields to the others, 0 for no limit
+#define TSDB_MAX_QUERY_TIME_SLICE       10000
+#define TSDB_DEFAULT_QUERY_TIME_SLICE   100
+
+#define TSDB_MIN_PARALLEL_QUERY_THREADS 0       // threads scanning the tables of a super table query, 0 or 1 for serial
+#define TSDB_MAX_PARALLEL_QUERY_THREADS 64
+#define TSDB_DEFAULT_PARALLEL_QUERY_THREADS 0
+
+#define TSDB_MIN_TAG_INDEX_COLUMNS      1       // leading tags of each super table indexed, the first one always is
+#define TSDB_MAX_TAG_INDEX_COLUMNS      TSDB_MAX_TAGS
+#define TSDB_DEFAULT_TAG_INDEX_COLUMNS  1
+
 #define TSDB_MIN_REPLICA_NUM            1
 #define TSDB_MAX_REPLICA_NUM            3
 #define TSDB_DEFAULT_REPLICA_NUM        1
@@ -465,6 +465,7 @@ typedef struct {
   int32_t     tsNumOfBlocks;  // ts comp block numbers
   int32_t     tsOrder;        // ts comp block order
   int32_t     numOfTags;      // number of tags columns involved
+  int32_t     compressColData;  // result columns larger than it are encoded by the codec of the type, -1 for none
   SColumnInfo colList[];
 } SQueryTableMsg;
 
@@ -481,13 +482,22 @@ typedef struct {
 
 typedef struct SRetrieveTableRsp {
   int32_t numOfRows;
-  int8_t  completed;  // all results are returned to client
+  int8_t  completed;   // all results are returned to client
+  int8_t  compressed;  // data is the number of columns followed by the SRetrieveColumn of each column
   int16_t precision;
   int64_t offset;  // updated offset value for multi-vnode projection query
   int64_t useconds;
   char    data[];
 } SRetrieveTableRsp;
 
+typedef struct SRetrieveColumn {
+  int8_t  type;
+  int8_t  comp;   // NO_COMPRESSION or ONE_STAGE_COMP
+  int16_t bytes;
+  int32_t len;    // length of the encoded values
+  char    data[];
+} SRetrieveColumn;
+
 typedef struct {
   int32_t vgId;
   int32_t cfgVersion;
@@ -72,6 +72,19 @@ typedef struct {
   int64_t pointsWritten;  // total data points written
 } STsdbStat;
 
+// --------- TSDB FILE GROUP COMPACTION STATISTICS
+typedef struct {
+  int32_t fid;               // file group being compacted, -1 if the compactor is idle
+  int32_t numOfTables;       // tables to rewrite in the file group being compacted
+  int32_t tablesDone;        // tables rewritten in the file group being compacted
+  int64_t numOfCompactions;  // file groups compacted
+  int64_t numOfAborts;       // compactions given up since the file group is changed by a commit
+  int64_t bytesRead;
+  int64_t bytesWritten;
+  int64_t bytesReclaimed;    // disk space freed by the compactions
+  int64_t subBlocksMerged;   // sub-blocks merged into super blocks
+} STsdbCompactStat;
+
 typedef void TsdbRepoT;  // use void to hide implementation details from outside
 
 void      tsdbSetDefaultCfg(STsdbCfg *pCfg);
@@ -158,6 +171,33 @@ STableInfo *tsdbGetTableInfo(TsdbRepoT *pRepo, STableId tid);
  */
 int32_t tsdbInsertData(TsdbRepoT *repo, SSubmitMsg *pMsg, SShellSubmitRspMsg * pRsp) ;
 
+// SSubmitMsg Iterator, the fields of the message and its blocks are converted to host byte order on the way
+typedef struct {
+  int32_t     totalLen;
+  int32_t     len;
+  SSubmitBlk *pBlock;
+} SSubmitMsgIter;
+
+int         tsdbInitSubmitMsgIter(SSubmitMsg *pMsg, SSubmitMsgIter *pIter);
+SSubmitBlk *tsdbGetSubmitMsgNext(SSubmitMsgIter *pIter);
+
+/**
+ * Let several threads insert the blocks of different tables with tsdbInsertSubmitBlk. In this mode a commit is only
+ * marked when it is due, the caller triggers it with tsdbCommitIfWanted while no insert is running.
+ */
+void tsdbSetParallelInsert(TsdbRepoT *repo, bool parallel);
+
+/**
+ * Insert one block of a submit message whose fields are already in host byte order
+ */
+int32_t tsdbInsertSubmitBlk(TsdbRepoT *repo, SSubmitBlk *pBlock, int32_t *affectedrows);
+
+/**
+ * Check if the parallel inserts marked a commit, and trigger it, return true if it is triggered
+ */
+bool tsdbCommitWanted(TsdbRepoT *repo);
+bool tsdbCommitIfWanted(TsdbRepoT *repo);
+
 // -- FOR QUERY TIME SERIES DATA
 
 typedef void *TsdbQueryHandleT;  // Use void to hide implementation details
@@ -320,7 +360,16 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle);
  * @param totalStorage. total bytes took by the tsdb
  * @param compStorage. total bytes took by the tsdb after compressed
  */
-void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage);
+// the hits and misses of the block cache are counted since the repository is opened
+void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage, int64_t *cacheHits,
+                    int64_t *cacheMisses);
+
+/**
+ * get the progress and statistics of the background file group compaction
+ * @param repo. point to the tsdbrepo
+ * @param pStat. the statistics to fill
+ */
+void tsdbGetCompactStat(TsdbRepoT *repo, STsdbCompactStat *pStat);
 
 #ifdef __cplusplus
 }
@@ -39,6 +39,19 @@ typedef struct {
   int8_t    keep;      // keep the wal file when closed
 } SWalCfg;
 
+#define TAOS_WAL_HIST_BUCKETS 20
+
+typedef struct {
+  int64_t   numOfFlushes;
+  int64_t   numOfRecords;
+  int64_t   numOfCopies;      // records copied into the WAL buffer by walWrite
+  int64_t   bytesCopied;
+  int64_t   numOfRefs;        // records written from the caller's memory, appended by walWriteRef
+  int64_t   bytesReferenced;
+  int64_t   batchHist[TAOS_WAL_HIST_BUCKETS];  // records per flush, bucket i holds [2^i, 2^(i+1))
+  int64_t   fsyncHist[TAOS_WAL_HIST_BUCKETS];  // fsync latency in us, bucket i holds [2^i, 2^(i+1))
+} SWalStat;
+
 typedef void* twalh;  // WAL HANDLE
 typedef int (*FWalWrite)(void *ahandle, void *pHead, int type);
 
@@ -46,7 +59,10 @@ twalh   walOpen(const char *path, const SWalCfg *pCfg);
 void    walClose(twalh);
 int     walRenew(twalh);
 int     walWrite(twalh, SWalHead *);
-void    walFsync(twalh);
+int     walWriteRef(twalh, SWalHead *);  // the record is not copied, it is kept unchanged till walWriteOut returns
+int     walWriteOut(twalh);              // write the records appended into the file, without syncing it
+int     walFsync(twalh);
+void    walGetStat(twalh, SWalStat *);
 int     walRestore(twalh, void *pVnode, FWalWrite writeFp);
 int     walGetWalFile(twalh, char *name, uint32_t *index);
 
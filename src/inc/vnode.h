@@ -39,6 +39,7 @@ typedef struct {
   void    *pCont;
   int32_t  contLen;
   SRpcMsg  rpcMsg;
+  void    *pVnode;  // for the msg not in the read queue of the vnode
 } SReadMsg;
 
 int32_t vnodeCreate(SMDCreateVnodeMsg *pVnodeCfg);
@@ -57,7 +58,14 @@ void*   vnodeGetWqueue(int32_t vgId);
 void*   vnodeGetWal(void *pVnode);
 
 int32_t vnodeProcessWrite(void *pVnode, int qtype, void *pHead, void *item);
+
+// vnodeProcessWrite in two steps for the messages kept till they are written out: vnodeAppendWrite appends the
+// message into the WAL without copying it, it returns 1 if the message is already written. After walWriteOut,
+// vnodeApplyWrite forwards and processes the message, which may change it in place
+int32_t vnodeAppendWrite(void *pVnode, void *pHead);
+int32_t vnodeApplyWrite(void *pVnode, int qtype, void *pHead, void *item);
 void    vnodeBuildStatusMsg(void * param);
+void    vnodeGetBlockCacheStatis(int64_t *hits, int64_t *misses);  // summed over the vnodes open
 
 int32_t vnodeProcessRead(void *pVnode, SReadMsg *pReadMsg);
 
@@ -182,16 +182,17 @@ static int32_t mnodeChildTableActionUpdate(SSdbOper *pOper) {
   SChildTableObj *pNew = pOper->pObj;
   SChildTableObj *pTable = mnodeGetChildTable(pNew->info.tableId);
   if (pTable != pNew) {
-    void *oldTableId = pTable->info.tableId;
+    // only the persisted part is replaced, the super table of the table is kept
     void *oldSql = pTable->sql;
     void *oldSchema = pTable->schema;
-    memcpy(pTable, pNew, pOper->rowSize);
+    memcpy((char *)pTable + sizeof(char *), (char *)pNew + sizeof(char *), tsChildTableUpdateSize);
+    pTable->nextColId = pNew->nextColId;
     pTable->sql = pNew->sql;
     pTable->schema = pNew->schema;
+    free(pNew->info.tableId);
     free(pNew);
     free(oldSql);
     free(oldSchema);
-    free(oldTableId);
   }
   mnodeDecTableRef(pTable);
 
@@ -254,6 +255,11 @@ static int32_t mnodeChildTableActionDecode(SSdbOper *pOper) {
     memcpy(pTable->schema, pOper->rowData + len, schemaSize);
     len += schemaSize;
 
+    // the next column id is not persisted, it follows the largest one of the schema
+    for (int32_t i = 0; i < pTable->numOfColumns; ++i) {
+      if (pTable->schema[i].colId >= pTable->nextColId) pTable->nextColId = pTable->schema[i].colId + 1;
+    }
+
     if (pTable->sqlLen != 0) {
       pTable->sql = malloc(pTable->sqlLen);
       if (pTable->sql == NULL) {
@@ -437,13 +443,13 @@ static int32_t mnodeSuperTableActionUpdate(SSdbOper *pOper) {
   SSuperTableObj *pNew = pOper->pObj;
   SSuperTableObj *pTable = mnodeGetSuperTable(pNew->info.tableId);
   if (pTable != pNew) {
-    void *oldTableId = pTable->info.tableId;
+    // only the persisted part is replaced, the tables and vgroups of the super table are kept
     void *oldSchema = pTable->schema;
-    memcpy(pTable, pNew, pOper->rowSize);
+    memcpy((char *)pTable + sizeof(char *), (char *)pNew + sizeof(char *), tsSuperTableUpdateSize);
     pTable->schema = pNew->schema;
+    free(pNew->info.tableId);
     free(pNew->vgHash);
     free(pNew);
-    free(oldTableId);
     free(oldSchema);
   }
   mnodeDecTableRef(pTable);
@@ -497,7 +503,12 @@ static int32_t mnodeSuperTableActionDecode(SSdbOper *pOper) {
   }
 
   memcpy(pStable->schema, pOper->rowData + len, schemaSize);
-  
+
+  // the next column id is not persisted, it follows the largest one of the schema
+  for (int32_t i = 0; i < pStable->numOfColumns + pStable->numOfTags; ++i) {
+    if (pStable->schema[i].colId >= pStable->nextColId) pStable->nextColId = pStable->schema[i].colId + 1;
+  }
+
   pOper->pObj = pStable;
 
   return TSDB_CODE_SUCCESS;
@@ -196,6 +196,7 @@ extern "C" {
 
 int tsem_init(dispatch_semaphore_t *sem, int pshared, unsigned int value);
 int tsem_wait(dispatch_semaphore_t *sem);
+int tsem_trywait(dispatch_semaphore_t *sem);
 int tsem_post(dispatch_semaphore_t *sem);
 int tsem_destroy(dispatch_semaphore_t *sem);
 
@@ -203,6 +204,8 @@ void osInit();
 
 ssize_t twrite(int fd, void *buf, size_t n);
 
+#define fdatasync fsync
+
 char *taosCharsetReplace(char *charsetstr);
 
 bool taosCheckPthreadValid(pthread_t thread);
@@ -328,6 +328,10 @@ int tsem_wait(dispatch_semaphore_t *sem) {
   return 0;
 }
 
+int tsem_trywait(dispatch_semaphore_t *sem) {
+  return dispatch_semaphore_wait(*sem, DISPATCH_TIME_NOW) == 0 ? 0 : -1;
+}
+
 int tsem_post(dispatch_semaphore_t *sem) {
   dispatch_semaphore_signal(*sem);
   return 0;
@@ -199,6 +199,7 @@ extern "C" {
 #define tsem_t sem_t
 #define tsem_init sem_init
 #define tsem_wait sem_wait
+#define tsem_trywait sem_trywait
 #define tsem_post sem_post
 #define tsem_destroy sem_destroy
 
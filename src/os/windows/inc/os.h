@@ -89,6 +89,7 @@ extern "C" {
 #define socklen_t int
 #define htobe64 htonll
 #define twrite write
+#define fdatasync fsync
 
 #ifndef PATH_MAX
   #define PATH_MAX 256
@@ -334,6 +335,7 @@ __int64 interlocked_xor_fetch_64(__int64 volatile* ptr, __int64 val);
 #define tsem_t sem_t
 #define tsem_init sem_init
 #define tsem_wait sem_wait
+#define tsem_trywait sem_trywait
 #define tsem_post sem_post
 #define tsem_destroy sem_destroy
 
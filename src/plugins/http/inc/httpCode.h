@@ -107,6 +107,14 @@
 //tgf
 #define HTTP_TG_STABLE_NOT_EXIST     80
 
+//line protocol
+#define HTTP_LP_DB_NOT_INPUT          81
+#define HTTP_LP_DB_TOO_LONG           82
+#define HTTP_LP_INVALID_PRECISION     83
+#define HTTP_LP_INVALID_LINE          84
+#define HTTP_LP_POINTS_NULL           85
+#define HTTP_LP_SCHEMA_MISMATCH       86
+
 extern char *httpMsg[];
 
 #endif
\ No newline at end of file
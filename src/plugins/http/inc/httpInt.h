@@ -56,6 +56,7 @@
 #define HTTP_REQTYPE_HEARTBEAT      2
 #define HTTP_REQTYPE_SINGLE_SQL     3
 #define HTTP_REQTYPE_MULTI_SQL      4
+#define HTTP_REQTYPE_LINE           5
 
 #define HTTP_CHECK_BODY_ERROR      -1
 #define HTTP_CHECK_BODY_CONTINUE    0
@@ -104,5 +104,11 @@ char* httpMsg[] = {
     "value not find",
     "value type should be boolean, number or string",
     "stable not exist",
+    "database name can not be null",         // 81
+    "database name too long",
+    "precision should be n, u, ms or s",     // 83
+    "invalid line protocol",
+    "no points in the request",              // 85
+    "points mismatch the schema of stable",
 
 };
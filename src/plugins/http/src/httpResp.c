@@ -162,6 +162,13 @@ void httpSendErrorRespWithDesc(HttpContext *pContext, int errNo, char *desc) {
     case HTTP_INVALID_BASIC_AUTH_TOKEN:
     case HTTP_INVALID_TAOSD_AUTH_TOKEN:
     case HTTP_TG_HOST_NOT_STRING:
+    // line protocol
+    case HTTP_LP_DB_NOT_INPUT:
+    case HTTP_LP_DB_TOO_LONG:
+    case HTTP_LP_INVALID_PRECISION:
+    case HTTP_LP_INVALID_LINE:
+    case HTTP_LP_POINTS_NULL:
+    case HTTP_LP_SCHEMA_MISMATCH:
     // grafana
     case HTTP_GC_QUERY_NULL:
     case HTTP_GC_QUERY_SIZE:
@@ -24,6 +24,7 @@
 #include "httpResp.h"
 #include "httpAuth.h"
 #include "httpSession.h"
+#include "lpHandle.h"
 
 void *taos_connect_a(char *ip, char *user, char *pass, char *db, uint16_t port, void (*fp)(void *, TAOS_RES *, int),
                      void *param, void **taos);
@@ -344,6 +345,9 @@ void httpExecCmd(HttpContext *pContext) {
     case HTTP_REQTYPE_HEARTBEAT:
       httpProcessHeartBeatCmd(pContext);
       break;
+    case HTTP_REQTYPE_LINE:
+      lpProcessLineCmd(pContext);
+      break;
     case HTTP_REQTYPE_OTHERS:
       httpCloseContextByApp(pContext);
       break;
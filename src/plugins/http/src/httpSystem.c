@@ -29,6 +29,7 @@
 #include "gcHandle.h"
 #include "restHandle.h"
 #include "tgHandle.h"
+#include "lpHandle.h"
 
 #ifndef _ADMIN
 void adminInitHandle(HttpServer* pServer) {}
@@ -54,6 +55,7 @@ int httpInitSystem() {
   adminInitHandle(&tsHttpServer);
   gcInitHandle(&tsHttpServer);
   tgInitHandle(&tsHttpServer);
+  lpInitHandle(&tsHttpServer);
   opInitHandle(&tsHttpServer);
 
   return 0;
@@ -89,6 +91,7 @@ void httpStopSystem() {
   tsHttpServer.status = HTTP_SERVER_CLOSING;
   shutdown(tsHttpServer.fd, SHUT_RD);
   tgCleanupHandle();
+  lpCleanupHandle();
 }
 
 void httpCleanUpSystem() {
@@ -0,0 +1,1374 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+#include "taos.h"
+#include "taosdef.h"
+#include "taoserror.h"
+#include "tarray.h"
+#include "tglobal.h"
+#include "tmd5.h"
+#include "tsched.h"
+#include "ttime.h"
+#include "cJSON.h"
+#include "httpLog.h"
+#include "httpCode.h"
+#include "lpHandle.h"
+
+/*
+ * The points of InfluxDB line protocol, or the metrics of telegraf in json as /telegraf accepts, are written into the
+ * super tables of the measurements and the child tables of the tag sets, which are named as /telegraf names them:
+ *   measurement,host=h1,cpu=c0 usage=0.5,count=3i,ok=true,note="a b" 1500000000000000000
+ * is written into the child table measurement_h1_c0 of super table measurement, with the columns of f_usage, f_count,
+ * f_ok and f_note and the tags of t_host and t_cpu. The url is /influxdb/<db>[/<precision>], the precision of the
+ * timestamps is n, u, ms or s, which is n for line protocol and ms for json by default, and the timestamps are
+ * converted to the precision of the database. The super tables are created from the first points of them if they do
+ * not exist, and the fields and tags not in a super table yet are added to it.
+ *
+ * Instead of generating a sql string per metric, the rows of the points are bound to a prepared statement per super
+ * table, which merges the rows of the tables into a submit block per vgroup.
+ */
+
+#define LP_VALUE_DOUBLE    0
+#define LP_VALUE_BIGINT    1
+#define LP_VALUE_BOOL      2
+#define LP_VALUE_STRING    3
+
+#define LP_MIN_BINARY_LEN  32
+#define LP_MAX_DESC_LEN    256
+#define LP_QUEUE_SIZE      1000
+
+typedef struct {
+  char   *key;   // the column is "t_" or "f_" with the key
+  int8_t  type;
+  int16_t col;   // in the columns of the super table, the tags follow the columns
+  int32_t len;   // of the string value
+  union {
+    double  d;
+    int64_t i;
+    char   *s;
+  } val;
+} SLpValue;
+
+typedef struct {
+  char    stable[TSDB_TABLE_NAME_LEN];
+  char    table[TSDB_TABLE_NAME_LEN];
+  int64_t ts;
+  int32_t index;  // in the request, the rows of a table are inserted in the order of the points
+  int32_t pos;    // of the first tag in the values, the fields follow the tags
+  int16_t numOfTags;
+  int16_t numOfFields;
+} SLpPoint;
+
+typedef struct {
+  char    name[TSDB_COL_NAME_LEN];
+  int8_t  type;
+  int32_t bytes;   // as describe shows, the characters of binary and nchar
+  int32_t maxLen;  // of the strings bound to the column
+} SLpColumn;
+
+typedef struct {
+  HttpContext *pContext;
+  char        *db;
+  int64_t      tsUnit;     // the nanoseconds of the precision of the timestamps in the request
+  int32_t      precision;  // of the database, -1 if it is not read yet
+  int64_t      tsMul;      // the timestamps are converted to the precision of the database by ts * tsMul / tsDiv
+  int64_t      tsDiv;
+  cJSON       *root;
+  SArray      *points;  // SLpPoint
+  SArray      *values;  // SLpValue
+  char        *name;    // to build the names of the tables
+  int32_t      nameSize;
+  int32_t      httpCode;  // the request fails with httpCode or taosCode
+  int32_t      taosCode;
+  char         desc[LP_MAX_DESC_LEN];
+} SLpRequest;
+
+static HttpDecodeMethod lpDecodeMethod = {"influxdb", lpProcessRequest};
+static void *lpQhandle = NULL;
+
+char *tgGetStableName(char *stname, cJSON *fields, int fieldsSize);
+
+static bool lpSetError(SLpRequest *pReq, int32_t httpCode, const char *format, ...) {
+  pReq->httpCode = httpCode;
+  if (format == NULL) {
+    return false;
+  }
+
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(pReq->desc, sizeof(pReq->desc), format, ap);
+  va_end(ap);
+
+  // the desc is a string in the json of the response
+  for (char *p = pReq->desc; *p != 0; ++p) {
+    if (*p == '\"' || *p == '\\') {
+      *p = '\'';
+    } else if ((uint8_t)*p < ' ') {
+      *p = ' ';
+    }
+  }
+
+  return false;
+}
+
+static bool lpGetPrecision(HttpContext *pContext, bool isJson, int64_t *tsUnit) {
+  HttpBuf *precision = &pContext->parser.path[LP_PRECISION_URL_POS];
+  char    *str = (precision->len > 0) ? precision->pos : (isJson ? "ms" : "n");
+
+  if (strcmp(str, "n") == 0) {
+    *tsUnit = 1;
+  } else if (strcmp(str, "u") == 0) {
+    *tsUnit = 1000L;
+  } else if (strcmp(str, "ms") == 0) {
+    *tsUnit = 1000000L;
+  } else if (strcmp(str, "s") == 0) {
+    *tsUnit = 1000000000L;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+static char *lpReserveName(SLpRequest *pReq, int32_t size) {
+  if (size > pReq->nameSize) {
+    char *name = realloc(pReq->name, (size_t)size);
+    if (name == NULL) {
+      return NULL;
+    }
+    pReq->name = name;
+    pReq->nameSize = size;
+  }
+
+  return pReq->name;
+}
+
+// the characters out of identifiers are replaced by '_', and the long names are shortened by md5 as
+// httpShrinkTableName does, so the names are the same ones /telegraf uses
+static void lpShrinkName(char *dst, char *name, int32_t len) {
+  for (int32_t i = 0; i < len; ++i) {
+    if (!isalnum((uint8_t)name[i]) && name[i] != '_') {
+      name[i] = '_';
+    }
+  }
+
+  if (len < TSDB_TABLE_NAME_LEN - 1) {
+    memcpy(dst, name, (size_t)len);
+    dst[len] = 0;
+    return;
+  }
+
+  MD5_CTX context;
+  MD5Init(&context);
+  MD5Update(&context, (uint8_t *)name, (uint32_t)len);
+  MD5Final(&context);
+
+  for (int32_t i = 0; i < 16; ++i) {
+    sprintf(dst + i * 2, "%02x", context.digest[i]);
+  }
+  dst[0] = 't';
+}
+
+// the keys are the names of columns after "t_" or "f_", which are in lower case
+static bool lpCheckKey(SLpRequest *pReq, char *key, int32_t lineNo) {
+  int32_t len = 0;
+  for (char *p = key; *p != 0; ++p, ++len) {
+    *p = isalnum((uint8_t)*p) ? (char)tolower((uint8_t)*p) : '_';
+  }
+
+  if (len == 0 || len > TSDB_COL_NAME_LEN - 3) {
+    return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: length of the name of %s should be in [1, %d]", lineNo,
+                      key, TSDB_COL_NAME_LEN - 3);
+  }
+
+  return true;
+}
+
+static int lpCompareTag(const void *a, const void *b) {
+  const SLpValue *tag1 = a;
+  const SLpValue *tag2 = b;
+
+  bool isHost1 = (strcasecmp(tag1->key, "host") == 0);
+  bool isHost2 = (strcasecmp(tag2->key, "host") == 0);
+  if (isHost1 != isHost2) {
+    return isHost1 ? -1 : 1;
+  }
+
+  return strcmp(tag1->key, tag2->key);
+}
+
+/*
+ * The tags are ordered by the keys with host at first, and the table is named by the super table and the values of
+ * the tags in order, as /telegraf does. The point is added to the request.
+ */
+static bool lpAddPoint(SLpRequest *pReq, SLpPoint *pPoint, const char *stname, int32_t lineNo) {
+  if (pPoint->numOfTags <= 0 || pPoint->numOfTags > TSDB_MAX_TAGS) {
+    return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: number of tags should be in [1, %d]", lineNo,
+                      TSDB_MAX_TAGS);
+  }
+
+  if (pPoint->numOfFields <= 0 || pPoint->numOfFields > TSDB_MAX_COLUMNS - TSDB_MAX_TAGS - 1) {
+    return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: number of fields should be in [1, %d]", lineNo,
+                      TSDB_MAX_COLUMNS - TSDB_MAX_TAGS - 1);
+  }
+
+  SLpValue *tags = taosArrayGet(pReq->values, (size_t)pPoint->pos);
+  qsort(tags, (size_t)pPoint->numOfTags, sizeof(SLpValue), lpCompareTag);
+
+  int32_t numOfValues = pPoint->numOfTags + pPoint->numOfFields;
+  int32_t size = (int32_t)strlen(stname) + 32;
+  for (int32_t i = 0; i < numOfValues; ++i) {
+    if (!lpCheckKey(pReq, tags[i].key, lineNo)) {
+      return false;
+    }
+    if (i < pPoint->numOfTags) {
+      size += (tags[i].type == LP_VALUE_STRING) ? tags[i].len + 1 : 24;
+    }
+  }
+
+  char *name = lpReserveName(pReq, size);
+  if (name == NULL) {
+    return lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+  }
+
+  int32_t len = 0;
+  if (tsTelegrafUseFieldNum == 0) {
+    len = sprintf(name, "%s", stname);
+  } else {
+    len = sprintf(name, "%s_%d_%d", stname, pPoint->numOfFields, pPoint->numOfTags);
+  }
+
+  int32_t stableLen = len;
+  for (int32_t i = 0; i < pPoint->numOfTags; ++i) {
+    if (tags[i].type == LP_VALUE_STRING) {
+      name[len++] = '_';
+      memcpy(name + len, tags[i].val.s, (size_t)tags[i].len);
+      len += tags[i].len;
+    } else {
+      len += sprintf(name + len, "_%" PRId64, tags[i].val.i);
+    }
+  }
+
+  lpShrinkName(pPoint->table, name, len);
+  lpShrinkName(pPoint->stable, name, stableLen);
+
+  pPoint->index = (int32_t)taosArrayGetSize(pReq->points);
+  if (taosArrayPush(pReq->points, pPoint) == NULL) {
+    return lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+  }
+
+  return true;
+}
+
+static bool lpPushValue(SLpRequest *pReq, SLpValue *pValue) {
+  if (taosArrayPush(pReq->values, pValue) == NULL) {
+    return lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+  }
+  return true;
+}
+
+/*
+ * The token ends at one of the delimiters or the end of the line, it is unescaped and terminated in place, and the
+ * delimiter is returned.
+ */
+static char lpNextToken(char **str, const char *delims, char **token, int32_t *len) {
+  char *r = *str;
+  char *w = *str;
+
+  while (*r != 0 && strchr(delims, *r) == NULL) {
+    if (*r == '\\' && (r[1] == ',' || r[1] == '=' || r[1] == ' ')) {
+      r++;
+    }
+    *w++ = *r++;
+  }
+
+  char delim = *r;
+  *w = 0;
+  *token = *str;
+  *len = (int32_t)(w - *str);
+  *str = (delim != 0) ? r + 1 : r;
+  return delim;
+}
+
+// the field value is a quoted string, an integer with the suffix of i or u, a boolean or a float
+static bool lpParseFieldValue(SLpRequest *pReq, char **str, SLpValue *pValue, char *delim, int32_t lineNo) {
+  char *p = *str;
+
+  if (*p == '\"') {
+    char *r = ++p;
+    char *w = p;
+    while (*r != 0 && *r != '\"') {
+      if (*r == '\\' && (r[1] == '\"' || r[1] == '\\')) {
+        r++;
+      }
+      *w++ = *r++;
+    }
+
+    if (*r != '\"' || (r[1] != 0 && r[1] != ',' && r[1] != ' ')) {
+      return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: invalid string value of field %s", lineNo,
+                        pValue->key);
+    }
+
+    *delim = r[1];
+    *str = (r[1] != 0) ? r + 2 : r + 1;
+    *w = 0;
+
+    pValue->type = LP_VALUE_STRING;
+    pValue->val.s = p;
+    pValue->len = (int32_t)(w - p);
+    return true;
+  }
+
+  char *r = p;
+  while (*r != 0 && *r != ',' && *r != ' ') {
+    r++;
+  }
+
+  *delim = *r;
+  *str = (*r != 0) ? r + 1 : r;
+  *r = 0;
+
+  int32_t len = (int32_t)(r - p);
+  if (len == 0) {
+    return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: value of field %s is null", lineNo, pValue->key);
+  }
+
+  if (strcmp(p, "t") == 0 || strcmp(p, "T") == 0 || strcmp(p, "true") == 0 || strcmp(p, "True") == 0 ||
+      strcmp(p, "TRUE") == 0) {
+    pValue->type = LP_VALUE_BOOL;
+    pValue->val.i = 1;
+    return true;
+  }
+
+  if (strcmp(p, "f") == 0 || strcmp(p, "F") == 0 || strcmp(p, "false") == 0 || strcmp(p, "False") == 0 ||
+      strcmp(p, "FALSE") == 0) {
+    pValue->type = LP_VALUE_BOOL;
+    pValue->val.i = 0;
+    return true;
+  }
+
+  char *end = NULL;
+  errno = 0;
+  if (p[len - 1] == 'i' || p[len - 1] == 'u') {
+    bool isUnsigned = (p[len - 1] == 'u');
+    p[len - 1] = 0;
+
+    pValue->type = LP_VALUE_BIGINT;
+    if (isUnsigned) {
+      uint64_t u = strtoull(p, &end, 10);
+      pValue->val.i = (int64_t)u;
+      if (*p == '-' || u > INT64_MAX) errno = ERANGE;
+    } else {
+      pValue->val.i = strtoll(p, &end, 10);
+    }
+  } else if (isdigit((uint8_t)*p) || *p == '-' || *p == '+' || *p == '.') {
+    pValue->type = LP_VALUE_DOUBLE;
+    pValue->val.d = strtod(p, &end);
+  }
+
+  if (end == NULL || end == p || *end != 0 || errno != 0) {
+    return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: invalid value of field %s", lineNo, pValue->key);
+  }
+
+  return true;
+}
+
+/*
+ * parse single line
+ *   measurement[,tag_key=tag_value...] field_key=field_value[,field_key=field_value...] [timestamp]
+ * the commas, equal signs and spaces in the names and the tag values are escaped by backslashes
+ */
+static bool lpParseLine(SLpRequest *pReq, char *line, int32_t lineNo) {
+  SLpPoint point = {0};
+  point.pos = (int32_t)taosArrayGetSize(pReq->values);
+
+  char   *p = line;
+  char   *measurement = NULL;
+  int32_t len = 0;
+
+  char delim = lpNextToken(&p, ", ", &measurement, &len);
+  if (len == 0) {
+    return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: measurement is null", lineNo);
+  }
+
+  while (delim == ',') {
+    SLpValue tag = {.type = LP_VALUE_STRING};
+    int32_t  keyLen = 0;
+
+    delim = lpNextToken(&p, ",= ", &tag.key, &keyLen);
+    if (delim != '=' || keyLen == 0) {
+      return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: invalid tag of measurement %s", lineNo, measurement);
+    }
+
+    delim = lpNextToken(&p, ", ", &tag.val.s, &tag.len);
+    if (tag.len == 0) {
+      return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: value of tag %s is null", lineNo, tag.key);
+    }
+
+    if (!lpPushValue(pReq, &tag)) {
+      return false;
+    }
+    point.numOfTags++;
+  }
+
+  if (delim != ' ') {
+    return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: fields of measurement %s not found", lineNo, measurement);
+  }
+
+  while (*p == ' ') p++;
+
+  do {
+    SLpValue field = {0};
+    int32_t  keyLen = 0;
+
+    delim = lpNextToken(&p, ",= ", &field.key, &keyLen);
+    if (delim != '=' || keyLen == 0) {
+      return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: invalid field of measurement %s", lineNo, measurement);
+    }
+
+    if (!lpParseFieldValue(pReq, &p, &field, &delim, lineNo) || !lpPushValue(pReq, &field)) {
+      return false;
+    }
+    point.numOfFields++;
+  } while (delim == ',');
+
+  while (*p == ' ') p++;
+
+  if (*p == 0) {
+    point.ts = taosGetTimestampUs() * 1000L / pReq->tsUnit;
+  } else {
+    char *end = NULL;
+    errno = 0;
+    int64_t ts = strtoll(p, &end, 10);
+    while (end != NULL && *end == ' ') end++;
+    if (end == p || *end != 0 || errno != 0) {
+      return lpSetError(pReq, HTTP_LP_INVALID_LINE, "line %d: invalid timestamp", lineNo);
+    }
+    point.ts = ts;
+  }
+
+  return lpAddPoint(pReq, &point, measurement, lineNo);
+}
+
+static bool lpParseLines(SLpRequest *pReq, char *data) {
+  if (!lpGetPrecision(pReq->pContext, false, &pReq->tsUnit)) {
+    return lpSetError(pReq, HTTP_LP_INVALID_PRECISION, NULL);
+  }
+
+  int32_t lineNo = 0;
+  char   *line = data;
+  while (line != NULL && *line != 0) {
+    char *next = strchr(line, '\n');
+    if (next != NULL) {
+      *next++ = 0;
+    }
+    lineNo++;
+
+    int32_t len = (int32_t)strlen(line);
+    while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ' || line[len - 1] == '\t')) {
+      line[--len] = 0;
+    }
+    while (*line == ' ' || *line == '\t') line++;
+
+    if (*line != 0 && *line != '#' && !lpParseLine(pReq, line, lineNo)) {
+      return false;
+    }
+
+    line = next;
+  }
+
+  return true;
+}
+
+// the metric of telegraf, see tgProcessSingleMetric
+static bool lpParseJsonMetric(SLpRequest *pReq, cJSON *metric, int32_t metricNo) {
+  SLpPoint point = {0};
+  point.pos = (int32_t)taosArrayGetSize(pReq->values);
+
+  cJSON *name = cJSON_GetObjectItem(metric, "name");
+  if (name == NULL) {
+    return lpSetError(pReq, HTTP_TG_METRIC_NULL, NULL);
+  }
+  if (name->type != cJSON_String) {
+    return lpSetError(pReq, HTTP_TG_METRIC_TYPE, NULL);
+  }
+  if (name->valuestring == NULL || strlen(name->valuestring) == 0) {
+    return lpSetError(pReq, HTTP_TG_METRIC_NAME_NULL, NULL);
+  }
+
+  cJSON *timestamp = cJSON_GetObjectItem(metric, "timestamp");
+  if (timestamp == NULL) {
+    return lpSetError(pReq, HTTP_TG_TIMESTAMP_NULL, NULL);
+  }
+  if (timestamp->type != cJSON_Number) {
+    return lpSetError(pReq, HTTP_TG_TIMESTAMP_TYPE, NULL);
+  }
+  if (timestamp->valueint <= 0) {
+    return lpSetError(pReq, HTTP_TG_TIMESTAMP_VAL_NULL, NULL);
+  }
+  point.ts = timestamp->valueint;
+
+  cJSON *tags = cJSON_GetObjectItem(metric, "tags");
+  if (tags == NULL) {
+    return lpSetError(pReq, HTTP_TG_TAGS_NULL, NULL);
+  }
+
+  int tagsSize = cJSON_GetArraySize(tags);
+  for (int i = 0; i < tagsSize; i++) {
+    cJSON *tag = cJSON_GetArrayItem(tags, i);
+    if (tag == NULL) {
+      return lpSetError(pReq, HTTP_TG_TAG_NULL, NULL);
+    }
+    if (tag->string == NULL || strlen(tag->string) == 0) {
+      return lpSetError(pReq, HTTP_TG_TAG_NAME_NULL, NULL);
+    }
+
+    SLpValue value = {.key = tag->string};
+    if (tag->type == cJSON_String) {
+      if (tag->valuestring == NULL || strlen(tag->valuestring) == 0) {
+        return lpSetError(pReq, HTTP_TG_TAG_VALUE_NULL, NULL);
+      }
+      value.type = LP_VALUE_STRING;
+      value.val.s = tag->valuestring;
+      value.len = (int32_t)strlen(tag->valuestring);
+    } else if (tag->type == cJSON_Number) {
+      value.type = LP_VALUE_BIGINT;
+      value.val.i = tag->valueint;
+    } else {
+      return lpSetError(pReq, HTTP_TG_TAG_VALUE_TYPE, NULL);
+    }
+
+    if (!lpPushValue(pReq, &value)) {
+      return false;
+    }
+    point.numOfTags++;
+  }
+
+  cJSON *fields = cJSON_GetObjectItem(metric, "fields");
+  if (fields == NULL) {
+    return lpSetError(pReq, HTTP_TG_FIELDS_NULL, NULL);
+  }
+
+  int fieldsSize = cJSON_GetArraySize(fields);
+  for (int i = 0; i < fieldsSize; i++) {
+    cJSON *field = cJSON_GetArrayItem(fields, i);
+    if (field == NULL) {
+      return lpSetError(pReq, HTTP_TG_FIELD_NULL, NULL);
+    }
+    if (field->string == NULL || strlen(field->string) == 0) {
+      return lpSetError(pReq, HTTP_TG_FIELD_NAME_NULL, NULL);
+    }
+
+    SLpValue value = {.key = field->string};
+    if (field->type == cJSON_String) {
+      if (field->valuestring == NULL || strlen(field->valuestring) == 0) {
+        return lpSetError(pReq, HTTP_TG_FIELD_VALUE_NULL, NULL);
+      }
+      value.type = LP_VALUE_STRING;
+      value.val.s = field->valuestring;
+      value.len = (int32_t)strlen(field->valuestring);
+    } else if (field->type == cJSON_Number) {
+      value.type = LP_VALUE_DOUBLE;
+      value.val.d = field->valuedouble;
+    } else if (field->type == cJSON_True || field->type == cJSON_False) {
+      value.type = LP_VALUE_BOOL;
+      value.val.i = (field->type == cJSON_True);
+    } else {
+      return lpSetError(pReq, HTTP_TG_FIELD_VALUE_TYPE, NULL);
+    }
+
+    if (!lpPushValue(pReq, &value)) {
+      return false;
+    }
+    point.numOfFields++;
+  }
+
+  // the names of the fields are not changed by lpAddPoint yet
+  char *stname = tgGetStableName(name->valuestring, fields, fieldsSize);
+  return lpAddPoint(pReq, &point, stname, metricNo);
+}
+
+static bool lpParseJson(SLpRequest *pReq, char *data) {
+  if (!lpGetPrecision(pReq->pContext, true, &pReq->tsUnit)) {
+    return lpSetError(pReq, HTTP_LP_INVALID_PRECISION, NULL);
+  }
+
+  pReq->root = cJSON_Parse(data);
+  if (pReq->root == NULL) {
+    return lpSetError(pReq, HTTP_TG_INVALID_JSON, NULL);
+  }
+
+  cJSON *metrics = cJSON_GetObjectItem(pReq->root, "metrics");
+  if (metrics == NULL) {
+    return lpParseJsonMetric(pReq, pReq->root, 1);
+  }
+
+  int size = cJSON_GetArraySize(metrics);
+  for (int i = 0; i < size; i++) {
+    cJSON *metric = cJSON_GetArrayItem(metrics, i);
+    if (metric != NULL && !lpParseJsonMetric(pReq, metric, i + 1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static int32_t lpExecSql(TAOS *taos, const char *sql) {
+  TAOS_RES *res = taos_query(taos, sql);
+  int32_t   code = taos_errno(res);
+  if (code != TSDB_CODE_SUCCESS) {
+    httpError("failed to execute sql:%s, reason:%s", sql, taos_errstr(res));
+  }
+
+  taos_free_result(res);
+  return code;
+}
+
+/*
+ * The precision of the database is read from show databases, and the timestamps of the request are converted to it,
+ * the database may be created by the request, so it is read after the super table is described.
+ */
+static int32_t lpGetDbPrecision(SLpRequest *pReq, TAOS *taos) {
+  TAOS_RES *res = taos_query(taos, "show databases");
+  int32_t   code = taos_errno(res);
+  if (code != TSDB_CODE_SUCCESS) {
+    httpError("context:%p, failed to show databases, reason:%s", pReq->pContext, taos_errstr(res));
+    taos_free_result(res);
+    return code;
+  }
+
+  TAOS_FIELD *fields = taos_fetch_fields(res);
+  int32_t     numOfFields = taos_num_fields(res);
+  int32_t     nameIndex = -1, precisionIndex = -1;
+  for (int32_t i = 0; i < numOfFields; ++i) {
+    if (strcmp(fields[i].name, "name") == 0) {
+      nameIndex = i;
+    } else if (strcmp(fields[i].name, "precision") == 0) {
+      precisionIndex = i;
+    }
+  }
+
+  size_t   dbLen = strlen(pReq->db);
+  TAOS_ROW row = NULL;
+  while (nameIndex >= 0 && precisionIndex >= 0 && (row = taos_fetch_row(res)) != NULL) {
+    int *length = taos_fetch_lengths(res);
+    if (length[nameIndex] == (int)dbLen && strncasecmp(row[nameIndex], pReq->db, dbLen) == 0) {
+      bool isMicro = (length[precisionIndex] == (int)strlen(TSDB_TIME_PRECISION_MICRO_STR) &&
+                      strncmp(row[precisionIndex], TSDB_TIME_PRECISION_MICRO_STR, (size_t)length[precisionIndex]) == 0);
+      pReq->precision = isMicro ? TSDB_TIME_PRECISION_MICRO : TSDB_TIME_PRECISION_MILLI;
+      break;
+    }
+  }
+
+  taos_free_result(res);
+  if (pReq->precision < 0) {
+    return TSDB_CODE_MND_INVALID_DB;
+  }
+
+  int64_t dbUnit = (pReq->precision == TSDB_TIME_PRECISION_MICRO) ? 1000L : 1000000L;
+  pReq->tsMul = (pReq->tsUnit >= dbUnit) ? pReq->tsUnit / dbUnit : 1;
+  pReq->tsDiv = (pReq->tsUnit >= dbUnit) ? 1 : dbUnit / pReq->tsUnit;
+  return TSDB_CODE_SUCCESS;
+}
+
+// the columns of the super table, with the tags following the columns
+static int32_t lpDescribeStable(SLpRequest *pReq, TAOS *taos, char *stable, SArray *columns, int32_t *numOfCols) {
+  char sql[TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + 16] = {0};
+  snprintf(sql, sizeof(sql), "describe %s.%s", pReq->db, stable);
+
+  TAOS_RES *res = taos_query(taos, sql);
+  int32_t   code = taos_errno(res);
+
+  *numOfCols = 0;
+  TAOS_ROW row = NULL;
+  while (code == TSDB_CODE_SUCCESS && (row = taos_fetch_row(res)) != NULL) {
+    int       *length = taos_fetch_lengths(res);
+    SLpColumn  column = {0};
+
+    memcpy(column.name, row[0], (size_t)MIN(length[0], TSDB_COL_NAME_LEN - 1));
+    for (int8_t t = TSDB_DATA_TYPE_BOOL; t <= TSDB_DATA_TYPE_NCHAR; ++t) {
+      if (length[1] == tDataTypeDesc[t].nameLen && strncmp(row[1], tDataTypeDesc[t].aName, (size_t)length[1]) == 0) {
+        column.type = t;
+        break;
+      }
+    }
+    column.bytes = *(int32_t *)row[2];
+
+    bool isTag = (row[3] != NULL && length[3] == 3 && strncmp(row[3], "TAG", 3) == 0);
+    if (!isTag) {
+      (*numOfCols)++;
+    }
+
+    if (taosArrayPush(columns, &column) == NULL) {
+      code = TSDB_CODE_COM_OUT_OF_MEMORY;
+    }
+  }
+
+  taos_free_result(res);
+  return code;
+}
+
+// the column of the value is added to the columns if it is not there, with the type of the value
+static bool lpAddColumn(SArray *pArray, SLpValue *pValue, bool isTag) {
+  SLpColumn column = {0};
+  snprintf(column.name, sizeof(column.name), "%s_%s", isTag ? "t" : "f", pValue->key);
+
+  SLpColumn *pColumn = NULL;
+  for (size_t c = 0; c < taosArrayGetSize(pArray); ++c) {
+    SLpColumn *pExist = taosArrayGet(pArray, c);
+    if (strcmp(pExist->name, column.name) == 0) {
+      pColumn = pExist;
+      break;
+    }
+  }
+
+  if (pColumn == NULL) {
+    static const int8_t types[] = {TSDB_DATA_TYPE_DOUBLE, TSDB_DATA_TYPE_BIGINT, TSDB_DATA_TYPE_BOOL,
+                                   TSDB_DATA_TYPE_BINARY};
+    column.type = types[pValue->type];
+    if ((pColumn = taosArrayPush(pArray, &column)) == NULL) {
+      return false;
+    }
+  }
+
+  pColumn->maxLen = MAX(pColumn->maxLen, pValue->len);
+  return true;
+}
+
+static int32_t lpPrintColumn(char *sql, SLpColumn *pColumn) {
+  if (pColumn->type == TSDB_DATA_TYPE_BINARY) {
+    return sprintf(sql, "%s binary(%d)", pColumn->name, MAX(LP_MIN_BINARY_LEN, pColumn->maxLen));
+  }
+
+  return sprintf(sql, "%s %s", pColumn->name, tDataTypeDesc[pColumn->type].aName);
+}
+
+// the super table with the columns of all the fields and tags of the points
+static int32_t lpCreateStable(SLpRequest *pReq, TAOS *taos, SLpPoint **points, int32_t numOfPoints) {
+  SArray *columns = taosArrayInit(16, sizeof(SLpColumn));
+  SArray *tags = taosArrayInit(16, sizeof(SLpColumn));
+  char   *sql = NULL;
+  int32_t code = TSDB_CODE_COM_OUT_OF_MEMORY;
+
+  if (columns == NULL || tags == NULL) {
+    goto _end;
+  }
+
+  for (int32_t p = 0; p < numOfPoints; ++p) {
+    SLpPoint *pPoint = points[p];
+    SLpValue *values = taosArrayGet(pReq->values, (size_t)pPoint->pos);
+
+    for (int32_t i = 0; i < pPoint->numOfTags + pPoint->numOfFields; ++i) {
+      bool isTag = (i < pPoint->numOfTags);
+      if (!lpAddColumn(isTag ? tags : columns, &values[i], isTag)) {
+        goto _end;
+      }
+    }
+  }
+
+  size_t numOfColumns = taosArrayGetSize(columns) + taosArrayGetSize(tags);
+  size_t size = numOfColumns * (TSDB_COL_NAME_LEN + 32) + TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + 64;
+  if ((sql = malloc(size)) == NULL) {
+    goto _end;
+  }
+
+  int32_t len = sprintf(sql, "create table if not exists %s.%s (ts timestamp", pReq->db, points[0]->stable);
+  for (int32_t i = 0; i < 2; ++i) {
+    SArray *pArray = (i == 0) ? columns : tags;
+    for (size_t c = 0; c < taosArrayGetSize(pArray); ++c) {
+      len += sprintf(sql + len, "%s", (c == 0 && i == 1) ? "" : ", ");
+      len += lpPrintColumn(sql + len, taosArrayGet(pArray, c));
+    }
+    len += sprintf(sql + len, (i == 0) ? ") tags (" : ")");
+  }
+
+  code = lpExecSql(taos, sql);
+  if (code == TSDB_CODE_MND_INVALID_DB || code == TSDB_CODE_MND_DB_NOT_SELECTED) {
+    char createDb[TSDB_DB_NAME_LEN + 32] = {0};
+    snprintf(createDb, sizeof(createDb), "create database if not exists %s", pReq->db);
+    code = lpExecSql(taos, createDb);
+    if (code == TSDB_CODE_SUCCESS) {
+      code = lpExecSql(taos, sql);
+    }
+  }
+
+_end:
+  taosArrayDestroy(columns);
+  taosArrayDestroy(tags);
+  free(sql);
+  return code;
+}
+
+/*
+ * The fields and tags of the points not in the super table yet are added to it one at a time, a column added by
+ * another request in the meantime is already there.
+ */
+static int32_t lpAlterStable(SLpRequest *pReq, TAOS *taos, const char *stable, SArray *columns, SArray *tags) {
+  char sql[TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + TSDB_COL_NAME_LEN + 64] = {0};
+
+  for (int32_t i = 0; i < 2; ++i) {
+    SArray *pArray = (i == 0) ? columns : tags;
+    for (size_t c = 0; c < taosArrayGetSize(pArray); ++c) {
+      int32_t len = sprintf(sql, "alter table %s.%s add %s ", pReq->db, stable, (i == 0) ? "column" : "tag");
+      lpPrintColumn(sql + len, taosArrayGet(pArray, c));
+
+      int32_t code = lpExecSql(taos, sql);
+      if (code != TSDB_CODE_SUCCESS && code != TSDB_CODE_MND_FIELD_ALREAY_EXIST &&
+          code != TSDB_CODE_MND_TAG_ALREAY_EXIST) {
+        return code;
+      }
+
+      httpTrace("context:%p, %s", pReq->pContext, sql);
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static bool lpIsVarType(int8_t type) { return type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR; }
+
+static bool lpMatchColumn(SArray *columns, int32_t col, int32_t begin, int32_t end, char prefix, const char *key) {
+  if (col < begin || col >= end) {
+    return false;
+  }
+
+  SLpColumn *pColumn = taosArrayGet(columns, (size_t)col);
+  return pColumn->name[0] == prefix && pColumn->name[1] == '_' && strcmp(pColumn->name + 2, key) == 0;
+}
+
+/*
+ * Set the column of each value of the points, the column is looked up from the one of the value at the same position
+ * in the previous point, since the points of a measurement are mostly in the same shape. The values not in the super
+ * table are collected into newCols and newTags to alter the super table, or fail the request if they are NULL.
+ */
+static bool lpMapColumns(SLpRequest *pReq, SArray *columns, int32_t numOfCols, SLpPoint **points, int32_t numOfPoints,
+                         SArray *newCols, SArray *newTags) {
+  int32_t numOfColumns = (int32_t)taosArrayGetSize(columns);
+  int16_t hints[TSDB_MAX_COLUMNS] = {0};
+
+  for (int32_t p = 0; p < numOfPoints; ++p) {
+    SLpPoint *pPoint = points[p];
+    SLpValue *values = taosArrayGet(pReq->values, (size_t)pPoint->pos);
+
+    for (int32_t i = 0; i < pPoint->numOfTags + pPoint->numOfFields; ++i) {
+      SLpValue *pValue = &values[i];
+      bool      isTag = (i < pPoint->numOfTags);
+      char      prefix = isTag ? 't' : 'f';
+      int32_t   begin = isTag ? numOfCols : 1;
+      int32_t   end = isTag ? numOfColumns : numOfCols;
+
+      int32_t col = hints[i];
+      if (!lpMatchColumn(columns, col, begin, end, prefix, pValue->key)) {
+        for (col = begin; col < end && !lpMatchColumn(columns, col, begin, end, prefix, pValue->key); ++col) {
+        }
+      }
+
+      if ((col < begin || col >= end) && newCols != NULL) {
+        if (!lpAddColumn(isTag ? newTags : newCols, pValue, isTag)) {
+          return lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+        }
+        continue;
+      }
+
+      if (col < begin || col >= end) {
+        return lpSetError(pReq, HTTP_LP_SCHEMA_MISMATCH, "%c_%s is not a %s of stable %s", prefix, pValue->key,
+                          isTag ? "tag" : "column", pPoint->stable);
+      }
+
+      SLpColumn *pColumn = taosArrayGet(columns, (size_t)col);
+      if ((pValue->type == LP_VALUE_STRING) != lpIsVarType(pColumn->type)) {
+        return lpSetError(pReq, HTTP_LP_SCHEMA_MISMATCH, "type of %s mismatch the %s of stable %s", pColumn->name,
+                          tDataTypeDesc[pColumn->type].aName, pPoint->stable);
+      }
+
+      if (pColumn->type == TSDB_DATA_TYPE_BINARY && pValue->len > pColumn->bytes) {
+        return lpSetError(pReq, HTTP_LP_SCHEMA_MISMATCH, "length of %s can not be more than %d of stable %s",
+                          pColumn->name, pColumn->bytes, pPoint->stable);
+      }
+
+      pColumn->maxLen = MAX(pColumn->maxLen, pValue->len);
+      pValue->col = (int16_t)col;
+      hints[i] = (int16_t)col;
+    }
+  }
+
+  return true;
+}
+
+// the number value is converted to the type of the column, false if it is out of the range
+static bool lpConvertValue(SLpValue *pValue, int8_t type, char *dst) {
+  double  d = (pValue->type == LP_VALUE_DOUBLE) ? pValue->val.d : (double)pValue->val.i;
+  int64_t i = pValue->val.i;
+
+  if (pValue->type == LP_VALUE_DOUBLE && type != TSDB_DATA_TYPE_FLOAT && type != TSDB_DATA_TYPE_DOUBLE &&
+      type != TSDB_DATA_TYPE_BOOL) {
+    if (!(d > (double)INT64_MIN && d < (double)INT64_MAX)) {
+      return false;
+    }
+    i = (int64_t)d;
+  }
+
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+      *(int8_t *)dst = (int8_t)(d != 0);
+      break;
+    case TSDB_DATA_TYPE_TINYINT:
+      if (i <= INT8_MIN || i > INT8_MAX) return false;
+      *(int8_t *)dst = (int8_t)i;
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      if (i <= INT16_MIN || i > INT16_MAX) return false;
+      *(int16_t *)dst = (int16_t)i;
+      break;
+    case TSDB_DATA_TYPE_INT:
+      if (i <= INT32_MIN || i > INT32_MAX) return false;
+      *(int32_t *)dst = (int32_t)i;
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      if (i == INT64_MIN) return false;
+      *(int64_t *)dst = i;
+      break;
+    case TSDB_DATA_TYPE_FLOAT:
+      *(float *)dst = (float)d;
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+      *(double *)dst = d;
+      break;
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+static bool lpSetTableTags(SLpRequest *pReq, TAOS_STMT *stmt, SArray *columns, int32_t numOfCols, SLpPoint *pPoint) {
+  int32_t       numOfTags = (int32_t)taosArrayGetSize(columns) - numOfCols;
+  TAOS_BIND     tags[TSDB_MAX_TAGS] = {{0}};
+  int64_t       buffers[TSDB_MAX_TAGS] = {0};
+  unsigned long lengths[TSDB_MAX_TAGS] = {0};
+  int           isNull[TSDB_MAX_TAGS] = {0};
+
+  for (int32_t t = 0; t < numOfTags; ++t) {
+    tags[t].buffer_type = ((SLpColumn *)taosArrayGet(columns, (size_t)(numOfCols + t)))->type;
+    tags[t].buffer = &buffers[t];
+    tags[t].length = &lengths[t];
+    tags[t].is_null = &isNull[t];
+    isNull[t] = 1;
+  }
+
+  SLpValue *values = taosArrayGet(pReq->values, (size_t)pPoint->pos);
+  for (int32_t i = 0; i < pPoint->numOfTags; ++i) {
+    int32_t t = values[i].col - numOfCols;
+    if (values[i].type == LP_VALUE_STRING) {
+      tags[t].buffer = values[i].val.s;
+      lengths[t] = (unsigned long)values[i].len;
+    } else if (!lpConvertValue(&values[i], (int8_t)tags[t].buffer_type, (char *)&buffers[t])) {
+      return lpSetError(pReq, HTTP_LP_SCHEMA_MISMATCH, "value of t_%s is out of the range of %s", values[i].key,
+                        tDataTypeDesc[tags[t].buffer_type].aName);
+    }
+    isNull[t] = 0;
+  }
+
+  char name[TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + 2] = {0};
+  snprintf(name, sizeof(name), "%s.%s", pReq->db, pPoint->table);
+
+  int32_t code = taos_stmt_set_tbname_tags(stmt, name, tags);
+  if (code != TSDB_CODE_SUCCESS) {
+    httpError("context:%p, failed to set table %s, reason:%s", pReq->pContext, name, tstrerror(code));
+    pReq->taosCode = code;
+    return false;
+  }
+
+  return true;
+}
+
+static bool lpBindRows(SLpRequest *pReq, TAOS_STMT *stmt, SArray *columns, TAOS_MULTI_BIND *cols, int32_t numOfCols,
+                       SLpPoint **points, int32_t numOfRows) {
+  for (int32_t c = 0; c < numOfCols; ++c) {
+    memset(cols[c].is_null, 1, (size_t)numOfRows);
+    cols[c].num = numOfRows;
+  }
+
+  for (int32_t r = 0; r < numOfRows; ++r) {
+    SLpPoint *pPoint = points[r];
+    if (pPoint->ts > INT64_MAX / pReq->tsMul || pPoint->ts < INT64_MIN / pReq->tsMul) {
+      return lpSetError(pReq, HTTP_LP_INVALID_LINE, "timestamp %" PRId64 " of table %s is out of range", pPoint->ts,
+                        pPoint->table);
+    }
+    *(int64_t *)((char *)cols[0].buffer + r * sizeof(int64_t)) = pPoint->ts * pReq->tsMul / pReq->tsDiv;
+    cols[0].is_null[r] = 0;
+
+    SLpValue *values = taosArrayGet(pReq->values, (size_t)(pPoint->pos + pPoint->numOfTags));
+    for (int32_t i = 0; i < pPoint->numOfFields; ++i) {
+      SLpValue        *pValue = &values[i];
+      TAOS_MULTI_BIND *pCol = &cols[pValue->col];
+      char            *dst = (char *)pCol->buffer + r * pCol->buffer_length;
+
+      if (pValue->type == LP_VALUE_STRING) {
+        memcpy(dst, pValue->val.s, (size_t)pValue->len);
+        pCol->length[r] = pValue->len;
+      } else if (!lpConvertValue(pValue, (int8_t)pCol->buffer_type, dst)) {
+        return lpSetError(pReq, HTTP_LP_SCHEMA_MISMATCH, "value of f_%s is out of the range of %s", pValue->key,
+                          tDataTypeDesc[pCol->buffer_type].aName);
+      }
+      pCol->is_null[r] = 0;
+    }
+  }
+
+  int32_t code = taos_stmt_bind_param_batch(stmt, cols);
+  if (code != TSDB_CODE_SUCCESS) {
+    httpError("context:%p, failed to bind the rows of table %s, reason:%s", pReq->pContext, points[0]->table,
+              tstrerror(code));
+    pReq->taosCode = code;
+    return false;
+  }
+
+  return true;
+}
+
+/*
+ * The rows of the points of a super table are bound to the prepared statement a child table at a time, with the
+ * values of the columns in the buffers of the columns, and submitted by one execution.
+ */
+static bool lpBindPoints(SLpRequest *pReq, TAOS *taos, SArray *columns, int32_t numOfCols, SLpPoint **points,
+                         int32_t numOfPoints) {
+  int32_t          numOfColumns = (int32_t)taosArrayGetSize(columns);
+  TAOS_MULTI_BIND *cols = calloc((size_t)numOfCols, sizeof(TAOS_MULTI_BIND));
+  char            *sql = malloc((size_t)(numOfColumns * 2 + TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + 64));
+  TAOS_STMT       *stmt = NULL;
+  bool             succ = false;
+
+  int32_t maxRows = 0;
+  for (int32_t s = 0, e = 0; s < numOfPoints; s = e) {
+    for (e = s + 1; e < numOfPoints && strcmp(points[e]->table, points[s]->table) == 0; ++e) {
+    }
+    maxRows = MAX(maxRows, e - s);
+  }
+
+  if (cols == NULL || sql == NULL) {
+    lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+    goto _end;
+  }
+
+  for (int32_t c = 0; c < numOfCols; ++c) {
+    SLpColumn *pColumn = taosArrayGet(columns, (size_t)c);
+    cols[c].buffer_type = pColumn->type;
+    cols[c].buffer_length = lpIsVarType(pColumn->type) ? MAX(pColumn->maxLen, 1) : tDataTypeDesc[pColumn->type].nSize;
+    cols[c].buffer = malloc(cols[c].buffer_length * maxRows);
+    cols[c].is_null = malloc((size_t)maxRows);
+    cols[c].length = lpIsVarType(pColumn->type) ? malloc(sizeof(int32_t) * maxRows) : NULL;
+    if (cols[c].buffer == NULL || cols[c].is_null == NULL || (lpIsVarType(pColumn->type) && cols[c].length == NULL)) {
+      lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+      goto _end;
+    }
+  }
+
+  int32_t len = sprintf(sql, "insert into ? using %s.%s tags(", pReq->db, points[0]->stable);
+  for (int32_t c = numOfCols; c < numOfColumns; ++c) {
+    len += sprintf(sql + len, (c == numOfCols) ? "?" : ",?");
+  }
+  len += sprintf(sql + len, ") values(");
+  for (int32_t c = 0; c < numOfCols; ++c) {
+    len += sprintf(sql + len, (c == 0) ? "?" : ",?");
+  }
+  sprintf(sql + len, ")");
+
+  stmt = taos_stmt_init(taos);
+  if (stmt == NULL) {
+    pReq->taosCode = terrno;
+    goto _end;
+  }
+
+  int32_t code = taos_stmt_prepare(stmt, sql, 0);
+  if (code != TSDB_CODE_SUCCESS) {
+    httpError("context:%p, failed to prepare sql:%s, reason:%s", pReq->pContext, sql, tstrerror(code));
+    pReq->taosCode = code;
+    goto _end;
+  }
+
+  for (int32_t s = 0, e = 0; s < numOfPoints; s = e) {
+    for (e = s + 1; e < numOfPoints && strcmp(points[e]->table, points[s]->table) == 0; ++e) {
+    }
+
+    if (!lpSetTableTags(pReq, stmt, columns, numOfCols, points[s]) ||
+        !lpBindRows(pReq, stmt, columns, cols, numOfCols, points + s, e - s)) {
+      goto _end;
+    }
+  }
+
+  code = taos_stmt_execute(stmt);
+  if (code != TSDB_CODE_SUCCESS) {
+    httpError("context:%p, failed to insert the points of stable %s, reason:%s", pReq->pContext, points[0]->stable,
+              tstrerror(code));
+    pReq->taosCode = code;
+    goto _end;
+  }
+
+  succ = true;
+
+_end:
+  if (stmt != NULL) {
+    taos_stmt_close(stmt);
+  }
+
+  if (cols != NULL) {
+    for (int32_t c = 0; c < numOfCols; ++c) {
+      free(cols[c].buffer);
+      free(cols[c].is_null);
+      free(cols[c].length);
+    }
+    free(cols);
+  }
+
+  free(sql);
+  return succ;
+}
+
+/*
+ * The super table is described, or created if it does not exist. The fields and tags of the points not in it are
+ * added to it, and it is described again, before the points are bound to the columns.
+ */
+static bool lpInsertStableImp(SLpRequest *pReq, TAOS *taos, SLpPoint **points, int32_t numOfPoints) {
+  SArray *columns = taosArrayInit(16, sizeof(SLpColumn));
+  SArray *newCols = taosArrayInit(4, sizeof(SLpColumn));
+  SArray *newTags = taosArrayInit(4, sizeof(SLpColumn));
+  int32_t numOfCols = 0;
+  bool    succ = false;
+
+  if (columns == NULL || newCols == NULL || newTags == NULL) {
+    lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+    goto _end;
+  }
+
+  int32_t code = lpDescribeStable(pReq, taos, points[0]->stable, columns, &numOfCols);
+  if (code != TSDB_CODE_SUCCESS) {
+    code = lpCreateStable(pReq, taos, points, numOfPoints);
+    if (code == TSDB_CODE_SUCCESS) {
+      taosArrayClear(columns);
+      code = lpDescribeStable(pReq, taos, points[0]->stable, columns, &numOfCols);
+    }
+  }
+
+  if (code == TSDB_CODE_SUCCESS && pReq->precision < 0) {
+    code = lpGetDbPrecision(pReq, taos);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    pReq->taosCode = code;
+    goto _end;
+  }
+
+  if (!lpMapColumns(pReq, columns, numOfCols, points, numOfPoints, newCols, newTags)) {
+    goto _end;
+  }
+
+  if (taosArrayGetSize(newCols) > 0 || taosArrayGetSize(newTags) > 0) {
+    code = lpAlterStable(pReq, taos, points[0]->stable, newCols, newTags);
+    if (code == TSDB_CODE_SUCCESS) {
+      taosArrayClear(columns);
+      code = lpDescribeStable(pReq, taos, points[0]->stable, columns, &numOfCols);
+    }
+
+    if (code != TSDB_CODE_SUCCESS) {
+      pReq->taosCode = code;
+      goto _end;
+    }
+
+    if (!lpMapColumns(pReq, columns, numOfCols, points, numOfPoints, NULL, NULL)) {
+      goto _end;
+    }
+  }
+
+  succ = lpBindPoints(pReq, taos, columns, numOfCols, points, numOfPoints);
+
+_end:
+  taosArrayDestroy(columns);
+  taosArrayDestroy(newCols);
+  taosArrayDestroy(newTags);
+  return succ;
+}
+
+// the table meta cached by the client is out of date if the super table or the database is dropped by others
+static bool lpIsMetaExpired(int32_t code) {
+  return code == TSDB_CODE_MND_INVALID_TABLE_NAME || code == TSDB_CODE_MND_INVALID_TABLE_ID ||
+         code == TSDB_CODE_MND_INVALID_DB || code == TSDB_CODE_TDB_INVALID_TABLE_ID ||
+         code == TSDB_CODE_TDB_TABLE_SCHEMA_VERSION;
+}
+
+static bool lpInsertStable(SLpRequest *pReq, TAOS *taos, SLpPoint **points, int32_t numOfPoints) {
+  if (lpInsertStableImp(pReq, taos, points, numOfPoints)) {
+    return true;
+  }
+
+  if (pReq->httpCode != HTTP_SUCCESS || !lpIsMetaExpired(pReq->taosCode)) {
+    return false;
+  }
+
+  httpTrace("context:%p, retry stable %s since the table meta is expired, reason:%s", pReq->pContext,
+            points[0]->stable, tstrerror(pReq->taosCode));
+  pReq->taosCode = lpExecSql(taos, "reset query cache");
+  if (pReq->taosCode != TSDB_CODE_SUCCESS) {
+    return false;
+  }
+
+  // the database may be created again with another precision
+  pReq->precision = -1;
+
+  return lpInsertStableImp(pReq, taos, points, numOfPoints);
+}
+
+static int lpComparePoint(const void *a, const void *b) {
+  const SLpPoint *pPoint1 = *(const SLpPoint **)a;
+  const SLpPoint *pPoint2 = *(const SLpPoint **)b;
+
+  int ret = strcmp(pPoint1->stable, pPoint2->stable);
+  if (ret == 0) {
+    ret = strcmp(pPoint1->table, pPoint2->table);
+  }
+  if (ret == 0) {
+    ret = (pPoint1->index < pPoint2->index) ? -1 : 1;
+  }
+
+  return ret;
+}
+
+// the points are grouped by the super tables and the child tables, and inserted a super table at a time
+static bool lpInsertPoints(SLpRequest *pReq, TAOS *taos) {
+  int32_t    numOfPoints = (int32_t)taosArrayGetSize(pReq->points);
+  SLpPoint **points = malloc(sizeof(SLpPoint *) * numOfPoints);
+  if (points == NULL) {
+    return lpSetError(pReq, HTTP_NO_ENOUGH_MEMORY, NULL);
+  }
+
+  for (int32_t i = 0; i < numOfPoints; ++i) {
+    points[i] = taosArrayGet(pReq->points, (size_t)i);
+  }
+  qsort(points, (size_t)numOfPoints, sizeof(SLpPoint *), lpComparePoint);
+
+  bool succ = true;
+  for (int32_t s = 0, e = 0; s < numOfPoints && succ; s = e) {
+    for (e = s + 1; e < numOfPoints && strcmp(points[e]->stable, points[s]->stable) == 0; ++e) {
+    }
+    succ = lpInsertStable(pReq, taos, points + s, e - s);
+  }
+
+  free(points);
+  return succ;
+}
+
+static void lpProcessLine(SSchedMsg *pMsg) {
+  HttpContext *pContext = pMsg->ahandle;
+  SLpRequest   req = {0};
+
+  req.pContext = pContext;
+  req.db = pContext->parser.path[LP_DB_URL_POS].pos;
+  req.precision = -1;
+  req.points = taosArrayInit(64, sizeof(SLpPoint));
+  req.values = taosArrayInit(256, sizeof(SLpValue));
+
+  char *data = pContext->parser.data.pos;
+  while (isspace((uint8_t)*data)) data++;
+
+  if (req.points == NULL || req.values == NULL) {
+    lpSetError(&req, HTTP_NO_ENOUGH_MEMORY, NULL);
+  } else if (*data == '{' ? lpParseJson(&req, data) : lpParseLines(&req, data)) {
+    if (taosArrayGetSize(req.points) == 0) {
+      lpSetError(&req, HTTP_LP_POINTS_NULL, NULL);
+    } else {
+      httpTrace("context:%p, fd:%d, ip:%s, insert %d points into db:%s", pContext, pContext->fd, pContext->ipstr,
+                (int)taosArrayGetSize(req.points), req.db);
+      lpInsertPoints(&req, pContext->session->taos);
+    }
+  }
+
+  if (req.httpCode != HTTP_SUCCESS) {
+    httpSendErrorRespWithDesc(pContext, req.httpCode, (req.desc[0] != 0) ? req.desc : NULL);
+  } else if (req.taosCode != TSDB_CODE_SUCCESS) {
+    httpSendTaosdErrorResp(pContext, req.taosCode);
+  } else {
+    char desc[64] = {0};
+    snprintf(desc, sizeof(desc), "%d points", (int)taosArrayGetSize(req.points));
+    httpSendSuccResp(pContext, desc);
+  }
+
+  cJSON_Delete(req.root);
+  taosArrayDestroy(req.points);
+  taosArrayDestroy(req.values);
+  free(req.name);
+}
+
+void lpProcessLineCmd(HttpContext *pContext) {
+  if (lpQhandle == NULL) {
+    httpSendErrorResp(pContext, HTTP_SERVER_OFFLINE);
+    return;
+  }
+
+  SSchedMsg schedMsg = {0};
+  schedMsg.fp = lpProcessLine;
+  schedMsg.ahandle = pContext;
+  taosScheduleTask(lpQhandle, &schedMsg);
+}
+
+void lpInitHandle(HttpServer *pServer) {
+  lpQhandle = taosInitScheduler(LP_QUEUE_SIZE, tsHttpMaxThreads, "http-lp");
+  if (lpQhandle == NULL) {
+    httpError("failed to init the workers of line protocol");
+  }
+
+  httpAddMethod(pServer, &lpDecodeMethod);
+}
+
+void lpCleanupHandle() {
+  if (lpQhandle != NULL) {
+    taosCleanUpScheduler(lpQhandle);
+    lpQhandle = NULL;
+  }
+}
+
+bool lpProcessRequest(struct HttpContext *pContext) {
+  if (strlen(pContext->user) == 0 || strlen(pContext->pass) == 0) {
+    httpSendErrorResp(pContext, HTTP_PARSE_USR_ERROR);
+    return false;
+  }
+
+  HttpParser *pParser = &pContext->parser;
+  if (pParser->path[LP_DB_URL_POS].len <= 0) {
+    httpSendErrorResp(pContext, HTTP_LP_DB_NOT_INPUT);
+    return false;
+  }
+
+  if (pParser->path[LP_DB_URL_POS].len >= TSDB_DB_NAME_LEN) {
+    httpSendErrorResp(pContext, HTTP_LP_DB_TOO_LONG);
+    return false;
+  }
+
+  int64_t tsUnit = 0;
+  if (!lpGetPrecision(pContext, false, &tsUnit)) {
+    httpSendErrorResp(pContext, HTTP_LP_INVALID_PRECISION);
+    return false;
+  }
+
+  if (pParser->data.pos == NULL) {
+    httpSendErrorResp(pContext, HTTP_NO_MSG_INPUT);
+    return false;
+  }
+
+  pContext->reqType = HTTP_REQTYPE_LINE;
+  return true;
+}
@@ -22,6 +22,7 @@
 #include "ttimer.h"
 #include "tutil.h"
 #include "tsystem.h"
+#include "tmempool.h"
 #include "tscUtil.h"
 #include "tsclient.h"
 #include "dnode.h"
@@ -45,6 +46,8 @@ typedef enum {
   MONITOR_CMD_CREATE_TB_DN,
   MONITOR_CMD_CREATE_TB_ACCT_ROOT,
   MONITOR_CMD_CREATE_TB_SLOWQUERY,
+  MONITOR_CMD_CREATE_MT_MEM,
+  MONITOR_CMD_CREATE_TB_MEM,
   MONITOR_CMD_MAX
 } EMonitorCommand;
 
@@ -184,6 +187,17 @@ static void dnodeBuildMonitorSql(char *sql, int32_t cmd) {
              "create table if not exists %s.slowquery(ts timestamp, username "
              "binary(%d), created_time timestamp, time bigint, sql binary(%d))",
              tsMonitorDbName, TSDB_TABLE_ID_LEN - 1, TSDB_SLOW_QUERY_SQL_LEN);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_MEM) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.mem(ts timestamp"
+             ", slab_alloc bigint, slab_free bigint, slab_large bigint, slab_refill bigint"
+             ", slab_used bigint, slab_reserved bigint"
+             ", blkcache_hits bigint, blkcache_misses bigint"
+             ") tags (dnodeid int, fqdn binary(%d))",
+             tsMonitorDbName, TSDB_FQDN_LEN);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_MEM) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.mem%d using %s.mem tags(%d, '%s')", tsMonitorDbName,
+             dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
   } else if (cmd == MONITOR_CMD_CREATE_TB_LOG) {
     snprintf(sql, SQL_LENGTH,
              "create table if not exists %s.log(ts timestamp, level tinyint, "
@@ -261,6 +275,16 @@ static void dnodeMontiorInsertSysCallback(void *param, TAOS_RES *result, int32_t
   }
 }
 
+static void dnodeMontiorInsertMemCallback(void *param, TAOS_RES *result, int32_t code) {
+  if (code < 0) {
+    monitorError("monitor:%p, save memory info failed, code:%s", tsMonitorConn.conn, tstrerror(code));
+  } else if (code == 0) {
+    monitorError("monitor:%p, save memory info failed, affect rows:%d", tsMonitorConn.conn, code);
+  } else {
+    monitorTrace("monitor:%p, save memory info success, code:%s", tsMonitorConn.conn, tstrerror(code));
+  }
+}
+
 static void dnodeMontiorInsertLogCallback(void *param, TAOS_RES *result, int32_t code) {
   if (code < 0) {
     monitorError("monitor:%p, save log failed, code:%s", tsMonitorConn.conn, tstrerror(code));
@@ -319,9 +343,8 @@ static int32_t monitorBuildBandSql(char *sql) {
   return sprintf(sql, ", %f", bandSpeedKb);
 }
 
-static int32_t monitorBuildReqSql(char *sql) {
-  SDnodeStatisInfo info = dnodeGetStatisInfo(); 
-  return sprintf(sql, ", %d, %d, %d)", info.httpReqNum, info.queryReqNum, info.submitReqNum);
+static int32_t monitorBuildReqSql(char *sql, SDnodeStatisInfo *pInfo) {
+  return sprintf(sql, ", %d, %d, %d)", pInfo->httpReqNum, pInfo->queryReqNum, pInfo->submitReqNum);
 }
 
 static int32_t monitorBuildIoSql(char *sql) {
@@ -334,6 +357,26 @@ static int32_t monitorBuildIoSql(char *sql) {
   return sprintf(sql, ", %f, %f", readKB, writeKB);
 }
 
+/*
+ * counters of the allocator of the queue items and RPC messages, the bytes are the in use and the reserved ones,
+ * and the hits and misses of the block caches of the vnodes open
+ */
+static void monitorSaveMemInfo(SDnodeStatisInfo *pInfo) {
+  SSlabStatis statis;
+  char        sql[SQL_LENGTH] = {0};
+
+  taosGetSlabStatis(&statis);
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.mem%d values(%" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64
+           ", %" PRId64 ", %" PRId64 ", %" PRId64 ")",
+           tsMonitorDbName, dnodeGetDnodeId(), taosGetTimestampUs(), statis.numOfAllocs, statis.numOfFrees,
+           statis.numOfLarges, statis.numOfRefills, statis.usedBytes, statis.reservedBytes, pInfo->blockCacheHits,
+           pInfo->blockCacheMisses);
+
+  monitorTrace("monitor:%p, save memory info, sql:%s", tsMonitorConn.conn, sql);
+  taos_query_a(tsMonitorConn.conn, sql, dnodeMontiorInsertMemCallback, "mem");
+}
+
 static void monitorSaveSystemInfo() {
   if (tsMonitorConn.state != MONITOR_STATE_INITIALIZED) {
     monitorStartTimer();
@@ -344,16 +387,21 @@ static void monitorSaveSystemInfo() {
   char *  sql = tsMonitorConn.sql;
   int32_t pos = snprintf(sql, SQL_LENGTH, "insert into %s.dn%d values(%" PRId64, tsMonitorDbName, dnodeGetDnodeId(), ts);
 
+  // the request counters are reset as they are read, the mem table takes the other counters of the same read
+  SDnodeStatisInfo info = dnodeGetStatisInfo();
+
   pos += monitorBuildCpuSql(sql + pos);
   pos += monitorBuildMemorySql(sql + pos);
   pos += monitorBuildDiskSql(sql + pos);
   pos += monitorBuildBandSql(sql + pos);
   pos += monitorBuildIoSql(sql + pos);
-  pos += monitorBuildReqSql(sql + pos);
+  pos += monitorBuildReqSql(sql + pos, &info);
 
   monitorTrace("monitor:%p, save system info, sql:%s", tsMonitorConn.conn, sql);
   taos_query_a(tsMonitorConn.conn, sql, dnodeMontiorInsertSysCallback, "log");
 
+  monitorSaveMemInfo(&info);
+
   if (tsMonitorConn.timer != NULL && tsMonitorConn.state != MONITOR_STATE_STOPPED) {
     monitorStartTimer();
   }
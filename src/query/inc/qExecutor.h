@@ -121,11 +121,22 @@ typedef struct SQueryCostInfo {
   uint32_t totalBlocks;
   uint32_t loadBlocks;
   uint32_t loadBlockStatis;
+  uint32_t statisBlocks;     // blocks aggregated by the block statistics, without loading the data
   uint32_t discardBlocks;
+  uint32_t numOfYields;      // executions stopped by the time slice
   uint64_t elapsedTime;
   uint64_t computTime;
 } SQueryCostInfo;
 
+typedef struct SQueryStatusInfo {
+  int32_t     status;       // query status
+  TSKEY       lastKey;      // the lastKey value before query executed
+  STimeWindow w;            // whole query time window
+  STimeWindow curWindow;    // current query window
+  int32_t     windowIndex;  // index of active time window result for interval query
+  STSCursor   cur;
+} SQueryStatusInfo;
+
 typedef struct SGroupItem {
   STableId         id;
   STableQueryInfo* info;
@@ -150,6 +161,7 @@ typedef struct SQuery {
   SColumnInfo*     colList;
   SColumnInfo*     tagColList;
   int32_t          numOfFilterCols;
+  int32_t          compressColData;  // result columns larger than it are encoded in the retrieve rsp, -1 for none
   int64_t*         fillVal;
   uint32_t         status;  // query status
   SResultRec       rec;
@@ -177,6 +189,12 @@ typedef struct SQueryRuntimeEnv {
   void*                pSecQueryHandle;  // another thread for
   SDiskbasedResultBuf* pResultBuf;       // query result buffer based on blocked-wised disk file
   bool                 topBotQuery;      // false;
+  int64_t              sliceEndTime;     // us when the time slice of current execution is used up, 0 for no limit
+  bool                 yieldable;        // the scan can be stopped by the time slice and resumed
+  bool                 yielded;          // the scan of current execution is stopped by the time slice
+  bool                 resumeScan;       // the stopped table scan is resumed with resumeStatus
+  SQueryStatusInfo     resumeStatus;
+  int32_t              numOfThreads;     // threads scanning the tables of a super table query, 0 or 1 for serial
 } SQueryRuntimeEnv;
 
 typedef struct SQInfo {
@@ -203,6 +221,15 @@ typedef struct SQInfo {
    */
   int32_t tableIndex;
   int32_t numOfGroupResultPages;
+
+  struct SQInfo* pMaster;  // the query this table scan worker belongs to, NULL if it is not a worker
 } SQInfo;
 
+/**
+ * Encode the result columns of the rows into the data of a retrieve rsp
+ *
+ * @return the end of the encoded data
+ */
+char *doEncodeQueryResult(SQuery *pQuery, int32_t numOfRows, char *data);
+
 #endif  // TDENGINE_QUERYEXECUTOR_H
@@ -26,6 +26,7 @@ extern "C" {
 
 #include "taosmsg.h"
 #include "taosdef.h"
+#include "tbitmap.h"
 #include "tvariant.h"
 
 struct tExprNode;
@@ -39,6 +40,9 @@ enum {
 
 typedef bool (*__result_filter_fn_t)(const void *, void *);
 typedef void (*__do_filter_suppl_fn_t)(void *, void *);
+typedef void *(*__get_index_fn_t)(void *, int32_t);
+typedef int32_t (*__get_elem_id_fn_t)(const void *);
+typedef bool (*__get_elem_fn_t)(void *, int32_t, void *);
 
 /**
  * this structure is used to filter data in tags, so the offset of filtered tag column in tagdata string is required
@@ -57,6 +61,10 @@ typedef struct SExprTraverseSupp {
   __result_filter_fn_t   nodeFilterFn;
   __do_filter_suppl_fn_t setupInfoFn;
   void *                 pExtInfo;
+  __get_index_fn_t       getIndexFn;  // skiplist index on the tag column of an index in schema, or NULL
+  void *                 pIndexInfo;  // parameter of getIndexFn and getElemFn
+  __get_elem_id_fn_t     getElemIdFn; // id of an element, the bit of it in the result bitmap
+  __get_elem_fn_t        getElemFn;   // fill the element of an id, false if there is none
 } SExprTraverseSupp;
 
 typedef struct tExprNode {
@@ -81,7 +89,12 @@ void tSQLBinaryExprToString(tExprNode *pExpr, char *dst, int32_t *len);
 
 void tExprTreeDestroy(tExprNode **pExprs, void (*fp)(void*));
 
-void tExprTreeTraverse(tExprNode *pExpr, SSkipList *pSkipList, SArray *result, SExprTraverseSupp *param);
+/*
+ * The elements satisfying the expression are set in the result bitmap by their ids. The indexed conditions are
+ * answered by the indexes and combined a word at a time, the others are applied on the candidates left only.
+ * It returns TSDB_CODE_QRY_OUT_OF_MEMORY if a bitmap of the intermediate result can not be created.
+ */
+int32_t tExprTreeTraverseBitmap(tExprNode *pExpr, SSkipList *pSkipList, SBitmap *pResult, SExprTraverseSupp *param);
 
 void tExprTreeCalcTraverse(tExprNode *pExprs, int32_t numOfRows, char *pOutput, void *param, int32_t order,
                                 char *(*cb)(void *, const char*, int32_t));
@@ -27,6 +27,7 @@
 #include "tdataformat.h"
 #include "tlosertree.h"
 #include "tscUtil.h"  // todo move the function to common module
+#include "tsched.h"
 #include "tscompression.h"
 #include "ttime.h"
 
@@ -45,9 +46,15 @@
 
 #define GET_QINFO_ADDR(x) ((void *)((char *)(x)-offsetof(SQInfo, runtimeEnv)))
 
+// all the group results share one page id list in the disk-based result buffer
+#define GROUPRESULTID 1
+
 #define GET_COL_DATA_POS(query, index, step) ((query)->pos + (index) * (step))
 #define SWITCH_ORDER(n) (((n) = ((n) == TSDB_ORDER_ASC) ? TSDB_ORDER_DESC : TSDB_ORDER_ASC))
 
+// the table scans of the parallel queries waiting for a scan thread
+#define QUERY_SCAN_QUEUE_SIZE 1024
+
 /* get the qinfo struct address from the query struct address */
 #define GET_COLUMN_BYTES(query, colidx) \
   ((query)->colList[(query)->pSelectExpr[colidx].base.colInfo.colIndex].bytes)
@@ -80,20 +87,14 @@ enum {
   TS_JOIN_TAG_NOT_EQUALS = 2,
 };
 
-typedef struct {
-  int32_t     status;       // query status
-  TSKEY       lastKey;      // the lastKey value before query executed
-  STimeWindow w;            // whole query time window
-  STimeWindow curWindow;    // current query window
-  int32_t     windowIndex;  // index of active time window result for interval query
-  STSCursor   cur;
-} SQueryStatusInfo;
-
 #define CLEAR_QUERY_STATUS(q, st)   ((q)->status &= (~(st)))
 static void setQueryStatus(SQuery *pQuery, int8_t status);
 
 static bool isIntervalQuery(SQuery *pQuery) { return pQuery->intervalTime > 0; }
 
+static pthread_mutex_t scanSchedMutex = PTHREAD_MUTEX_INITIALIZER;
+static void *          scanQhandle = NULL;
+
 // todo move to utility
 static int32_t mergeIntoGroupResultImpl(SQInfo *pQInfo, SArray *group);
 
@@ -648,7 +649,7 @@ static void doBlockwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SWindowStat
       pCtx[k].size = forwardStep;
       pCtx[k].startOffset = (QUERY_IS_ASC_QUERY(pQuery)) ? offset : offset - (forwardStep - 1);
 
-      if ((aAggs[functionId].nStatus & TSDB_FUNCSTATE_SELECTIVITY) != 0) {
+      if ((aAggs[functionId].nStatus & TSDB_FUNCSTATE_SELECTIVITY) != 0 && tsBuf != NULL) {
         pCtx[k].ptsList = &tsBuf[offset];
       }
 
@@ -847,7 +848,25 @@ static void blockwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *
   }
 
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
-  if (isIntervalQuery(pQuery)) {
+  if (isIntervalQuery(pQuery) && tsCols == NULL) {
+    /*
+     * the data block is not loaded, since it lies entirely inside one time window, see loadDataBlockOnDemand.
+     * All rows are aggregated into this window with the block statistics.
+     */
+    TSKEY       ts = QUERY_IS_ASC_QUERY(pQuery) ? pDataBlockInfo->window.skey : pDataBlockInfo->window.ekey;
+    STimeWindow win = getActiveTimeWindow(pWindowResInfo, ts, pQuery);
+    if (setWindowOutputBufByKey(pRuntimeEnv, pWindowResInfo, pDataBlockInfo->tid, &win) != TSDB_CODE_SUCCESS) {
+      tfree(sasArray);
+      return;
+    }
+
+    TSKEY lastKey = QUERY_IS_ASC_QUERY(pQuery) ? pDataBlockInfo->window.ekey : pDataBlockInfo->window.skey;
+    pQuery->current->lastKey = lastKey + step;
+
+    SWindowStatus *pStatus = getTimeWindowResStatus(pWindowResInfo, curTimeWindow(pWindowResInfo));
+    doBlockwiseApplyFunctions(pRuntimeEnv, pStatus, &win, pQuery->pos, pDataBlockInfo->rows, NULL,
+                              pDataBlockInfo->rows);
+  } else if (isIntervalQuery(pQuery)) {
     int32_t offset = GET_COL_DATA_POS(pQuery, 0, step);
     TSKEY   ts = tsCols[offset];
 
@@ -915,8 +934,6 @@ static int32_t setGroupResultOutputBuf(SQueryRuntimeEnv *pRuntimeEnv, char *pDat
     return -1;
   }
 
-  int32_t GROUPRESULTID = 1;
-
   SDiskbasedResultBuf *pResultBuf = pRuntimeEnv->pResultBuf;
 
   int64_t v = -1;
@@ -1495,6 +1512,11 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
 }
 
 static bool isQueryKilled(SQInfo *pQInfo) {
+  // a table scan worker is killed along with its query
+  if (pQInfo->pMaster != NULL) {
+    pQInfo = pQInfo->pMaster;
+  }
+
   return (pQInfo->code == TSDB_CODE_TSC_QUERY_CANCELLED);
 }
 
@@ -1912,7 +1934,52 @@ static void getNextTimeWindow(SQuery *pQuery, STimeWindow *pTimeWindow) {
   pTimeWindow->ekey = pTimeWindow->skey + (pQuery->intervalTime - 1);
 }
 
-SArray *loadDataBlockOnDemand(SQueryRuntimeEnv *pRuntimeEnv, void* pQueryHandle, SDataBlockInfo* pBlockInfo, SDataStatis **pStatis) {
+// the functions of an interval query that can be computed from the block statistics of a whole data block
+static bool isBlockStatisSufficient(SQuery *pQuery) {
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    int32_t functionId = pQuery->pSelectExpr[i].base.functionId;
+    if (functionId != TSDB_FUNC_COUNT && functionId != TSDB_FUNC_SUM && functionId != TSDB_FUNC_AVG &&
+        functionId != TSDB_FUNC_MIN && functionId != TSDB_FUNC_MAX && functionId != TSDB_FUNC_SPREAD &&
+        functionId != TSDB_FUNC_TS && functionId != TSDB_FUNC_TAG && functionId != TSDB_FUNC_TAG_DUMMY &&
+        functionId != TSDB_FUNC_TAGPRJ) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * A data block that lies entirely inside one time window of a tumbling window query is aggregated as a whole,
+ * so the functions that accept the block statistics do not need the data block to be loaded.
+ */
+static bool isBlockInOneTimeWindow(SQuery *pQuery, SWindowResInfo *pWindowResInfo, STimeWindow *pBlockWin) {
+  if (pQuery->slidingTime != pQuery->intervalTime) {
+    return false;
+  }
+
+  // the first time window is not decided yet
+  if (pWindowResInfo->curIndex == -1 && pWindowResInfo->prevSKey == TSKEY_INITIAL_VAL) {
+    return false;
+  }
+
+  TSKEY sk = MIN(pQuery->window.skey, pQuery->window.ekey);
+  TSKEY ek = MAX(pQuery->window.skey, pQuery->window.ekey);
+  if (pBlockWin->skey < sk || pBlockWin->ekey > ek) {
+    return false;
+  }
+
+  if (QUERY_IS_ASC_QUERY(pQuery)) {
+    STimeWindow w = getActiveTimeWindow(pWindowResInfo, pBlockWin->skey, pQuery);
+    return pBlockWin->ekey <= w.ekey;
+  } else {
+    STimeWindow w = getActiveTimeWindow(pWindowResInfo, pBlockWin->ekey, pQuery);
+    return pBlockWin->skey >= w.skey;
+  }
+}
+
+SArray *loadDataBlockOnDemand(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, void *pQueryHandle,
+                              SDataBlockInfo *pBlockInfo, SDataStatis **pStatis) {
   SQuery *pQuery = pRuntimeEnv->pQuery;
 
   uint32_t r = 0;
@@ -1930,7 +1997,11 @@ SArray *loadDataBlockOnDemand(SQueryRuntimeEnv *pRuntimeEnv, void* pQueryHandle,
       r |= aAggs[functionId].dataReqFunc(&pRuntimeEnv->pCtx[i], pQuery->window.skey, pQuery->window.ekey, colId);
     }
 
-    if (pRuntimeEnv->pTSBuf > 0 || isIntervalQuery(pQuery)) {
+    if (pRuntimeEnv->pTSBuf > 0) {
+      r |= BLK_DATA_ALL_NEEDED;
+    } else if (isIntervalQuery(pQuery) &&
+               (isGroupbyNormalCol(pQuery->pGroupbyExpr) || !isBlockStatisSufficient(pQuery) ||
+                !isBlockInOneTimeWindow(pQuery, pWindowResInfo, &pBlockInfo->window))) {
       r |= BLK_DATA_ALL_NEEDED;
     }
   }
@@ -1949,6 +2020,9 @@ SArray *loadDataBlockOnDemand(SQueryRuntimeEnv *pRuntimeEnv, void* pQueryHandle,
     if (*pStatis == NULL) { // data block statistics does not exist, load data block
       pDataBlock = tsdbRetrieveDataBlock(pQueryHandle, NULL);
       pRuntimeEnv->summary.totalCheckedRows += pBlockInfo->rows;
+      pRuntimeEnv->summary.loadBlocks += 1;
+    } else {
+      pRuntimeEnv->summary.statisBlocks += 1;
     }
   } else {
     assert(r == BLK_DATA_ALL_NEEDED);
@@ -2104,6 +2178,24 @@ static void ensureOutputBuffer(SQueryRuntimeEnv* pRuntimeEnv, SDataBlockInfo* pB
   }
 }
 
+/*
+ * The scan of an execution is stopped at a block boundary once its time slice is used up, and the next execution goes
+ * on with the next block of the query handle. Only the master scan of the executors that allow it is stopped.
+ */
+static bool isTimeSliceUsedUp(SQueryRuntimeEnv *pRuntimeEnv) {
+  if (!pRuntimeEnv->yieldable || pRuntimeEnv->sliceEndTime == 0 || !IS_MASTER_SCAN(pRuntimeEnv)) {
+    return false;
+  }
+
+  if (taosGetTimestampUs() < pRuntimeEnv->sliceEndTime) {
+    return false;
+  }
+
+  pRuntimeEnv->yielded = true;
+  pRuntimeEnv->summary.numOfYields += 1;
+  return true;
+}
+
 static int64_t doScanAllDataBlocks(SQueryRuntimeEnv *pRuntimeEnv) {
   SQuery *pQuery = pRuntimeEnv->pQuery;
   STableQueryInfo* pTableQueryInfo = pQuery->current;
@@ -2148,7 +2240,8 @@ static int64_t doScanAllDataBlocks(SQueryRuntimeEnv *pRuntimeEnv) {
     ensureOutputBuffer(pRuntimeEnv, &blockInfo);
 
     SDataStatis *pStatis = NULL;
-    SArray *pDataBlock = loadDataBlockOnDemand(pRuntimeEnv, pQueryHandle, &blockInfo, &pStatis);
+    SArray *pDataBlock =
+        loadDataBlockOnDemand(pRuntimeEnv, &pRuntimeEnv->windowResInfo, pQueryHandle, &blockInfo, &pStatis);
 
     // query start position can not move into tableApplyFunctionsOnBlock due to limit/offset condition
     pQuery->pos = QUERY_IS_ASC_QUERY(pQuery)? 0 : blockInfo.rows - 1;
@@ -2162,6 +2255,12 @@ static int64_t doScanAllDataBlocks(SQueryRuntimeEnv *pRuntimeEnv) {
     if (Q_STATUS_EQUAL(pQuery->status, QUERY_RESBUF_FULL | QUERY_COMPLETED)) {
       break;
     }
+
+    if (isTimeSliceUsedUp(pRuntimeEnv)) {
+      qTrace("QInfo:%p time slice is used up, yield at lastKey:%" PRId64, GET_QINFO_ADDR(pRuntimeEnv),
+             pTableQueryInfo->lastKey);
+      return 0;
+    }
   }
 
   // if the result buffer is not full, set the query complete
@@ -3096,8 +3195,14 @@ void scanOneTableDataBlocks(SQueryRuntimeEnv *pRuntimeEnv, TSKEY start) {
   
   setQueryStatus(pQuery, QUERY_NOT_COMPLETED);
 
-  // store the start query position
-  SQueryStatusInfo qstatus = getQueryStatusInfo(pRuntimeEnv, start);
+  // store the start query position, or restore it when the scan stopped by the previous execution is resumed
+  SQueryStatusInfo qstatus;
+  if (pRuntimeEnv->resumeScan) {
+    qstatus = pRuntimeEnv->resumeStatus;
+    pRuntimeEnv->resumeScan = false;
+  } else {
+    qstatus = getQueryStatusInfo(pRuntimeEnv, start);
+  }
 
   SET_MASTER_SCAN_FLAG(pRuntimeEnv);
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
@@ -3105,6 +3210,12 @@ void scanOneTableDataBlocks(SQueryRuntimeEnv *pRuntimeEnv, TSKEY start) {
   while (1) {
     doScanAllDataBlocks(pRuntimeEnv);
 
+    if (pRuntimeEnv->yielded) {
+      pRuntimeEnv->resumeStatus = qstatus;
+      pRuntimeEnv->resumeScan = true;
+      return;
+    }
+
     if (pRuntimeEnv->scanFlag == MASTER_SCAN) {
       qstatus.status = pQuery->status;
       qstatus.curWindow.ekey = pTableQueryInfo->lastKey - step;
@@ -3251,7 +3362,6 @@ void setExecutionContext(SQInfo *pQInfo, STableId* pTableId, int32_t groupIndex,
   STableQueryInfo *pTableQueryInfo = pRuntimeEnv->pQuery->current;
   
   SWindowResInfo *  pWindowResInfo = &pRuntimeEnv->windowResInfo;
-  int32_t           GROUPRESULTID = 1;
 
   SWindowResult *pWindowRes = doSetTimeWindowFromKey(pRuntimeEnv, pWindowResInfo, (char *)&groupIndex, sizeof(groupIndex));
   if (pWindowRes == NULL) {
@@ -3615,13 +3725,51 @@ bool queryHasRemainResults(SQueryRuntimeEnv* pRuntimeEnv) {
   return false;
 }
 
-static void doCopyQueryResultToMsg(SQInfo *pQInfo, int32_t numOfRows, char *data) {
-  SQuery *pQuery = pQInfo->runtimeEnv.pQuery;
+/*
+ * Each result column is encoded by the codec of its type, the same as the data blocks in files. The columns no larger
+ * than compressColData are copied, so are the ones of no codec.
+ */
+char *doEncodeQueryResult(SQuery *pQuery, int32_t numOfRows, char *data) {
+  *(int32_t *)data = htonl(pQuery->numOfOutput);
+  data += sizeof(int32_t);
+
   for (int32_t col = 0; col < pQuery->numOfOutput; ++col) {
-    int32_t bytes = pQuery->pSelectExpr[col].bytes;
+    SRetrieveColumn *pCol = (SRetrieveColumn *)data;
+    int16_t          type = pQuery->pSelectExpr[col].type;
+    int32_t          bytes = pQuery->pSelectExpr[col].bytes;
+    int32_t          len = bytes * numOfRows;
+
+    pCol->type = (int8_t)type;
+    pCol->bytes = htons(bytes);
+    if (len > pQuery->compressColData && tDataTypeDesc[type].compFunc != NULL) {
+      pCol->comp = ONE_STAGE_COMP;
+      len = (*tDataTypeDesc[type].compFunc)(pQuery->sdata[col]->data, len, numOfRows, pCol->data,
+                                           len + COMP_OVERFLOW_BYTES, ONE_STAGE_COMP, NULL, 0);
+    } else {
+      pCol->comp = NO_COMPRESSION;
+      memmove(pCol->data, pQuery->sdata[col]->data, len);
+    }
 
-    memmove(data, pQuery->sdata[col]->data, bytes * numOfRows);
-    data += bytes * numOfRows;
+    pCol->len = htonl(len);
+    data += sizeof(SRetrieveColumn) + len;
+  }
+
+  return data;
+}
+
+static int32_t doCopyQueryResultToMsg(SQInfo *pQInfo, int32_t numOfRows, char *data) {
+  SQuery *pQuery = pQInfo->runtimeEnv.pQuery;
+  char *  start = data;
+
+  if (pQuery->compressColData >= 0) {
+    data = doEncodeQueryResult(pQuery, numOfRows, data);
+  } else {
+    for (int32_t col = 0; col < pQuery->numOfOutput; ++col) {
+      int32_t bytes = pQuery->pSelectExpr[col].bytes;
+
+      memmove(data, pQuery->sdata[col]->data, bytes * numOfRows);
+      data += bytes * numOfRows;
+    }
   }
 
   int32_t numOfTables = (int32_t)taosArrayGetSize(pQInfo->arrTableIdInfo);
@@ -3648,6 +3796,8 @@ static void doCopyQueryResultToMsg(SQInfo *pQInfo, int32_t numOfRows, char *data
       }
     }
   }
+
+  return (int32_t)(data - start);
 }
 
 int32_t doFillGapsInResults(SQueryRuntimeEnv* pRuntimeEnv, tFilePage **pDst, int32_t *numOfInterpo) {
@@ -3717,8 +3867,10 @@ static void queryCostStatis(SQInfo *pQInfo) {
 //      pSummary->skippedFileBlocks, pSummary->totalGenData);
   
   qTrace("QInfo:%p :cost summary: elpased time:%"PRId64" us, total blocks:%d, use block statis:%d, use block data:%d, "
-         "total rows:%"PRId64 ", check rows:%"PRId64, pQInfo, pSummary->elapsedTime, pSummary->totalBlocks,
-         pSummary->loadBlockStatis, pSummary->loadBlocks, pSummary->totalRows, pSummary->totalCheckedRows);
+         "answered by statis:%d, discarded:%d, total rows:%"PRId64 ", check rows:%"PRId64 ", yields:%d", pQInfo,
+         pSummary->elapsedTime, pSummary->totalBlocks, pSummary->loadBlockStatis, pSummary->loadBlocks,
+         pSummary->statisBlocks, pSummary->discardBlocks, pSummary->totalRows, pSummary->totalCheckedRows,
+         pSummary->numOfYields);
 
 //  qTrace("QInfo:%p cost: temp file:%d Bytes", pQInfo, pSummary->tmpBufferInDisk);
 //
@@ -4128,7 +4280,8 @@ static int64_t scanMultiTableDataBlocks(SQInfo *pQInfo) {
     setCurrentQueryTable(pRuntimeEnv, pTableQueryInfo);
 
     SDataStatis *pStatis = NULL;
-    SArray *pDataBlock = loadDataBlockOnDemand(pRuntimeEnv, pQueryHandle, &blockInfo, &pStatis);
+    SArray *pDataBlock =
+        loadDataBlockOnDemand(pRuntimeEnv, &pTableQueryInfo->windowResInfo, pQueryHandle, &blockInfo, &pStatis);
 
     if (!isGroupbyNormalCol(pQuery->pGroupbyExpr)) {
       if (!isIntervalQuery(pQuery)) {
@@ -4146,6 +4299,11 @@ static int64_t scanMultiTableDataBlocks(SQInfo *pQInfo) {
   
     qTrace("QInfo:%p check data block, uid:%"PRId64", tid:%d, brange:%" PRId64 "-%" PRId64 ", numOfRows:%d, lastKey:%" PRId64,
            pQInfo, blockInfo.uid, blockInfo.tid, blockInfo.window.skey, blockInfo.window.ekey, blockInfo.rows, pQuery->current->lastKey);
+
+    if (isTimeSliceUsedUp(pRuntimeEnv)) {
+      qTrace("QInfo:%p time slice is used up, yield after %d blocks", pQInfo, summary->totalBlocks);
+      break;
+    }
   }
 
   int64_t et = taosGetTimestampMs();
@@ -4543,6 +4701,409 @@ static void doCloseAllTimeWindowAfterScan(SQInfo *pQInfo) {
   }
 }
 
+static bool canScanTablesInParallel(SQInfo *pQInfo) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+
+  // the scan stopped by the time slice is resumed in the same way
+  if (pRuntimeEnv->numOfThreads <= 1 || pQInfo->groupInfo.numOfTables <= 1 || pRuntimeEnv->summary.totalBlocks > 0) {
+    return false;
+  }
+
+  // the ts comp join and the reverse scan go through the tables in order, the rate results are not merged by group
+  return (pRuntimeEnv->pTSBuf == NULL) && !needReverseScan(pQuery) && !isSumAvgRateQuery(pQuery) &&
+         !isGroupbyNormalCol(pQuery->pGroupbyExpr);
+}
+
+static void destroyScanWorker(SQInfo *pWorker) {
+  if (pWorker == NULL) {
+    return;
+  }
+
+  SQuery *pQuery = pWorker->runtimeEnv.pQuery;
+  teardownQueryRuntimeEnv(&pWorker->runtimeEnv);
+
+  // the table query info of each group item is owned by the query
+  if (pWorker->groupInfo.pGroupList != NULL) {
+    size_t numOfGroups = taosArrayGetSize(pWorker->groupInfo.pGroupList);
+    for (int32_t i = 0; i < numOfGroups; ++i) {
+      taosArrayDestroy(taosArrayGetP(pWorker->groupInfo.pGroupList, i));
+    }
+
+    taosArrayDestroy(pWorker->groupInfo.pGroupList);
+  }
+
+  if (pWorker->tableIdGroupInfo.pGroupList != NULL) {
+    size_t numOfGroups = taosArrayGetSize(pWorker->tableIdGroupInfo.pGroupList);
+    for (int32_t i = 0; i < numOfGroups; ++i) {
+      taosArrayDestroy(taosArrayGetP(pWorker->tableIdGroupInfo.pGroupList, i));
+    }
+
+    taosArrayDestroy(pWorker->tableIdGroupInfo.pGroupList);
+  }
+
+  if (pQuery != NULL) {
+    tfree(pQuery->pFilterInfo);
+    free(pQuery);
+  }
+
+  free(pWorker);
+}
+
+/*
+ * The worker scans every numOfWorkers-th table of the query, with its own query handle and result buffer. It shares
+ * the table query info and the expressions with the query, and copies the query, since the scan position and the
+ * filter data of each block are kept in it.
+ */
+static int32_t createScanWorker(SQInfo *pQInfo, int32_t index, int32_t numOfWorkers, SQInfo **pWorker) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+
+  SQInfo *pw = calloc(1, sizeof(SQInfo));
+  if (pw == NULL) {
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  pw->signature = pw;
+  pw->pMaster = pQInfo;
+  pw->tsdb = pQInfo->tsdb;
+  pw->vgId = pQInfo->vgId;
+
+  SArray *pTableIdList = taosArrayInit(4, sizeof(STableId));
+  pw->tableIdGroupInfo.pGroupList = taosArrayInit(1, POINTER_BYTES);
+  taosArrayPush(pw->tableIdGroupInfo.pGroupList, &pTableIdList);
+
+  size_t numOfGroups = taosArrayGetSize(pQInfo->groupInfo.pGroupList);
+  pw->groupInfo.pGroupList = taosArrayInit(numOfGroups, POINTER_BYTES);
+
+  int32_t tableIndex = 0;
+  for (int32_t i = 0; i < numOfGroups; ++i) {
+    SArray *group = taosArrayGetP(pQInfo->groupInfo.pGroupList, i);
+    SArray *p1 = taosArrayInit(4, sizeof(SGroupItem));
+
+    size_t num = taosArrayGetSize(group);
+    for (int32_t j = 0; j < num; ++j, ++tableIndex) {
+      if (tableIndex % numOfWorkers != index) {
+        continue;
+      }
+
+      SGroupItem *item = taosArrayGet(group, j);
+      taosArrayPush(p1, item);
+      taosArrayPush(pTableIdList, &item->id);
+    }
+
+    taosArrayPush(pw->groupInfo.pGroupList, &p1);
+  }
+
+  pw->groupInfo.numOfTables = taosArrayGetSize(pTableIdList);
+  pw->tableIdGroupInfo.numOfTables = pw->groupInfo.numOfTables;
+
+  SQuery *pWorkerQuery = malloc(sizeof(SQuery));
+  if (pWorkerQuery == NULL) {
+    destroyScanWorker(pw);
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  *pWorkerQuery = *pQuery;
+  pWorkerQuery->sdata = NULL;
+  pWorkerQuery->current = NULL;
+  pWorkerQuery->pFilterInfo = NULL;
+  pw->runtimeEnv.pQuery = pWorkerQuery;
+
+  if (pQuery->numOfFilterCols > 0) {
+    pWorkerQuery->pFilterInfo = malloc(sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+    if (pWorkerQuery->pFilterInfo == NULL) {
+      destroyScanWorker(pw);
+      return TSDB_CODE_QRY_OUT_OF_MEMORY;
+    }
+
+    memcpy(pWorkerQuery->pFilterInfo, pQuery->pFilterInfo, sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+  }
+
+  SQueryRuntimeEnv *pEnv = &pw->runtimeEnv;
+  pEnv->stableQuery = true;
+  pEnv->topBotQuery = pRuntimeEnv->topBotQuery;
+  pEnv->scanFlag = pRuntimeEnv->scanFlag;
+  pEnv->cur.vgroupIndex = -1;
+
+  int32_t code = setupQueryRuntimeEnv(pEnv, pQuery->order.order);
+  if (code == TSDB_CODE_SUCCESS) {
+    pEnv->numOfRowsPerPage = pRuntimeEnv->numOfRowsPerPage;
+    code = createDiskbasedResultBuffer(&pEnv->pResultBuf, getInitialPageNum(pw), pQuery->rowSize, pw);
+  }
+
+  if (code == TSDB_CODE_SUCCESS && !isIntervalQuery(pQuery)) {
+    code = initWindowResInfo(&pEnv->windowResInfo, pEnv, 512, 4096, pRuntimeEnv->windowResInfo.type);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    destroyScanWorker(pw);
+    return code;
+  }
+
+  STsdbQueryCond cond = {
+      .twindow   = pQuery->window,
+      .order     = pQuery->order.order,
+      .colList   = pQuery->colList,
+      .numOfCols = pQuery->numOfCols,
+  };
+
+  pEnv->pQueryHandle = tsdbQueryTables(pw->tsdb, &cond, &pw->tableIdGroupInfo, pw);
+  if (pEnv->pQueryHandle == NULL) {
+    destroyScanWorker(pw);
+    return terrno;
+  }
+
+  *pWorker = pw;
+  return TSDB_CODE_SUCCESS;
+}
+
+static void scanTablesInWorker(SQInfo *pWorker) {
+  int64_t el = scanMultiTableDataBlocks(pWorker);
+  doCloseAllTimeWindowAfterScan(pWorker);
+
+  qTrace("QInfo:%p worker:%p scan completed, %d tables, elapsed time: %" PRId64 "ms", pWorker->pMaster, pWorker,
+         pWorker->groupInfo.numOfTables, el);
+}
+
+static void scanTablesInScheduler(SSchedMsg *pMsg) {
+  scanTablesInWorker((SQInfo *)pMsg->ahandle);
+  tsem_post((tsem_t *)pMsg->thandle);
+}
+
+/*
+ * The scan threads are shared by the parallel scans of all queries. They are created by the first parallel scan, one
+ * less than the threads it asks for since the calling thread scans as well, and kept until qCleanupScanThreads.
+ */
+static void *getScanScheduler(int32_t numOfThreads) {
+  pthread_mutex_lock(&scanSchedMutex);
+  if (scanQhandle == NULL) {
+    scanQhandle = taosInitScheduler(QUERY_SCAN_QUEUE_SIZE, numOfThreads - 1, "qscan");
+  }
+  pthread_mutex_unlock(&scanSchedMutex);
+
+  return scanQhandle;
+}
+
+void qCleanupScanThreads() {
+  pthread_mutex_lock(&scanSchedMutex);
+  taosCleanUpScheduler(scanQhandle);
+  scanQhandle = NULL;
+  pthread_mutex_unlock(&scanSchedMutex);
+}
+
+// copy the result pages of the id from the worker result buffer, and keep the new page id of each page in pageMap
+static int32_t copyWorkerResultPages(SDiskbasedResultBuf *pResultBuf, SDiskbasedResultBuf *pWorkerBuf, int32_t id,
+                                     int32_t *pageMap) {
+  SIDList list = getDataBufPagesIdList(pWorkerBuf, id);
+
+  for (int32_t i = 0; i < list.size; ++i) {
+    int32_t    pageId = -1;
+    tFilePage *page = getNewDataBuf(pResultBuf, id, &pageId);
+    if (page == NULL) {
+      return TSDB_CODE_QRY_NO_DISKSPACE;
+    }
+
+    memcpy(page, GET_RES_BUF_PAGE_BY_ID(pWorkerBuf, list.pData[i]), DEFAULT_INTERN_BUF_PAGE_SIZE);
+    pageMap[list.pData[i]] = pageId;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void remapWindowResultPages(SWindowResInfo *pWindowResInfo, int32_t *pageMap) {
+  for (int32_t i = 0; i < pWindowResInfo->size; ++i) {
+    SPosInfo *pos = &pWindowResInfo->pResult[i].pos;
+    if (pos->pageId != -1) {
+      pos->pageId = pageMap[pos->pageId];
+    }
+  }
+}
+
+static int32_t copyWorkerResults(SQInfo *pQInfo, SQInfo *pWorker) {
+  SDiskbasedResultBuf *pResultBuf = pQInfo->runtimeEnv.pResultBuf;
+  SDiskbasedResultBuf *pWorkerBuf = pWorker->runtimeEnv.pResultBuf;
+
+  int32_t *pageMap = malloc(sizeof(int32_t) * MAX(pWorkerBuf->allocateId, 1));
+  if (pageMap == NULL) {
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  if (isIntervalQuery(pQInfo->runtimeEnv.pQuery)) {  // the time window results of each table are kept by its tid
+    size_t numOfGroups = taosArrayGetSize(pWorker->groupInfo.pGroupList);
+    for (int32_t i = 0; i < numOfGroups && code == TSDB_CODE_SUCCESS; ++i) {
+      SArray *group = taosArrayGetP(pWorker->groupInfo.pGroupList, i);
+
+      size_t num = taosArrayGetSize(group);
+      for (int32_t j = 0; j < num && code == TSDB_CODE_SUCCESS; ++j) {
+        SGroupItem *item = taosArrayGet(group, j);
+
+        code = copyWorkerResultPages(pResultBuf, pWorkerBuf, item->info->id.tid, pageMap);
+        if (code == TSDB_CODE_SUCCESS) {
+          remapWindowResultPages(&item->info->windowResInfo, pageMap);
+        }
+      }
+    }
+  } else {
+    code = copyWorkerResultPages(pResultBuf, pWorkerBuf, GROUPRESULTID, pageMap);
+    if (code == TSDB_CODE_SUCCESS) {
+      remapWindowResultPages(&pWorker->runtimeEnv.windowResInfo, pageMap);
+    }
+  }
+
+  free(pageMap);
+  return code;
+}
+
+/*
+ * The group results of the workers are merged into the group results of the query, in the same way as the time
+ * window results of different tables are merged in mergeIntoGroupResultImpl.
+ */
+static int32_t mergeWorkerGroupResults(SQInfo *pQInfo, SQInfo **pWorkers, int32_t numOfWorkers) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+  SWindowResInfo *  pWindowResInfo = &pRuntimeEnv->windowResInfo;
+
+  int32_t functionId = pQuery->pSelectExpr[0].base.functionId;
+  bool    hasTimestamp = (functionId == TSDB_FUNC_TS || functionId == TSDB_FUNC_TS_DUMMY);
+
+  int32_t numOfGroups = taosArrayGetSize(pQInfo->groupInfo.pGroupList);
+  for (int32_t g = 0; g < numOfGroups; ++g) {
+    SWindowResult *pWindowRes = NULL;
+
+    for (int32_t i = 0; i < numOfWorkers; ++i) {
+      SWindowResInfo *pWorkerResInfo = &pWorkers[i]->runtimeEnv.windowResInfo;
+
+      int32_t *slot = (int32_t *)taosHashGet(pWorkerResInfo->hashList, (char *)&g, sizeof(g));
+      if (slot == NULL) {
+        continue;
+      }
+
+      SWindowResult *pWorkerRes = getWindowResult(pWorkerResInfo, *slot);
+      if (pWorkerRes->numOfRows == 0) {
+        continue;
+      }
+
+      bool mergeFlag = (pWindowRes != NULL);
+      if (!mergeFlag) {
+        pWindowRes = doSetTimeWindowFromKey(pRuntimeEnv, pWindowResInfo, (char *)&g, sizeof(g));
+        if (pWindowRes == NULL || addNewWindowResultBuf(pWindowRes, pRuntimeEnv->pResultBuf, GROUPRESULTID,
+                                                        pRuntimeEnv->numOfRowsPerPage) != TSDB_CODE_SUCCESS) {
+          return TSDB_CODE_QRY_OUT_OF_MEMORY;
+        }
+
+        // doMerge moves the output buffer forward to the group result before it starts a new result
+        setWindowResOutputBuf(pRuntimeEnv, pWindowRes);
+        for (int32_t k = 0; k < pQuery->numOfOutput; ++k) {
+          pRuntimeEnv->pCtx[k].aOutputBuf -= pRuntimeEnv->pCtx[k].outputBytes;
+          pRuntimeEnv->pCtx[k].size = 1;
+          pRuntimeEnv->pCtx[k].startOffset = 0;
+        }
+      }
+
+      TSKEY ts = pQuery->window.skey;
+      if (hasTimestamp) {
+        ts = GET_INT64_VAL(getPosInResultPage(pRuntimeEnv, PRIMARYKEY_TIMESTAMP_COL_INDEX, pWorkerRes));
+      }
+
+      doMerge(pRuntimeEnv, ts, pWorkerRes, mergeFlag);
+      pWindowRes->numOfRows = MAX(pWindowRes->numOfRows, pWorkerRes->numOfRows);
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void addQueryCostInfo(SQueryCostInfo *pSummary, SQueryCostInfo *pWorkerSummary) {
+  pSummary->loadStatisTime += pWorkerSummary->loadStatisTime;
+  pSummary->loadFileBlockTime += pWorkerSummary->loadFileBlockTime;
+  pSummary->loadDataInCacheTime += pWorkerSummary->loadDataInCacheTime;
+  pSummary->loadStatisSize += pWorkerSummary->loadStatisSize;
+  pSummary->loadFileBlockSize += pWorkerSummary->loadFileBlockSize;
+  pSummary->loadDataInCacheSize += pWorkerSummary->loadDataInCacheSize;
+  pSummary->loadDataTime += pWorkerSummary->loadDataTime;
+  pSummary->totalRows += pWorkerSummary->totalRows;
+  pSummary->totalCheckedRows += pWorkerSummary->totalCheckedRows;
+  pSummary->totalBlocks += pWorkerSummary->totalBlocks;
+  pSummary->loadBlocks += pWorkerSummary->loadBlocks;
+  pSummary->loadBlockStatis += pWorkerSummary->loadBlockStatis;
+  pSummary->statisBlocks += pWorkerSummary->statisBlocks;
+  pSummary->discardBlocks += pWorkerSummary->discardBlocks;
+}
+
+/*
+ * The tables are partitioned across the workers, the first one scans in the calling thread and the others in the
+ * shared scan threads. The results of the workers are then moved into the query, as if the query scanned all the
+ * tables itself.
+ */
+static int64_t scanMultiTableDataBlocksInParallel(SQInfo *pQInfo) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+
+  int64_t st = taosGetTimestampMs();
+  int32_t numOfWorkers = MIN(pRuntimeEnv->numOfThreads, pQInfo->groupInfo.numOfTables);
+
+  SQInfo **pWorkers = calloc(numOfWorkers, POINTER_BYTES);
+
+  int32_t code = (pWorkers == NULL) ? TSDB_CODE_QRY_OUT_OF_MEMORY : TSDB_CODE_SUCCESS;
+  for (int32_t i = 0; i < numOfWorkers && code == TSDB_CODE_SUCCESS; ++i) {
+    code = createScanWorker(pQInfo, i, numOfWorkers, &pWorkers[i]);
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    void * qhandle = getScanScheduler(pRuntimeEnv->numOfThreads);
+    tsem_t done;
+    tsem_init(&done, 0, 0);
+
+    int32_t numOfScheduled = 0;
+    for (int32_t i = 1; i < numOfWorkers && qhandle != NULL; ++i, ++numOfScheduled) {
+      SSchedMsg schedMsg = {.fp = scanTablesInScheduler, .ahandle = pWorkers[i], .thandle = &done};
+      taosScheduleTask(qhandle, &schedMsg);
+    }
+
+    // without the scan threads, the workers scan in the calling thread one after another
+    scanTablesInWorker(pWorkers[0]);
+    for (int32_t i = numOfScheduled + 1; i < numOfWorkers; ++i) {
+      scanTablesInWorker(pWorkers[i]);
+    }
+
+    for (int32_t i = 0; i < numOfScheduled; ++i) {
+      tsem_wait(&done);
+    }
+
+    tsem_destroy(&done);
+
+    for (int32_t i = 0; i < numOfWorkers; ++i) {
+      addQueryCostInfo(&pRuntimeEnv->summary, &pWorkers[i]->runtimeEnv.summary);
+      if (pWorkers[i]->code != TSDB_CODE_SUCCESS && code == TSDB_CODE_SUCCESS) {
+        code = pWorkers[i]->code;
+      }
+    }
+  }
+
+  for (int32_t i = 0; i < numOfWorkers && code == TSDB_CODE_SUCCESS && !isQueryKilled(pQInfo); ++i) {
+    code = copyWorkerResults(pQInfo, pWorkers[i]);
+  }
+
+  if (code == TSDB_CODE_SUCCESS && !isQueryKilled(pQInfo) && !isIntervalQuery(pRuntimeEnv->pQuery)) {
+    code = mergeWorkerGroupResults(pQInfo, pWorkers, numOfWorkers);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    qError("QInfo:%p parallel scan failed, code:%s", pQInfo, tstrerror(code));
+    pQInfo->code = code;
+  }
+
+  for (int32_t i = 0; i < numOfWorkers && pWorkers != NULL; ++i) {
+    destroyScanWorker(pWorkers[i]);
+  }
+
+  tfree(pWorkers);
+
+  return taosGetTimestampMs() - st;
+}
+
 static void multiTableQueryProcess(SQInfo *pQInfo) {
   SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
   SQuery *          pQuery = pRuntimeEnv->pQuery;
@@ -4568,9 +5129,15 @@ static void multiTableQueryProcess(SQInfo *pQInfo) {
   qTrace("QInfo:%p query start, qrange:%" PRId64 "-%" PRId64 ", order:%d, forward scan start", pQInfo,
          pQuery->window.skey, pQuery->window.ekey, pQuery->order.order);
 
-  // do check all qualified data blocks
-  int64_t el = scanMultiTableDataBlocks(pQInfo);
-  qTrace("QInfo:%p master scan completed, elapsed time: %lldms, reverse scan start", pQInfo, el);
+  int64_t el = 0;
+  if (canScanTablesInParallel(pQInfo)) {
+    el = scanMultiTableDataBlocksInParallel(pQInfo);
+  } else {
+    // do check all qualified data blocks, the master scan may be stopped by the time slice and resumed later
+    pRuntimeEnv->yieldable = true;
+    el = scanMultiTableDataBlocks(pQInfo);
+    pRuntimeEnv->yieldable = false;
+  }
 
   // query error occurred or query is killed, abort current execution
   if (pQInfo->code != TSDB_CODE_SUCCESS || isQueryKilled(pQInfo)) {
@@ -4578,6 +5145,13 @@ static void multiTableQueryProcess(SQInfo *pQInfo) {
     return;
   }
 
+  if (pRuntimeEnv->yielded) {
+    qTrace("QInfo:%p master scan yields, elapsed time: %lldms", pQInfo, el);
+    return;
+  }
+
+  qTrace("QInfo:%p master scan completed, elapsed time: %lldms, reverse scan start", pQInfo, el);
+
   // close all time window results
   doCloseAllTimeWindowAfterScan(pQInfo);
 
@@ -4631,7 +5205,14 @@ static void tableFixedOutputProcess(SQInfo *pQInfo, STableQueryInfo* pTableInfo)
   
   pQuery->current = pTableInfo;  // set current query table info
   
+  pRuntimeEnv->yieldable = true;
   scanOneTableDataBlocks(pRuntimeEnv, pTableInfo->lastKey);
+  pRuntimeEnv->yieldable = false;
+
+  if (pRuntimeEnv->yielded) {
+    return;
+  }
+
   finalizeQueryResult(pRuntimeEnv);
 
   if (isQueryKilled(pQInfo)) {
@@ -4713,7 +5294,7 @@ static void tableIntervalProcessImpl(SQueryRuntimeEnv *pRuntimeEnv, TSKEY start)
   while (1) {
     scanOneTableDataBlocks(pRuntimeEnv, start);
 
-    if (isQueryKilled(GET_QINFO_ADDR(pRuntimeEnv))) {
+    if (isQueryKilled(GET_QINFO_ADDR(pRuntimeEnv)) || pRuntimeEnv->yielded) {
       return;
     }
 
@@ -4755,9 +5336,17 @@ static void tableIntervalProcess(SQInfo *pQInfo, STableQueryInfo* pTableInfo) {
     return;
   }
 
+  // the skipped time windows are not restored, so the scan is stopped by the time slice only without offset
+  pRuntimeEnv->yieldable = (pQuery->limit.offset <= 0);
+
   while (1) {
     tableIntervalProcessImpl(pRuntimeEnv, newStartKey);
 
+    if (pRuntimeEnv->yielded) {
+      pRuntimeEnv->yieldable = false;
+      return;
+    }
+
     if (isIntervalQuery(pQuery)) {
       pQInfo->groupIndex = 0;  // always start from 0
       pQuery->rec.rows = 0;
@@ -4786,6 +5375,8 @@ static void tableIntervalProcess(SQInfo *pQInfo, STableQueryInfo* pTableInfo) {
     }
   }
 
+  pRuntimeEnv->yieldable = false;
+
   // all data scanned, the group by normal column can return
   if (isGroupbyNormalCol(pQuery->pGroupbyExpr)) {  // todo refactor with merge interval time result
     pQInfo->groupIndex = 0;
@@ -5031,6 +5622,7 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
   pQueryMsg->tsNumOfBlocks = htonl(pQueryMsg->tsNumOfBlocks);
   pQueryMsg->tsOrder = htonl(pQueryMsg->tsOrder);
   pQueryMsg->numOfTags = htonl(pQueryMsg->numOfTags);
+  pQueryMsg->compressColData = htonl(pQueryMsg->compressColData);
 
   // query msg safety check
   if (!validateQueryMsg(pQueryMsg)) {
@@ -5484,6 +6076,7 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArray* pTableIdList,
   pQuery->slidingTimeUnit = pQueryMsg->slidingTimeUnit;
   pQuery->fillType        = pQueryMsg->fillType;
   pQuery->numOfTags       = pQueryMsg->numOfTags;
+  pQuery->compressColData = pQueryMsg->compressColData;
   
   // todo do not allocate ??
   pQuery->colList = calloc(numOfCols, sizeof(SSingleColumnFilterInfo));
@@ -5783,7 +6376,7 @@ static size_t getResultSize(SQInfo *pQInfo, int64_t *numOfRows) {
   }
 }
 
-static int32_t doDumpQueryResult(SQInfo *pQInfo, char *data) {
+static int32_t doDumpQueryResult(SQInfo *pQInfo, char *data, int32_t *len) {
   // the remained number of retrieved rows, not the interpolated result
   SQuery *pQuery = pQInfo->runtimeEnv.pQuery;
 
@@ -5812,7 +6405,7 @@ static int32_t doDumpQueryResult(SQInfo *pQInfo, char *data) {
       setQueryStatus(pQuery, QUERY_OVER);
     }
   } else {
-    doCopyQueryResultToMsg(pQInfo, pQuery->rec.rows, data);
+    *len = doCopyQueryResultToMsg(pQInfo, pQuery->rec.rows, data);
   }
 
   pQuery->rec.total += pQuery->rec.rows;
@@ -5962,21 +6555,26 @@ void qDestroyQueryInfo(qinfo_t qHandle) {
   }
 }
 
-void qTableQuery(qinfo_t qinfo) {
+bool qTableQuery(qinfo_t qinfo, int32_t timeSlice, int32_t numOfThreads) {
   SQInfo *pQInfo = (SQInfo *)qinfo;
 
   if (pQInfo == NULL || pQInfo->signature != pQInfo) {
     qTrace("QInfo:%p has been freed, no need to execute", pQInfo);
-    return;
+    return false;
   }
 
   if (isQueryKilled(pQInfo)) {
     qTrace("QInfo:%p it is already killed, abort", pQInfo);
     qDestroyQueryInfo(pQInfo);
-    return;
+    return false;
   }
 
-  qTrace("QInfo:%p query task is launched", pQInfo);
+  qTrace("QInfo:%p query task is launched, time slice:%d ms, threads:%d", pQInfo, timeSlice, numOfThreads);
+
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  pRuntimeEnv->sliceEndTime = (timeSlice > 0) ? taosGetTimestampUs() + (int64_t)timeSlice * 1000 : 0;
+  pRuntimeEnv->yielded = false;
+  pRuntimeEnv->numOfThreads = numOfThreads;
 
   if (onlyQueryTags(pQInfo->runtimeEnv.pQuery)) {
     assert(pQInfo->runtimeEnv.pQueryHandle == NULL);
@@ -5987,8 +6585,15 @@ void qTableQuery(qinfo_t qinfo) {
     tableQueryImpl(pQInfo);
   }
 
+  // the results are not ready, keep the reference for the next execution
+  if (pRuntimeEnv->yielded && !isQueryKilled(pQInfo)) {
+    qTrace("QInfo:%p query yields, to be continued", pQInfo);
+    return true;
+  }
+
   sem_post(&pQInfo->dataReady);
   qDestroyQueryInfo(pQInfo);
+  return false;
 }
 
 int32_t qRetrieveQueryResultInfo(qinfo_t qinfo) {
@@ -6048,9 +6653,13 @@ int32_t qDumpRetrieveResult(qinfo_t qinfo, SRetrieveTableRsp **pRsp, int32_t *co
 
   SQueryRuntimeEnv* pRuntimeEnv = &pQInfo->runtimeEnv;
   SQuery *pQuery = pQInfo->runtimeEnv.pQuery;
+  bool    compressed = (pQuery->compressColData >= 0 && !isTSCompQuery(pQuery));
   size_t  size = getResultSize(pQInfo, &pQuery->rec.rows);
   size += sizeof(int32_t);
   size += sizeof(STableIdInfo) * taosArrayGetSize(pQInfo->arrTableIdInfo);
+  if (compressed) {
+    size += sizeof(int32_t) + (sizeof(SRetrieveColumn) + COMP_OVERFLOW_BYTES) * pQuery->numOfOutput;
+  }
   *contLen = size + sizeof(SRetrieveTableRsp);
 
   // todo handle failed to allocate memory
@@ -6068,7 +6677,15 @@ int32_t qDumpRetrieveResult(qinfo_t qinfo, SRetrieveTableRsp **pRsp, int32_t *co
   
   (*pRsp)->precision = htons(pQuery->precision);
   if (pQuery->rec.rows > 0 && code == TSDB_CODE_SUCCESS) {
-    code = doDumpQueryResult(pQInfo, (*pRsp)->data);
+    int32_t len = (int32_t)size;
+    code = doDumpQueryResult(pQInfo, (*pRsp)->data, &len);
+
+    // the encoded columns are no larger than the estimated size
+    if (compressed) {
+      (*pRsp)->compressed = 1;
+      *contLen = len + sizeof(SRetrieveTableRsp);
+      qTrace("QInfo:%p rows:%" PRId64 " encoded into %d bytes", pQInfo, pQuery->rec.rows, len);
+    }
   } else {
     setQueryStatus(pQuery, QUERY_OVER);
     code = pQInfo->code;
@@ -500,6 +500,7 @@ static int32_t setQueryCond(tQueryInfo *queryColInfo, SQueryCond* pCond) {
   return TSDB_CODE_SUCCESS;
 }
 
+// the nodes of the skiplist index satisfying the condition are put into the result
 static void tQueryIndexColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArray* result) {
   SSkipListIterator* iter = NULL;
   
@@ -526,7 +527,7 @@ static void tQueryIndexColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArr
           break;
         }
         
-        taosArrayPush(result, SL_GET_NODE_DATA(pNode));
+        taosArrayPush(result, &pNode);
       }
     } else if (optr == TSDB_RELATION_GREATER || optr == TSDB_RELATION_GREATER_EQUAL) { // greater equal
       bool comp = true;
@@ -543,7 +544,7 @@ static void tQueryIndexColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArr
         if (ret == 0 && optr == TSDB_RELATION_GREATER) {
           continue;
         } else {
-          taosArrayPush(result, SL_GET_NODE_DATA(pNode));
+          taosArrayPush(result, &pNode);
           comp = false;
         }
       }
@@ -557,7 +558,7 @@ static void tQueryIndexColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArr
           continue;
         }
         
-        taosArrayPush(result, SL_GET_NODE_DATA(pNode));
+        taosArrayPush(result, &pNode);
       }
       
       tSkipListDestroyIter(iter);
@@ -571,7 +572,7 @@ static void tQueryIndexColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArr
           continue;
         }
   
-        taosArrayPush(result, SL_GET_NODE_DATA(pNode));
+        taosArrayPush(result, &pNode);
       }
   
     } else {
@@ -595,105 +596,16 @@ static void tQueryIndexColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArr
         if (ret == 0 && optr == TSDB_RELATION_LESS) {
           continue;
         } else {
-          taosArrayPush(result, SL_GET_NODE_DATA(pNode));
+          taosArrayPush(result, &pNode);
           comp = false;  // no need to compare anymore
         }
       }
     }
   }
-}
-
-int32_t merge(SArray *pLeft, SArray *pRight, SArray *pFinalRes) {
-//  assert(pFinalRes->pRes == 0);
-//
-//  pFinalRes->pRes = calloc((size_t)(pLeft->num + pRight->num), POINTER_BYTES);
-//  pFinalRes->num = 0;
-//
-//  // sort according to address
-//  tSkipListNode **pLeftNodes = (tSkipListNode **)pLeft->pRes;
-//  qsort(pLeftNodes, pLeft->num, sizeof(pLeft->pRes[0]), compareByAddr);
-//
-//  tSkipListNode **pRightNodes = (tSkipListNode **)pRight->pRes;
-//  qsort(pRightNodes, pRight->num, sizeof(pRight->pRes[0]), compareByAddr);
-//
-//  int32_t i = 0, j = 0;
-//
-//  // merge two sorted arrays in O(n) time
-//  while (i < pLeft->num && j < pRight->num) {
-//    int64_t ret = (int64_t)pLeftNodes[i] - (int64_t)pRightNodes[j];
-//
-//    if (ret < 0) {
-//      pFinalRes->pRes[pFinalRes->num++] = pLeftNodes[i++];
-//    } else if (ret > 0) {
-//      pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j++];
-//    } else {  // pNode->key > pkey[i]
-//      pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j++];
-//      i++;
-//    }
-//  }
-//
-//  while (i < pLeft->num) {
-//    pFinalRes->pRes[pFinalRes->num++] = pLeftNodes[i++];
-//  }
-//
-//  while (j < pRight->num) {
-//    pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j++];
-//  }
-//
-//  return pFinalRes->num;
-  return 0;
-}
-
-int32_t intersect(SArray *pLeft, SArray *pRight, SArray *pFinalRes) {
-//  int64_t num = MIN(pLeft->num, pRight->num);
-//
-//  assert(pFinalRes->pRes == 0);
-//
-//  pFinalRes->pRes = calloc(num, POINTER_BYTES);
-//  pFinalRes->num = 0;
-//
-//  // sort according to address
-//  tSkipListNode **pLeftNodes = (tSkipListNode **)pLeft->pRes;
-//  qsort(pLeftNodes, pLeft->num, sizeof(pLeft->pRes[0]), compareByAddr);
-//
-//  tSkipListNode **pRightNodes = (tSkipListNode **)pRight->pRes;
-//  qsort(pRightNodes, pRight->num, sizeof(pRight->pRes[0]), compareByAddr);
-//
-//  int32_t i = 0, j = 0;
-//  // merge two sorted arrays in O(n) time
-//  while (i < pLeft->num && j < pRight->num) {
-//    int64_t ret = (int64_t)pLeftNodes[i] - (int64_t)pRightNodes[j];
-//
-//    if (ret < 0) {
-//      i++;
-//    } else if (ret > 0) {
-//      j++;
-//    } else {  // pNode->key > pkey[i]
-//      pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j];
-//      i++;
-//      j++;
-//    }
-//  }
-//
-//  return pFinalRes->num;
- return 0;
-}
 
-/*
- * traverse the result and apply the function to each item to check if the item is qualified or not
- */
-static void tArrayTraverse(tExprNode *pExpr, __result_filter_fn_t fp, SArray *pResult) {
-  assert(pExpr->_node.pLeft->nodeType == TSQL_NODE_COL && pExpr->_node.pRight->nodeType == TSQL_NODE_VALUE && fp != NULL);
-
-  //  scan the result array list and check for each item in the list
-  for (int32_t i = 0; i < taosArrayGetSize(pResult); ++i) {
-    void* item = taosArrayGet(pResult, i);
-    if (fp(item, pExpr->_node.info)) {
-      i++;
-    } else {
-      taosArrayRemove(pResult, i);
-    }
-  }
+  tSkipListDestroyIter(iter);
+  tfree(cond.start);
+  tfree(cond.end);
 }
 
 static bool filterItem(tExprNode *pExpr, const void *pItem, SExprTraverseSupp *param) {
@@ -725,172 +637,136 @@ static bool filterItem(tExprNode *pExpr, const void *pItem, SExprTraverseSupp *p
   return param->nodeFilterFn(pItem, pExpr->_node.info);
 }
 
-/**
- * Apply the filter expression on non-indexed tag columns to each element in the result list, which is generated
- * by filtering on indexed tag column. So the whole result set only needs to be iterated once to generate
- * result that is satisfied to the filter expression, no matter how the filter expression consisting of.
- *
- * @param pExpr     filter expression on non-indexed tag columns.
- * @param pResult   results from filter on the indexed tag column, which is usually the first tag column
- * @param pSchema   tag schemas
- * @param fp        filter callback function
- */
-static void exprTreeTraverseImpl(tExprNode *pExpr, SArray *pResult, SExprTraverseSupp *param) {
-  size_t size = taosArrayGetSize(pResult);
-  
-  SArray* array = taosArrayInit(size, POINTER_BYTES);
-  for (int32_t i = 0; i < size; ++i) {
-    void *pItem = taosArrayGetP(pResult, i);
-
-    if (filterItem(pExpr, pItem, param)) {
-      taosArrayPush(array, &pItem);
-    }
+// the condition of EQUAL is answered by an index with fewer tables than a range one, 0 for an unindexable one
+static int32_t tQueryIndexRank(uint8_t optr) {
+  switch (optr) {
+    case TSDB_RELATION_EQUAL:
+      return 2;
+    case TSDB_RELATION_GREATER:
+    case TSDB_RELATION_GREATER_EQUAL:
+    case TSDB_RELATION_LESS:
+    case TSDB_RELATION_LESS_EQUAL:
+      return 1;
+    default:
+      return 0;
   }
-  
-  taosArrayCopy(pResult, array);
 }
 
-static void tSQLBinaryTraverseOnSkipList(tExprNode *pExpr, SArray *pResult, SSkipList *pSkipList, SExprTraverseSupp *param ) {
-  SSkipListIterator* iter = tSkipListCreateIter(pSkipList);
+// the index answering the leaf condition, or NULL
+static SSkipList *tExprNodeGetIndex(tExprNode *pExpr, SExprTraverseSupp *param) {
+  param->setupInfoFn(pExpr, param->pExtInfo);
+  tQueryInfo *pQueryInfo = pExpr->_node.info;
 
-  while (tSkipListIterNext(iter)) {
-    SSkipListNode *pNode = tSkipListIterGet(iter);
-    if (filterItem(pExpr, pNode, param)) {
-      taosArrayPush(pResult, SL_GET_NODE_DATA(pNode));
-    }
+  if (tQueryIndexRank(pQueryInfo->optr) == 0 || pQueryInfo->colIndex < 0) return NULL;
+  return param->getIndexFn(param->pIndexInfo, pQueryInfo->colIndex);
+}
+
+static bool tExprTreeHasIndexedCond(tExprNode *pExpr, SExprTraverseSupp *param) {
+  tExprNode *pLeft  = pExpr->_node.pLeft;
+  tExprNode *pRight = pExpr->_node.pRight;
+
+  if (pLeft->nodeType == TSQL_NODE_EXPR && pRight->nodeType == TSQL_NODE_EXPR) {
+    return tExprTreeHasIndexedCond(pLeft, param) || tExprTreeHasIndexedCond(pRight, param);
   }
-  tSkipListDestroyIter(iter);
+
+  return tExprNodeGetIndex(pExpr, param) != NULL;
 }
 
-static void tQueryIndexlessColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArray* res, __result_filter_fn_t filterFp) {
-  SSkipListIterator* iter = tSkipListCreateIter(pSkipList);
+static void tBitmapSetElem(SBitmap *pBitmap, const void *pElem, SExprTraverseSupp *param) {
+  int32_t id = param->getElemIdFn(pElem);
+  if (id >= 0 && id < pBitmap->numOfBits) taosBitmapSet(pBitmap, id);
+}
 
-  while (tSkipListIterNext(iter)) {
-    bool addToResult = false;
-
-    SSkipListNode *pNode = tSkipListIterGet(iter);
-    char *         pData = SL_GET_NODE_DATA(pNode);
-
-    // todo refactor:
-    tstr *name = ((STableIndexElem *)pData)->pTable->name;
-    // todo speed up by using hash
-    if (pQueryInfo->colIndex == TSDB_TBNAME_COLUMN_INDEX) {
-      if (pQueryInfo->optr == TSDB_RELATION_IN) {
-        addToResult = pQueryInfo->compare(name, pQueryInfo->q);
-      } else if (pQueryInfo->optr == TSDB_RELATION_LIKE) {
-        addToResult = !pQueryInfo->compare(name, pQueryInfo->q);
+/*
+ * Apply the expression without any indexed condition on the candidates once, or on all the elements of the skiplist
+ * if there is no candidate bitmap.
+ */
+static void tExprTreeScanBitmap(tExprNode *pExpr, SSkipList *pSkipList, SBitmap *pCand, SBitmap *pResult,
+                                SExprTraverseSupp *param) {
+  if (pCand != NULL) {
+    STableIndexElem elem;
+    for (int32_t id = taosBitmapNext(pCand, 0); id >= 0; id = taosBitmapNext(pCand, id + 1)) {
+      if (param->getElemFn(param->pIndexInfo, id, &elem) && filterItem(pExpr, &elem, param)) {
+        taosBitmapSet(pResult, id);
       }
-    } else {
-      addToResult = filterFp(pNode, pQueryInfo);
     }
+    return;
+  }
 
-    if (addToResult) {
-      taosArrayPush(res, pData);
+  SSkipListIterator *iter = tSkipListCreateIter(pSkipList);
+  while (tSkipListIterNext(iter)) {
+    char *pData = SL_GET_NODE_DATA(tSkipListIterGet(iter));
+    if (filterItem(pExpr, pData, param)) {
+      tBitmapSetElem(pResult, pData, param);
     }
   }
-
   tSkipListDestroyIter(iter);
 }
 
-// post-root order traverse syntax tree
-void tExprTreeTraverse(tExprNode *pExpr, SSkipList *pSkipList, SArray *result, SExprTraverseSupp *param) {
-  if (pExpr == NULL) {
-    return;
-  }
-
+static int32_t tExprTreeTraverseBitmapImpl(tExprNode *pExpr, SSkipList *pSkipList, SBitmap *pCand, SBitmap *pResult,
+                                           SExprTraverseSupp *param) {
   tExprNode *pLeft  = pExpr->_node.pLeft;
   tExprNode *pRight = pExpr->_node.pRight;
 
-  // column project
-  if (pLeft->nodeType != TSQL_NODE_EXPR && pRight->nodeType != TSQL_NODE_EXPR) {
-    assert(pLeft->nodeType == TSQL_NODE_COL && pRight->nodeType == TSQL_NODE_VALUE);
-
-    param->setupInfoFn(pExpr, param->pExtInfo);
-    if (pSkipList == NULL) {
-      tArrayTraverse(pExpr, param->nodeFilterFn, result);
-      return;
+  if (pLeft->nodeType != TSQL_NODE_EXPR || pRight->nodeType != TSQL_NODE_EXPR) {
+    SSkipList *pIndex = tExprNodeGetIndex(pExpr, param);
+    if (pIndex == NULL) {
+      tExprTreeScanBitmap(pExpr, pSkipList, pCand, pResult, param);
+      return TSDB_CODE_SUCCESS;
     }
 
-    tQueryInfo *pQueryInfo = pExpr->_node.info;
-    if (pQueryInfo->colIndex == 0 && pQueryInfo->optr != TSDB_RELATION_LIKE) {
-      tQueryIndexColumn(pSkipList, pQueryInfo, result);
-    } else {
-      tQueryIndexlessColumn(pSkipList, pQueryInfo, result, param->nodeFilterFn);
+    SArray *pNodes = taosArrayInit(16, POINTER_BYTES);
+    tQueryIndexColumn(pIndex, pExpr->_node.info, pNodes);
+
+    size_t size = taosArrayGetSize(pNodes);
+    for (int32_t i = 0; i < size; ++i) {
+      tBitmapSetElem(pResult, SL_GET_NODE_DATA((SSkipListNode *)taosArrayGetP(pNodes, i)), param);
     }
+    taosArrayDestroy(pNodes);
 
-    return;
+    if (pCand != NULL) taosBitmapAnd(pResult, pCand);
+    return TSDB_CODE_SUCCESS;
   }
 
-  // recursive traverse left child branch
-  uint8_t weight = pLeft->_node.hasPK + pRight->_node.hasPK;
-
-  if (weight == 0 ) {
-    if (taosArrayGetSize(result) > 0 && pSkipList == NULL) {
-    /**
-     * Perform the filter operation based on the initial filter result, which is obtained from filtering from index.
-     * Since no index presented, the filter operation is done by scan all elements in the result set.
-     *
-     * if the query is a high selectivity filter, only small portion of meters are retrieved.
-     */
-      exprTreeTraverseImpl(pExpr, result, param);
-    } else {
-      /**
-       * apply the hierarchical expression to every node in skiplist for find the qualified nodes
-       */
-      assert(taosArrayGetSize(result) == 0);
-      tSQLBinaryTraverseOnSkipList(pExpr, result, pSkipList, param);
-    }
-    return;
+  if (!tExprTreeHasIndexedCond(pExpr, param)) {
+    tExprTreeScanBitmap(pExpr, pSkipList, pCand, pResult, param);
+    return TSDB_CODE_SUCCESS;
   }
-  
-  if (weight == 2 || (weight == 1 && pExpr->_node.optr == TSDB_RELATION_OR)) {
-    SArray* rLeft  = taosArrayInit(10, POINTER_BYTES);
-    SArray* rRight = taosArrayInit(10, POINTER_BYTES);
 
-    tExprTreeTraverse(pLeft, pSkipList, rLeft, param);
-    tExprTreeTraverse(pRight, pSkipList, rRight, param);
+  SBitmap *pOther = taosBitmapCreate(pResult->numOfBits);
+  if (pOther == NULL) return TSDB_CODE_QRY_OUT_OF_MEMORY;
 
-    if (pExpr->_node.optr == TSDB_RELATION_AND) {  // CROSS
-      intersect(rLeft, rRight, result);
-    } else if (pExpr->_node.optr == TSDB_RELATION_OR) {  // or
-      merge(rLeft, rRight, result);
-    } else {
-      assert(false);
-    }
+  int32_t code = TSDB_CODE_SUCCESS;
 
-    taosArrayDestroy(rLeft);
-    taosArrayDestroy(rRight);
-    return;
-  }
+  if (pExpr->_node.optr == TSDB_RELATION_AND) {
+    // the branch with an indexed condition narrows down the candidates of the other one
+    if (!tExprTreeHasIndexedCond(pLeft, param)) {
+      SWAP(pLeft, pRight, tExprNode *);
+    }
 
-  /*
-    * (weight == 1 && pExpr->nSQLBinaryOptr == TSDB_RELATION_AND) is handled here
-    *
-    * first, we filter results based on the skiplist index, which is the initial filter stage,
-    * then, we conduct the secondary filter operation based on the result from the initial filter stage.
-    */
-  assert(pExpr->_node.optr == TSDB_RELATION_AND);
-
-  tExprNode *pFirst = NULL;
-  tExprNode *pSecond = NULL;
-  if (pLeft->_node.hasPK == 1) {
-    pFirst = pLeft;
-    pSecond = pRight;
+    code = tExprTreeTraverseBitmapImpl(pLeft, pSkipList, pCand, pOther, param);
+    if (code == TSDB_CODE_SUCCESS) code = tExprTreeTraverseBitmapImpl(pRight, pSkipList, pOther, pResult, param);
   } else {
-    pFirst = pRight;
-    pSecond = pLeft;
+    assert(pExpr->_node.optr == TSDB_RELATION_OR);
+
+    code = tExprTreeTraverseBitmapImpl(pLeft, pSkipList, pCand, pResult, param);
+    if (code == TSDB_CODE_SUCCESS) code = tExprTreeTraverseBitmapImpl(pRight, pSkipList, pCand, pOther, param);
+    if (code == TSDB_CODE_SUCCESS) taosBitmapOr(pResult, pOther);
   }
 
-  assert(pFirst != pSecond && pFirst != NULL && pSecond != NULL);
+  taosBitmapDestroy(pOther);
+  return code;
+}
 
-  // we filter the result based on the skiplist index in the first place
-  tExprTreeTraverse(pFirst, pSkipList, result, param);
+int32_t tExprTreeTraverseBitmap(tExprNode *pExpr, SSkipList *pSkipList, SBitmap *pResult, SExprTraverseSupp *param) {
+  taosBitmapClear(pResult);
+  if (pExpr == NULL) {
+    return TSDB_CODE_SUCCESS;
+  }
 
-  /*
-    * recursively perform the filter operation based on the initial results,
-    * So, we do not set the skip list index as a parameter
-    */
-  tExprTreeTraverse(pSecond, NULL, result, param);
+  int32_t code = tExprTreeTraverseBitmapImpl(pExpr, pSkipList, NULL, pResult, param);
+  if (code != TSDB_CODE_SUCCESS) taosBitmapClear(pResult);
+  return code;
 }
 
 void tExprTreeCalcTraverse(tExprNode *pExprs, int32_t numOfRows, char *pOutput, void *param, int32_t order,
@@ -305,7 +305,7 @@ void rpcClose(void *param) {
 void *rpcMallocCont(int contLen) {
   int size = contLen + RPC_MSG_OVERHEAD;
 
-  char *start = (char *)calloc(1, (size_t)size);
+  char *start = (char *)taosSlabCalloc((size_t)size);
   if (start == NULL) {
     tError("failed to malloc msg, size:%d", size);
     return NULL;
@@ -317,7 +317,7 @@ void *rpcMallocCont(int contLen) {
 void rpcFreeCont(void *cont) {
   if ( cont ) {
     char *temp = ((char *)cont) - sizeof(SRpcHead) - sizeof(SRpcReqContext);
-    free(temp);
+    taosSlabFree(temp);
   }
 }
 
@@ -326,12 +326,12 @@ void *rpcReallocCont(void *ptr, int contLen) {
 
   char *start = ((char *)ptr) - sizeof(SRpcReqContext) - sizeof(SRpcHead);
   if (contLen == 0 ) {
-    free(start); 
+    taosSlabFree(start); 
     return NULL;
   }
 
   int size = contLen + RPC_MSG_OVERHEAD;
-  start = realloc(start, size);
+  start = taosSlabRealloc(start, size);
   if (start == NULL) {
     tError("failed to realloc cont, size:%d", size);
     return NULL;
@@ -518,7 +518,7 @@ void rpcCancelRequest(void *handle) {
 static void rpcFreeMsg(void *msg) {
   if ( msg ) {
     char *temp = (char *)msg - sizeof(SRpcReqContext);
-    free(temp);
+    taosSlabFree(temp);
   }
 }
 
@@ -1286,7 +1286,7 @@ static int32_t rpcCompressRpcMsg(char* pCont, int32_t contLen) {
     return contLen;
   }
   
-  char *buf = malloc (contLen + overhead + 8);  // 8 extra bytes
+  char *buf = taosSlabMalloc(contLen + overhead + 8);  // 8 extra bytes
   if (buf == NULL) {
     tError("failed to allocate memory for rpc msg compression, contLen:%d", contLen);
     return contLen;
@@ -1311,7 +1311,7 @@ static int32_t rpcCompressRpcMsg(char* pCont, int32_t contLen) {
     finalLen = contLen;
   }
 
-  free(buf);
+  taosSlabFree(buf);
   return finalLen;
 }
 
@@ -1327,7 +1327,7 @@ static SRpcHead *rpcDecompressRpcMsg(SRpcHead *pHead) {
     int contLen = htonl(pComp->contLen);
   
     // prepare the temporary buffer to decompress message
-    char *temp = (char *)malloc(contLen + RPC_MSG_OVERHEAD);
+    char *temp = (char *)taosSlabMalloc(contLen + RPC_MSG_OVERHEAD);
     pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
   
     if (pNewHead) {
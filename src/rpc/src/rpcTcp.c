@@ -16,6 +16,7 @@
 #include "os.h"
 #include "tsocket.h"
 #include "tutil.h"
+#include "tmempool.h"
 #include "taosdef.h"
 #include "taoserror.h" 
 #include "rpcLog.h"
@@ -26,6 +27,9 @@
   #define EPOLLWAKEUP (1u << 29)
 #endif
 
+#define TCP_RECV_BUF_SIZE  (64 * 1024)  // receive buffer shared by the connections of a thread
+#define TCP_MAX_READS      16           // reads of one connection per event, so the others are not starved
+
 typedef struct SFdObj {
   void              *signature;
   int                fd;          // TCP socket FD
@@ -33,6 +37,11 @@ typedef struct SFdObj {
   void              *thandle;     // handle from upper layer, like TAOS
   uint32_t           ip;
   uint16_t           port;
+  SRpcHead           head;        // head of the message being received
+  int32_t            headLen;     // bytes of the head received
+  char              *buffer;      // buffer of the message being received, NULL while the head is received
+  int32_t            msgLen;
+  int32_t            recvLen;     // bytes of the message received
   struct SThreadObj *pThreadObj;
   struct SFdObj     *prev;
   struct SFdObj     *next;
@@ -48,6 +57,7 @@ typedef struct SThreadObj {
   int             numOfFds;
   int             threadId;
   char            label[TSDB_LABEL_LEN];
+  char           *buffer;   // receive buffer, TCP_RECV_BUF_SIZE bytes
   void           *shandle;  // handle passed by upper layer during server initialization
   void           *(*processData)(SRecvInfo *pPacket);
 } SThreadObj;
@@ -127,6 +137,13 @@ void *taosInitTcpServer(uint32_t ip, uint16_t port, char *label, int numOfThread
       break;
     }
 
+    pThreadObj->buffer = malloc(TCP_RECV_BUF_SIZE);
+    if (pThreadObj->buffer == NULL) {
+      tError("%s failed to malloc TCP receive buffer", label);
+      code = -1;
+      break;
+    }
+
     code = pthread_create(&(pThreadObj->thread), &thattr, taosProcessTcpData, (void *)(pThreadObj));
     if (code != 0) {
       tError("%s failed to create TCP process data thread(%s)", label, strerror(errno));
@@ -188,6 +205,8 @@ static void taosStopTcpThread(SThreadObj* pThreadObj) {
     pThreadObj->pHead = pFdObj->next;
     taosFreeFdObj(pFdObj);
   }
+
+  tfree(pThreadObj->buffer);
 }
 
 
@@ -285,6 +304,15 @@ void *taosInitTcpClient(uint32_t ip, uint16_t port, char *label, int num, void *
     return NULL;
   }
 
+  pThreadObj->buffer = malloc(TCP_RECV_BUF_SIZE);
+  if (pThreadObj->buffer == NULL) {
+    tError("%s failed to malloc TCP client receive buffer", label);
+    close(pThreadObj->pollFd);
+    free(pThreadObj);
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return NULL;
+  }
+
   pThreadObj->processData = fp;
 
   pthread_attr_init(&thattr);
@@ -293,6 +321,7 @@ void *taosInitTcpClient(uint32_t ip, uint16_t port, char *label, int num, void *
   pthread_attr_destroy(&thattr);
   if (code != 0) {
     close(pThreadObj->pollFd);
+    free(pThreadObj->buffer);
     free(pThreadObj);
     terrno = TAOS_SYSTEM_ERROR(errno); 
     tError("%s failed to create TCP read data thread(%s)", label, strerror(errno));
@@ -376,51 +405,130 @@ static void taosReportBrokenLink(SFdObj *pFdObj) {
   taosFreeFdObj(pFdObj);
 }
 
-static int taosReadTcpData(SFdObj *pFdObj, SRecvInfo *pInfo) {
-  SRpcHead    rpcHead;
-  int32_t     msgLen, leftLen, retLen, headLen;
-  char       *buffer, *msg;
+/*
+ * hand a completely received message over to the upper layer, return -1 if the connection is closed by the app
+ * and shall be shut down, 1 if the FdObj is freed
+ */
+static int taosProcessTcpMsg(SFdObj *pFdObj) {
+  SThreadObj *pThreadObj = pFdObj->pThreadObj;
+  SRecvInfo   recvInfo;
+
+  char *buffer = pFdObj->buffer;
+  pFdObj->buffer = NULL;
+  pFdObj->headLen = 0;
 
+  if (pFdObj->closedByApp) {
+    taosSlabFree(buffer);
+    return -1;
+  }
+
+  recvInfo.msg = buffer + tsRpcOverhead;
+  recvInfo.msgLen = pFdObj->msgLen;
+  recvInfo.ip = pFdObj->ip;
+  recvInfo.port = pFdObj->port;
+  recvInfo.shandle = pThreadObj->shandle;
+  recvInfo.thandle = pFdObj->thandle;
+  recvInfo.chandle = pFdObj;
+  recvInfo.connType = RPC_CONN_TCP;
+
+  pFdObj->thandle = (*(pThreadObj->processData))(&recvInfo);
+  if (pFdObj->thandle == NULL) {
+    taosFreeFdObj(pFdObj);
+    return 1;
+  }
+
+  return 0;
+}
+
+// the head of a message is received, allocate the buffer of the whole message from the slabs, the upper layer owns it
+static int taosAllocTcpMsg(SFdObj *pFdObj) {
   SThreadObj *pThreadObj = pFdObj->pThreadObj;
 
-  headLen = taosReadMsg(pFdObj->fd, &rpcHead, sizeof(SRpcHead));
-  if (headLen != sizeof(SRpcHead)) {
-    tTrace("%s %p, read error, headLen:%d", pThreadObj->label, pFdObj->thandle, headLen);
-    return -1; 
+  int32_t msgLen = (int32_t)htonl((uint32_t)pFdObj->head.msgLen);
+  if (msgLen < (int32_t)sizeof(SRpcHead)) {
+    tError("%s %p, invalid msgLen:%d", pThreadObj->label, pFdObj->thandle, msgLen);
+    return -1;
   }
 
-  msgLen = (int32_t)htonl((uint32_t)rpcHead.msgLen);
-  buffer = malloc(msgLen + tsRpcOverhead);
-  if ( NULL == buffer) {
+  pFdObj->buffer = taosSlabMalloc(msgLen + tsRpcOverhead);
+  if (pFdObj->buffer == NULL) {
     tError("%s %p, TCP malloc(size:%d) fail", pThreadObj->label, pFdObj->thandle, msgLen);
     return -1;
   }
 
-  msg = buffer + tsRpcOverhead;
-  leftLen = msgLen - headLen;
-  retLen = taosReadMsg(pFdObj->fd, msg + headLen, leftLen);
+  memcpy(pFdObj->buffer + tsRpcOverhead, &pFdObj->head, sizeof(SRpcHead));
+  pFdObj->msgLen = msgLen;
+  pFdObj->recvLen = sizeof(SRpcHead);
+  return 0;
+}
 
-  if (leftLen != retLen) {
-    tError("%s %p, read error, leftLen:%d retLen:%d", 
-            pThreadObj->label, pFdObj->thandle, leftLen, retLen);
-    free(buffer);
-    return -1;
-  }
+/*
+ * Read the data available on the socket without blocking, and hand the complete messages over to the upper layer.
+ * A message partly received is kept in the FdObj, and resumed by the next EPOLLIN event, so a slow peer does not
+ * hold up the other connections of the thread. The bytes are read into the receive buffer of the thread, which may
+ * carry several messages, only a message body larger than the buffer is read into its own buffer directly.
+ *
+ * return -1 if the connection shall be shut down, 1 if the FdObj is freed by the upper layer
+ */
+static int taosReadTcpData(SFdObj *pFdObj) {
+  SThreadObj *pThreadObj = pFdObj->pThreadObj;
 
-  memcpy(msg, &rpcHead, sizeof(SRpcHead));
-  
-  pInfo->msg = msg;
-  pInfo->msgLen = msgLen;
-  pInfo->ip = pFdObj->ip;
-  pInfo->port = pFdObj->port;
-  pInfo->shandle = pThreadObj->shandle;
-  pInfo->thandle = pFdObj->thandle;;
-  pInfo->chandle = pFdObj;
-  pInfo->connType = RPC_CONN_TCP;
+  for (int reads = 0; reads < TCP_MAX_READS; ++reads) {
+    int32_t nread;
+
+    if (pFdObj->buffer != NULL && pFdObj->msgLen - pFdObj->recvLen >= TCP_RECV_BUF_SIZE) {
+      char *msg = pFdObj->buffer + tsRpcOverhead;
+      nread = (int32_t)recv(pFdObj->fd, msg + pFdObj->recvLen, (size_t)(pFdObj->msgLen - pFdObj->recvLen), MSG_DONTWAIT);
+      if (nread > 0) {
+        pFdObj->recvLen += nread;
+        if (pFdObj->recvLen == pFdObj->msgLen) {
+          int code = taosProcessTcpMsg(pFdObj);
+          if (code != 0) return code;
+        }
+        continue;
+      }
+    } else {
+      nread = (int32_t)recv(pFdObj->fd, pThreadObj->buffer, TCP_RECV_BUF_SIZE, MSG_DONTWAIT);
+    }
 
-  if (pFdObj->closedByApp) {
-    free(buffer); 
-    return -1;
+    if (nread == 0) {
+      tTrace("%s %p, TCP connection is closed by peer", pThreadObj->label, pFdObj->thandle);
+      return -1;
+    } else if (nread < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+      tTrace("%s %p, read error(%s)", pThreadObj->label, pFdObj->thandle, strerror(errno));
+      return -1;
+    }
+
+    char   *data = pThreadObj->buffer;
+    int32_t left = nread;
+    while (left > 0) {
+      if (pFdObj->buffer == NULL) {
+        int32_t len = MIN(left, (int32_t)sizeof(SRpcHead) - pFdObj->headLen);
+        memcpy((char *)&pFdObj->head + pFdObj->headLen, data, (size_t)len);
+        pFdObj->headLen += len;
+        data += len;
+        left -= len;
+
+        if (pFdObj->headLen < (int32_t)sizeof(SRpcHead)) break;
+        if (taosAllocTcpMsg(pFdObj) < 0) return -1;
+      }
+
+      int32_t len = MIN(left, pFdObj->msgLen - pFdObj->recvLen);
+      memcpy(pFdObj->buffer + tsRpcOverhead + pFdObj->recvLen, data, (size_t)len);
+      pFdObj->recvLen += len;
+      data += len;
+      left -= len;
+
+      if (pFdObj->recvLen == pFdObj->msgLen) {
+        int code = taosProcessTcpMsg(pFdObj);
+        if (code != 0) return code;
+      }
+    }
+
+    // the socket is drained, no need to wait for EAGAIN
+    if (nread < TCP_RECV_BUF_SIZE) return 0;
   }
 
   return 0;
@@ -432,7 +540,6 @@ static void *taosProcessTcpData(void *param) {
   SThreadObj        *pThreadObj = param;
   SFdObj            *pFdObj;
   struct epoll_event events[maxEvents];
-  SRecvInfo          recvInfo;
  
   while (1) {
     int fdNum = epoll_wait(pThreadObj->pollFd, events, maxEvents, -1);
@@ -463,13 +570,9 @@ static void *taosProcessTcpData(void *param) {
         continue;
       }
 
-      if (taosReadTcpData(pFdObj, &recvInfo) < 0) {
+      if (taosReadTcpData(pFdObj) < 0) {
         shutdown(pFdObj->fd, SHUT_WR); 
-        continue;
       }
-
-      pFdObj->thandle = (*(pThreadObj->processData))(&recvInfo);
-      if (pFdObj->thandle == NULL) taosFreeFdObj(pFdObj);
     }
   }
 
@@ -545,5 +648,7 @@ static void taosFreeFdObj(SFdObj *pFdObj) {
   tTrace("%s %p, FD:%p is cleaned, numOfFds:%d", 
           pThreadObj->label, pFdObj->thandle, pFdObj, pThreadObj->numOfFds);
 
+  taosSlabFree(pFdObj->buffer);
+  pFdObj->buffer = NULL;
   tfree(pFdObj);
 }
@@ -18,6 +18,7 @@
 #include "tsystem.h"
 #include "ttimer.h"
 #include "tutil.h"
+#include "tmempool.h"
 #include "taosdef.h"
 #include "taoserror.h"
 #include "rpcLog.h"
@@ -197,7 +198,7 @@ static void *taosRecvUdpData(void *param) {
       continue;
     }
 
-    char *tmsg = malloc(dataLen + tsRpcOverhead);
+    char *tmsg = taosSlabMalloc(dataLen + tsRpcOverhead);
     if (NULL == tmsg) {
       tError("%s failed to allocate memory, size:%ld", pConn->label, dataLen);
       continue;
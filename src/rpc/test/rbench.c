@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * TCP throughput and latency of the RPC module, a server and the clients run in one process.
+ * Each client thread keeps one request outstanding on its own connection, and the slow peers send
+ * the head of a large message and then trickle its body, as a client on a slow network does.
+ */
+
+#include "os.h"
+#include "tutil.h"
+#include "tglobal.h"
+#include "tsocket.h"
+#include "ttime.h"
+#include "taosmsg.h"
+#include "rpcLog.h"
+#include "rpcHead.h"
+#include "trpc.h"
+
+typedef struct {
+  int       index;
+  SRpcIpSet ipSet;
+  int       numOfReqs;
+  int       msgSize;
+  sem_t     rspSem;
+  pthread_t thread;
+  void     *pRpc;
+  int64_t  *latency;  // latency of each request in us
+} SInfo;
+
+static void   *pServer = NULL;
+static int     rspSize = 16;
+static bool    stopSlowPeers = false;
+
+static void processRequestMsg(SRpcMsg *pMsg, SRpcIpSet *pIpSet) {
+  SRpcMsg rpcMsg = {0};
+
+  rpcFreeCont(pMsg->pCont);
+
+  rpcMsg.pCont = rpcMallocCont(rspSize);
+  rpcMsg.contLen = rspSize;
+  rpcMsg.handle = pMsg->handle;
+  rpcMsg.code = 0;
+  rpcSendResponse(&rpcMsg);
+}
+
+static void processResponse(SRpcMsg *pMsg, SRpcIpSet *pIpSet) {
+  SInfo *pInfo = (SInfo *)pMsg->handle;
+
+  if (pMsg->code != 0) {
+    tError("thread:%d, response code:0x%x", pInfo->index, pMsg->code);
+  }
+
+  rpcFreeCont(pMsg->pCont);
+  sem_post(&pInfo->rspSem);
+}
+
+static void *sendRequest(void *param) {
+  SInfo  *pInfo = (SInfo *)param;
+  SRpcMsg rpcMsg = {0};
+
+  for (int i = 0; i < pInfo->numOfReqs; ++i) {
+    rpcMsg.pCont = rpcMallocCont(pInfo->msgSize);
+    rpcMsg.contLen = pInfo->msgSize;
+    rpcMsg.handle = pInfo;
+    rpcMsg.msgType = TSDB_MSG_TYPE_QUERY;  // a query message is always sent through TCP
+
+    int64_t st = taosGetTimestampUs();
+    rpcSendRequest(pInfo->pRpc, &pInfo->ipSet, &rpcMsg);
+    sem_wait(&pInfo->rspSem);
+    pInfo->latency[i] = taosGetTimestampUs() - st;
+  }
+
+  return NULL;
+}
+
+// send the head of a 1MB message, then a byte of its body every 10ms
+static void *sendSlowly(void *param) {
+  uint16_t port = *(uint16_t *)param;
+
+  int fd = taosOpenTcpClientSocket(inet_addr("127.0.0.1"), port, 0);
+  if (fd < 0) {
+    tError("slow peer failed to connect");
+    return NULL;
+  }
+
+  SRpcHead head;
+  memset(&head, 0, sizeof(head));
+  head.msgType = TSDB_MSG_TYPE_QUERY;
+  head.msgLen = (int32_t)htonl(1024 * 1024);
+  taosWriteMsg(fd, &head, sizeof(head));
+
+  char c = 0;
+  while (!stopSlowPeers) {
+    if (taosWriteMsg(fd, &c, 1) != 1) break;
+    usleep(10000);
+  }
+
+  taosCloseSocket(fd);
+  return NULL;
+}
+
+static int compareLatency(const void *p1, const void *p2) {
+  int64_t l1 = *(int64_t *)p1;
+  int64_t l2 = *(int64_t *)p2;
+  return (l1 < l2) ? -1 : ((l1 > l2) ? 1 : 0);
+}
+
+int main(int argc, char *argv[]) {
+  SRpcInit  rpcInit;
+  SRpcIpSet ipSet;
+  uint16_t  port = 7010;
+  int       serverThreads = 1;
+  int       numOfConns = 16;
+  int       numOfReqs = 2000;
+  int       msgSize = 1024;
+  int       slowPeers = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-p") == 0 && i < argc - 1) {
+      port = (uint16_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-t") == 0 && i < argc - 1) {
+      serverThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-c") == 0 && i < argc - 1) {
+      numOfConns = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      numOfReqs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-m") == 0 && i < argc - 1) {
+      msgSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i < argc - 1) {
+      rspSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-w") == 0 && i < argc - 1) {
+      slowPeers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0 && i < argc - 1) {
+      rpcDebugFlag = atoi(argv[++i]);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-p port]: server port number, default is:%d\n", port);
+      printf("  [-t threads]: number of server rpc threads, default is:%d\n", serverThreads);
+      printf("  [-c connections]: number of client connections, default is:%d\n", numOfConns);
+      printf("  [-n requests]: number of requests per connection, default is:%d\n", numOfReqs);
+      printf("  [-m msgSize]: request body size, default is:%d\n", msgSize);
+      printf("  [-r rspSize]: response body size, default is:%d\n", rspSize);
+      printf("  [-w slowPeers]: number of peers trickling a large message, default is:%d\n", slowPeers);
+      printf("  [-d debugFlag]: debug flag, default:%d\n", rpcDebugFlag);
+      printf("  [-h help]: print out this help\n\n");
+      exit(0);
+    }
+  }
+
+  taosBlockSIGPIPE();
+  tsAsyncLog = 0;
+  taosInitLog("rbench.log", 100000, 10);
+
+  memset(&rpcInit, 0, sizeof(rpcInit));
+  rpcInit.localPort    = port;
+  rpcInit.label        = "SER";
+  rpcInit.numOfThreads = serverThreads;
+  rpcInit.cfp          = processRequestMsg;
+  rpcInit.sessions     = numOfConns * 2 + 10;
+  rpcInit.idleTime     = tsShellActivityTimer * 1500;
+  rpcInit.connType     = TAOS_CONN_SERVER;
+
+  pServer = rpcOpen(&rpcInit);
+  if (pServer == NULL) {
+    printf("failed to start RPC server\n");
+    return -1;
+  }
+
+  memset(&rpcInit, 0, sizeof(rpcInit));
+  rpcInit.localPort    = 0;
+  rpcInit.label        = "APP";
+  rpcInit.numOfThreads = 1;
+  rpcInit.cfp          = processResponse;
+  rpcInit.sessions     = numOfConns * 2 + 10;
+  rpcInit.idleTime     = tsShellActivityTimer * 1000;
+  rpcInit.user         = "bench";
+  rpcInit.connType     = TAOS_CONN_CLIENT;
+
+  void *pClient = rpcOpen(&rpcInit);
+  if (pClient == NULL) {
+    printf("failed to start RPC client\n");
+    return -1;
+  }
+
+  memset(&ipSet, 0, sizeof(ipSet));
+  ipSet.numOfIps = 1;
+  ipSet.inUse = 0;
+  ipSet.port[0] = port;
+  strcpy(ipSet.fqdn[0], "127.0.0.1");
+
+  pthread_attr_t thattr;
+  pthread_attr_init(&thattr);
+  pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_JOINABLE);
+
+  pthread_t *slowThreads = calloc(slowPeers + 1, sizeof(pthread_t));
+  for (int i = 0; i < slowPeers; ++i) {
+    pthread_create(&slowThreads[i], &thattr, sendSlowly, &port);
+  }
+  if (slowPeers > 0) sleep(1);
+
+  SInfo *pInfo = calloc(numOfConns, sizeof(SInfo));
+  int64_t startTime = taosGetTimestampUs();
+
+  for (int i = 0; i < numOfConns; ++i) {
+    pInfo[i].index = i;
+    pInfo[i].ipSet = ipSet;
+    pInfo[i].numOfReqs = numOfReqs;
+    pInfo[i].msgSize = msgSize;
+    pInfo[i].pRpc = pClient;
+    pInfo[i].latency = calloc(numOfReqs, sizeof(int64_t));
+    sem_init(&pInfo[i].rspSem, 0, 0);
+    pthread_create(&pInfo[i].thread, &thattr, sendRequest, pInfo + i);
+  }
+
+  for (int i = 0; i < numOfConns; ++i) {
+    pthread_join(pInfo[i].thread, NULL);
+  }
+
+  int64_t usedTime = taosGetTimestampUs() - startTime;
+
+  int64_t  total = (int64_t)numOfConns * numOfReqs;
+  int64_t *latency = malloc(total * sizeof(int64_t));
+  for (int i = 0; i < numOfConns; ++i) {
+    memcpy(latency + (int64_t)i * numOfReqs, pInfo[i].latency, numOfReqs * sizeof(int64_t));
+  }
+  qsort(latency, total, sizeof(int64_t), compareLatency);
+
+  printf("connections:%d slowPeers:%d requests:%" PRId64 " msgSize:%d serverThreads:%d\n", numOfConns, slowPeers,
+         total, msgSize, serverThreads);
+  printf("throughput: %.1f requests/s, %.2f MB/s\n", total * 1000000.0 / usedTime,
+         (double)total * msgSize / usedTime);
+  printf("latency(us): p50:%" PRId64 " p99:%" PRId64 " p99.9:%" PRId64 " max:%" PRId64 "\n", latency[total / 2],
+         latency[total * 99 / 100], latency[total * 999 / 1000], latency[total - 1]);
+
+  stopSlowPeers = true;
+  for (int i = 0; i < slowPeers; ++i) {
+    pthread_join(slowThreads[i], NULL);
+  }
+
+  rpcClose(pClient);
+  rpcClose(pServer);
+
+  for (int i = 0; i < numOfConns; ++i) {
+    free(pInfo[i].latency);
+    sem_destroy(&pInfo[i].rspSem);
+  }
+  free(pInfo);
+  free(latency);
+  free(slowThreads);
+  pthread_attr_destroy(&thattr);
+  taosCloseLog();
+
+  return 0;
+}
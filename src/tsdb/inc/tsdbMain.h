@@ -36,16 +36,22 @@ extern int tsdbDebugFlag;
 
 // ------------------------------ TSDB META FILE INTERFACES ------------------------------
 #define TSDB_META_FILE_NAME "meta"
+#define TSDB_META_CKP_FILE_NAME "meta.ckp"
 #define TSDB_META_HASH_FRACTION 1.1
 
 typedef int (*iterFunc)(void *, void *cont, int contLen);
-typedef void (*afterFunc)(void *);
+typedef void (*afterFunc)(void *, void *ckpCont, int ckpContLen);  // content of the checkpoint, NULL if not restored
 
 typedef struct {
   int       fd;        // File descriptor
   int       nDel;      // number of deletions
   int       tombSize;  // deleted size
   int64_t   size;      // Total file size
+  int64_t   ckpSize;   // size of the file covered by the checkpoint, 0 if there is none
+  int64_t   ckpWriting;  // size covered by the checkpoint being written, 0 if none or it is dropped
+  void *    pCkp;      // the checkpoint prepared in memory and not written yet
+  char      ckpName[TSDB_FILENAME_LEN];
+  pthread_mutex_t ckpMutex;  // the checkpoint is written by the commit thread while the records are changed
   void *    map;       // Map from uid ==> position
   iterFunc  iFunc;
   afterFunc aFunc;
@@ -56,20 +62,57 @@ SMetaFile *tsdbInitMetaFile(char *rootDir, int32_t maxTables, iterFunc iFunc, af
 int32_t    tsdbInsertMetaRecord(SMetaFile *mfh, uint64_t uid, void *cont, int32_t contLen);
 int32_t    tsdbDeleteMetaRecord(SMetaFile *mfh, uint64_t uid);
 int32_t    tsdbUpdateMetaRecord(SMetaFile *mfh, uint64_t uid, void *cont, int32_t contLen);
+bool       tsdbMetaFileCheckpointed(SMetaFile *mfh);
+int32_t    tsdbPrepareMetaFileCheckpoint(SMetaFile *mfh, void *cont, int32_t contLen);
+int32_t    tsdbWriteMetaFileCheckpoint(SMetaFile *mfh);
 void       tsdbCloseMetaFile(SMetaFile *mfh);
 
 // ------------------------------ TSDB META INTERFACES ------------------------------
 #define IS_CREATE_STABLE(pCfg) ((pCfg)->tagValues != NULL)
 
+// Chunk k of the row buffer holds (TSDB_MEM_CHUNK_MIN_ROWS << k) rows, so chunks never move once allocated
+#define TSDB_MEM_CHUNK_MIN_ROWS 64
+#define TSDB_MEM_MAX_CHUNKS 25
+#define TSDB_MEM_CHUNK_ROWS(k) (TSDB_MEM_CHUNK_MIN_ROWS << (k))
+
 typedef struct {
-  TSKEY   keyFirst;
-  TSKEY   keyLast;
-  int32_t numOfRows;
-  void *  pData;
+  TSKEY     keyFirst;
+  TSKEY     keyLast;
+  int32_t   numOfRows;
+  void *    pData;         // skiplist of the rows not appended to the row buffer
+  int32_t   numOfBufRows;  // rows in the row buffer, in ascending key order
+  SDataRow *chunks[TSDB_MEM_MAX_CHUNKS];
 } SMemTable;
 
+typedef struct {
+  SMemTable *        pMem;
+  int32_t            numOfBufRows;  // rows of the row buffer visible to the iterator
+  int32_t            pos;           // position in the row buffer
+  SSkipListIterator *pIter;         // iterator of the skiplist rows
+  SDataRow           row;           // current row, NULL if the iterator is not started or at the end
+  int8_t             order;
+  int8_t             chosen;        // where the current row comes from
+  bool               started;
+} SMemTableIter;
+
+SMemTable *    tsdbNewMemTable();
+void           tsdbFreeMemTable(SMemTable *pMemTable);
+int            tsdbAppendRowToMemTable(SMemTable *pMemTable, SDataRow row);
+bool           tsdbMemTableBufHasKey(SMemTable *pMemTable, TSKEY key);
+SMemTableIter *tsdbCreateMemTableIter(SMemTable *pMemTable, TSKEY key, int order);
+bool           tsdbMemTableIterNext(SMemTableIter *pIter);
+SDataRow       tsdbMemTableIterGet(SMemTableIter *pIter);
+void           tsdbDestroyMemTableIter(SMemTableIter *pIter);
+
 // ---------- TSDB TABLE DEFINITION
 #define TSDB_MAX_TABLE_SCHEMAS 16
+
+// secondary index of a super table on one of its tags other than the first one
+typedef struct {
+  int16_t colId;   // tag column indexed
+  void *  pIndex;  // skiplist of STableIndexElem, the child tables without the tag value are not in it
+} STagIndex;
+
 typedef struct STable {
   int8_t         type;
   STableId       tableId;
@@ -81,6 +124,8 @@ typedef struct STable {
   SMemTable *    mem;
   SMemTable *    imem;
   void *         pIndex;         // For TSDB_SUPER_TABLE, it is the skiplist index
+  STagIndex *    tagIndex;       // For TSDB_SUPER_TABLE, the indexes on the tags set by tagIndexColumns
+  int16_t        numOfTagIndex;
   void *         eventHandler;   // TODO
   void *         streamHandler;  // TODO
   TSKEY          lastKey;        // lastkey inserted in this table, initialized as 0, TODO: make a structure
@@ -119,10 +164,14 @@ typedef struct {
 typedef struct STableIndexElem {
   STsdbMeta* pMeta;
   STable*    pTable;
+  int16_t    colId;  // tag column of the secondary index the element is in, 0 for the index on the first tag
 } STableIndexElem;
 
 STsdbMeta *tsdbInitMeta(char *rootDir, int32_t maxTables, void *pRepo);
 int32_t    tsdbFreeMeta(STsdbMeta *pMeta);
+int32_t    tsdbCheckpointMeta(STsdbMeta *pMeta);
+int32_t    tsdbPrepareMetaCheckpoint(STsdbMeta *pMeta);
+int32_t    tsdbWriteMetaCheckpoint(STsdbMeta *pMeta);
 STSchema * tsdbGetTableTagSchema(STsdbMeta *pMeta, STable *pTable);
 
 // ---- Operation on STable
@@ -178,11 +227,15 @@ typedef struct {
   SCacheMem *      mem;
   SCacheMem *      imem;
   TsdbRepoT *      pRepo;
+  bool             parallel;      // inserted by several threads, the allocation is protected by mutex
+  bool             commitWanted;  // a commit is due but not triggered in parallel mode
+  pthread_mutex_t  mutex;
 } STsdbCache;
 
 STsdbCache *tsdbInitCache(int cacheBlockSize, int totalBlocks, TsdbRepoT *pRepo);
 void        tsdbFreeCache(STsdbCache *pCache);
 void *      tsdbAllocFromCache(STsdbCache *pCache, int bytes, TSKEY key);
+bool        tsdbCacheCommitDue(STsdbCache *pCache, int bytes);
 
 // ------------------------------ TSDB FILE INTERFACES ------------------------------
 #define TSDB_FILE_HEAD_SIZE 512
@@ -223,14 +276,20 @@ typedef struct {
 #define TSDB_IS_FILE_OPENED(f) ((f)->fd != -1)
 
 typedef struct {
-  int32_t fileId;
-  SFile   files[TSDB_FILE_TYPE_MAX];
+  int32_t  fileId;
+  uint32_t version;  // changed each time the files of the group are replaced
+  SFile    files[TSDB_FILE_TYPE_MAX];
 } SFileGroup;
 
 // TSDB file handle
 typedef struct {
-  int maxFGroups;
-  int numOfFGroups;
+  int      maxFGroups;
+  int      numOfFGroups;
+  uint32_t version;  // the last version given to a file group
+
+  // The files of a group are replaced by renames, the readers open them under the read lock and the commit and the
+  // compactor rename them under the write lock, so a reader never pairs a new .head with an old .data or .last
+  pthread_rwlock_t fhlock;
 
   SFileGroup *fGroup;
 } STsdbFileH;
@@ -349,6 +408,65 @@ int         tsdbCopyBlockDataInFile(SFile *pOutFile, SFile *pInFile, SCompInfo *
 SFileGroup *tsdbSearchFGroup(STsdbFileH *pFileH, int fid);
 void tsdbGetKeyRangeOfFileId(int32_t daysPerFile, int8_t precision, int32_t fileId, TSKEY *minKey, TSKEY *maxKey);
 
+// ------------------------------ TSDB BLOCK CACHE INTERFACES ------------------------------
+// A LRU cache of decompressed column data of file blocks, shared by all the queries of a repository
+typedef struct {
+  int64_t offset;  // block offset in .data or .last file
+  TSKEY   keyFirst;
+  TSKEY   keyLast;
+  int32_t fid;
+  int32_t len;  // block length in file
+  int32_t numOfRows;
+  int16_t colId;
+  int8_t  last;
+  int8_t  padding;
+} SBlockCacheKey;
+
+typedef struct SBlockCacheEntry {
+  SBlockCacheKey           key;
+  struct SBlockCacheEntry *prev;
+  struct SBlockCacheEntry *next;
+  int32_t                  len;  // length of the decompressed column data
+  char                     data[];
+} SBlockCacheEntry;
+
+typedef struct {
+  pthread_mutex_t   mutex;
+  int64_t           maxSize;  // memory budget in bytes
+  int64_t           size;     // memory taken by the cached entries
+  int64_t           numOfHits;
+  int64_t           numOfMisses;
+  void *            pHash;    // SBlockCacheKey -> SBlockCacheEntry *
+  SBlockCacheEntry *head;     // the most recently used entry
+  SBlockCacheEntry *tail;     // the least recently used entry
+} STsdbBlockCache;
+
+STsdbBlockCache *tsdbNewBlockCache(int64_t maxSize);
+void             tsdbFreeBlockCache(STsdbBlockCache *pCache);
+void             tsdbClearBlockCache(STsdbBlockCache *pCache);
+bool tsdbGetColFromBlockCache(STsdbBlockCache *pCache, int fid, SCompBlock *pCompBlock, SDataCol *pDataCol);
+void tsdbPutColIntoBlockCache(STsdbBlockCache *pCache, int fid, SCompBlock *pCompBlock, SDataCol *pDataCol);
+
+// ------------------------------ TSDB COMPACTOR INTERFACES ------------------------------
+// Suffixes of the files a file group is compacted into, the marker file is created once they are complete
+#define TSDB_COMPACT_HEAD_SUFFIX ".chead"
+#define TSDB_COMPACT_DATA_SUFFIX ".cdata"
+#define TSDB_COMPACT_LAST_SUFFIX ".clast"
+#define TSDB_COMPACT_DONE_SUFFIX ".cdone"
+
+typedef struct {
+  pthread_t        thread;
+  pthread_mutex_t  mutex;
+  pthread_cond_t   cond;  // signaled to wake up the compactor when it is stopped
+  bool             running;     // the background thread is started
+  bool             stop;
+  bool             compacting;  // a file group is being compacted
+  int64_t          ioStart;  // start time of the I/O budget window in ms
+  int64_t          ioBytes;  // bytes read and written since ioStart
+  STsdbCompactStat stat;
+  void *           pRepo;
+} STsdbCompactor;
+
 // TSDB repository definition
 typedef struct STsdbRepo {
   char *rootDir;
@@ -368,6 +486,12 @@ typedef struct STsdbRepo {
   // The TSDB file handle
   STsdbFileH *tsdbFileH;
 
+  // The shared cache of decompressed file blocks, NULL if disabled
+  STsdbBlockCache *tsdbBlockCache;
+
+  // The background compactor of the file groups
+  STsdbCompactor *tsdbCompactor;
+
   // Disk tier handle for multi-tier storage
   void *diskTier;
 
@@ -394,16 +518,6 @@ SDataRow tsdbGetSubmitBlkNext(SSubmitBlkIter *pIter);
 
 #define TSDB_SUBMIT_MSG_HEAD_SIZE sizeof(SSubmitMsg)
 
-// SSubmitMsg Iterator
-typedef struct {
-  int32_t     totalLen;
-  int32_t     len;
-  SSubmitBlk *pBlock;
-} SSubmitMsgIter;
-
-int         tsdbInitSubmitMsgIter(SSubmitMsg *pMsg, SSubmitMsgIter *pIter);
-SSubmitBlk *tsdbGetSubmitMsgNext(SSubmitMsgIter *pIter);
-
 int32_t tsdbTriggerCommit(TsdbRepoT *repo);
 int32_t tsdbLockRepo(TsdbRepoT *repo);
 int32_t tsdbUnLockRepo(TsdbRepoT *repo);
@@ -462,6 +576,9 @@ typedef struct {
 
   void *pBuffer;  // Buffer to hold the whole data block
   void *compBuffer;   // Buffer for temperary compress/decompress purpose
+
+  STsdbBlockCache *pBlockCache;  // For read purpose only
+  STsdbFileH *     pFileH;       // The fhlock of it is taken to open or replace the files of a group
 } SRWHelper;
 
 // --------- Helper state
@@ -486,6 +603,7 @@ void tsdbResetHelper(SRWHelper *pHelper);
 
 // --------- For set operations
 int tsdbSetAndOpenHelperFile(SRWHelper *pHelper, SFileGroup *pGroup);
+int tsdbSetAndOpenHelperNewFile(SRWHelper *pHelper, SFileGroup *pGroup);
 void tsdbSetHelperTable(SRWHelper *pHelper, STable *pTable, STsdbRepo *pRepo);
 int  tsdbCloseHelperFile(SRWHelper *pHelper, bool hasError);
 
@@ -493,7 +611,7 @@ int  tsdbCloseHelperFile(SRWHelper *pHelper, bool hasError);
 int  tsdbLoadCompIdx(SRWHelper *pHelper, void *target);
 int  tsdbLoadCompInfo(SRWHelper *pHelper, void *target);
 int  tsdbLoadCompData(SRWHelper *pHelper, SCompBlock *pCompBlock, void *target);
-int  tsdbLoadBlockDataCols(SRWHelper *pHelper, SDataCols *pDataCols, int blkIdx, int16_t *colIds, int numOfColIds);
+int  tsdbLoadBlockDataCols(SRWHelper *pHelper, SCompBlock *pCompBlock, int16_t *colIds, int numOfColIds);
 int  tsdbLoadBlockData(SRWHelper *pHelper, SCompBlock *pCompBlock, SDataCols *target);
 void tsdbGetDataStatis(SRWHelper *pHelper, SDataStatis *pStatis, int numOfCols);
 
@@ -512,9 +630,16 @@ int       tsdbUpdateFileHeader(SFile *pFile, uint32_t version);
 int       tsdbUpdateTable(STsdbMeta *pMeta, STable *pTable, STableCfg *pCfg);
 int       tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable);
 int       tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable);
+void *    tsdbGetTagIndex(STable *pSTable, int16_t colId);
+bool      tsdbIsTagIndexed(STable *pSTable, int16_t colId);
 STSchema *tsdbGetTableSchemaByVersion(STsdbMeta *pMeta, STable *pTable, int16_t version);
 STSchema *tsdbGetTableSchema(STsdbMeta *pMeta, STable *pTable);
 
+STsdbCompactor *tsdbNewCompactor(STsdbRepo *pRepo);
+void            tsdbFreeCompactor(STsdbCompactor *pCompactor);
+int             tsdbCompactFGroup(STsdbRepo *pRepo, int fid);
+int             tsdbRecoverCompaction(char *dataDir);
+
 #define DEFAULT_TAG_INDEX_COLUMN 0  // skip list built based on the first column of tags
 
 int compFGroupKey(const void *key, const void *fgroup);
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "hash.h"
+#include "hashfunc.h"
+#include "tsdbMain.h"
+
+static void tsdbInitBlockCacheKey(SBlockCacheKey *pKey, int fid, SCompBlock *pCompBlock, int16_t colId);
+static void tsdbUnlinkBlockCacheEntry(STsdbBlockCache *pCache, SBlockCacheEntry *pEntry);
+static void tsdbLinkBlockCacheEntryToHead(STsdbBlockCache *pCache, SBlockCacheEntry *pEntry);
+static void tsdbRemoveBlockCacheEntry(STsdbBlockCache *pCache, SBlockCacheEntry *pEntry);
+
+STsdbBlockCache *tsdbNewBlockCache(int64_t maxSize) {
+  if (maxSize <= 0) return NULL;
+
+  STsdbBlockCache *pCache = (STsdbBlockCache *)calloc(1, sizeof(STsdbBlockCache));
+  if (pCache == NULL) return NULL;
+
+  pCache->maxSize = maxSize;
+  pCache->pHash = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false);
+  if (pCache->pHash == NULL) {
+    free(pCache);
+    return NULL;
+  }
+
+  pthread_mutex_init(&(pCache->mutex), NULL);
+
+  return pCache;
+}
+
+void tsdbFreeBlockCache(STsdbBlockCache *pCache) {
+  if (pCache == NULL) return;
+
+  tsdbClearBlockCache(pCache);
+  taosHashCleanup((SHashObj *)pCache->pHash);
+  pthread_mutex_destroy(&(pCache->mutex));
+  free(pCache);
+}
+
+/**
+ * Drop all the cached entries. Called after a commit since the .last file may be rewritten and a new block can
+ * take the offset of an old one.
+ */
+void tsdbClearBlockCache(STsdbBlockCache *pCache) {
+  if (pCache == NULL) return;
+
+  pthread_mutex_lock(&(pCache->mutex));
+  while (pCache->tail != NULL) tsdbRemoveBlockCacheEntry(pCache, pCache->tail);
+  ASSERT(pCache->size == 0);
+  pthread_mutex_unlock(&(pCache->mutex));
+}
+
+/**
+ * Copy the decompressed data of a column of a file block from the cache to pDataCol.
+ * @return true if found, false otherwise
+ */
+bool tsdbGetColFromBlockCache(STsdbBlockCache *pCache, int fid, SCompBlock *pCompBlock, SDataCol *pDataCol) {
+  if (pCache == NULL) return false;
+
+  SBlockCacheKey key;
+  tsdbInitBlockCacheKey(&key, fid, pCompBlock, pDataCol->colId);
+
+  pthread_mutex_lock(&(pCache->mutex));
+
+  SBlockCacheEntry **ppEntry = (SBlockCacheEntry **)taosHashGet((SHashObj *)pCache->pHash, (void *)&key, sizeof(key));
+  if (ppEntry == NULL || (*ppEntry)->len > pDataCol->spaceSize) {
+    pCache->numOfMisses++;
+    pthread_mutex_unlock(&(pCache->mutex));
+    return false;
+  }
+
+  SBlockCacheEntry *pEntry = *ppEntry;
+  memcpy(pDataCol->pData, pEntry->data, pEntry->len);
+  pDataCol->len = pEntry->len;
+
+  tsdbUnlinkBlockCacheEntry(pCache, pEntry);
+  tsdbLinkBlockCacheEntryToHead(pCache, pEntry);
+  pCache->numOfHits++;
+
+  pthread_mutex_unlock(&(pCache->mutex));
+
+  if (pDataCol->type == TSDB_DATA_TYPE_BINARY || pDataCol->type == TSDB_DATA_TYPE_NCHAR) {
+    dataColSetOffset(pDataCol, pCompBlock->numOfRows);
+  }
+
+  return true;
+}
+
+/**
+ * Put the decompressed data of a column of a file block into the cache, the least recently used entries are evicted
+ * if the cache is full.
+ */
+void tsdbPutColIntoBlockCache(STsdbBlockCache *pCache, int fid, SCompBlock *pCompBlock, SDataCol *pDataCol) {
+  if (pCache == NULL) return;
+
+  int64_t tsize = sizeof(SBlockCacheEntry) + pDataCol->len;
+  if (tsize > pCache->maxSize) return;
+
+  SBlockCacheEntry *pEntry = (SBlockCacheEntry *)malloc(tsize);
+  if (pEntry == NULL) return;
+
+  tsdbInitBlockCacheKey(&(pEntry->key), fid, pCompBlock, pDataCol->colId);
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+  pEntry->len = pDataCol->len;
+  memcpy(pEntry->data, pDataCol->pData, pDataCol->len);
+
+  pthread_mutex_lock(&(pCache->mutex));
+
+  // Another query may load the same block concurrently
+  if (taosHashGet((SHashObj *)pCache->pHash, (void *)&(pEntry->key), sizeof(SBlockCacheKey)) != NULL) {
+    pthread_mutex_unlock(&(pCache->mutex));
+    free(pEntry);
+    return;
+  }
+
+  while (pCache->size + tsize > pCache->maxSize && pCache->tail != NULL) {
+    tsdbRemoveBlockCacheEntry(pCache, pCache->tail);
+  }
+
+  if (taosHashPut((SHashObj *)pCache->pHash, (void *)&(pEntry->key), sizeof(SBlockCacheKey), (void *)&pEntry,
+                  sizeof(pEntry)) < 0) {
+    pthread_mutex_unlock(&(pCache->mutex));
+    free(pEntry);
+    return;
+  }
+
+  tsdbLinkBlockCacheEntryToHead(pCache, pEntry);
+  pCache->size += tsize;
+
+  pthread_mutex_unlock(&(pCache->mutex));
+}
+
+static void tsdbInitBlockCacheKey(SBlockCacheKey *pKey, int fid, SCompBlock *pCompBlock, int16_t colId) {
+  // Keys are hashed and compared as raw bytes, so the padding must be cleared
+  memset((void *)pKey, 0, sizeof(*pKey));
+  pKey->offset = pCompBlock->offset;
+  pKey->keyFirst = pCompBlock->keyFirst;
+  pKey->keyLast = pCompBlock->keyLast;
+  pKey->fid = fid;
+  pKey->len = pCompBlock->len;
+  pKey->numOfRows = pCompBlock->numOfRows;
+  pKey->colId = colId;
+  pKey->last = pCompBlock->last;
+}
+
+static void tsdbUnlinkBlockCacheEntry(STsdbBlockCache *pCache, SBlockCacheEntry *pEntry) {
+  if (pEntry->prev) {
+    pEntry->prev->next = pEntry->next;
+  } else {
+    pCache->head = pEntry->next;
+  }
+
+  if (pEntry->next) {
+    pEntry->next->prev = pEntry->prev;
+  } else {
+    pCache->tail = pEntry->prev;
+  }
+
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+}
+
+static void tsdbLinkBlockCacheEntryToHead(STsdbBlockCache *pCache, SBlockCacheEntry *pEntry) {
+  pEntry->prev = NULL;
+  pEntry->next = pCache->head;
+  if (pCache->head) {
+    pCache->head->prev = pEntry;
+  } else {
+    pCache->tail = pEntry;
+  }
+  pCache->head = pEntry;
+}
+
+static void tsdbRemoveBlockCacheEntry(STsdbBlockCache *pCache, SBlockCacheEntry *pEntry) {
+  tsdbUnlinkBlockCacheEntry(pCache, pEntry);
+  taosHashRemove((SHashObj *)pCache->pHash, (void *)&(pEntry->key), sizeof(SBlockCacheKey));
+  pCache->size -= (sizeof(SBlockCacheEntry) + pEntry->len);
+  free(pEntry);
+}
@@ -34,6 +34,7 @@ STsdbCache *tsdbInitCache(int cacheBlockSize, int totalBlocks, TsdbRepoT *pRepo)
   pCache->cacheBlockSize = cacheBlockSize;
   pCache->totalCacheBlocks = totalBlocks;
   pCache->pRepo = pRepo;
+  pthread_mutex_init(&(pCache->mutex), NULL);
 
   STsdbBufferPool *pPool = &(pCache->pool);
   pPool->index = 0;
@@ -58,6 +59,7 @@ void tsdbFreeCache(STsdbCache *pCache) {
   tsdbFreeCacheMem(pCache->imem);
   tsdbFreeCacheMem(pCache->mem);
   tsdbFreeBlockList(pCache->pool.memPool);
+  pthread_mutex_destroy(&(pCache->mutex));
   free(pCache);
 }
 
@@ -65,9 +67,17 @@ void *tsdbAllocFromCache(STsdbCache *pCache, int bytes, TSKEY key) {
   if (pCache == NULL) return NULL;
   if (bytes > pCache->cacheBlockSize) return NULL;
 
+  bool parallel = pCache->parallel;
+  if (parallel) pthread_mutex_lock(&(pCache->mutex));
+
   if (pCache->curBlock == NULL || pCache->curBlock->remain < bytes) {
     if (pCache->curBlock !=NULL && listNEles(pCache->mem->list) >= pCache->totalCacheBlocks/2) {
-      tsdbTriggerCommit(pCache->pRepo);
+      // other threads may be inserting into the memtables to be swapped, leave the commit to the caller
+      if (parallel) {
+        pCache->commitWanted = true;
+      } else {
+        tsdbTriggerCommit(pCache->pRepo);
+      }
     }
 
     while (tsdbAllocBlockFromPool(pCache) < 0) {
@@ -84,9 +94,18 @@ void *tsdbAllocFromCache(STsdbCache *pCache, int bytes, TSKEY key) {
   if (key > pCache->mem->keyLast) pCache->mem->keyLast = key;
   pCache->mem->numOfRows++;
 
+  if (parallel) pthread_mutex_unlock(&(pCache->mutex));
+
   return ptr;
 }
 
+// Whether allocating the bytes triggers a commit, the same check as tsdbAllocFromCache
+bool tsdbCacheCommitDue(STsdbCache *pCache, int bytes) {
+  if (pCache == NULL || pCache->parallel) return false;
+  return pCache->curBlock != NULL && pCache->curBlock->remain < bytes &&
+         listNEles(pCache->mem->list) >= pCache->totalCacheBlocks / 2;
+}
+
 static void tsdbFreeBlockList(SList *list) {
   SListNode *      node = NULL;
   STsdbCacheBlock *pBlock = NULL;
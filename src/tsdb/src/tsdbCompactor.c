@@ -0,0 +1,498 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <dirent.h>
+#include <libgen.h>
+
+#include "os.h"
+#include "tsdbMain.h"
+#include "ttime.h"
+
+// Suffixes of the compacted files, indexed by TSDB_FILE_TYPE
+static const char *tsdbCompactSuffix[] = {
+    TSDB_COMPACT_HEAD_SUFFIX,  // TSDB_FILE_TYPE_HEAD
+    TSDB_COMPACT_DATA_SUFFIX,  // TSDB_FILE_TYPE_DATA
+    TSDB_COMPACT_LAST_SUFFIX   // TSDB_FILE_TYPE_LAST
+};
+
+static void *tsdbCompactorThread(void *arg);
+static bool  tsdbPickCompactFGroup(STsdbRepo *pRepo, int minFid, int *fid);
+static bool  tsdbShouldCompactFGroup(SFileGroup *pGroup);
+static bool  tsdbCompactorStopped(STsdbCompactor *pCompactor);
+static void  tsdbWaitCompactor(STsdbCompactor *pCompactor, int64_t ms);
+static void  tsdbThrottleCompactIO(STsdbCompactor *pCompactor, int64_t bytesRead, int64_t bytesWritten);
+static int   tsdbCompactTable(STsdbRepo *pRepo, SRWHelper *pRHelper, SRWHelper *pWHelper, STable *pTable,
+                              SDataCols *pDataCols);
+static int   tsdbWriteCompactBlock(STsdbCompactor *pCompactor, SRWHelper *pWHelper, SDataCols *pDataCols);
+static int64_t tsdbGetBlockBytes(SRWHelper *pHelper, SCompBlock *pCompBlock);
+static int64_t tsdbGetFGroupBytes(SFileGroup *pGroup);
+static void  tsdbRemoveCompactFiles(char *dataDir, int fid);
+
+STsdbCompactor *tsdbNewCompactor(STsdbRepo *pRepo) {
+  STsdbCompactor *pCompactor = (STsdbCompactor *)calloc(1, sizeof(STsdbCompactor));
+  if (pCompactor == NULL) return NULL;
+
+  pthread_mutex_init(&(pCompactor->mutex), NULL);
+  pthread_cond_init(&(pCompactor->cond), NULL);
+  pCompactor->pRepo = pRepo;
+  pCompactor->stat.fid = -1;
+
+  // The file groups can still be compacted on demand if the background compaction is disabled
+  if (tsCompactInterval > 0) {
+    if (pthread_create(&(pCompactor->thread), NULL, tsdbCompactorThread, (void *)pCompactor) != 0) {
+      tsdbError("vgId:%d, failed to start compactor thread", pRepo->config.tsdbId);
+    } else {
+      pCompactor->running = true;
+    }
+  }
+
+  return pCompactor;
+}
+
+void tsdbFreeCompactor(STsdbCompactor *pCompactor) {
+  if (pCompactor == NULL) return;
+
+  pthread_mutex_lock(&(pCompactor->mutex));
+  pCompactor->stop = true;
+  pthread_cond_signal(&(pCompactor->cond));
+  pthread_mutex_unlock(&(pCompactor->mutex));
+
+  if (pCompactor->running) pthread_join(pCompactor->thread, NULL);
+
+  pthread_cond_destroy(&(pCompactor->cond));
+  pthread_mutex_destroy(&(pCompactor->mutex));
+  free(pCompactor);
+}
+
+void tsdbGetCompactStat(TsdbRepoT *repo, STsdbCompactStat *pStat) {
+  STsdbCompactor *pCompactor = ((STsdbRepo *)repo)->tsdbCompactor;
+
+  if (pCompactor == NULL) {
+    memset((void *)pStat, 0, sizeof(*pStat));
+    pStat->fid = -1;
+    return;
+  }
+
+  pthread_mutex_lock(&(pCompactor->mutex));
+  *pStat = pCompactor->stat;
+  pthread_mutex_unlock(&(pCompactor->mutex));
+}
+
+/**
+ * Rewrite the file group fid into full size blocks without sub-blocks and garbage. The file group is read from a
+ * snapshot taken when no commit is running, and the new files only replace the old ones if the file group is not
+ * changed by a commit in the meantime.
+ *
+ * @return 0 if the file group is compacted, -1 if it fails or gives up
+ */
+int tsdbCompactFGroup(STsdbRepo *pRepo, int fid) {
+  STsdbCompactor *pCompactor = pRepo->tsdbCompactor;
+  STsdbMeta *     pMeta = pRepo->tsdbMeta;
+  STsdbFileH *    pFileH = pRepo->tsdbFileH;
+  STsdbCfg *      pCfg = &(pRepo->config);
+  SRWHelper       rhelper = {{0}};
+  SRWHelper       whelper = {{0}};
+  SDataCols *     pDataCols = NULL;
+  SFileGroup *    pGroup = NULL;
+  SFileGroup      fGroup = {0};
+  SFileGroup      nGroup = {0};
+  char            dataDir[128] = "\0";
+  char            fname[128] = "\0";
+  int             code = -1;
+
+  if (pCompactor == NULL) return -1;
+
+  pthread_mutex_lock(&(pCompactor->mutex));
+  if (pCompactor->compacting) {
+    pthread_mutex_unlock(&(pCompactor->mutex));
+    return -1;
+  }
+  pCompactor->compacting = true;
+  pCompactor->stat.fid = fid;
+  pCompactor->stat.numOfTables = 0;
+  pCompactor->stat.tablesDone = 0;
+  pCompactor->ioStart = taosGetTimestampMs();
+  pCompactor->ioBytes = 0;
+  pthread_mutex_unlock(&(pCompactor->mutex));
+
+  // Take a snapshot of the file group, the files are only appended or replaced by the commit
+  tsdbLockRepo(pRepo);
+  pGroup = pRepo->commit ? NULL : tsdbSearchFGroup(pFileH, fid);
+  if (pGroup != NULL) fGroup = *pGroup;
+  tsdbUnLockRepo(pRepo);
+  if (pGroup == NULL) goto _exit;
+
+  char *fnameDup = strdup(fGroup.files[TSDB_FILE_TYPE_HEAD].fname);
+  if (fnameDup == NULL) goto _exit;
+  strncpy(dataDir, dirname(fnameDup), sizeof(dataDir) - 1);
+  free(fnameDup);
+
+  // Remove the files left by a compaction given up before, then create the new files
+  tsdbRemoveCompactFiles(dataDir, fid);
+  nGroup.fileId = fid;
+  for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
+    if (tsdbCreateFile(dataDir, fid, tsdbCompactSuffix[type], &(nGroup.files[type])) < 0) {
+      tsdbError("vgId:%d, failed to create compact file %s", pCfg->tsdbId, nGroup.files[type].fname);
+      goto _exit;
+    }
+  }
+
+  if (tsdbInitReadHelper(&rhelper, pRepo) < 0 || tsdbInitWriteHelper(&whelper, pRepo) < 0) goto _exit;
+  rhelper.pBlockCache = NULL;  // Do not flush the blocks of the queries out of the cache
+  if ((pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pCfg->maxRowsPerFileBlock)) == NULL) goto _exit;
+
+  if (tsdbSetAndOpenHelperFile(&rhelper, &fGroup) < 0) goto _exit;
+  if (tsdbSetAndOpenHelperNewFile(&whelper, &nGroup) < 0) goto _exit;
+
+  int numOfTables = 0;
+  for (int tid = 1; tid < pCfg->maxTables; tid++) {
+    if (rhelper.pCompIdx[tid].offset > 0) numOfTables++;
+  }
+  pthread_mutex_lock(&(pCompactor->mutex));
+  pCompactor->stat.numOfTables = numOfTables;
+  pthread_mutex_unlock(&(pCompactor->mutex));
+
+  tsdbTrace("vgId:%d, start to compact file group %d, %d tables", pCfg->tsdbId, fid, numOfTables);
+
+  for (int tid = 1; tid < pCfg->maxTables; tid++) {
+    SCompIdx *pIdx = rhelper.pCompIdx + tid;
+    if (pIdx->offset == 0) continue;
+
+    if (tsdbCompactorStopped(pCompactor)) goto _exit;
+
+    // The data of a dropped table is not carried over
+    STable *pTable = pMeta->tables[tid];
+    if (pTable != NULL && pTable->tableId.uid == pIdx->uid) {
+      if (tsdbCompactTable(pRepo, &rhelper, &whelper, pTable, pDataCols) < 0) {
+        tsdbError("vgId:%d, failed to compact table tid:%d in file group %d", pCfg->tsdbId, tid, fid);
+        goto _exit;
+      }
+    }
+
+    pthread_mutex_lock(&(pCompactor->mutex));
+    pCompactor->stat.tablesDone++;
+    pthread_mutex_unlock(&(pCompactor->mutex));
+  }
+
+  if (tsdbWriteCompIdx(&whelper) < 0) {
+    tsdbError("vgId:%d, failed to write compIdx part of file group %d", pCfg->tsdbId, fid);
+    goto _exit;
+  }
+  tsdbCloseHelperFile(&whelper, false);
+  nGroup.files[TSDB_FILE_TYPE_HEAD] = whelper.files.headF;
+  nGroup.files[TSDB_FILE_TYPE_DATA] = whelper.files.dataF;
+  nGroup.files[TSDB_FILE_TYPE_LAST] = whelper.files.lastF;
+  tsdbCloseHelperFile(&rhelper, false);
+
+  int64_t reclaimed = tsdbGetFGroupBytes(&fGroup) - tsdbGetFGroupBytes(&nGroup);
+
+  // Swap the files if the file group is not changed. The marker file only exists while the files are renamed, so the
+  // renames are finished by tsdbRecoverCompaction if the process crashes in the middle.
+  tsdbLockRepo(pRepo);
+  pGroup = tsdbSearchFGroup(pFileH, fid);
+  if (pRepo->commit || pGroup == NULL || pGroup->version != fGroup.version) {
+    tsdbUnLockRepo(pRepo);
+    tsdbTrace("vgId:%d, file group %d is changed during compaction, give up", pCfg->tsdbId, fid);
+    pthread_mutex_lock(&(pCompactor->mutex));
+    pCompactor->stat.numOfAborts++;
+    pthread_mutex_unlock(&(pCompactor->mutex));
+    goto _exit;
+  }
+
+  tsdbGetFileName(dataDir, fid, TSDB_COMPACT_DONE_SUFFIX, fname);
+  int fd = open(fname, O_WRONLY | O_CREAT, 0755);
+  if (fd < 0) {
+    tsdbUnLockRepo(pRepo);
+    tsdbError("vgId:%d, failed to create file %s, reason:%s", pCfg->tsdbId, fname, strerror(errno));
+    goto _exit;
+  }
+  fsync(fd);
+  close(fd);
+
+  // The readers open the files of the group under the read lock, so none of them sees the files half swapped
+  bool renamed = true;
+  pthread_rwlock_wrlock(&(pFileH->fhlock));
+  for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
+    if (rename(nGroup.files[type].fname, pGroup->files[type].fname) < 0) {
+      tsdbError("vgId:%d, failed to rename %s, reason:%s", pCfg->tsdbId, nGroup.files[type].fname, strerror(errno));
+      renamed = false;
+    }
+    pGroup->files[type].info = nGroup.files[type].info;
+  }
+  pthread_rwlock_unlock(&(pFileH->fhlock));
+  // Keep the marker file to retry the renames on restart if any of them fails
+  if (renamed) remove(fname);
+  pGroup->version = ++pFileH->version;
+
+  // Blocks in the new files take the place of the cached ones
+  tsdbClearBlockCache(pRepo->tsdbBlockCache);
+  tsdbUnLockRepo(pRepo);
+
+  pthread_mutex_lock(&(pCompactor->mutex));
+  pCompactor->stat.numOfCompactions++;
+  if (reclaimed > 0) pCompactor->stat.bytesReclaimed += reclaimed;
+  pthread_mutex_unlock(&(pCompactor->mutex));
+
+  tsdbTrace("vgId:%d, file group %d is compacted, %" PRId64 " bytes reclaimed", pCfg->tsdbId, fid, reclaimed);
+  code = 0;
+
+_exit:
+  tdFreeDataCols(pDataCols);
+  tsdbDestroyHelper(&rhelper);
+  tsdbDestroyHelper(&whelper);
+  if (code < 0 && dataDir[0] != '\0') tsdbRemoveCompactFiles(dataDir, fid);
+
+  pthread_mutex_lock(&(pCompactor->mutex));
+  pCompactor->compacting = false;
+  pCompactor->stat.fid = -1;
+  pthread_mutex_unlock(&(pCompactor->mutex));
+
+  return code;
+}
+
+/**
+ * Finish the file swaps of the compactions interrupted by a crash and remove the files of the unfinished
+ * compactions. It should be called before the file groups are loaded.
+ */
+int tsdbRecoverCompaction(char *dataDir) {
+  char src[128] = "\0";
+  char dst[128] = "\0";
+
+  DIR *dir = opendir(dataDir);
+  if (dir == NULL) return -1;
+
+  struct dirent *dp = NULL;
+  while ((dp = readdir(dir)) != NULL) {
+    int  fid = 0;
+    char suffix[16] = "\0";
+    if (sscanf(dp->d_name, "f%d%15s", &fid, suffix) < 2) continue;
+
+    tsdbGetFileName(dataDir, fid, TSDB_COMPACT_DONE_SUFFIX, dst);
+    if (strcmp(suffix, TSDB_COMPACT_DONE_SUFFIX) == 0) {
+      for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
+        tsdbGetFileName(dataDir, fid, tsdbCompactSuffix[type], src);
+        tsdbGetFileName(dataDir, fid, tsdbFileSuffix[type], dst);
+        if (access(src, F_OK) == 0 && rename(src, dst) < 0) {
+          tsdbError("failed to rename %s, reason:%s", src, strerror(errno));
+        }
+      }
+      tsdbGetFileName(dataDir, fid, TSDB_COMPACT_DONE_SUFFIX, dst);
+      remove(dst);
+      tsdbPrint("compaction of file group %d in %s is finished", fid, dataDir);
+    } else if (access(dst, F_OK) < 0) {
+      for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
+        if (strcmp(suffix, tsdbCompactSuffix[type]) == 0) {
+          tsdbGetFileName(dataDir, fid, suffix, src);
+          remove(src);
+        }
+      }
+    }
+  }
+  closedir(dir);
+
+  return 0;
+}
+
+static void *tsdbCompactorThread(void *arg) {
+  STsdbCompactor *pCompactor = (STsdbCompactor *)arg;
+  STsdbRepo *     pRepo = (STsdbRepo *)pCompactor->pRepo;
+
+  while (true) {
+    pthread_mutex_lock(&(pCompactor->mutex));
+    if (!pCompactor->stop) tsdbWaitCompactor(pCompactor, (int64_t)tsCompactInterval * 1000);
+    pthread_mutex_unlock(&(pCompactor->mutex));
+    if (tsdbCompactorStopped(pCompactor)) break;
+
+    // Compact the file groups need to in ascending order, the groups are picked one by one since the file handle
+    // may change between the compactions
+    int minFid = INT32_MIN;
+    int fid = 0;
+    while (!tsdbCompactorStopped(pCompactor) && tsdbPickCompactFGroup(pRepo, minFid, &fid)) {
+      tsdbCompactFGroup(pRepo, fid);
+      if (fid == INT32_MAX) break;
+      minFid = fid + 1;
+    }
+  }
+
+  return NULL;
+}
+
+// Pick the first file group not less than minFid to compact. The file group being written is not compacted.
+static bool tsdbPickCompactFGroup(STsdbRepo *pRepo, int minFid, int *fid) {
+  STsdbFileH *pFileH = pRepo->tsdbFileH;
+  STsdbCfg *  pCfg = &(pRepo->config);
+  bool        found = false;
+
+  int activeFid = tsdbGetKeyFileId(taosGetTimestamp(pCfg->precision), pCfg->daysPerFile, pCfg->precision);
+
+  tsdbLockRepo(pRepo);
+  if (!pRepo->commit) {
+    for (int i = 0; i < pFileH->numOfFGroups; i++) {
+      SFileGroup *pGroup = pFileH->fGroup + i;
+      if (pGroup->fileId < minFid) continue;
+      if (pGroup->fileId >= activeFid) break;
+      if (tsdbShouldCompactFGroup(pGroup)) {
+        *fid = pGroup->fileId;
+        found = true;
+        break;
+      }
+    }
+  }
+  tsdbUnLockRepo(pRepo);
+
+  return found;
+}
+
+// A file group should be compacted if it has too many sub-blocks or too much garbage in the .data file
+static bool tsdbShouldCompactFGroup(SFileGroup *pGroup) {
+  STsdbFileInfo *pHeadInfo = &(pGroup->files[TSDB_FILE_TYPE_HEAD].info);
+  STsdbFileInfo *pDataInfo = &(pGroup->files[TSDB_FILE_TYPE_DATA].info);
+
+  if (pHeadInfo->totalBlocks == 0) return false;
+  if (pHeadInfo->totalSubBlocks > 0 &&
+      (uint64_t)pHeadInfo->totalSubBlocks * 100 >= (uint64_t)pHeadInfo->totalBlocks * tsCompactRatio)
+    return true;
+  if (pDataInfo->tombSize > 0 && pDataInfo->tombSize * 100 >= pDataInfo->size * tsCompactRatio) return true;
+
+  return false;
+}
+
+static bool tsdbCompactorStopped(STsdbCompactor *pCompactor) {
+  pthread_mutex_lock(&(pCompactor->mutex));
+  bool stop = pCompactor->stop;
+  pthread_mutex_unlock(&(pCompactor->mutex));
+  return stop;
+}
+
+// Wait for ms milliseconds or until the compactor is stopped, the mutex of the compactor should be locked
+static void tsdbWaitCompactor(STsdbCompactor *pCompactor, int64_t ms) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += ms / 1000;
+  ts.tv_nsec += (ms % 1000) * 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  pthread_cond_timedwait(&(pCompactor->cond), &(pCompactor->mutex), &ts);
+}
+
+// Account the I/O of the compaction, and sleep if it goes beyond the budget of compactIoLimit MB per second
+static void tsdbThrottleCompactIO(STsdbCompactor *pCompactor, int64_t bytesRead, int64_t bytesWritten) {
+  pthread_mutex_lock(&(pCompactor->mutex));
+  pCompactor->stat.bytesRead += bytesRead;
+  pCompactor->stat.bytesWritten += bytesWritten;
+  pCompactor->ioBytes += (bytesRead + bytesWritten);
+
+  if (tsCompactIoLimit > 0 && !pCompactor->stop) {
+    int64_t budget = (int64_t)tsCompactIoLimit * 1024 * 1024;
+    int64_t expected = pCompactor->ioBytes * 1000 / budget;
+    int64_t elapsed = taosGetTimestampMs() - pCompactor->ioStart;
+    if (expected > elapsed) tsdbWaitCompactor(pCompactor, expected - elapsed);
+  }
+  pthread_mutex_unlock(&(pCompactor->mutex));
+}
+
+// Read all the blocks of a table and write them back as full size super blocks
+static int tsdbCompactTable(STsdbRepo *pRepo, SRWHelper *pRHelper, SRWHelper *pWHelper, STable *pTable,
+                            SDataCols *pDataCols) {
+  STsdbCompactor *pCompactor = pRepo->tsdbCompactor;
+  int             maxRows = pRepo->config.maxRowsPerFileBlock;
+  int64_t         subBlocks = 0;
+
+  tsdbSetHelperTable(pRHelper, pTable, pRepo);
+  if (tsdbLoadCompInfo(pRHelper, NULL) < 0) return -1;
+  tsdbSetHelperTable(pWHelper, pTable, pRepo);
+  tdInitDataCols(pDataCols, tsdbGetTableSchema(pRepo->tsdbMeta, pTable));
+
+  SCompIdx *pIdx = pRHelper->pCompIdx + pTable->tableId.tid;
+  for (int blkIdx = 0; blkIdx < pIdx->numOfBlocks; blkIdx++) {
+    SCompBlock *pCompBlock = blockAtIdx(pRHelper, blkIdx);
+    if (pCompBlock->numOfSubBlocks > 1) subBlocks += pCompBlock->numOfSubBlocks;
+
+    if (tsdbLoadBlockData(pRHelper, pCompBlock, NULL) < 0) return -1;
+    tsdbThrottleCompactIO(pCompactor, tsdbGetBlockBytes(pRHelper, pCompBlock), 0);
+
+    // Move the rows of the block to pDataCols and write it out once it is full
+    SDataCols *pBlockCols = pRHelper->pDataCols[0];
+    while (pBlockCols->numOfRows > 0) {
+      int rowsToMove = MIN(maxRows - pDataCols->numOfRows, pBlockCols->numOfRows);
+      if (tdMergeDataCols(pDataCols, pBlockCols, rowsToMove) < 0) return -1;
+      tdPopDataColsPoints(pBlockCols, rowsToMove);
+
+      if (pDataCols->numOfRows >= maxRows) {
+        if (tsdbWriteCompactBlock(pCompactor, pWHelper, pDataCols) < 0) return -1;
+      }
+    }
+  }
+
+  // The remaining rows go to the .last file if they are not enough for a block in the .data file
+  if (pDataCols->numOfRows > 0) {
+    if (tsdbWriteCompactBlock(pCompactor, pWHelper, pDataCols) < 0) return -1;
+  }
+
+  if (tsdbWriteCompInfo(pWHelper) < 0) return -1;
+
+  pthread_mutex_lock(&(pCompactor->mutex));
+  pCompactor->stat.subBlocksMerged += subBlocks;
+  pthread_mutex_unlock(&(pCompactor->mutex));
+
+  return 0;
+}
+
+static int tsdbWriteCompactBlock(STsdbCompactor *pCompactor, SRWHelper *pWHelper, SDataCols *pDataCols) {
+  uint64_t size = pWHelper->files.dataF.info.size + pWHelper->files.lastF.info.size;
+
+  int rowsWritten = tsdbWriteDataBlock(pWHelper, pDataCols);
+  if (rowsWritten < 0) return -1;
+  ASSERT(rowsWritten == pDataCols->numOfRows);
+  tdPopDataColsPoints(pDataCols, rowsWritten);
+
+  tsdbThrottleCompactIO(pCompactor, 0, pWHelper->files.dataF.info.size + pWHelper->files.lastF.info.size - size);
+  return 0;
+}
+
+// Get the bytes of the block and its sub-blocks in file
+static int64_t tsdbGetBlockBytes(SRWHelper *pHelper, SCompBlock *pCompBlock) {
+  if (pCompBlock->numOfSubBlocks <= 1) return pCompBlock->len;
+
+  int64_t     bytes = 0;
+  SCompBlock *pSubBlock = (SCompBlock *)POINTER_SHIFT(pHelper->pCompInfo, pCompBlock->offset);
+  for (int i = 0; i < pCompBlock->numOfSubBlocks; i++) {
+    bytes += pSubBlock[i].len;
+  }
+  return bytes;
+}
+
+static int64_t tsdbGetFGroupBytes(SFileGroup *pGroup) {
+  int64_t     bytes = 0;
+  struct stat st;
+
+  for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
+    if (stat(pGroup->files[type].fname, &st) == 0) bytes += st.st_size;
+  }
+  return bytes;
+}
+
+// Remove the files of a compaction, the marker file goes first so that the compaction is never rolled forward
+static void tsdbRemoveCompactFiles(char *dataDir, int fid) {
+  char fname[128] = "\0";
+
+  tsdbGetFileName(dataDir, fid, TSDB_COMPACT_DONE_SUFFIX, fname);
+  remove(fname);
+  for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
+    tsdbGetFileName(dataDir, fid, tsdbCompactSuffix[type], fname);
+    remove(fname);
+  }
+}
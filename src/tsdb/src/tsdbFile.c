@@ -45,6 +45,7 @@ STsdbFileH *tsdbInitFileH(char *dataDir, STsdbCfg *pCfg) {
   }
 
   pFileH->maxFGroups = pCfg->keep / pCfg->daysPerFile + 3;
+  pthread_rwlock_init(&(pFileH->fhlock), NULL);
 
   pFileH->fGroup = (SFileGroup *)calloc(pFileH->maxFGroups, sizeof(SFileGroup));
   if (pFileH->fGroup == NULL) {
@@ -52,6 +53,9 @@ STsdbFileH *tsdbInitFileH(char *dataDir, STsdbCfg *pCfg) {
     return NULL;
   }
 
+  // Finish or drop the compactions interrupted by a crash before the files are scanned
+  tsdbRecoverCompaction(dataDir);
+
   DIR *dir = opendir(dataDir);
   if (dir == NULL) {
     free(pFileH);
@@ -75,6 +79,7 @@ STsdbFileH *tsdbInitFileH(char *dataDir, STsdbCfg *pCfg) {
 
 void tsdbCloseFileH(STsdbFileH *pFileH) {
   if (pFileH) {
+    pthread_rwlock_destroy(&(pFileH->fhlock));
     tfree(pFileH->fGroup);
     free(pFileH);
   }
@@ -106,6 +111,7 @@ static int tsdbOpenFGroup(STsdbFileH *pFileH, char *dataDir, int fid) {
 
   SFileGroup fGroup = {0};
   fGroup.fileId = fid;
+  fGroup.version = ++pFileH->version;
 
   for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
     if (tsdbInitFile(dataDir, fid, tsdbFileSuffix[type], &fGroup.files[type]) < 0) return -1;
@@ -129,6 +135,7 @@ SFileGroup *tsdbCreateFGroup(STsdbFileH *pFileH, char *dataDir, int fid, int max
   SFileGroup *pGroup = tsdbSearchFGroup(pFileH, fid);
   if (pGroup == NULL) {  // if not exists, create one
     pFGroup->fileId = fid;
+    pFGroup->version = ++pFileH->version;
     for (int type = TSDB_FILE_TYPE_HEAD; type < TSDB_FILE_TYPE_MAX; type++) {
       if (tsdbCreateFile(dataDir, fid, tsdbFileSuffix[type], &(pFGroup->files[type])) < 0)
         goto _err;
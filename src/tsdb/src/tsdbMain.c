@@ -19,6 +19,14 @@
 #define TSDB_DATA_DIR_NAME "data"
 #define TSDB_DEFAULT_FILE_BLOCK_ROW_OPTION 0.7
 #define TSDB_MAX_LAST_FILE_SIZE (1024 * 1024 * 10) // 10M
+#define TSDB_MAX_SKIPLIST_RUN 512
+
+// A run of skiplist nodes of one submit block with non-decreasing keys, waiting to be put into the skiplist at once
+typedef struct {
+  SMemTable *    pMem;  // the memtable the nodes belong to
+  int32_t        numOfNodes;
+  SSkipListNode *pNodes[TSDB_MAX_SKIPLIST_RUN];
+} SSkipListRun;
 
 enum { TSDB_REPO_STATE_ACTIVE, TSDB_REPO_STATE_CLOSED, TSDB_REPO_STATE_CONFIGURING };
 
@@ -30,10 +38,11 @@ static int32_t tsdbInsertDataToTable(TsdbRepoT *repo, SSubmitBlk *pBlock, TSKEY
 static int32_t tsdbRestoreCfg(STsdbRepo *pRepo, STsdbCfg *pCfg);
 static int32_t tsdbGetDataDirName(STsdbRepo *pRepo, char *fname);
 static void *  tsdbCommitData(void *arg);
-static int     tsdbCommitToFile(STsdbRepo *pRepo, int fid, SSkipListIterator **iters, SRWHelper *pHelper,
-                                SDataCols *pDataCols);
-static TSKEY   tsdbNextIterKey(SSkipListIterator *pIter);
-static int     tsdbHasDataToCommit(SSkipListIterator **iters, int nIters, TSKEY minKey, TSKEY maxKey);
+static void *  tsdbCommitWorker(void *arg);
+static int     tsdbCommitToFile(STsdbRepo *pRepo, int fid, SMemTableIter **iters, SRWHelper *pHelper,
+                                SDataCols *pDataCols, pthread_mutex_t *pMutex);
+static TSKEY   tsdbNextIterKey(SMemTableIter *pIter);
+static int     tsdbHasDataToCommit(SMemTableIter **iters, int nIters, TSKEY minKey, TSKEY maxKey);
 static void    tsdbAlterCompression(STsdbRepo *pRepo, int8_t compression);
 static void    tsdbAlterKeep(STsdbRepo *pRepo, int32_t keep);
 static void    tsdbAlterMaxTables(STsdbRepo *pRepo, int32_t maxTables);
@@ -140,6 +149,8 @@ int32_t tsdbDropRepo(TsdbRepoT *repo) {
 
   pRepo->state = TSDB_REPO_STATE_CLOSED;
 
+  tsdbFreeCompactor(pRepo->tsdbCompactor);
+
   // Free the metaHandle
   tsdbFreeMeta(pRepo->tsdbMeta);
 
@@ -233,8 +244,12 @@ TsdbRepoT *tsdbOpenRepo(char *rootDir, STsdbAppH *pAppH) {
     return NULL;
   }
 
+  // A NULL block cache means the cache is disabled
+  pRepo->tsdbBlockCache = tsdbNewBlockCache((int64_t)tsBlockCacheSize * 1024 * 1024);
+
   // Restore key from file
   if (tsdbRestoreInfo(pRepo) < 0) {
+    tsdbFreeBlockCache(pRepo->tsdbBlockCache);
     tsdbFreeCache(pRepo->tsdbCache);
     tsdbFreeMeta(pRepo->tsdbMeta);
     tsdbCloseFileH(pRepo->tsdbFileH);
@@ -243,6 +258,9 @@ TsdbRepoT *tsdbOpenRepo(char *rootDir, STsdbAppH *pAppH) {
     return NULL;
   }
 
+  // A NULL compactor means the file groups are not compacted
+  pRepo->tsdbCompactor = tsdbNewCompactor(pRepo);
+
   pRepo->state = TSDB_REPO_STATE_ACTIVE;
 
   tsdbTrace("vgId:%d, open tsdb repository successfully!", pRepo->config.tsdbId);
@@ -287,15 +305,26 @@ int32_t tsdbCloseRepo(TsdbRepoT *repo, int toCommit) {
   pRepo->tsdbCache->curBlock = NULL;
   tsdbUnLockRepo(repo);
 
+  // The compactor gives up the file group it is working on since the commit flag is set
+  tsdbFreeCompactor(pRepo->tsdbCompactor);
+  pRepo->tsdbCompactor = NULL;
+
   if (pRepo->appH.notifyStatus) pRepo->appH.notifyStatus(pRepo->appH.appH, TSDB_STATUS_COMMIT_START);
   if (toCommit) tsdbCommitData((void *)repo);
 
   tsdbCloseFileH(pRepo->tsdbFileH);
 
+  tsdbCheckpointMeta(pRepo->tsdbMeta);
   tsdbFreeMeta(pRepo->tsdbMeta);
 
   tsdbFreeCache(pRepo->tsdbCache);
 
+  if (pRepo->tsdbBlockCache) {
+    tsdbTrace("vgId:%d, block cache hits:%" PRId64 " misses:%" PRId64, id, pRepo->tsdbBlockCache->numOfHits,
+              pRepo->tsdbBlockCache->numOfMisses);
+    tsdbFreeBlockCache(pRepo->tsdbBlockCache);
+  }
+
   tfree(pRepo->rootDir);
   tfree(pRepo);
 
@@ -371,6 +400,10 @@ int32_t tsdbTriggerCommit(TsdbRepoT *repo) {
   pRepo->tsdbCache->curBlock = NULL;
   tsdbUnLockRepo(repo);
 
+  // The commit is triggered by the writer, which is the only one to change the meta, so the checkpoint of the meta is
+  // taken here in memory, and written to disk by the commit thread. It is skipped if no table is created since the last.
+  tsdbPrepareMetaCheckpoint(pRepo->tsdbMeta);
+
   // TODO: here should set as detached or use join for memory leak
   pthread_attr_t thattr;
   pthread_attr_init(&thattr);
@@ -453,12 +486,14 @@ int tsdbUpdateTagValue(TsdbRepoT *repo, SUpdateTableTagValMsg *pMsg) {
         pRepo->config.tsdbId, varDataVal(pTable->name), tversion, schemaVersion(pTable->tagSchema));
     return TSDB_CODE_TDB_TAG_VER_OUT_OF_DATE;
   }
-  if (schemaColAt(pTagSchema, DEFAULT_TAG_INDEX_COLUMN)->colId == htons(pMsg->colId)) {
+  // the table is put into the indexes again if the tag is indexed by any of them
+  STable *pSTable = tsdbGetTableByUid(pMeta, pTable->superUid);
+  bool    indexed = tsdbIsTagIndexed(pSTable, htons(pMsg->colId));
+  if (indexed) {
     tsdbRemoveTableFromIndex(pMeta, pTable);
   }
-  // TODO: remove table from index if it is the first column of tag
   tdSetKVRowDataOfCol(&pTable->tagVal, htons(pMsg->colId), htons(pMsg->type), pMsg->data);
-  if (schemaColAt(pTagSchema, DEFAULT_TAG_INDEX_COLUMN)->colId == htons(pMsg->colId)) {
+  if (indexed) {
     tsdbAddTableIntoIndex(pMeta, pTable);
   }
   return TSDB_CODE_SUCCESS;
@@ -511,6 +546,29 @@ int32_t tsdbInsertData(TsdbRepoT *repo, SSubmitMsg *pMsg, SShellSubmitRspMsg * p
   return code;
 }
 
+void tsdbSetParallelInsert(TsdbRepoT *repo, bool parallel) {
+  STsdbRepo *pRepo = (STsdbRepo *)repo;
+
+  pRepo->tsdbCache->parallel = parallel;
+  if (!parallel) tsdbCommitIfWanted(repo);
+}
+
+int32_t tsdbInsertSubmitBlk(TsdbRepoT *repo, SSubmitBlk *pBlock, int32_t *affectedrows) {
+  STsdbRepo *pRepo = (STsdbRepo *)repo;
+
+  return tsdbInsertDataToTable(repo, pBlock, taosGetTimestamp(pRepo->config.precision), affectedrows);
+}
+
+bool tsdbCommitWanted(TsdbRepoT *repo) { return ((STsdbRepo *)repo)->tsdbCache->commitWanted; }
+
+bool tsdbCommitIfWanted(TsdbRepoT *repo) {
+  STsdbCache *pCache = ((STsdbRepo *)repo)->tsdbCache;
+
+  if (!pCache->commitWanted) return false;
+  pCache->commitWanted = false;
+  return tsdbTriggerCommit(repo) == 0;
+}
+
 /**
  * Initialize a table configuration
  */
@@ -902,47 +960,91 @@ static int32_t tsdbDestroyRepoEnv(STsdbRepo *pRepo) {
 //   return 0;
 // }
 
-static int32_t tdInsertRowToTable(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
-  // TODO
+static void tsdbFlushSkipListRun(SSkipListRun *pRun) {
+  if (pRun->numOfNodes == 0) return;
+
+  SMemTable *pMem = pRun->pMem;
+
+  tSkipListPutBatch(pMem->pData, pRun->pNodes, pRun->numOfNodes);
+  pRun->numOfNodes = 0;
+
+  pMem->numOfRows = pMem->numOfBufRows + tSkipListGetSize(pMem->pData);
+}
+
+static int32_t tdInsertRowToTable(STsdbRepo *pRepo, SDataRow row, STable *pTable, SSkipListRun *pRun) {
   int32_t level = 0;
   int32_t headSize = 0;
 
   if (pTable->mem == NULL) {
-    pTable->mem = (SMemTable *)calloc(1, sizeof(SMemTable));
+    pTable->mem = tsdbNewMemTable();
     if (pTable->mem == NULL) return -1;
-    pTable->mem->pData = tSkipListCreate(5, TSDB_DATA_TYPE_TIMESTAMP, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP], 0, 0, 0, getTSTupleKey);
-    pTable->mem->keyFirst = INT64_MAX;
-    pTable->mem->keyLast = 0;
   }
 
-  tSkipListNewNodeInfo(pTable->mem->pData, &level, &headSize);
+  SMemTable *pMem = pTable->mem;
+  TSKEY      key = dataRowKey(row);
+  bool       append = (tsMemTableType == TSDB_MEM_TABLE_APPEND && (pMem->numOfRows == 0 || key > pMem->keyLast));
 
-  TSKEY key = dataRowKey(row);
-  // printf("insert:%lld, size:%d\n", key, pTable->mem->numOfRows);
-  
-  // Copy row into the memory
-  SSkipListNode *pNode = tsdbAllocFromCache(pRepo->tsdbCache, headSize + dataRowLen(row), key);
-  if (pNode == NULL) {
-    // TODO: deal with allocate failure
+  if (!append) {
+    // Duplicated key, the row inserted first is kept as the skiplist does
+    if (tsdbMemTableBufHasKey(pMem, key)) return 0;
+
+    if (pMem->pData == NULL) {
+      pMem->pData = tSkipListCreate(5, TSDB_DATA_TYPE_TIMESTAMP, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP], 0, 0, 0, getTSTupleKey);
+      if (pMem->pData == NULL) return -1;
+    }
+
+    // The run must stay sorted, so put the pending nodes first if the row goes backward
+    if (pRun->numOfNodes == TSDB_MAX_SKIPLIST_RUN ||
+        (pRun->numOfNodes > 0 && key < dataRowKey(SL_GET_NODE_DATA(pRun->pNodes[pRun->numOfNodes - 1])))) {
+      tsdbFlushSkipListRun(pRun);
+    }
+
+    tSkipListNewNodeInfo(pMem->pData, &level, &headSize);
   }
 
-  pNode->level = level;
-  dataRowCpy(SL_GET_NODE_DATA(pNode), row);
+  // The memtables are swapped when the allocation triggers a commit, so put the pending nodes into their memtable
+  // before the commit thread reads it
+  if (tsdbCacheCommitDue(pRepo->tsdbCache, headSize + dataRowLen(row))) tsdbFlushSkipListRun(pRun);
 
-  // Insert the skiplist node into the data
+  // Copy row into the memory
+  void *ptr = tsdbAllocFromCache(pRepo->tsdbCache, headSize + dataRowLen(row), key);
+  if (ptr == NULL) return -1;
+
+  // The allocation may trigger a commit, which moves the memtable of the table to imem
   if (pTable->mem == NULL) {
-    pTable->mem = (SMemTable *)calloc(1, sizeof(SMemTable));
+    pTable->mem = tsdbNewMemTable();
     if (pTable->mem == NULL) return -1;
-    pTable->mem->pData = tSkipListCreate(5, TSDB_DATA_TYPE_TIMESTAMP, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP], 0, 0, 0, getTSTupleKey);
-    pTable->mem->keyFirst = INT64_MAX;
-    pTable->mem->keyLast = 0;
   }
-  tSkipListPut(pTable->mem->pData, pNode);
-  if (key > pTable->mem->keyLast) pTable->mem->keyLast = key;
-  if (key < pTable->mem->keyFirst) pTable->mem->keyFirst = key;
+  pMem = pTable->mem;
+
+  if (append) {
+    // In-order row, append it to the row buffer without any search or node header
+    dataRowCpy(ptr, row);
+    if (tsdbAppendRowToMemTable(pMem, ptr) < 0) return -1;
+  } else {
+    if (pMem->pData == NULL) {
+      pMem->pData = tSkipListCreate(5, TSDB_DATA_TYPE_TIMESTAMP, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP], 0, 0, 0, getTSTupleKey);
+      if (pMem->pData == NULL) return -1;
+      // The level of an empty skiplist is 1, no higher than the one the node is allocated for
+      tSkipListNewNodeInfo(pMem->pData, &level, &headSize);
+    }
+
+    SSkipListNode *pNode = (SSkipListNode *)ptr;
+    pNode->level = level;
+    dataRowCpy(SL_GET_NODE_DATA(pNode), row);
+
+    // The node is put into the skiplist with the rest of the run
+    if (pRun->numOfNodes > 0 && pRun->pMem != pMem) tsdbFlushSkipListRun(pRun);
+    if (pRun->numOfNodes == 0) pRun->pMem = pMem;
+    pRun->pNodes[pRun->numOfNodes++] = pNode;
+  }
+
+  if (key > pMem->keyLast) pMem->keyLast = key;
+  if (key < pMem->keyFirst) pMem->keyFirst = key;
   if (key > pTable->lastKey) pTable->lastKey = key;
-  
-  pTable->mem->numOfRows = tSkipListGetSize(pTable->mem->pData);
+
+  pMem->numOfRows = pMem->numOfBufRows + ((pMem->pData == NULL) ? 0 : tSkipListGetSize(pMem->pData)) +
+                    ((pRun->pMem == pMem) ? pRun->numOfNodes : 0);
 
   tsdbTrace("vgId:%d, tid:%d, uid:%" PRId64 ", table:%s a row is inserted to table! key:%" PRId64, pRepo->config.tsdbId,
             pTable->tableId.tid, pTable->tableId.uid, varDataVal(pTable->name), dataRowKey(row));
@@ -1000,6 +1102,8 @@ static int32_t tsdbInsertDataToTable(TsdbRepoT *repo, SSubmitBlk *pBlock, TSKEY
 
   SSubmitBlkIter blkIter = {0};
   SDataRow row = NULL;
+  SSkipListRun   run = {0};
+  int32_t        code = TSDB_CODE_SUCCESS;
 
   TSKEY minKey = now - tsMsPerDay[pRepo->config.precision] * pRepo->config.keep;
   TSKEY maxKey = now + tsMsPerDay[pRepo->config.precision] * pRepo->config.daysPerFile;
@@ -1010,22 +1114,28 @@ static int32_t tsdbInsertDataToTable(TsdbRepoT *repo, SSubmitBlk *pBlock, TSKEY
       tsdbError("vgId:%d, table:%s, tid:%d, talbe uid:%ld timestamp is out of range. now:" PRId64 ", maxKey:" PRId64
                 ", minKey:" PRId64,
                 pRepo->config.tsdbId, varDataVal(pTable->name), pTable->tableId.tid, pTable->tableId.uid, now, minKey, maxKey);
-      return TSDB_CODE_TDB_TIMESTAMP_OUT_OF_RANGE;
+      code = TSDB_CODE_TDB_TIMESTAMP_OUT_OF_RANGE;
+      break;
     }
 
-    if (tdInsertRowToTable(pRepo, row, pTable) < 0) {
-      return -1;
+    if (tdInsertRowToTable(pRepo, row, pTable, &run) < 0) {
+      code = -1;
+      break;
     }
      (*affectedrows)++;
      points++;
   }
+
+  // Rows accepted before an error are still inserted, as they were when rows were put one by one
+  if (run.numOfNodes > 0) tsdbFlushSkipListRun(&run);
+
   atomic_fetch_add_64(&(pRepo->stat.pointsWritten), points * (pSchema->numOfCols));
   atomic_fetch_add_64(&(pRepo->stat.totalStorage), points * pSchema->vlen);
 
-  return TSDB_CODE_SUCCESS;
+  return code;
 }
 
-static int tsdbReadRowsFromCache(STsdbMeta *pMeta, STable *pTable, SSkipListIterator *pIter, TSKEY maxKey, int maxRowsToRead, SDataCols *pCols) {
+static int tsdbReadRowsFromCache(STsdbMeta *pMeta, STable *pTable, SMemTableIter *pIter, TSKEY maxKey, int maxRowsToRead, SDataCols *pCols) {
   ASSERT(maxRowsToRead > 0);
   if (pIter == NULL) return 0;
   STSchema *pSchema = NULL;
@@ -1035,10 +1145,8 @@ static int tsdbReadRowsFromCache(STsdbMeta *pMeta, STable *pTable, SSkipListIter
   do {
     if (numOfRows >= maxRowsToRead) break;
 
-    SSkipListNode *node = tSkipListIterGet(pIter);
-    if (node == NULL) break;
-
-    SDataRow row = SL_GET_NODE_DATA(node);
+    SDataRow row = tsdbMemTableIterGet(pIter);
+    if (row == NULL) break;
     if (dataRowKey(row) > maxKey) break;
 
     if (pSchema == NULL || schemaVersion(pSchema) != dataRowVersion(row)) {
@@ -1051,34 +1159,36 @@ static int tsdbReadRowsFromCache(STsdbMeta *pMeta, STable *pTable, SSkipListIter
 
     tdAppendDataRowToDataCol(row, pSchema, pCols);
     numOfRows++;
-  } while (tSkipListIterNext(pIter));
+  } while (tsdbMemTableIterNext(pIter));
 
   return numOfRows;
 }
 
-static void tsdbDestroyTableIters(SSkipListIterator **iters, int maxTables) {
+static void tsdbDestroyTableIters(SMemTableIter **iters, int maxTables) {
   if (iters == NULL) return;
 
   for (int tid = 1; tid < maxTables; tid++) {
     if (iters[tid] == NULL) continue;
-    tSkipListDestroyIter(iters[tid]);
+    tsdbDestroyMemTableIter(iters[tid]);
   }
 
   free(iters);
 }
 
-static SSkipListIterator **tsdbCreateTableIters(STsdbMeta *pMeta, int maxTables) {
-  SSkipListIterator **iters = (SSkipListIterator **)calloc(maxTables, sizeof(SSkipListIterator *));
+// Create the iterators of all the tables, each positioned at the first row whose key is not less than skey
+static SMemTableIter **tsdbCreateTableIters(STsdbMeta *pMeta, int maxTables, TSKEY skey) {
+  SMemTableIter **iters = (SMemTableIter **)calloc(maxTables, sizeof(SMemTableIter *));
   if (iters == NULL) return NULL;
 
   for (int tid = 1; tid < maxTables; tid++) {
     STable *pTable = pMeta->tables[tid];
     if (pTable == NULL || pTable->imem == NULL || pTable->imem->numOfRows == 0) continue;
 
-    iters[tid] = tSkipListCreateIter(pTable->imem->pData);
+    iters[tid] = tsdbCreateMemTableIter(pTable->imem, skey, TSDB_ORDER_ASC);
     if (iters[tid] == NULL) goto _err;
 
-    if (!tSkipListIterNext(iters[tid])) goto _err;
+    // The iterator stays at the end if there is no such row
+    tsdbMemTableIterNext(iters[tid]);
   }
 
   return iters;
@@ -1088,55 +1198,72 @@ static SSkipListIterator **tsdbCreateTableIters(STsdbMeta *pMeta, int maxTables)
   return NULL;
 }
 
-static void tsdbFreeMemTable(SMemTable *pMemTable) {
-  if (pMemTable) {
-    tSkipListDestroy(pMemTable->pData);
-    free(pMemTable);
-  }
-}
+// Context shared by the workers of one commit
+typedef struct {
+  STsdbRepo *     pRepo;
+  pthread_mutex_t mutex;  // protect the file handle and the fields below
+  int             nextFid;
+  int             efid;
+  int             code;
+} STsdbCommitCtx;
 
 // Commit to file
 static void *tsdbCommitData(void *arg) {
-  STsdbRepo * pRepo = (STsdbRepo *)arg;
-  STsdbMeta * pMeta = pRepo->tsdbMeta;
-  STsdbCache *pCache = pRepo->tsdbCache;
-  STsdbCfg *  pCfg = &(pRepo->config);
-  SDataCols * pDataCols = NULL;
-  SRWHelper   whelper = {{0}};
-  if (pCache->imem == NULL) return NULL;
+  STsdbRepo *    pRepo = (STsdbRepo *)arg;
+  STsdbMeta *    pMeta = pRepo->tsdbMeta;
+  STsdbCache *   pCache = pRepo->tsdbCache;
+  STsdbCfg *     pCfg = &(pRepo->config);
+  STsdbCommitCtx ctx = {0};
 
-  tsdbPrint("vgId:%d, starting to commit....", pRepo->config.tsdbId);
+  // The checkpoint of the meta taken by the writer is written here, so the insert thread does not wait for the fsync
+  tsdbWriteMetaCheckpoint(pMeta);
 
-  // Create the iterator to read from cache
-  SSkipListIterator **iters = tsdbCreateTableIters(pMeta, pCfg->maxTables);
-  if (iters == NULL) {
-    ASSERT(0);
-    return NULL;
-  }
+  if (pCache->imem == NULL) return NULL;
 
-  if (tsdbInitWriteHelper(&whelper, pRepo) < 0) goto _exit;
-  if ((pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pCfg->maxRowsPerFileBlock)) == NULL) goto _exit;
+  tsdbPrint("vgId:%d, starting to commit....", pRepo->config.tsdbId);
 
   int sfid = tsdbGetKeyFileId(pCache->imem->keyFirst, pCfg->daysPerFile, pCfg->precision);
   int efid = tsdbGetKeyFileId(pCache->imem->keyLast, pCfg->daysPerFile, pCfg->precision);
 
-  // Loop to commit to each file
-  for (int fid = sfid; fid <= efid; fid++) {
-    if (tsdbCommitToFile(pRepo, fid, iters, &whelper, pDataCols) < 0) {
-      ASSERT(false);
-      goto _exit;
+  ctx.pRepo = pRepo;
+  ctx.nextFid = sfid;
+  ctx.efid = efid;
+  pthread_mutex_init(&(ctx.mutex), NULL);
+
+  // File groups are independent of each other, so they can be committed in parallel, each worker takes the next
+  // file id to commit until all are done
+  int nWorkers = MIN(tsCommitThreads, efid - sfid + 1);
+  if (nWorkers > 1) {
+    pthread_t *workers = (pthread_t *)calloc(nWorkers, sizeof(pthread_t));
+    int        nStarted = 0;
+    if (workers != NULL) {
+      for (; nStarted < nWorkers; nStarted++) {
+        if (pthread_create(workers + nStarted, NULL, tsdbCommitWorker, (void *)&ctx) != 0) break;
+      }
     }
+    // Commit in this thread as well if no worker is started
+    if (nStarted == 0) tsdbCommitWorker((void *)&ctx);
+    for (int i = 0; i < nStarted; i++) pthread_join(workers[i], NULL);
+    tfree(workers);
+  } else {
+    tsdbCommitWorker((void *)&ctx);
   }
 
+  pthread_mutex_destroy(&(ctx.mutex));
+  if (ctx.code < 0) {
+    tsdbError("vgId:%d, failed to commit data to files", pRepo->config.tsdbId);
+    ASSERT(false);
+    goto _exit;
+  }
+
+  // Blocks in the rewritten files may take the place of the cached ones
+  tsdbClearBlockCache(pRepo->tsdbBlockCache);
+
   // Do retention actions
   tsdbFitRetention(pRepo);
   if (pRepo->appH.notifyStatus) pRepo->appH.notifyStatus(pRepo->appH.appH, TSDB_STATUS_COMMIT_OVER);
 
 _exit:
-  tdFreeDataCols(pDataCols);
-  tsdbDestroyTableIters(iters, pCfg->maxTables);
-  tsdbDestroyHelper(&whelper);
-
   tsdbLockRepo(arg);
   tdListMove(pCache->imem->list, pCache->pool.memPool);
   tsdbAdjustCacheBlocks(pCache);
@@ -1157,12 +1284,74 @@ _exit:
   return NULL;
 }
 
-static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SSkipListIterator **iters, SRWHelper *pHelper, SDataCols *pDataCols) {
+// Commit the file groups one by one with its own helper and buffer until no file group left or any error occurs
+static void *tsdbCommitWorker(void *arg) {
+  STsdbCommitCtx *pCtx = (STsdbCommitCtx *)arg;
+  STsdbRepo *     pRepo = pCtx->pRepo;
+  STsdbMeta *     pMeta = pRepo->tsdbMeta;
+  STsdbCfg *      pCfg = &(pRepo->config);
+  SDataCols *     pDataCols = NULL;
+  SRWHelper       whelper = {{0}};
+  int             code = 0;
+
+  if (tsdbInitWriteHelper(&whelper, pRepo) < 0) {
+    code = -1;
+    goto _exit;
+  }
+  if ((pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pCfg->maxRowsPerFileBlock)) == NULL) {
+    code = -1;
+    goto _exit;
+  }
+
+  while (true) {
+    pthread_mutex_lock(&(pCtx->mutex));
+    if (pCtx->code < 0 || pCtx->nextFid > pCtx->efid) {
+      pthread_mutex_unlock(&(pCtx->mutex));
+      break;
+    }
+    int fid = pCtx->nextFid++;
+    pthread_mutex_unlock(&(pCtx->mutex));
+
+    TSKEY minKey = 0, maxKey = 0;
+    tsdbGetKeyRangeOfFileId(pCfg->daysPerFile, pCfg->precision, fid, &minKey, &maxKey);
+
+    // Create the iterator to read from cache
+    SMemTableIter **iters = tsdbCreateTableIters(pMeta, pCfg->maxTables, minKey);
+    if (iters == NULL) {
+      code = -1;
+      break;
+    }
+
+    if (tsdbCommitToFile(pRepo, fid, iters, &whelper, pDataCols, &(pCtx->mutex)) < 0) code = -1;
+    tsdbDestroyTableIters(iters, pCfg->maxTables);
+    if (code < 0) break;
+  }
+
+_exit:
+  tdFreeDataCols(pDataCols);
+  tsdbDestroyHelper(&whelper);
+
+  if (code < 0) {
+    pthread_mutex_lock(&(pCtx->mutex));
+    pCtx->code = code;
+    pthread_mutex_unlock(&(pCtx->mutex));
+  }
+
+  return NULL;
+}
+
+/**
+ * Commit the data of file id fid in the cache. The file handle is shared with the other commit workers, so it is only
+ * touched with pMutex locked, and the helper works on a copy of the file group.
+ */
+static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SMemTableIter **iters, SRWHelper *pHelper,
+                            SDataCols *pDataCols, pthread_mutex_t *pMutex) {
   char dataDir[128] = {0};
   STsdbMeta * pMeta = pRepo->tsdbMeta;
   STsdbFileH *pFileH = pRepo->tsdbFileH;
   STsdbCfg *  pCfg = &pRepo->config;
   SFileGroup *pGroup = NULL;
+  SFileGroup  fGroup;
 
   TSKEY minKey = 0, maxKey = 0;
   tsdbGetKeyRangeOfFileId(pCfg->daysPerFile, pCfg->precision, fid, &minKey, &maxKey);
@@ -1173,13 +1362,17 @@ static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SSkipListIterator **iters
 
   // Create and open files for commit
   tsdbGetDataDirName(pRepo, dataDir);
-  if ((pGroup = tsdbCreateFGroup(pFileH, dataDir, fid, pCfg->maxTables)) == NULL) {
+  pthread_mutex_lock(pMutex);
+  pGroup = tsdbCreateFGroup(pFileH, dataDir, fid, pCfg->maxTables);
+  if (pGroup != NULL) fGroup = *pGroup;
+  pthread_mutex_unlock(pMutex);
+  if (pGroup == NULL) {
     tsdbError("vgId:%d, failed to create file group %d", pRepo->config.tsdbId, fid);
     goto _err;
   }
 
   // Open files for write/read
-  if (tsdbSetAndOpenHelperFile(pHelper, pGroup) < 0) {
+  if (tsdbSetAndOpenHelperFile(pHelper, &fGroup) < 0) {
     tsdbError("vgId:%d, failed to set helper file", pRepo->config.tsdbId);
     goto _err;
   }
@@ -1189,7 +1382,7 @@ static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SSkipListIterator **iters
     STable *           pTable = pMeta->tables[tid];
     if (pTable == NULL) continue;
 
-    SSkipListIterator *pIter = iters[tid];
+    SMemTableIter *pIter = iters[tid];
 
     // Set the helper and the buffer dataCols object to help to write this table
     tsdbSetHelperTable(pHelper, pTable, pRepo);
@@ -1238,9 +1431,17 @@ static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SSkipListIterator **iters
 
   tsdbCloseHelperFile(pHelper, 0);
   // TODO: make it atomic with some methods
+  // Search the group again since other workers may have moved it by creating new groups
+  pthread_mutex_lock(pMutex);
+  pGroup = tsdbSearchFGroup(pFileH, fid);
+  ASSERT(pGroup != NULL);
+  pthread_rwlock_wrlock(&(pFileH->fhlock));
   pGroup->files[TSDB_FILE_TYPE_HEAD] = pHelper->files.headF;
   pGroup->files[TSDB_FILE_TYPE_DATA] = pHelper->files.dataF;
   pGroup->files[TSDB_FILE_TYPE_LAST] = pHelper->files.lastF;
+  pthread_rwlock_unlock(&(pFileH->fhlock));
+  pGroup->version = ++pFileH->version;
+  pthread_mutex_unlock(pMutex);
 
   return 0;
 
@@ -1256,20 +1457,19 @@ static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SSkipListIterator **iters
  * @return the next key if iter has
  *         -1 if iter not
  */
-static TSKEY tsdbNextIterKey(SSkipListIterator *pIter) {
+static TSKEY tsdbNextIterKey(SMemTableIter *pIter) {
   if (pIter == NULL) return -1;
 
-  SSkipListNode *node = tSkipListIterGet(pIter);
-  if (node == NULL) return -1;
+  SDataRow row = tsdbMemTableIterGet(pIter);
+  if (row == NULL) return -1;
 
-  SDataRow row = SL_GET_NODE_DATA(node);
   return dataRowKey(row);
 }
 
-static int tsdbHasDataToCommit(SSkipListIterator **iters, int nIters, TSKEY minKey, TSKEY maxKey) {
+static int tsdbHasDataToCommit(SMemTableIter **iters, int nIters, TSKEY minKey, TSKEY maxKey) {
   TSKEY nextKey;
   for (int i = 0; i < nIters; i++) {
-    SSkipListIterator *pIter = iters[i];
+    SMemTableIter *pIter = iters[i];
     nextKey = tsdbNextIterKey(pIter);
     if (nextKey > 0 && (nextKey >= minKey && nextKey <= maxKey)) return 1;
   }
@@ -1388,10 +1588,13 @@ uint32_t tsdbGetFileInfo(TsdbRepoT *repo, char *name, uint32_t *index, uint32_t
   return magic;
 }
 
-void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage){
+void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage, int64_t *cacheHits,
+                    int64_t *cacheMisses) {
     ASSERT(repo != NULL);
     STsdbRepo * pRepo = repo;
     *totalPoints = pRepo->stat.pointsWritten;
     *totalStorage = pRepo->stat.totalStorage;
     *compStorage = pRepo->stat.compStorage;
+    *cacheHits = (pRepo->tsdbBlockCache != NULL) ? pRepo->tsdbBlockCache->numOfHits : 0;
+    *cacheMisses = (pRepo->tsdbBlockCache != NULL) ? pRepo->tsdbBlockCache->numOfMisses : 0;
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "tsdb.h"
+#include "tsdbMain.h"
+
+#define TSDB_MEM_ITER_NONE -1
+#define TSDB_MEM_ITER_BUF 0
+#define TSDB_MEM_ITER_SKIPLIST 1
+
+static int32_t tsdbCountBufRowsBefore(SMemTable *pMemTable, int32_t numOfRows, TSKEY key, bool inclusive);
+
+// Locate the row at position pos of the row buffer
+static FORCE_INLINE int32_t tsdbGetBufChunk(int32_t pos, int32_t *offset) {
+  int32_t k = 31 - __builtin_clz(pos / TSDB_MEM_CHUNK_MIN_ROWS + 1);
+  *offset = pos - TSDB_MEM_CHUNK_MIN_ROWS * ((1 << k) - 1);
+  return k;
+}
+
+static FORCE_INLINE SDataRow tsdbGetBufRow(SMemTable *pMemTable, int32_t pos) {
+  int32_t offset = 0;
+  int32_t k = tsdbGetBufChunk(pos, &offset);
+  return pMemTable->chunks[k][offset];
+}
+
+SMemTable *tsdbNewMemTable() {
+  SMemTable *pMemTable = (SMemTable *)calloc(1, sizeof(SMemTable));
+  if (pMemTable == NULL) return NULL;
+
+  pMemTable->keyFirst = INT64_MAX;
+  pMemTable->keyLast = 0;
+
+  return pMemTable;
+}
+
+void tsdbFreeMemTable(SMemTable *pMemTable) {
+  if (pMemTable == NULL) return;
+
+  tSkipListDestroy(pMemTable->pData);
+  for (int k = 0; k < TSDB_MEM_MAX_CHUNKS; k++) {
+    tfree(pMemTable->chunks[k]);
+  }
+
+  free(pMemTable);
+}
+
+/**
+ * Append a row to the end of the row buffer. The key of the row must be greater than all the keys in the buffer.
+ * Readers only see the row after numOfBufRows is updated, so no lock is needed with a single writer.
+ */
+int tsdbAppendRowToMemTable(SMemTable *pMemTable, SDataRow row) {
+  int32_t pos = pMemTable->numOfBufRows;
+  int32_t offset = 0;
+  int32_t k = tsdbGetBufChunk(pos, &offset);
+  if (k >= TSDB_MEM_MAX_CHUNKS) return -1;
+
+  if (pMemTable->chunks[k] == NULL) {
+    pMemTable->chunks[k] = (SDataRow *)malloc(sizeof(SDataRow) * TSDB_MEM_CHUNK_ROWS(k));
+    if (pMemTable->chunks[k] == NULL) return -1;
+  }
+
+  ASSERT(pos == 0 || dataRowKey(tsdbGetBufRow(pMemTable, pos - 1)) < dataRowKey(row));
+  pMemTable->chunks[k][offset] = row;
+  atomic_store_32(&(pMemTable->numOfBufRows), pos + 1);
+
+  return 0;
+}
+
+bool tsdbMemTableBufHasKey(SMemTable *pMemTable, TSKEY key) {
+  int32_t numOfRows = pMemTable->numOfBufRows;
+  int32_t pos = tsdbCountBufRowsBefore(pMemTable, numOfRows, key, false);
+
+  return (pos < numOfRows) && (dataRowKey(tsdbGetBufRow(pMemTable, pos)) == key);
+}
+
+/**
+ * Create an iterator merging the row buffer and the skiplist of the memory table. As the skiplist iterator, it is
+ * positioned before the first row whose key is not less (ascending) or not greater (descending) than key, and
+ * tsdbMemTableIterNext should be called to move to that row.
+ */
+SMemTableIter *tsdbCreateMemTableIter(SMemTable *pMemTable, TSKEY key, int order) {
+  ASSERT(order == TSDB_ORDER_ASC || order == TSDB_ORDER_DESC);
+
+  SMemTableIter *pIter = (SMemTableIter *)calloc(1, sizeof(SMemTableIter));
+  if (pIter == NULL) return NULL;
+
+  pIter->pMem = pMemTable;
+  pIter->order = order;
+  pIter->chosen = TSDB_MEM_ITER_NONE;
+
+  // Rows appended after this point are not visible to the iterator
+  pIter->numOfBufRows = atomic_load_32(&(pMemTable->numOfBufRows));
+  if (order == TSDB_ORDER_ASC) {
+    pIter->pos = tsdbCountBufRowsBefore(pMemTable, pIter->numOfBufRows, key, false) - 1;
+  } else {
+    pIter->pos = tsdbCountBufRowsBefore(pMemTable, pIter->numOfBufRows, key, true);
+  }
+
+  if (pMemTable->pData != NULL) {
+    pIter->pIter = tSkipListCreateIterFromVal(pMemTable->pData, (const char *)&key, TSDB_DATA_TYPE_TIMESTAMP, order);
+    if (pIter->pIter == NULL) {
+      free(pIter);
+      return NULL;
+    }
+  }
+
+  return pIter;
+}
+
+/**
+ * Move the iterator to the next row.
+ * @return true if there is such row, false otherwise
+ */
+bool tsdbMemTableIterNext(SMemTableIter *pIter) {
+  int step = (pIter->order == TSDB_ORDER_ASC) ? 1 : -1;
+
+  if (!pIter->started) {
+    pIter->started = true;
+    pIter->pos += step;
+    if (pIter->pIter != NULL) tSkipListIterNext(pIter->pIter);
+  } else if (pIter->chosen == TSDB_MEM_ITER_BUF) {
+    pIter->pos += step;
+  } else if (pIter->chosen == TSDB_MEM_ITER_SKIPLIST) {
+    tSkipListIterNext(pIter->pIter);
+  } else {
+    return false;
+  }
+
+  SDataRow bufRow = NULL, slRow = NULL;
+  if (pIter->pos >= 0 && pIter->pos < pIter->numOfBufRows) bufRow = tsdbGetBufRow(pIter->pMem, pIter->pos);
+  if (pIter->pIter != NULL) {
+    SSkipListNode *node = tSkipListIterGet(pIter->pIter);
+    if (node != NULL) slRow = SL_GET_NODE_DATA(node);
+  }
+
+  // The row buffer and the skiplist never hold the same key
+  if (bufRow != NULL && slRow != NULL) {
+    bool bufFirst = (pIter->order == TSDB_ORDER_ASC) ? (dataRowKey(bufRow) < dataRowKey(slRow))
+                                                     : (dataRowKey(bufRow) > dataRowKey(slRow));
+    pIter->chosen = bufFirst ? TSDB_MEM_ITER_BUF : TSDB_MEM_ITER_SKIPLIST;
+  } else if (bufRow != NULL) {
+    pIter->chosen = TSDB_MEM_ITER_BUF;
+  } else if (slRow != NULL) {
+    pIter->chosen = TSDB_MEM_ITER_SKIPLIST;
+  } else {
+    pIter->chosen = TSDB_MEM_ITER_NONE;
+  }
+
+  pIter->row = (pIter->chosen == TSDB_MEM_ITER_BUF) ? bufRow : slRow;
+  return pIter->row != NULL;
+}
+
+SDataRow tsdbMemTableIterGet(SMemTableIter *pIter) {
+  if (pIter == NULL) return NULL;
+  return pIter->row;
+}
+
+void tsdbDestroyMemTableIter(SMemTableIter *pIter) {
+  if (pIter == NULL) return;
+
+  tSkipListDestroyIter(pIter->pIter);
+  free(pIter);
+}
+
+// Return the number of rows in the first numOfRows rows of the buffer whose keys are less than (or equal to) key
+static int32_t tsdbCountBufRowsBefore(SMemTable *pMemTable, int32_t numOfRows, TSKEY key, bool inclusive) {
+  int32_t low = 0, high = numOfRows;
+
+  while (low < high) {
+    int32_t mid = low + (high - low) / 2;
+    TSKEY   midKey = dataRowKey(tsdbGetBufRow(pMemTable, mid));
+    if (midKey < key || (inclusive && midKey == key)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
@@ -3,6 +3,7 @@
 #include "tsdb.h"
 #include "taosdef.h"
 #include "hash.h"
+#include "tbitmap.h"
 #include "tsdbMain.h"
 
 #define TSDB_SUPER_TABLE_SL_LEVEL 5 // TODO: may change here
@@ -13,6 +14,24 @@ static int     tsdbFreeTable(STable *pTable);
 static int32_t tsdbCheckTableCfg(STableCfg *pCfg);
 static int     tsdbAddTableToMeta(STsdbMeta *pMeta, STable *pTable, bool addIdx);
 static int     tsdbRemoveTableFromMeta(STsdbMeta *pMeta, STable *pTable, bool rmFromIdx);
+static int     tsdbUpdateTagIndexes(STsdbMeta *pMeta, STable *pSTable);
+static void    tsdbAddTableIntoTagIndex(STsdbMeta *pMeta, STable *pTable, STagIndex *pTagIndex);
+static SSkipListNode *tsdbNewIndexNode(STsdbMeta *pMeta, STable *pTable, SSkipList *pIndex, int16_t colId);
+
+/*
+ * The order of the child tables in each index of a super table is kept in the checkpoint of the meta file, so the
+ * indexes are restored by putting the tables in sorted runs instead of one by one. An index is followed by the tids
+ * of its tables, the index on the first tag always comes first among the ones of the super table.
+ */
+typedef struct {
+  uint64_t superUid;
+  int16_t  colId;  // 0 for pIndex on the first tag
+  int16_t  reserved;
+  int32_t  numOfTables;
+} STagIndexCkp;
+
+#define TSDB_TAG_INDEX_CKP_LEN(numOfTables) \
+  (sizeof(STagIndexCkp) + sizeof(int32_t) * (((numOfTables) + 1) / 2 * 2))
 
 /**
  * Encode a TSDB table object as a binary content
@@ -126,7 +145,8 @@ void tsdbFreeEncode(void *cont) {
 
 static char* getTagIndexKey(const void* pData) {
   STableIndexElem* elem = (STableIndexElem*) pData;
-  
+  if (elem->colId != 0) return tdGetKVRowValOfCol(elem->pTable->tagVal, elem->colId);
+
   STSchema* pSchema = tsdbGetTableTagSchema(elem->pMeta, elem->pTable);
   STColumn* pCol = &pSchema->columns[DEFAULT_TAG_INDEX_COLUMN];
   void * res = tdGetKVRowValOfCol(elem->pTable->tagVal, pCol->colId);
@@ -143,6 +163,7 @@ int tsdbRestoreTable(void *pHandle, void *cont, int contLen) {
     STColumn* pColSchema = schemaColAt(pTable->tagSchema, 0);
     pTable->pIndex = tSkipListCreate(TSDB_SUPER_TABLE_SL_LEVEL, pColSchema->type, pColSchema->bytes,
                                     1, 0, 1, getTagIndexKey);
+    tsdbUpdateTagIndexes(pMeta, pTable);
   }
 
   tsdbAddTableToMeta(pMeta, pTable, false);
@@ -150,15 +171,205 @@ int tsdbRestoreTable(void *pHandle, void *cont, int contLen) {
   return 0;
 }
 
-void tsdbOrgMeta(void *pHandle) {
+static bool tsdbIsChildOf(STsdbMeta *pMeta, int32_t tid, STable *pSTable) {
+  if (tid <= 0 || tid >= pMeta->maxTables) return false;
+
+  STable *pTable = pMeta->tables[tid];
+  return pTable != NULL && pTable->type == TSDB_CHILD_TABLE && pTable->superUid == pSTable->tableId.uid;
+}
+
+// the nodes are put in a sorted run, the ones out of order, such as a table of a reused tid, are put one by one
+static void tsdbPutIndexNodes(SSkipList *pIndex, SArray *pNodes) {
+  SSkipListNode **nodes = (SSkipListNode **)pNodes->pData;
+  size_t          size = taosArrayGetSize(pNodes);
+  int32_t         numOfSorted = 0;
+
+  for (int32_t i = 0; i < size; ++i) {
+    if (numOfSorted > 0 &&
+        pIndex->comparFn(SL_GET_NODE_KEY(pIndex, nodes[numOfSorted - 1]), SL_GET_NODE_KEY(pIndex, nodes[i])) > 0) {
+      tSkipListPut(pIndex, nodes[i]);
+    } else {
+      nodes[numOfSorted++] = nodes[i];
+    }
+  }
+
+  tSkipListPutBatch(pIndex, nodes, numOfSorted);
+  taosArrayClear(pNodes);
+}
+
+/*
+ * Restore the indexes of the super tables in the order kept in the checkpoint. The tables put into pIndex are set in
+ * pIndexed, the ones left are added as usual. A table missing from the checkpoint of a secondary index, such as an
+ * index added by tagIndexColumns after the checkpoint, is added into it one by one.
+ */
+static void tsdbRestoreIndexes(STsdbMeta *pMeta, char *cont, int contLen, SBitmap *pIndexed) {
+  SBitmap *pSeen = taosBitmapCreate(pMeta->maxTables);
+  SArray * pNodes = taosArrayInit(1024, POINTER_BYTES);
+  if (pSeen == NULL || pNodes == NULL) goto _exit;
+
+  char *end = cont + contLen;
+  char *ptr = cont;
+  while (ptr + sizeof(STagIndexCkp) <= end) {
+    STagIndexCkp *pCkp = (STagIndexCkp *)ptr;
+    char *        next = ptr + TSDB_TAG_INDEX_CKP_LEN(pCkp->numOfTables);
+    int32_t *     tids = (int32_t *)(pCkp + 1);
+    if (pCkp->numOfTables < 0 || next > end) break;
+
+    STable *pSTable = tsdbGetTableByUid(pMeta, pCkp->superUid);
+    ptr = next;
+    if (pSTable == NULL || pSTable->type != TSDB_SUPER_TABLE || pCkp->colId != 0) continue;
+
+    for (int32_t i = 0; i < pCkp->numOfTables; ++i) {
+      if (!tsdbIsChildOf(pMeta, tids[i], pSTable) || taosBitmapGet(pIndexed, tids[i])) continue;
+
+      SSkipListNode *pNode = tsdbNewIndexNode(pMeta, pMeta->tables[tids[i]], pSTable->pIndex, 0);
+      if (pNode == NULL) break;
+
+      taosBitmapSet(pIndexed, tids[i]);
+      taosArrayPush(pNodes, &pNode);
+    }
+    tsdbPutIndexNodes(pSTable->pIndex, pNodes);
+
+    // the secondary indexes of the super table follow pIndex
+    char *pTagCkp[TSDB_MAX_TAGS] = {0};
+    while (ptr + sizeof(STagIndexCkp) <= end && ((STagIndexCkp *)ptr)->superUid == pSTable->tableId.uid &&
+           ((STagIndexCkp *)ptr)->colId != 0) {
+      STagIndexCkp *pTag = (STagIndexCkp *)ptr;
+      if (pTag->numOfTables < 0 || ptr + TSDB_TAG_INDEX_CKP_LEN(pTag->numOfTables) > end) break;
+
+      for (int j = 0; j < pSTable->numOfTagIndex; ++j) {
+        if (pSTable->tagIndex[j].colId == pTag->colId) pTagCkp[j] = ptr;
+      }
+      ptr += TSDB_TAG_INDEX_CKP_LEN(pTag->numOfTables);
+    }
+
+    for (int j = 0; j < pSTable->numOfTagIndex; ++j) {
+      STagIndex *pTagIndex = pSTable->tagIndex + j;
+      taosBitmapClear(pSeen);
+
+      if (pTagCkp[j] != NULL) {
+        STagIndexCkp *pTag = (STagIndexCkp *)pTagCkp[j];
+        int32_t *     tagTids = (int32_t *)(pTag + 1);
+
+        for (int32_t i = 0; i < pTag->numOfTables; ++i) {
+          int32_t tid = tagTids[i];
+          if (!tsdbIsChildOf(pMeta, tid, pSTable) || !taosBitmapGet(pIndexed, tid) || taosBitmapGet(pSeen, tid)) {
+            continue;
+          }
+
+          // a NULL key is never indexed
+          taosBitmapSet(pSeen, tid);
+          if (tdGetKVRowValOfCol(pMeta->tables[tid]->tagVal, pTagIndex->colId) == NULL) continue;
+
+          SSkipListNode *pNode = tsdbNewIndexNode(pMeta, pMeta->tables[tid], pTagIndex->pIndex, pTagIndex->colId);
+          if (pNode != NULL) taosArrayPush(pNodes, &pNode);
+        }
+        tsdbPutIndexNodes(pTagIndex->pIndex, pNodes);
+      }
+
+      for (int32_t i = 0; i < pCkp->numOfTables; ++i) {
+        int32_t tid = tids[i];
+        if (tsdbIsChildOf(pMeta, tid, pSTable) && taosBitmapGet(pIndexed, tid) && !taosBitmapGet(pSeen, tid)) {
+          taosBitmapSet(pSeen, tid);
+          tsdbAddTableIntoTagIndex(pMeta, pMeta->tables[tid], pTagIndex);
+        }
+      }
+    }
+  }
+
+_exit:
+  taosArrayDestroy(pNodes);
+  taosBitmapDestroy(pSeen);
+}
+
+void tsdbOrgMeta(void *pHandle, void *ckpCont, int ckpContLen) {
   STsdbMeta *pMeta = (STsdbMeta *)pHandle;
+  SBitmap *  pIndexed = NULL;
+
+  if (ckpCont != NULL) {
+    pIndexed = taosBitmapCreate(pMeta->maxTables);
+    if (pIndexed != NULL) tsdbRestoreIndexes(pMeta, ckpCont, ckpContLen, pIndexed);
+  }
 
   for (int i = 1; i < pMeta->maxTables; i++) {
     STable *pTable = pMeta->tables[i];
-    if (pTable != NULL && pTable->type == TSDB_CHILD_TABLE) {
+    if (pTable != NULL && pTable->type == TSDB_CHILD_TABLE && (pIndexed == NULL || !taosBitmapGet(pIndexed, i))) {
       tsdbAddTableIntoIndex(pMeta, pTable);
     }
   }
+
+  taosBitmapDestroy(pIndexed);
+}
+
+static char *tsdbEncodeIndexCkp(char *ptr, STable *pSTable, SSkipList *pIndex, int16_t colId) {
+  STagIndexCkp *pCkp = (STagIndexCkp *)ptr;
+  int32_t *     tids = (int32_t *)(pCkp + 1);
+
+  pCkp->superUid = pSTable->tableId.uid;
+  pCkp->colId = colId;
+  pCkp->reserved = 0;
+  pCkp->numOfTables = 0;
+
+  SSkipListIterator *pIter = tSkipListCreateIter(pIndex);
+  while (tSkipListIterNext(pIter)) {
+    STableIndexElem *pElem = (STableIndexElem *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    tids[pCkp->numOfTables++] = pElem->pTable->tableId.tid;
+  }
+  tSkipListDestroyIter(pIter);
+
+  if (pCkp->numOfTables % 2) tids[pCkp->numOfTables] = 0;
+  return ptr + TSDB_TAG_INDEX_CKP_LEN(pCkp->numOfTables);
+}
+
+/*
+ * Take the checkpoint of the meta file with the order of the child tables in the indexes of the super tables in
+ * memory. It shall be called when the meta is not changed by others, such as on close and by the writer when it
+ * triggers a commit, and the checkpoint is written by tsdbWriteMetaCheckpoint then.
+ */
+int32_t tsdbPrepareMetaCheckpoint(STsdbMeta *pMeta) {
+  if (pMeta == NULL || pMeta->mfh == NULL) return 0;
+  if (tsdbMetaFileCheckpointed(pMeta->mfh)) return 0;
+
+  size_t contLen = 0;
+  for (STable *pSTable = pMeta->superList; pSTable != NULL; pSTable = pSTable->next) {
+    contLen += TSDB_TAG_INDEX_CKP_LEN(tSkipListGetSize(pSTable->pIndex));
+    for (int i = 0; i < pSTable->numOfTagIndex; ++i) {
+      contLen += TSDB_TAG_INDEX_CKP_LEN(tSkipListGetSize(pSTable->tagIndex[i].pIndex));
+    }
+  }
+
+  char *cont = malloc(contLen + 1);
+  if (cont == NULL) return -1;
+
+  char *ptr = cont;
+  for (STable *pSTable = pMeta->superList; pSTable != NULL; pSTable = pSTable->next) {
+    ptr = tsdbEncodeIndexCkp(ptr, pSTable, pSTable->pIndex, 0);
+    for (int i = 0; i < pSTable->numOfTagIndex; ++i) {
+      ptr = tsdbEncodeIndexCkp(ptr, pSTable, pSTable->tagIndex[i].pIndex, pSTable->tagIndex[i].colId);
+    }
+  }
+  assert(ptr - cont == contLen);
+
+  int32_t code = tsdbPrepareMetaFileCheckpoint(pMeta->mfh, cont, (int32_t)contLen);
+  if (code < 0) tsdbError("failed to prepare the checkpoint of meta file");
+
+  free(cont);
+  return code;
+}
+
+// Write the checkpoint prepared, it may be called by the commit thread while the meta is changed
+int32_t tsdbWriteMetaCheckpoint(STsdbMeta *pMeta) {
+  if (pMeta == NULL || pMeta->mfh == NULL) return 0;
+
+  int32_t code = tsdbWriteMetaFileCheckpoint(pMeta->mfh);
+  if (code < 0) tsdbError("failed to checkpoint meta file, reason:%s", strerror(errno));
+
+  return code;
+}
+
+int32_t tsdbCheckpointMeta(STsdbMeta *pMeta) {
+  if (tsdbPrepareMetaCheckpoint(pMeta) < 0) return -1;
+  return tsdbWriteMetaCheckpoint(pMeta);
 }
 
 /**
@@ -345,7 +556,7 @@ static STable *tsdbNewTable(STableCfg *pCfg, bool isSuper) {
     STColumn *pColSchema = schemaColAt(pTable->tagSchema, 0);
     pTable->pIndex = tSkipListCreate(TSDB_SUPER_TABLE_SL_LEVEL, pColSchema->type, pColSchema->bytes, 1, 0, 0,
                                      getTagIndexKey);  // Allow duplicate key, no lock
-    if (pTable->pIndex == NULL) {
+    if (pTable->pIndex == NULL || tsdbUpdateTagIndexes(NULL, pTable) < 0) {
       terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
       goto _err;
     }
@@ -388,7 +599,7 @@ _err:
   return NULL;
 }
 
-static int tsdbUpdateTableTagSchema(STable *pTable, STSchema *newSchema) {
+static int tsdbUpdateTableTagSchema(STsdbMeta *pMeta, STable *pTable, STSchema *newSchema) {
   ASSERT(pTable->type == TSDB_SUPER_TABLE);
   ASSERT(schemaVersion(pTable->tagSchema) < schemaVersion(newSchema));
   STSchema *pOldSchema = pTable->tagSchema;
@@ -397,6 +608,9 @@ static int tsdbUpdateTableTagSchema(STable *pTable, STSchema *newSchema) {
   pTable->tagSchema = pNewSchema;
   tdFreeSchema(pOldSchema);
 
+  // the tags indexed are the leading ones of the new schema
+  if (tsdbUpdateTagIndexes(pMeta, pTable) < 0) return TSDB_CODE_TDB_OUT_OF_MEMORY;
+
   return TSDB_CODE_SUCCESS;
 }
 
@@ -406,7 +620,7 @@ int tsdbUpdateTable(STsdbMeta *pMeta, STable *pTable, STableCfg *pCfg) {
 
   if (pTable->type == TSDB_SUPER_TABLE) {
     if (schemaVersion(pTable->tagSchema) < schemaVersion(pCfg->tagSchema)) {
-      int32_t code = tsdbUpdateTableTagSchema(pTable, pCfg->tagSchema);
+      int32_t code = tsdbUpdateTableTagSchema(pMeta, pTable, pCfg->tagSchema);
       if (code != TSDB_CODE_SUCCESS) return code;
     }
     isChanged = true;
@@ -613,14 +827,6 @@ int tsdbDropTable(TsdbRepoT *repo, STableId tableId) {
 //   return 0;
 // }
 
-static void tsdbFreeMemTable(SMemTable *pMemTable) {
-  if (pMemTable) {
-    tSkipListDestroy(pMemTable->pData);
-  }
-
-  free(pMemTable);
-}
-
 static int tsdbFreeTable(STable *pTable) {
   if (pTable == NULL) return 0;
 
@@ -641,6 +847,8 @@ static int tsdbFreeTable(STable *pTable) {
   if (TSDB_TABLE_IS_SUPER_TABLE(pTable)) {
     tdFreeSchema(pTable->tagSchema);
     tSkipListDestroy(pTable->pIndex);
+    for (int i = 0; i < pTable->numOfTagIndex; i++) tSkipListDestroy(pTable->tagIndex[i].pIndex);
+    tfree(pTable->tagIndex);
   }
 
   tsdbFreeMemTable(pTable->mem);
@@ -744,28 +952,133 @@ static int tsdbRemoveTableFromMeta(STsdbMeta *pMeta, STable *pTable, bool rmFrom
   return 0;
 }
 
-int tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable) {
-  assert(pTable->type == TSDB_CHILD_TABLE && pTable != NULL);
-  STable* pSTable = tsdbGetTableByUid(pMeta, pTable->superUid);
-  assert(pSTable != NULL);
-  
+static void tsdbAddTableIntoTagIndex(STsdbMeta *pMeta, STable *pTable, STagIndex *pTagIndex) {
+  // a NULL key can not be compared, and such a table does not satisfy any condition on the tag
+  if (tdGetKVRowValOfCol(pTable->tagVal, pTagIndex->colId) == NULL) return;
+
+  SSkipListNode* pNode = tsdbNewIndexNode(pMeta, pTable, pTagIndex->pIndex, pTagIndex->colId);
+  if (pNode == NULL) return;
+
+  tSkipListPut(pTagIndex->pIndex, pNode);
+}
+
+static void tsdbRemoveTableFromTagIndex(STable *pTable, STagIndex *pTagIndex) {
+  char* key = tdGetKVRowValOfCol(pTable->tagVal, pTagIndex->colId);
+  if (key == NULL) return;
+
+  SArray* res = tSkipListGet(pTagIndex->pIndex, key);
+  size_t  size = taosArrayGetSize(res);
+
+  for (int32_t i = 0; i < size; ++i) {
+    SSkipListNode* pNode = taosArrayGetP(res, i);
+    if (((STableIndexElem*) SL_GET_NODE_DATA(pNode))->pTable == pTable) {
+      tSkipListRemoveNode(pTagIndex->pIndex, pNode);
+    }
+  }
+
+  taosArrayDestroy(res);
+}
+
+/*
+ * Keep the secondary indexes of the super table on its 2nd to tagIndexColumns-th tags, the first tag is always indexed
+ * by pIndex. The indexes still wanted are kept, the new ones are filled with the child tables already in pIndex.
+ */
+static int tsdbUpdateTagIndexes(STsdbMeta *pMeta, STable *pSTable) {
+  STSchema *pSchema = pSTable->tagSchema;
+  int       numOfIndex = MAX(MIN(tsTagIndexColumns, schemaNCols(pSchema)) - 1, 0);
+
+  STagIndex *tagIndex = NULL;
+  if (numOfIndex > 0) {
+    tagIndex = calloc(numOfIndex, sizeof(STagIndex));
+    if (tagIndex == NULL) return -1;
+  }
+
+  for (int i = 0; i < numOfIndex; ++i) {
+    STColumn *pCol = schemaColAt(pSchema, i + 1);
+    tagIndex[i].colId = colColId(pCol);
+
+    for (int j = 0; j < pSTable->numOfTagIndex; ++j) {
+      if (pSTable->tagIndex[j].colId == colColId(pCol)) {
+        tagIndex[i].pIndex = pSTable->tagIndex[j].pIndex;
+        pSTable->tagIndex[j].pIndex = NULL;
+        break;
+      }
+    }
+
+    if (tagIndex[i].pIndex != NULL) continue;
+
+    // duplicate keys, no lock as pIndex, the nodes are freed with the index
+    tagIndex[i].pIndex = tSkipListCreate(TSDB_SUPER_TABLE_SL_LEVEL, colType(pCol), colBytes(pCol), 1, 0, 1,
+                                         getTagIndexKey);
+    if (tagIndex[i].pIndex == NULL) {
+      for (int j = 0; j <= i; ++j) tSkipListDestroy(tagIndex[j].pIndex);
+      free(tagIndex);
+      return -1;
+    }
+
+    SSkipListIterator *pIter = tSkipListCreateIter(pSTable->pIndex);
+    while (tSkipListIterNext(pIter)) {
+      STableIndexElem *pElem = (STableIndexElem *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+      tsdbAddTableIntoTagIndex(pMeta, pElem->pTable, tagIndex + i);
+    }
+    tSkipListDestroyIter(pIter);
+  }
+
+  for (int j = 0; j < pSTable->numOfTagIndex; ++j) tSkipListDestroy(pSTable->tagIndex[j].pIndex);
+  tfree(pSTable->tagIndex);
+
+  pSTable->tagIndex = tagIndex;
+  pSTable->numOfTagIndex = numOfIndex;
+  return 0;
+}
+
+void *tsdbGetTagIndex(STable *pSTable, int16_t colId) {
+  for (int i = 0; i < pSTable->numOfTagIndex; ++i) {
+    if (pSTable->tagIndex[i].colId == colId) return pSTable->tagIndex[i].pIndex;
+  }
+
+  return NULL;
+}
+
+bool tsdbIsTagIndexed(STable *pSTable, int16_t colId) {
+  return colColId(schemaColAt(pSTable->tagSchema, DEFAULT_TAG_INDEX_COLUMN)) == colId ||
+         tsdbGetTagIndex(pSTable, colId) != NULL;
+}
+
+// the node of the table in the index on the tag of colId, 0 for pIndex
+static SSkipListNode *tsdbNewIndexNode(STsdbMeta *pMeta, STable *pTable, SSkipList *pIndex, int16_t colId) {
   int32_t level = 0;
   int32_t headSize = 0;
-  
-  tSkipListNewNodeInfo(pSTable->pIndex, &level, &headSize);
-  
+
+  tSkipListNewNodeInfo(pIndex, &level, &headSize);
+
   // NOTE: do not allocate the space for key, since in each skip list node, only keep the pointer to pTable, not the
   // actual key value, and the key value will be retrieved during query through the pTable and getTagIndexKey function
   SSkipListNode* pNode = calloc(1, headSize + sizeof(STableIndexElem));
+  if (pNode == NULL) return NULL;
   pNode->level = level;
-  
-  SSkipList* list = pSTable->pIndex;
+
   STableIndexElem* elem = (STableIndexElem*) (SL_GET_NODE_DATA(pNode));
-  
   elem->pTable = pTable;
   elem->pMeta = pMeta;
+  elem->colId = colId;
+
+  return pNode;
+}
+
+int tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable) {
+  assert(pTable->type == TSDB_CHILD_TABLE && pTable != NULL);
+  STable* pSTable = tsdbGetTableByUid(pMeta, pTable->superUid);
+  assert(pSTable != NULL);
   
-  tSkipListPut(list, pNode);
+  SSkipListNode* pNode = tsdbNewIndexNode(pMeta, pTable, pSTable->pIndex, 0);
+  if (pNode == NULL) return -1;
+
+  tSkipListPut(pSTable->pIndex, pNode);
+
+  for (int i = 0; i < pSTable->numOfTagIndex; ++i) {
+    tsdbAddTableIntoTagIndex(pMeta, pTable, pSTable->tagIndex + i);
+  }
   return 0;
 }
 
@@ -794,6 +1107,10 @@ int tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable) {
   }
   
   taosArrayDestroy(res);
+
+  for (int i = 0; i < pSTable->numOfTagIndex; ++i) {
+    tsdbRemoveTableFromTagIndex(pTable, pSTable->tagIndex + i);
+  }
   return 0;
 }
 
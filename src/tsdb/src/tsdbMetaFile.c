@@ -16,6 +16,7 @@
 
 #include "taosdef.h"
 #include "hash.h"
+#include "tchecksum.h"
 #include "tsdbMain.h"
 
 #define TSDB_META_FILE_VERSION_MAJOR 1
@@ -28,11 +29,30 @@ typedef struct {
   uint64_t uid;
 } SRecordInfo;
 
+/*
+ * The checkpoint of the meta file is a flat file mapped into memory on restore. It holds the records alive in the
+ * first metaSize bytes of the meta file, in the order of offset, followed by the content given by the application.
+ * The records are decoded from the mapped meta file instead of being read one by one, only the records appended after
+ * metaSize are read as before.
+ */
+#define TSDB_META_CKP_MAGIC "TDMCKP"
+#define TSDB_META_CKP_VERSION 1
+
+typedef struct {
+  char    magic[8];
+  int32_t version;
+  int32_t numOfRecords;
+  int64_t metaSize;
+  int32_t contLen;
+  TSCKSUM checksum;  // of the records and the content
+} SMetaCkpHead;
+
 // static int32_t tsdbGetMetaFileName(char *rootDir, char *fname);
 // static int32_t tsdbCheckMetaHeader(int fd);
 static int32_t tsdbWriteMetaHeader(int fd);
 static int     tsdbCreateMetaFile(char *fname);
 static int     tsdbRestoreFromMetaFile(char *fname, SMetaFile *mfh);
+static void    tsdbRemoveMetaCheckpoint(SMetaFile *mfh, int64_t offset);
 
 SMetaFile *tsdbInitMetaFile(char *rootDir, int32_t maxTables, iterFunc iFunc, afterFunc aFunc, void *appH) {
   char fname[128] = "\0";
@@ -47,6 +67,8 @@ SMetaFile *tsdbInitMetaFile(char *rootDir, int32_t maxTables, iterFunc iFunc, af
   mfh->nDel = 0;
   mfh->tombSize = 0;
   mfh->size = 0;
+  mfh->ckpSize = 0;
+  snprintf(mfh->ckpName, sizeof(mfh->ckpName), "%s/%s", rootDir, TSDB_META_CKP_FILE_NAME);
 
   // OPEN MAP
   mfh->map =
@@ -58,6 +80,7 @@ SMetaFile *tsdbInitMetaFile(char *rootDir, int32_t maxTables, iterFunc iFunc, af
 
   // OPEN FILE
   if (access(fname, F_OK) < 0) {  // file not exists
+    remove(mfh->ckpName);
     mfh->fd = tsdbCreateMetaFile(fname);
     if (mfh->fd < 0) {
       taosHashCleanup(mfh->map);
@@ -73,6 +96,7 @@ SMetaFile *tsdbInitMetaFile(char *rootDir, int32_t maxTables, iterFunc iFunc, af
     }
   }
 
+  pthread_mutex_init(&(mfh->ckpMutex), NULL);
   return mfh;
 }
 
@@ -117,6 +141,7 @@ int32_t tsdbDeleteMetaRecord(SMetaFile *mfh, uint64_t uid) {
   if (ptr == NULL) return -1;
 
   SRecordInfo info = *(SRecordInfo *)ptr;
+  tsdbRemoveMetaCheckpoint(mfh, info.offset);
 
   // Remove record from hash table
   taosHashRemove(mfh->map, (char *)(&uid), sizeof(uid));
@@ -144,6 +169,8 @@ int32_t tsdbUpdateMetaRecord(SMetaFile *mfh, uint64_t uid, void *cont, int32_t c
   if (ptr == NULL) return -1;
 
   SRecordInfo info = *(SRecordInfo *)ptr;
+  tsdbRemoveMetaCheckpoint(mfh, info.offset);
+
   // Update the hash table
   if (taosHashPut(mfh->map, (char *)(&uid), sizeof(uid), (void *)(&info), sizeof(SRecordInfo)) < 0) {
     return -1;
@@ -172,10 +199,122 @@ int32_t tsdbUpdateMetaRecord(SMetaFile *mfh, uint64_t uid, void *cont, int32_t c
   return 0;
 }
 
+static int tsdbCompareRecordOffset(const void *p1, const void *p2) {
+  if (((SRecordInfo *)p1)->offset < ((SRecordInfo *)p2)->offset) {
+    return -1;
+  } else if (((SRecordInfo *)p1)->offset > ((SRecordInfo *)p2)->offset) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+// Whether the checkpoint, the one being written or the one prepared covers the whole meta file
+bool tsdbMetaFileCheckpointed(SMetaFile *mfh) {
+  pthread_mutex_lock(&(mfh->ckpMutex));
+  bool checkpointed = (mfh->ckpSize == mfh->size || mfh->ckpWriting == mfh->size ||
+                       (mfh->pCkp != NULL && ((SMetaCkpHead *)mfh->pCkp)->metaSize == mfh->size));
+  pthread_mutex_unlock(&(mfh->ckpMutex));
+
+  return checkpointed;
+}
+
+/*
+ * Take the checkpoint of the whole meta file with the content of the application in memory. It shall be called when
+ * the records are not changed by others, and it is written to disk by tsdbWriteMetaFileCheckpoint later.
+ */
+int32_t tsdbPrepareMetaFileCheckpoint(SMetaFile *mfh, void *cont, int32_t contLen) {
+  int32_t       numOfRecords = (int32_t)taosHashGetSize(mfh->map);
+  SMetaCkpHead *pHead = malloc(sizeof(SMetaCkpHead) + sizeof(SRecordInfo) * numOfRecords + contLen);
+  if (pHead == NULL) return -1;
+
+  memset(pHead, 0, sizeof(SMetaCkpHead));
+  strcpy(pHead->magic, TSDB_META_CKP_MAGIC);
+  pHead->version = TSDB_META_CKP_VERSION;
+  pHead->metaSize = mfh->size;
+  pHead->contLen = contLen;
+
+  SRecordInfo *         records = (SRecordInfo *)(pHead + 1);
+  SHashMutableIterator *pIter = taosHashCreateIter(mfh->map);
+  while (taosHashIterNext(pIter) && pHead->numOfRecords < numOfRecords) {
+    records[pHead->numOfRecords++] = *(SRecordInfo *)taosHashIterGet(pIter);
+  }
+  taosHashDestroyIter(pIter);
+
+  qsort(records, pHead->numOfRecords, sizeof(SRecordInfo), tsdbCompareRecordOffset);
+  if (contLen > 0) memcpy(records + pHead->numOfRecords, cont, contLen);
+
+  pHead->checksum = taosCalcChecksum(0, (uint8_t *)records, sizeof(SRecordInfo) * pHead->numOfRecords + contLen);
+
+  pthread_mutex_lock(&(mfh->ckpMutex));
+  tfree(mfh->pCkp);
+  mfh->pCkp = pHead;
+  pthread_mutex_unlock(&(mfh->ckpMutex));
+
+  return 0;
+}
+
+/*
+ * Write the checkpoint prepared to a temporary file renamed at last, so a checkpoint found on restore is always
+ * complete. It is dropped if any record it covers is changed in the meantime.
+ */
+int32_t tsdbWriteMetaFileCheckpoint(SMetaFile *mfh) {
+  pthread_mutex_lock(&(mfh->ckpMutex));
+  SMetaCkpHead *pHead = mfh->pCkp;
+  mfh->pCkp = NULL;
+  if (pHead != NULL) mfh->ckpWriting = pHead->metaSize;
+  pthread_mutex_unlock(&(mfh->ckpMutex));
+
+  if (pHead == NULL) return 0;
+
+  int64_t metaSize = pHead->metaSize;
+  int64_t len = sizeof(SMetaCkpHead) + sizeof(SRecordInfo) * pHead->numOfRecords + pHead->contLen;
+
+  char tname[TSDB_FILENAME_LEN + 4];
+  snprintf(tname, sizeof(tname), "%s.t", mfh->ckpName);
+
+  // the records covered shall be on disk before the checkpoint refers to them
+  int32_t code = 0;
+  int     fd = open(tname, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+  if (fd < 0 || fsync(mfh->fd) < 0 || twrite(fd, pHead, len) != len || fsync(fd) < 0) {
+    code = -1;
+  }
+
+  if (fd >= 0) close(fd);
+  free(pHead);
+
+  pthread_mutex_lock(&(mfh->ckpMutex));
+  bool valid = (mfh->ckpWriting == metaSize);
+  if (code == 0 && valid && rename(tname, mfh->ckpName) == 0) {
+    mfh->ckpSize = metaSize;
+  } else {
+    remove(tname);
+    if (valid) code = -1;
+  }
+  mfh->ckpWriting = 0;
+  pthread_mutex_unlock(&(mfh->ckpMutex));
+
+  return code;
+}
+
+// the checkpoint, and the one being taken, no longer match the records they cover if the record at offset is changed
+static void tsdbRemoveMetaCheckpoint(SMetaFile *mfh, int64_t offset) {
+  pthread_mutex_lock(&(mfh->ckpMutex));
+  if (offset < mfh->ckpSize) {
+    remove(mfh->ckpName);
+    mfh->ckpSize = 0;
+  }
+  if (offset < mfh->ckpWriting) mfh->ckpWriting = 0;
+  if (mfh->pCkp != NULL && offset < ((SMetaCkpHead *)mfh->pCkp)->metaSize) tfree(mfh->pCkp);
+  pthread_mutex_unlock(&(mfh->ckpMutex));
+}
+
 void tsdbCloseMetaFile(SMetaFile *mfh) {
   if (mfh == NULL) return;
   close(mfh->fd);
 
+  tfree(mfh->pCkp);
+  pthread_mutex_destroy(&(mfh->ckpMutex));
   taosHashCleanup(mfh->map);
   tfree(mfh);
 }
@@ -222,6 +361,67 @@ static int tsdbCheckMetaFileIntegrety(int fd) {
   return 0;
 }
 
+// Map the checkpoint into memory, NULL if there is no one valid for the meta file of fileSize bytes
+static SMetaCkpHead *tsdbMapMetaCheckpoint(char *ckpName, int64_t fileSize, size_t *mapLen) {
+  int fd = open(ckpName, O_RDONLY);
+  if (fd < 0) return NULL;
+
+  struct stat fstatus;
+  if (fstat(fd, &fstatus) < 0 || fstatus.st_size < sizeof(SMetaCkpHead)) {
+    close(fd);
+    return NULL;
+  }
+
+  SMetaCkpHead *pHead = mmap(NULL, fstatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (pHead == MAP_FAILED) return NULL;
+
+  int64_t bodyLen = (int64_t)pHead->numOfRecords * sizeof(SRecordInfo) + pHead->contLen;
+  if (strncmp(pHead->magic, TSDB_META_CKP_MAGIC, sizeof(pHead->magic)) != 0 ||
+      pHead->version != TSDB_META_CKP_VERSION || pHead->numOfRecords < 0 || pHead->contLen < 0 ||
+      sizeof(SMetaCkpHead) + bodyLen != fstatus.st_size || pHead->metaSize < TSDB_META_FILE_HEADER_SIZE ||
+      pHead->metaSize > fileSize || !taosCheckChecksum((uint8_t *)(pHead + 1), bodyLen, pHead->checksum)) {
+    tsdbError("meta checkpoint %s is invalid, ignore it", ckpName);
+    munmap(pHead, fstatus.st_size);
+    return NULL;
+  }
+
+  SRecordInfo *records = (SRecordInfo *)(pHead + 1);
+  for (int32_t i = 0; i < pHead->numOfRecords; ++i) {
+    if (records[i].offset < TSDB_META_FILE_HEADER_SIZE || records[i].size < 0 ||
+        records[i].offset + sizeof(SRecordInfo) + records[i].size > pHead->metaSize) {
+      tsdbError("meta checkpoint %s has invalid record at offset %d, ignore it", ckpName, records[i].offset);
+      munmap(pHead, fstatus.st_size);
+      return NULL;
+    }
+  }
+
+  *mapLen = fstatus.st_size;
+  return pHead;
+}
+
+// Restore the records covered by the checkpoint from the mapped meta file, it returns the size of the file restored
+static int64_t tsdbRestoreFromMetaCheckpoint(SMetaFile *mfh, SMetaCkpHead *pHead) {
+  char *pMeta = mmap(NULL, pHead->metaSize, PROT_READ, MAP_PRIVATE, mfh->fd, 0);
+  if (pMeta == MAP_FAILED) return -1;
+
+  madvise(pMeta, pHead->metaSize, MADV_SEQUENTIAL);
+
+  SRecordInfo *records = (SRecordInfo *)(pHead + 1);
+  for (int32_t i = 0; i < pHead->numOfRecords; ++i) {
+    SRecordInfo *pInfo = records + i;
+    if (taosHashPut(mfh->map, (char *)(&pInfo->uid), sizeof(pInfo->uid), (void *)pInfo, sizeof(SRecordInfo)) < 0) {
+      munmap(pMeta, pHead->metaSize);
+      return -1;
+    }
+
+    (*mfh->iFunc)(mfh->appH, pMeta + pInfo->offset + sizeof(SRecordInfo), pInfo->size);
+  }
+
+  munmap(pMeta, pHead->metaSize);
+  return pHead->metaSize;
+}
+
 static int tsdbRestoreFromMetaFile(char *fname, SMetaFile *mfh) {
   int fd = open(fname, O_RDWR);
   if (fd < 0) return -1;
@@ -232,16 +432,35 @@ static int tsdbRestoreFromMetaFile(char *fname, SMetaFile *mfh) {
     return -1;
   }
 
-  if (lseek(fd, TSDB_META_FILE_HEADER_SIZE, SEEK_SET) < 0) {
+  mfh->fd = fd;
+  mfh->size += TSDB_META_FILE_HEADER_SIZE;
+
+  struct stat   fstatus;
+  size_t        ckpLen = 0;
+  SMetaCkpHead *pCkp = NULL;
+  if (fstat(fd, &fstatus) == 0) pCkp = tsdbMapMetaCheckpoint(mfh->ckpName, fstatus.st_size, &ckpLen);
+
+  if (pCkp != NULL) {
+    int64_t size = tsdbRestoreFromMetaCheckpoint(mfh, pCkp);
+    if (size < 0) {
+      munmap(pCkp, ckpLen);
+      close(fd);
+      return -1;
+    }
+
+    tsdbTrace("meta file %s, %d records restored from checkpoint, %" PRId64 " bytes left to replay", fname,
+              pCkp->numOfRecords, (int64_t)fstatus.st_size - size);
+    mfh->size = size;
+    mfh->ckpSize = size;
+  }
+
+  if (lseek(fd, mfh->size, SEEK_SET) < 0) {
     // TODO: deal with the error
+    if (pCkp != NULL) munmap(pCkp, ckpLen);
     close(fd);
     return -1;
   }
 
-  mfh->size += TSDB_META_FILE_HEADER_SIZE;
-
-  mfh->fd = fd;
-
   void *buf = NULL;
   // int buf_size = 0;
 
@@ -257,14 +476,19 @@ static int tsdbRestoreFromMetaFile(char *fname, SMetaFile *mfh) {
     } else {
       if (taosHashPut(mfh->map, (char *)(&info.uid), sizeof(info.uid), (void *)(&info), sizeof(SRecordInfo)) < 0) {
         if (buf) free(buf);
+        if (pCkp != NULL) munmap(pCkp, ckpLen);
         return -1;
       }
 
       buf = realloc(buf, info.size);
-      if (buf == NULL) return -1;
+      if (buf == NULL) {
+        if (pCkp != NULL) munmap(pCkp, ckpLen);
+        return -1;
+      }
 
       if (read(mfh->fd, buf, info.size) < 0) {
         if (buf) free(buf);
+        if (pCkp != NULL) munmap(pCkp, ckpLen);
         return -1;
       }
       (*mfh->iFunc)(mfh->appH, buf, info.size);
@@ -273,7 +497,13 @@ static int tsdbRestoreFromMetaFile(char *fname, SMetaFile *mfh) {
     }
 
   }
-  (*mfh->aFunc)(mfh->appH);
+  if (pCkp != NULL) {
+    SRecordInfo *records = (SRecordInfo *)(pCkp + 1);
+    (*mfh->aFunc)(mfh->appH, records + pCkp->numOfRecords, pCkp->contLen);
+    munmap(pCkp, ckpLen);
+  } else {
+    (*mfh->aFunc)(mfh->appH, NULL, 0);
+  }
 
   if (buf) free(buf);
 
@@ -120,6 +120,8 @@ static int tsdbInitHelper(SRWHelper *pHelper, STsdbRepo *pRepo, tsdb_rw_helper_t
   pHelper->config.minRowsPerFileBlock = pRepo->config.minRowsPerFileBlock;
   pHelper->config.maxRowsPerFileBlock = pRepo->config.maxRowsPerFileBlock;
   pHelper->config.compress = pRepo->config.compression;
+  if (type == TSDB_READ_HELPER) pHelper->pBlockCache = pRepo->tsdbBlockCache;
+  pHelper->pFileH = pRepo->tsdbFileH;
 
   pHelper->state = TSDB_HELPER_CLEAR_STATE;
 
@@ -189,6 +191,13 @@ int tsdbSetAndOpenHelperFile(SRWHelper *pHelper, SFileGroup *pGroup) {
 
   ASSERT(pHelper->state == TSDB_HELPER_CLEAR_STATE);
 
+  // The files are not replaced while a reader opens them, the writer is the only one to replace them itself
+  pthread_rwlock_t *fhlock = NULL;
+  if (TSDB_HELPER_TYPE(pHelper) == TSDB_READ_HELPER && pHelper->pFileH != NULL) {
+    fhlock = &(pHelper->pFileH->fhlock);
+    pthread_rwlock_rdlock(fhlock);
+  }
+
   // Set the files
   pHelper->files.fid = pGroup->fileId;
   pHelper->files.headF = pGroup->files[TSDB_FILE_TYPE_HEAD];
@@ -226,12 +235,50 @@ int tsdbSetAndOpenHelperFile(SRWHelper *pHelper, SFileGroup *pGroup) {
     if (tsdbOpenFile(&(pHelper->files.dataF), O_RDONLY) < 0) goto _err;
     if (tsdbOpenFile(&(pHelper->files.lastF), O_RDONLY) < 0) goto _err;
   }
+  if (fhlock != NULL) pthread_rwlock_unlock(fhlock);
 
   helperSetState(pHelper, TSDB_HELPER_FILE_SET_AND_OPEN);
 
   return tsdbLoadCompIdx(pHelper, NULL);
 
   _err:
+  if (fhlock != NULL) pthread_rwlock_unlock(fhlock);
+  return -1;
+}
+
+/**
+ * Set and open a write helper on a newly created file group. Blocks are only appended to the .data and .last files,
+ * and the SCompInfo and SCompIdx parts are written to the .head file in place, so no .h or .l file is used.
+ */
+int tsdbSetAndOpenHelperNewFile(SRWHelper *pHelper, SFileGroup *pGroup) {
+  ASSERT(pHelper != NULL && pGroup != NULL);
+  ASSERT(TSDB_HELPER_TYPE(pHelper) == TSDB_WRITE_HELPER);
+
+  tsdbResetHelper(pHelper);
+
+  ASSERT(pHelper->state == TSDB_HELPER_CLEAR_STATE);
+
+  // The .head file is written as the new head file, renaming it to itself on close does nothing
+  pHelper->files.fid = pGroup->fileId;
+  pHelper->files.headF = pGroup->files[TSDB_FILE_TYPE_HEAD];
+  pHelper->files.dataF = pGroup->files[TSDB_FILE_TYPE_DATA];
+  pHelper->files.lastF = pGroup->files[TSDB_FILE_TYPE_LAST];
+  pHelper->files.nHeadF = pGroup->files[TSDB_FILE_TYPE_HEAD];
+  pHelper->files.headF.fd = -1;
+  pHelper->files.dataF.fd = -1;
+  pHelper->files.lastF.fd = -1;
+  pHelper->files.nHeadF.fd = -1;
+
+  if (tsdbOpenFile(&(pHelper->files.dataF), O_RDWR) < 0) goto _err;
+  if (tsdbOpenFile(&(pHelper->files.lastF), O_RDWR) < 0) goto _err;
+  if (tsdbOpenFile(&(pHelper->files.nHeadF), O_WRONLY) < 0) goto _err;
+
+  memset(pHelper->pCompIdx, 0, tsizeof(pHelper->pCompIdx));
+  helperSetState(pHelper, (TSDB_HELPER_FILE_SET_AND_OPEN | TSDB_HELPER_IDX_LOAD));
+
+  return 0;
+
+_err:
   return -1;
 }
 
@@ -252,6 +299,7 @@ int tsdbCloseHelperFile(SRWHelper *pHelper, bool hasError) {
     close(pHelper->files.lastF.fd);
     pHelper->files.lastF.fd = -1;
   }
+  bool newHead = false, newLast = false;
   if (pHelper->files.nHeadF.fd > 0) {
     if (!hasError) tsdbUpdateFileHeader(&(pHelper->files.nHeadF), 0);
     fsync(pHelper->files.nHeadF.fd);
@@ -260,8 +308,7 @@ int tsdbCloseHelperFile(SRWHelper *pHelper, bool hasError) {
     if (hasError) {
       remove(pHelper->files.nHeadF.fname);
     } else {
-      rename(pHelper->files.nHeadF.fname, pHelper->files.headF.fname);
-      pHelper->files.headF.info = pHelper->files.nHeadF.info;
+      newHead = true;
     }
   }
   
@@ -273,9 +320,22 @@ int tsdbCloseHelperFile(SRWHelper *pHelper, bool hasError) {
     if (hasError) {
       remove(pHelper->files.nLastF.fname);
     } else {
+      newLast = true;
+    }
+  }
+
+  // The new .head and .last are put in place together for the readers
+  if (newHead || newLast) {
+    if (pHelper->pFileH != NULL) pthread_rwlock_wrlock(&(pHelper->pFileH->fhlock));
+    if (newHead) {
+      rename(pHelper->files.nHeadF.fname, pHelper->files.headF.fname);
+      pHelper->files.headF.info = pHelper->files.nHeadF.info;
+    }
+    if (newLast) {
       rename(pHelper->files.nLastF.fname, pHelper->files.lastF.fname);
       pHelper->files.lastF.info = pHelper->files.nLastF.info;
     }
+    if (pHelper->pFileH != NULL) pthread_rwlock_unlock(&(pHelper->pFileH->fhlock));
   }
   return 0;
 }
@@ -442,12 +502,18 @@ int tsdbWriteCompIdx(SRWHelper *pHelper) {
 
   SFile *pFile = &(pHelper->files.nHeadF);
   pFile->info.offset = offset;
+  pFile->info.totalBlocks = 0;
+  pFile->info.totalSubBlocks = 0;
 
   // TODO: change the implementation of pHelper->pBuffer
   void *buf = pHelper->pBuffer;
   for (uint32_t i = 0; i < pHelper->config.maxTables; i++) {
     SCompIdx *pCompIdx = pHelper->pCompIdx + i;
     if (pCompIdx->offset > 0) {
+      // The SCompBlock part holds the super blocks followed by the sub-blocks
+      pFile->info.totalBlocks += pCompIdx->numOfBlocks;
+      pFile->info.totalSubBlocks +=
+          (pCompIdx->len - sizeof(SCompInfo) - sizeof(TSCKSUM)) / sizeof(SCompBlock) - pCompIdx->numOfBlocks;
       int drift = POINTER_DISTANCE(buf, pHelper->pBuffer);
       if (tsizeof(pHelper->pBuffer) - drift < 128) {
         pHelper->pBuffer = trealloc(pHelper->pBuffer, tsizeof(pHelper->pBuffer)*2);
@@ -463,6 +529,7 @@ int tsdbWriteCompIdx(SRWHelper *pHelper) {
 
   if (twrite(pHelper->files.nHeadF.fd, (void *)pHelper->pBuffer, tsize) < tsize) return -1;
   pFile->info.len = tsize;
+  pFile->info.size = offset + tsize;
   return 0;
 }
 
@@ -586,62 +653,6 @@ static int comparColIdCompCol(const void *arg1, const void *arg2) {
   return (*(int16_t *)arg1) - ((SCompCol *)arg2)->colId;
 }
 
-static int comparColIdDataCol(const void *arg1, const void *arg2) {
-  return (*(int16_t *)arg1) - ((SDataCol *)arg2)->colId;
-}
-
-static int tsdbLoadSingleColumnData(int fd, SCompBlock *pCompBlock, SCompCol *pCompCol, void *buf) {
-  size_t tsize = sizeof(SCompData) + sizeof(SCompCol) * pCompBlock->numOfCols;
-  if (lseek(fd, pCompBlock->offset + tsize + pCompCol->offset, SEEK_SET) < 0) return -1;
-  if (tread(fd, buf, pCompCol->len) < pCompCol->len) return -1;
-
-  return 0;
-}
-
-static int tsdbLoadSingleBlockDataCols(SRWHelper *pHelper, SCompBlock *pCompBlock, int16_t *colIds, int numOfColIds,
-                                       SDataCols *pDataCols) {
-  if (tsdbLoadCompData(pHelper, pCompBlock, NULL) < 0) return -1;
-  int fd = (pCompBlock->last) ? pHelper->files.lastF.fd : pHelper->files.dataF.fd;
-
-  void *ptr = NULL;
-  for (int i = 0; i < numOfColIds; i++) {
-    int16_t colId = colIds[i];
-
-    ptr = bsearch((void *)&colId, (void *)pHelper->pCompData->cols, pHelper->pCompData->numOfCols, sizeof(SCompCol), comparColIdCompCol);
-    if (ptr == NULL) continue;
-    SCompCol *pCompCol = (SCompCol *)ptr;
-
-    ptr = bsearch((void *)&colId, (void *)(pDataCols->cols), pDataCols->numOfCols, sizeof(SDataCol), comparColIdDataCol);
-    ASSERT(ptr != NULL);
-    SDataCol *pDataCol = (SDataCol *)ptr;
-
-    pDataCol->len = pCompCol->len;
-    if (tsdbLoadSingleColumnData(fd, pCompBlock, pCompCol, pDataCol->pData) < 0) return -1;
-  }
-
-  return 0;
-}
-
-// Load specific column data from file
-int tsdbLoadBlockDataCols(SRWHelper *pHelper, SDataCols *pDataCols, int blkIdx, int16_t *colIds, int numOfColIds) {
-  SCompBlock *pCompBlock = pHelper->pCompInfo->blocks + blkIdx;
-
-  ASSERT(pCompBlock->numOfSubBlocks >= 1); // Must be super block
-
-  int numOfSubBlocks = pCompBlock->numOfSubBlocks;
-  SCompBlock *pStartBlock =
-      (numOfSubBlocks == 1) ? pCompBlock : (SCompBlock *)((char *)pHelper->pCompInfo->blocks + pCompBlock->offset);
-
-  if (tsdbLoadSingleBlockDataCols(pHelper, pStartBlock, colIds, numOfColIds, pDataCols) < 0) return -1;
-  for (int i = 1; i < numOfSubBlocks; i++) {
-    pStartBlock++;
-    if (tsdbLoadSingleBlockDataCols(pHelper, pStartBlock, colIds, numOfColIds, pHelper->pDataCols[1]) < 0) return -1;
-    tdMergeDataCols(pDataCols, pHelper->pDataCols[1], pHelper->pDataCols[1]->numOfRows);
-  }
-
-  return 0;
-}
-
 static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, char *content, int32_t len, int8_t comp, int numOfRows,
                                         int maxPoints, char *buffer, int bufferSize) {
   // Verify by checksum
@@ -675,6 +686,20 @@ static int tsdbLoadBlockDataImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDa
   ASSERT(tsizeof(pHelper->pBuffer) >= pCompBlock->len);
 
   SCompData *pCompData = (SCompData *)pHelper->pBuffer;
+  int        fid = pHelper->files.fid;
+  int8_t     cached[TSDB_MAX_COLUMNS] = {0};
+
+  pDataCols->numOfRows = pCompBlock->numOfRows;
+
+  // Try the block cache first, the block is not read if all the columns are cached
+  if (pHelper->pBlockCache != NULL) {
+    int numOfCached = 0;
+    for (int dcol = 0; dcol < pDataCols->numOfCols; dcol++) {
+      cached[dcol] = tsdbGetColFromBlockCache(pHelper->pBlockCache, fid, pCompBlock, pDataCols->cols + dcol);
+      numOfCached += cached[dcol];
+    }
+    if (numOfCached == pDataCols->numOfCols) return 0;
+  }
 
   int fd = (pCompBlock->last) ? pHelper->files.lastF.fd : pHelper->files.dataF.fd;
   if (lseek(fd, pCompBlock->offset, SEEK_SET) < 0) goto _err;
@@ -684,16 +709,20 @@ static int tsdbLoadBlockDataImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDa
   int32_t tsize = sizeof(SCompData) + sizeof(SCompCol) * pCompBlock->numOfCols + sizeof(TSCKSUM);
   if (!taosCheckChecksumWhole((uint8_t *)pCompData, tsize)) goto _err;
 
-  pDataCols->numOfRows = pCompBlock->numOfRows;
-
   // Recover the data
   int ccol = 0;
   int dcol = 0;
   while (dcol < pDataCols->numOfCols) {
     SDataCol *pDataCol = &(pDataCols->cols[dcol]);
+    if (cached[dcol]) {
+      dcol++;
+      continue;
+    }
+
     if (ccol >= pCompData->numOfCols) {
       // Set current column as NULL and forward
       dataColSetNEleNull(pDataCol, pCompBlock->numOfRows, pDataCols->maxPoints);
+      tsdbPutColIntoBlockCache(pHelper->pBlockCache, fid, pCompBlock, pDataCol);
       dcol++;
       continue;
     }
@@ -713,6 +742,7 @@ static int tsdbLoadBlockDataImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDa
                                        pCompBlock->algorithm, pCompBlock->numOfRows, pDataCols->maxPoints,
                                        pHelper->compBuffer, tsizeof(pHelper->compBuffer)) < 0)
         goto _err;
+      tsdbPutColIntoBlockCache(pHelper->pBlockCache, fid, pCompBlock, pDataCol);
       dcol++;
       ccol++;
     } else if (pCompCol->colId < pDataCol->colId) {
@@ -720,6 +750,7 @@ static int tsdbLoadBlockDataImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDa
     } else {
       // Set current column as NULL and forward
       dataColSetNEleNull(pDataCol, pCompBlock->numOfRows, pDataCols->maxPoints);
+      tsdbPutColIntoBlockCache(pHelper->pBlockCache, fid, pCompBlock, pDataCol);
       dcol++;
     }
   }
@@ -754,6 +785,114 @@ _err:
   return -1;
 }
 
+static bool tsdbIsColIdRequired(int16_t colId, int16_t *colIds, int numOfColIds) {
+  for (int i = 0; i < numOfColIds; i++) {
+    if (colIds[i] == colId) return true;
+  }
+  return false;
+}
+
+// Drop the columns not in colIds from pDataCols, the remaining columns keep their buffer
+static void tsdbProjectDataCols(SDataCols *pDataCols, int16_t *colIds, int numOfColIds) {
+  int ncol = 0;
+  for (int i = 0; i < pDataCols->numOfCols; i++) {
+    if (!tsdbIsColIdRequired(pDataCols->cols[i].colId, colIds, numOfColIds)) continue;
+    if (ncol != i) pDataCols->cols[ncol] = pDataCols->cols[i];
+    ncol++;
+  }
+  pDataCols->numOfCols = ncol;
+}
+
+static int tsdbLoadSingleColumnData(SRWHelper *pHelper, int fd, SCompBlock *pCompBlock, SCompCol *pCompCol,
+                                    SDataCol *pDataCol, int maxPoints) {
+  ASSERT(tsizeof(pHelper->pBuffer) >= pCompCol->len);
+
+  size_t tsize = sizeof(SCompData) + sizeof(SCompCol) * pCompBlock->numOfCols + sizeof(TSCKSUM);
+  if (lseek(fd, pCompBlock->offset + tsize + pCompCol->offset, SEEK_SET) < 0) return -1;
+  if (tread(fd, pHelper->pBuffer, pCompCol->len) < pCompCol->len) return -1;
+
+  if (pCompBlock->algorithm == TWO_STAGE_COMP) {
+    int zsize = pDataCol->bytes * pCompBlock->numOfRows + COMP_OVERFLOW_BYTES;
+    if (pCompCol->type == TSDB_DATA_TYPE_BINARY || pCompCol->type == TSDB_DATA_TYPE_NCHAR) {
+      zsize += (sizeof(VarDataLenT) * pCompBlock->numOfRows);
+    }
+    pHelper->compBuffer = trealloc(pHelper->compBuffer, zsize);
+    if (pHelper->compBuffer == NULL) return -1;
+  }
+
+  return tsdbCheckAndDecodeColumnData(pDataCol, (char *)pHelper->pBuffer, pCompCol->len, pCompBlock->algorithm,
+                                      pCompBlock->numOfRows, maxPoints, pHelper->compBuffer,
+                                      tsizeof(pHelper->compBuffer));
+}
+
+/**
+ * Read only the columns in pDataCols of a sub-block OR a super-block of which (numOfSubBlocks == 1)
+ */
+static int tsdbLoadSingleBlockDataCols(SRWHelper *pHelper, SCompBlock *pCompBlock, SDataCols *pDataCols) {
+  ASSERT(pCompBlock->numOfSubBlocks <= 1);
+
+  int  fid = pHelper->files.fid;
+  int  fd = (pCompBlock->last) ? pHelper->files.lastF.fd : pHelper->files.dataF.fd;
+  bool headLoaded = false;
+
+  pDataCols->numOfRows = pCompBlock->numOfRows;
+
+  for (int dcol = 0; dcol < pDataCols->numOfCols; dcol++) {
+    SDataCol *pDataCol = pDataCols->cols + dcol;
+
+    if (tsdbGetColFromBlockCache(pHelper->pBlockCache, fid, pCompBlock, pDataCol)) continue;
+
+    // Only load the block head when some column is not cached
+    if (!headLoaded) {
+      if (tsdbLoadCompData(pHelper, pCompBlock, NULL) < 0) return -1;
+      int32_t tsize = sizeof(SCompData) + sizeof(SCompCol) * pCompBlock->numOfCols + sizeof(TSCKSUM);
+      if (!taosCheckChecksumWhole((uint8_t *)pHelper->pCompData, tsize)) return -1;
+      headLoaded = true;
+    }
+
+    SCompCol *pCompCol = (SCompCol *)bsearch((void *)&(pDataCol->colId), (void *)pHelper->pCompData->cols,
+                                             pHelper->pCompData->numOfCols, sizeof(SCompCol), comparColIdCompCol);
+    if (pCompCol == NULL) {  // All NULL column in this block
+      dataColSetNEleNull(pDataCol, pCompBlock->numOfRows, pDataCols->maxPoints);
+    } else {
+      if (tsdbLoadSingleColumnData(pHelper, fd, pCompBlock, pCompCol, pDataCol, pDataCols->maxPoints) < 0) return -1;
+    }
+
+    tsdbPutColIntoBlockCache(pHelper->pBlockCache, fid, pCompBlock, pDataCol);
+  }
+
+  return 0;
+}
+
+/**
+ * Load specific column data of a super block from file. Only the columns in colIds are read, checksummed and
+ * decompressed, the other columns are dropped from pHelper->pDataCols[0] and pHelper->pDataCols[1]. The caller
+ * should re-init the data columns with the table schema before loading a different set of columns.
+ */
+int tsdbLoadBlockDataCols(SRWHelper *pHelper, SCompBlock *pCompBlock, int16_t *colIds, int numOfColIds) {
+  ASSERT(pCompBlock->numOfSubBlocks >= 1);  // Must be super block
+
+  int numOfSubBlock = pCompBlock->numOfSubBlocks;
+  if (numOfSubBlock > 1) pCompBlock = (SCompBlock *)((char *)pHelper->pCompInfo + pCompBlock->offset);
+
+  tsdbProjectDataCols(pHelper->pDataCols[0], colIds, numOfColIds);
+  tsdbProjectDataCols(pHelper->pDataCols[1], colIds, numOfColIds);
+
+  tdResetDataCols(pHelper->pDataCols[0]);
+  if (tsdbLoadSingleBlockDataCols(pHelper, pCompBlock, pHelper->pDataCols[0]) < 0) goto _err;
+  for (int i = 1; i < numOfSubBlock; i++) {
+    tdResetDataCols(pHelper->pDataCols[1]);
+    pCompBlock++;
+    if (tsdbLoadSingleBlockDataCols(pHelper, pCompBlock, pHelper->pDataCols[1]) < 0) goto _err;
+    if (tdMergeDataCols(pHelper->pDataCols[0], pHelper->pDataCols[1], pHelper->pDataCols[1]->numOfRows) < 0) goto _err;
+  }
+
+  return 0;
+
+_err:
+  return -1;
+}
+
 static bool tsdbShouldCreateNewLast(SRWHelper *pHelper) {
   ASSERT(pHelper->files.lastF.fd > 0);
   struct stat st;
@@ -846,6 +985,7 @@ static int tsdbWriteBlockToFile(SRWHelper *pHelper, SFile *pFile, SDataCols *pDa
 
   // Write the whole block to file
   if (twrite(pFile->fd, (void *)pCompData, lsize) < lsize) goto _err;
+  pFile->info.size = offset + lsize;
 
   // Update pCompBlock membership vairables
   pCompBlock->last = isLast;
@@ -1158,6 +1298,18 @@ static int tsdbUpdateSuperBlock(SRWHelper *pHelper, SCompBlock *pCompBlock, int
 
   ASSERT(pSCompBlock->numOfSubBlocks >= 1);
 
+  // The replaced blocks in the .data file are garbage now, the .last file is rewritten from time to time
+  if (!pSCompBlock->last) {
+    if (pSCompBlock->numOfSubBlocks > 1) {
+      SCompBlock *pSubBlock = (SCompBlock *)POINTER_SHIFT(pHelper->pCompInfo, pSCompBlock->offset);
+      for (int i = 0; i < pSCompBlock->numOfSubBlocks; i++) {
+        pHelper->files.dataF.info.tombSize += pSubBlock[i].len;
+      }
+    } else {
+      pHelper->files.dataF.info.tombSize += pSCompBlock->len;
+    }
+  }
+
   // Delete the sub blocks it has
   if (pSCompBlock->numOfSubBlocks > 1) {
     size_t tsize = pIdx->len - (pSCompBlock->offset + pSCompBlock->len);
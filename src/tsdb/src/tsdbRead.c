@@ -74,9 +74,9 @@ typedef struct STableCheckInfo {
   SDataCols*    pDataCols;
 
   int32_t       chosen;         // indicate which iterator should move forward
-  bool          initBuf;        // whether to initialize the in-memory skip list iterator or not
-  SSkipListIterator* iter;      // mem buffer skip list iterator
-  SSkipListIterator* iiter;     // imem buffer skip list iterator
+  bool          initBuf;        // whether to initialize the in-memory iterator or not
+  SMemTableIter* iter;          // mem buffer iterator
+  SMemTableIter* iiter;         // imem buffer iterator
 } STableCheckInfo;
 
 typedef struct STableBlockInfo {
@@ -140,6 +140,11 @@ TsdbQueryHandleT* tsdbQueryTables(TsdbRepoT* tsdb, STsdbQueryCond* pCond, STable
   // todo 2. add the reference count for each table that is involved in query
 
   STsdbQueryHandle* pQueryHandle = calloc(1, sizeof(STsdbQueryHandle));
+  if (pQueryHandle == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
   pQueryHandle->order       = pCond->order;
   pQueryHandle->window      = pCond->twindow;
   pQueryHandle->pTsdb       = tsdb;
@@ -256,13 +261,11 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
   assert(pCheckInfo->iter == NULL && pCheckInfo->iiter == NULL);
   
   if (pTable->mem) {
-    pCheckInfo->iter = tSkipListCreateIterFromVal(pTable->mem->pData, (const char*) &pCheckInfo->lastKey,
-                                                  TSDB_DATA_TYPE_TIMESTAMP, order);
+    pCheckInfo->iter = tsdbCreateMemTableIter(pTable->mem, pCheckInfo->lastKey, order);
   }
   
   if (pTable->imem) {
-    pCheckInfo->iiter = tSkipListCreateIterFromVal(pTable->imem->pData, (const char*) &pCheckInfo->lastKey,
-                                                   TSDB_DATA_TYPE_TIMESTAMP, order);
+    pCheckInfo->iiter = tsdbCreateMemTableIter(pTable->imem, pCheckInfo->lastKey, order);
   }
   
   // both iterators are NULL, no data in buffer right now
@@ -270,17 +273,16 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
     return false;
   }
   
-  bool memEmpty  = (pCheckInfo->iter == NULL) || (pCheckInfo->iter != NULL && !tSkipListIterNext(pCheckInfo->iter));
-  bool imemEmpty = (pCheckInfo->iiter == NULL) || (pCheckInfo->iiter != NULL && !tSkipListIterNext(pCheckInfo->iiter));
+  bool memEmpty  = (pCheckInfo->iter == NULL) || (pCheckInfo->iter != NULL && !tsdbMemTableIterNext(pCheckInfo->iter));
+  bool imemEmpty = (pCheckInfo->iiter == NULL) || (pCheckInfo->iiter != NULL && !tsdbMemTableIterNext(pCheckInfo->iiter));
   if (memEmpty && imemEmpty) { // buffer is empty
     return false;
   }
   
   if (!memEmpty) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iter);
-    assert(node != NULL);
+    SDataRow row = tsdbMemTableIterGet(pCheckInfo->iter);
+    assert(row != NULL);
   
-    SDataRow row = SL_GET_NODE_DATA(node);
     TSKEY key = dataRowKey(row);  // first timestamp in buffer
     tsdbTrace("%p uid:%" PRId64", tid:%d check data in mem from skey:%" PRId64 ", order:%d, %p", pHandle,
            pCheckInfo->tableId.uid, pCheckInfo->tableId.tid, key, order, pHandle->qinfo);
@@ -289,10 +291,9 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
   }
   
   if (!imemEmpty) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iiter);
-    assert(node != NULL);
+    SDataRow row = tsdbMemTableIterGet(pCheckInfo->iiter);
+    assert(row != NULL);
   
-    SDataRow row = SL_GET_NODE_DATA(node);
     TSKEY key = dataRowKey(row);  // first timestamp in buffer
     tsdbTrace("%p uid:%" PRId64", tid:%d check data in imem from skey:%" PRId64 ", order:%d, %p", pHandle,
            pCheckInfo->tableId.uid, pCheckInfo->tableId.tid, key, order, pHandle->qinfo);
@@ -306,17 +307,11 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
 SDataRow getSDataRowInTableMem(STableCheckInfo* pCheckInfo) {
   SDataRow rmem = NULL, rimem = NULL;
   if (pCheckInfo->iter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iter);
-    if (node != NULL) {
-      rmem = SL_GET_NODE_DATA(node);
-    }
+    rmem = tsdbMemTableIterGet(pCheckInfo->iter);
   }
 
   if (pCheckInfo->iiter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iiter);
-    if (node != NULL) {
-      rimem = SL_GET_NODE_DATA(node);
-    }
+    rimem = tsdbMemTableIterGet(pCheckInfo->iiter);
   }
 
   if (rmem != NULL && rimem != NULL) {
@@ -325,7 +320,7 @@ SDataRow getSDataRowInTableMem(STableCheckInfo* pCheckInfo) {
       return rmem;
     } else if (dataRowKey(rmem) == dataRowKey(rimem)) {
       // data ts are duplicated, ignore the data in mem
-      tSkipListIterNext(pCheckInfo->iter);
+      tsdbMemTableIterNext(pCheckInfo->iter);
       pCheckInfo->chosen = 1;
       return rimem;
     } else {
@@ -351,7 +346,7 @@ bool moveToNextRow(STableCheckInfo* pCheckInfo) {
   bool hasNext = false;
   if (pCheckInfo->chosen == 0) {
     if (pCheckInfo->iter != NULL) {
-      hasNext = tSkipListIterNext(pCheckInfo->iter);
+      hasNext = tsdbMemTableIterNext(pCheckInfo->iter);
     }
 
     if (hasNext) {
@@ -359,12 +354,12 @@ bool moveToNextRow(STableCheckInfo* pCheckInfo) {
     }
 
     if (pCheckInfo->iiter != NULL) {
-      return tSkipListIterGet(pCheckInfo->iiter) != NULL;
+      return tsdbMemTableIterGet(pCheckInfo->iiter) != NULL;
     }
   } else {
     if (pCheckInfo->chosen == 1) {
       if (pCheckInfo->iiter != NULL) {
-        hasNext = tSkipListIterNext(pCheckInfo->iiter);
+        hasNext = tsdbMemTableIterNext(pCheckInfo->iiter);
       }
 
       if (hasNext) {
@@ -372,7 +367,7 @@ bool moveToNextRow(STableCheckInfo* pCheckInfo) {
       }
 
       if (pCheckInfo->iter != NULL) {
-        return tSkipListIterGet(pCheckInfo->iter) != NULL;
+        return tsdbMemTableIterGet(pCheckInfo->iter) != NULL;
       }
     }
   }
@@ -589,9 +584,24 @@ static bool doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* pBlo
     pCheckInfo->pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pRepo->config.maxRowsPerFileBlock);
   }
 
-  tdInitDataCols(pCheckInfo->pDataCols, tsdbGetTableSchema(tsdbGetMeta(pQueryHandle->pTsdb), pCheckInfo->pTableObj));
+  STSchema* pSchema = tsdbGetTableSchema(tsdbGetMeta(pQueryHandle->pTsdb), pCheckInfo->pTableObj);
+  tdInitDataCols(pCheckInfo->pDataCols, pSchema);
+
+  // the columns of read helper may be projected by the previous load, reset them with the table schema
+  SRWHelper* pHelper = &pQueryHandle->rhelper;
+  tdInitDataCols(pHelper->pDataCols[0], pSchema);
+  tdInitDataCols(pHelper->pDataCols[1], pSchema);
+
+  // only read and decompress the required columns if the query does not touch all columns of the table
+  int32_t code = 0;
+  size_t  numOfLoadCols = taosArrayGetSize(sa);
+  if (numOfLoadCols < schemaNCols(pSchema)) {
+    code = tsdbLoadBlockDataCols(pHelper, pBlock, (int16_t*)sa->pData, numOfLoadCols);
+  } else {
+    code = tsdbLoadBlockData(pHelper, pBlock, NULL);
+  }
 
-  if (tsdbLoadBlockData(&(pQueryHandle->rhelper), pBlock, NULL) == 0) {
+  if (code == 0) {
     SDataBlockLoadInfo* pBlockLoadInfo = &pQueryHandle->dataBlockLoadInfo;
 
     pBlockLoadInfo->fileGroup = pQueryHandle->pFileGroup;
@@ -608,7 +618,8 @@ static bool doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* pBlo
   tfree(data);
 
   int64_t et = taosGetTimestampUs() - st;
-  tsdbTrace("%p load file block into buffer, elapsed time:%"PRId64 " us", pQueryHandle, et);
+  tsdbTrace("%p load file block into buffer, %zu of %d columns loaded, elapsed time:%"PRId64 " us", pQueryHandle,
+            numOfLoadCols, schemaNCols(pSchema), et);
 
   return blockLoaded;
 }
@@ -966,7 +977,7 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
     cur->rows = numOfRows;
     return;
   } else if (pCheckInfo->iter != NULL || pCheckInfo->iiter != NULL) {
-    SSkipListNode* node = NULL;
+    SDataRow node = NULL;
     do {
       SDataRow row = getSDataRowInTableMem(pCheckInfo);
       if (row == NULL) {
@@ -1007,7 +1018,7 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
 
         int32_t end = doBinarySearchKey(pCols->cols[0].pData, pCols->numOfRows, key, order);
         if (tsArray[end] == key) { // the value of key in cache equals to the end timestamp value, ignore it
-          tSkipListIterNext(pCheckInfo->iter);
+          tsdbMemTableIterNext(pCheckInfo->iter);
         }
         
         int32_t start = -1;
@@ -1039,8 +1050,8 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
        * copy them all to result buffer, since it may be overlapped with file data block.
        */
       if (node == NULL ||
-          ((dataRowKey(SL_GET_NODE_DATA(node)) > pQueryHandle->window.ekey) && ASCENDING_TRAVERSE(pQueryHandle->order)) ||
-          ((dataRowKey(SL_GET_NODE_DATA(node)) < pQueryHandle->window.ekey) && !ASCENDING_TRAVERSE(pQueryHandle->order))) {
+          ((dataRowKey(node) > pQueryHandle->window.ekey) && ASCENDING_TRAVERSE(pQueryHandle->order)) ||
+          ((dataRowKey(node) < pQueryHandle->window.ekey) && !ASCENDING_TRAVERSE(pQueryHandle->order))) {
         // no data in cache or data in cache is greater than the ekey of time window, load data from file block
         if (cur->win.skey == TSKEY_INITIAL_VAL) {
           cur->win.skey = tsArray[pos];
@@ -1573,7 +1584,8 @@ void changeQueryHandleForLastrowQuery(TsdbQueryHandleT pqHandle) {
     }
     
     STableCheckInfo* pTableCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
-    tSkipListDestroyIter(pTableCheckInfo->iter);
+    tsdbDestroyMemTableIter(pTableCheckInfo->iter);
+    tsdbDestroyMemTableIter(pTableCheckInfo->iiter);
     
     if (pTableCheckInfo->pDataCols != NULL) {
       tfree(pTableCheckInfo->pDataCols->buf);
@@ -1831,19 +1843,15 @@ static int32_t getAllTableIdList(STable* pSuperTable, SArray* list) {
 }
 
 /**
- * convert the result pointer to table id instead of table object pointer
- * todo remove it by using callback function to change the final result in-time.
+ * convert the result bitmap of table tids to the table ids, in the order of tid
  * @param pRes
  */
-static void convertQueryResult(SArray* pRes, SArray* pTableList) {
-  if (pTableList == NULL || taosArrayGetSize(pTableList) == 0) {
-    return;
-  }
-
-  size_t size = taosArrayGetSize(pTableList);
-  for (int32_t i = 0; i < size; ++i) {  // todo speedup  by using reserve space.
-    STableIndexElem* elem = taosArrayGet(pTableList, i);
-    taosArrayPush(pRes, &elem->pTable->tableId);
+static void convertQueryResult(SArray* pRes, STsdbMeta* pMeta, SBitmap* pBitmap) {
+  for (int32_t tid = taosBitmapNext(pBitmap, 0); tid >= 0; tid = taosBitmapNext(pBitmap, tid + 1)) {
+    STable* pTable = pMeta->tables[tid];
+    if (pTable != NULL) {
+      taosArrayPush(pRes, &pTable->tableId);
+    }
   }
 }
 
@@ -2024,10 +2032,10 @@ SArray* createTableGroup(SArray* pTableList, STSchema* pTagSchema, SColIndex* pC
   return pTableGroup;
 }
 
-bool indexedNodeFilterFp(const void* pNode, void* param) {
+bool indexedNodeFilterFp(const void* pElem, void* param) {
   tQueryInfo* pInfo = (tQueryInfo*) param;
   
-  STableIndexElem* elem = (STableIndexElem*)(SL_GET_NODE_DATA((SSkipListNode*)pNode));
+  STableIndexElem* elem = (STableIndexElem*) pElem;
 
   char*  val = NULL;
   int8_t type = pInfo->sch.type;
@@ -2038,8 +2046,12 @@ bool indexedNodeFilterFp(const void* pNode, void* param) {
   } else {
     val = tdGetKVRowValOfCol(elem->pTable->tagVal, pInfo->sch.colId);
   }
-  
-  //todo :the val is possible to be null, so check it out carefully
+
+  // a tag added after the table was created has no value, the table is not in the index of the tag either
+  if (val == NULL) {
+    return false;
+  }
+
   int32_t ret = 0;
   if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
     if (pInfo->optr == TSDB_RELATION_IN) {
@@ -2084,22 +2096,66 @@ bool indexedNodeFilterFp(const void* pNode, void* param) {
   return true;
 }
 
-static int32_t doQueryTableList(STable* pSTable, SArray* pRes, tExprNode* pExpr) {
+typedef struct {
+  STsdbMeta* pMeta;
+  STable*    pSTable;
+} STagIndexInfo;
+
+// the index of the super table on its tag of colIndex in the tag schema
+static void* getTagIndex(void* param, int32_t colIndex) {
+  STable* pSTable = ((STagIndexInfo*) param)->pSTable;
+
+  if (colIndex == DEFAULT_TAG_INDEX_COLUMN) return pSTable->pIndex;
+  if (colIndex >= schemaNCols(pSTable->tagSchema)) return NULL;
+
+  return tsdbGetTagIndex(pSTable, colColId(schemaColAt(pSTable->tagSchema, colIndex)));
+}
+
+static int32_t getTagIndexElemId(const void* pElem) { return ((STableIndexElem*) pElem)->pTable->tableId.tid; }
+
+// the element of the child table of tid, which is filtered on the tags as the one in the index
+static bool getTagIndexElem(void* param, int32_t tid, void* pElem) {
+  STagIndexInfo* pInfo = (STagIndexInfo*) param;
+  STable*        pTable = pInfo->pMeta->tables[tid];
+
+  if (pTable == NULL || pTable->type != TSDB_CHILD_TABLE || pTable->superUid != pInfo->pSTable->tableId.uid) {
+    return false;
+  }
+
+  STableIndexElem* elem = (STableIndexElem*) pElem;
+  elem->pMeta = pInfo->pMeta;
+  elem->pTable = pTable;
+  elem->colId = 0;
+  return true;
+}
+
+static int32_t doQueryTableList(STsdbMeta* pMeta, STable* pSTable, SArray* pRes, tExprNode* pExpr) {
+  STagIndexInfo info = {.pMeta = pMeta, .pSTable = pSTable};
+
   // query according to the expression tree
   SExprTraverseSupp supp = {
       .nodeFilterFn = (__result_filter_fn_t) indexedNodeFilterFp,
       .setupInfoFn = filterPrepare,
       .pExtInfo = pSTable->tagSchema,
+      .getIndexFn = getTagIndex,
+      .pIndexInfo = &info,
+      .getElemIdFn = getTagIndexElemId,
+      .getElemFn = getTagIndexElem,
       };
 
-  SArray* pTableList = taosArrayInit(8, sizeof(STableIndexElem));
+  // the qualified child tables are kept in a bitmap of tids, so the conditions are combined a word at a time
+  SBitmap* pBitmap = taosBitmapCreate(pMeta->maxTables);
+  if (pBitmap == NULL) {
+    tExprTreeDestroy(&pExpr, destroyHelper);
+    return TSDB_CODE_TDB_OUT_OF_MEMORY;
+  }
 
-  tExprTreeTraverse(pExpr, pSTable->pIndex, pTableList, &supp);
+  int32_t code = tExprTreeTraverseBitmap(pExpr, pSTable->pIndex, pBitmap, &supp);
   tExprTreeDestroy(&pExpr, destroyHelper);
 
-  convertQueryResult(pRes, pTableList);
-  taosArrayDestroy(pTableList);
-  return TSDB_CODE_SUCCESS;
+  if (code == TSDB_CODE_SUCCESS) convertQueryResult(pRes, pMeta, pBitmap);
+  taosBitmapDestroy(pBitmap);
+  return code;
 }
 
 int32_t tsdbQuerySTableByTagCond(TsdbRepoT* tsdb, uint64_t uid, const char* pTagCond, size_t len,
@@ -2168,7 +2224,8 @@ int32_t tsdbQuerySTableByTagCond(TsdbRepoT* tsdb, uint64_t uid, const char* pTag
     // TODO: more error handling
   } END_TRY
 
-  doQueryTableList(pTable, res, expr);
+  int32_t code = doQueryTableList(tsdbGetMeta(tsdb), pTable, res, expr);
+  if (ret == TSDB_CODE_SUCCESS) ret = code;
   pGroupInfo->numOfTables = taosArrayGetSize(res);
   pGroupInfo->pGroupList  = createTableGroup(res, pTagSchema, pColIndex, numOfCols, tsdb);
 
@@ -2203,7 +2260,8 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
   size_t size = taosArrayGetSize(pQueryHandle->pTableCheckInfo);
   for (int32_t i = 0; i < size; ++i) {
     STableCheckInfo* pTableCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
-    tSkipListDestroyIter(pTableCheckInfo->iter);
+    tsdbDestroyMemTableIter(pTableCheckInfo->iter);
+    tsdbDestroyMemTableIter(pTableCheckInfo->iiter);
 
     if (pTableCheckInfo->pDataCols != NULL) {
       tfree(pTableCheckInfo->pDataCols->buf);
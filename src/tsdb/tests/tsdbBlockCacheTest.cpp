@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include "tdataformat.h"
+#include "tsdbMain.h"
+
+namespace {
+
+void initBlock(SCompBlock *pBlock, int64_t offset, int numOfRows) {
+  memset((void *)pBlock, 0, sizeof(*pBlock));
+  pBlock->offset = offset;
+  pBlock->numOfRows = numOfRows;
+  pBlock->numOfSubBlocks = 1;
+  pBlock->len = 4096;
+  pBlock->keyFirst = offset * 1000;
+  pBlock->keyLast = pBlock->keyFirst + numOfRows - 1;
+}
+
+void initIntCol(SDataCol *pCol, int16_t colId, int numOfRows, int val) {
+  memset((void *)pCol, 0, sizeof(*pCol));
+  pCol->type = TSDB_DATA_TYPE_INT;
+  pCol->colId = colId;
+  pCol->bytes = sizeof(int32_t);
+  pCol->spaceSize = sizeof(int32_t) * numOfRows;
+  pCol->pData = malloc(pCol->spaceSize);
+  for (int i = 0; i < numOfRows; i++) ((int32_t *)pCol->pData)[i] = val + i;
+  pCol->len = pCol->spaceSize;
+}
+
+}  // namespace
+
+TEST(TsdbBlockCacheTest, getAndPut) {
+  int        numOfRows = 100;
+  SCompBlock block;
+  SDataCol   col, target;
+
+  ASSERT_EQ(tsdbNewBlockCache(0), nullptr);
+  STsdbBlockCache *pCache = tsdbNewBlockCache(1024 * 1024);
+  ASSERT_NE(pCache, nullptr);
+
+  initBlock(&block, 512, numOfRows);
+  initIntCol(&col, 1, numOfRows, 7);
+  initIntCol(&target, 1, numOfRows, 0);
+
+  ASSERT_FALSE(tsdbGetColFromBlockCache(pCache, 1, &block, &target));
+  tsdbPutColIntoBlockCache(pCache, 1, &block, &col);
+  ASSERT_TRUE(tsdbGetColFromBlockCache(pCache, 1, &block, &target));
+  ASSERT_EQ(target.len, col.len);
+  ASSERT_EQ(memcmp(target.pData, col.pData, col.len), 0);
+
+  // Another file group, column or block content is a different entry
+  ASSERT_FALSE(tsdbGetColFromBlockCache(pCache, 2, &block, &target));
+  target.colId = 2;
+  ASSERT_FALSE(tsdbGetColFromBlockCache(pCache, 1, &block, &target));
+  target.colId = 1;
+  block.keyLast++;
+  ASSERT_FALSE(tsdbGetColFromBlockCache(pCache, 1, &block, &target));
+  block.keyLast--;
+
+  ASSERT_EQ(pCache->numOfHits, 1);
+  ASSERT_EQ(pCache->numOfMisses, 4);
+
+  tsdbClearBlockCache(pCache);
+  ASSERT_EQ(pCache->size, 0);
+  ASSERT_FALSE(tsdbGetColFromBlockCache(pCache, 1, &block, &target));
+
+  tsdbFreeBlockCache(pCache);
+  free(col.pData);
+  free(target.pData);
+}
+
+TEST(TsdbBlockCacheTest, evictLeastRecentlyUsed) {
+  int        numOfRows = 1000;
+  int        numOfBlocks = 8;
+  SCompBlock blocks[8];
+  SDataCol   col, target;
+
+  initIntCol(&col, 1, numOfRows, 0);
+  initIntCol(&target, 1, numOfRows, 0);
+
+  // Only room for 4 columns
+  STsdbBlockCache *pCache = tsdbNewBlockCache((sizeof(SBlockCacheEntry) + col.len) * 4);
+  ASSERT_NE(pCache, nullptr);
+
+  for (int i = 0; i < numOfBlocks; i++) {
+    initBlock(blocks + i, i, numOfRows);
+    tsdbPutColIntoBlockCache(pCache, 1, blocks + i, &col);
+    // Keep the first block hot
+    ASSERT_TRUE(tsdbGetColFromBlockCache(pCache, 1, blocks, &target));
+    ASSERT_LE(pCache->size, pCache->maxSize);
+  }
+
+  ASSERT_TRUE(tsdbGetColFromBlockCache(pCache, 1, blocks, &target));
+  for (int i = 1; i < numOfBlocks - 3; i++) {
+    ASSERT_FALSE(tsdbGetColFromBlockCache(pCache, 1, blocks + i, &target));
+  }
+  for (int i = numOfBlocks - 3; i < numOfBlocks; i++) {
+    ASSERT_TRUE(tsdbGetColFromBlockCache(pCache, 1, blocks + i, &target));
+  }
+
+  // An entry larger than the whole cache is never kept
+  SDataCol large;
+  initIntCol(&large, 2, numOfRows * 8, 0);
+  tsdbPutColIntoBlockCache(pCache, 1, blocks, &large);
+  ASSERT_FALSE(tsdbGetColFromBlockCache(pCache, 1, blocks, &large));
+
+  tsdbFreeBlockCache(pCache);
+  free(col.pData);
+  free(target.pData);
+  free(large.pData);
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <algorithm>
+
+#include "tdataformat.h"
+#include "tsdbMain.h"
+#include "ttime.h"
+#include "tutil.h"
+
+namespace {
+
+double getCurTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+STSchema *createSchema(int nCols) {
+  STSchemaBuilder schemaBuilder;
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+
+  tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, 0, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP]);
+  for (int i = 1; i < nCols; i++) {
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_BIGINT, i, TYPE_BYTES[TSDB_DATA_TYPE_BIGINT]);
+  }
+
+  STSchema *pSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  return pSchema;
+}
+
+// Insert numOfRows rows with keys startKey, startKey + step, ... in one submit message
+int insertRows(TsdbRepoT *pRepo, STableId tableId, STSchema *pSchema, TSKEY startKey, TSKEY step, int numOfRows) {
+  SSubmitMsg *pMsg =
+      (SSubmitMsg *)malloc(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pSchema) * numOfRows);
+  if (pMsg == NULL) return -1;
+
+  memset((void *)pMsg, 0, sizeof(SSubmitMsg) + sizeof(SSubmitBlk));
+  SSubmitBlk *pBlock = pMsg->blocks;
+
+  for (int i = 0; i < numOfRows; i++) {
+    TSKEY    key = startKey + step * i;
+    SDataRow row = (SDataRow)(pBlock->data + pBlock->len);
+    tdInitDataRow(row, pSchema);
+
+    for (int j = 0; j < schemaNCols(pSchema); j++) {
+      STColumn *pTCol = schemaColAt(pSchema, j);
+      // Every column holds the key so that the content can be checked after commit
+      tdAppendColVal(row, (void *)(&key), pTCol->type, pTCol->bytes, pTCol->offset);
+    }
+    pBlock->len += dataRowLen(row);
+  }
+
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->len);
+  pMsg->numOfBlocks = htonl(1);
+
+  pBlock->uid = htobe64(tableId.uid);
+  pBlock->tid = htonl(tableId.tid);
+  pBlock->sversion = htonl(schemaVersion(pSchema));
+  pBlock->numOfRows = htons(numOfRows);
+  pBlock->len = htonl(pBlock->len);
+
+  SShellSubmitRspMsg rsp = {0};
+  int                code = tsdbInsertData(pRepo, pMsg, &rsp);
+  free(pMsg);
+  return (code == TSDB_CODE_SUCCESS) ? 0 : -1;
+}
+
+// Read back all the committed rows of a table and check the keys are strictly increasing with a fixed step
+void checkCommittedRows(STsdbRepo *pRepo, STable *pTable, TSKEY startKey, TSKEY step, int64_t expectedRows) {
+  SRWHelper rhelper;
+  ASSERT_EQ(tsdbInitReadHelper(&rhelper, pRepo), 0);
+
+  STSchema *pSchema = tsdbGetTableSchema(pRepo->tsdbMeta, pTable);
+  tdInitDataCols(rhelper.pDataCols[0], pSchema);
+  tdInitDataCols(rhelper.pDataCols[1], pSchema);
+
+  SFileGroupIter iter;
+  SFileGroup *   pGroup = NULL;
+  tsdbInitFileGroupIter(pRepo->tsdbFileH, &iter, TSDB_ORDER_ASC);
+
+  int64_t numOfRows = 0;
+  TSKEY   nextKey = startKey;
+  while ((pGroup = tsdbGetFileGroupNext(&iter)) != NULL) {
+    ASSERT_GE(tsdbSetAndOpenHelperFile(&rhelper, pGroup), 0);
+    tsdbSetHelperTable(&rhelper, pTable, pRepo);
+    ASSERT_EQ(tsdbLoadCompInfo(&rhelper, NULL), 0);
+
+    SCompIdx *pIdx = rhelper.pCompIdx + pTable->tableId.tid;
+    for (int blkIdx = 0; blkIdx < (int)pIdx->numOfBlocks; blkIdx++) {
+      SCompBlock *pBlock = blockAtIdx(&rhelper, blkIdx);
+      ASSERT_EQ(tsdbLoadBlockData(&rhelper, pBlock, NULL), 0);
+
+      SDataCols *pCols = rhelper.pDataCols[0];
+      for (int row = 0; row < pCols->numOfRows; row++) {
+        for (int col = 0; col < pCols->numOfCols; col++) {
+          ASSERT_EQ(((TSKEY *)pCols->cols[col].pData)[row], nextKey);
+        }
+        nextKey += step;
+      }
+      numOfRows += pCols->numOfRows;
+    }
+
+    tsdbCloseHelperFile(&rhelper, false);
+  }
+
+  ASSERT_EQ(numOfRows, expectedRows);
+  tsdbDestroyHelper(&rhelper);
+}
+
+// Backfill totalFids file groups in reverse order, then commit them with numOfThreads commit threads
+void commitFileGroups(int numOfThreads, int totalFids, int rowsPerFid, double *elapsed) {
+  char rootDir[] = "/tmp/ttest/commit";
+
+  taosRemoveDir(rootDir);
+  mkdir("/tmp/ttest", 0755);
+
+  STsdbCfg config;
+  tsdbSetDefaultCfg(&config);
+  config.cacheBlockSize = 16;
+  config.totalBlocks = 32;
+  ASSERT_EQ(tsdbCreateRepo(rootDir, &config, NULL), 0);
+
+  TsdbRepoT *pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  STsdbRepo *repo = (STsdbRepo *)pRepo;
+  STsdbCfg * pCfg = &(repo->config);
+
+  STableCfg tCfg;
+  char      tname[] = "commit";
+  ASSERT_EQ(tsdbInitTableCfg(&tCfg, TSDB_NORMAL_TABLE, 987607499877672L, 1), 0);
+  tsdbTableSetName(&tCfg, tname, true);
+
+  STSchema *pSchema = createSchema(8);
+  tsdbTableSetSchema(&tCfg, pSchema, true);
+  ASSERT_EQ(tsdbCreateTable(pRepo, &tCfg), 0);
+
+  TSKEY fidRange = pCfg->daysPerFile * tsMsPerDay[pCfg->precision];
+  int   efid = tsdbGetKeyFileId(taosGetTimestampMs(), pCfg->daysPerFile, pCfg->precision) - 1;
+  int   sfid = efid - totalFids + 1;
+  TSKEY step = fidRange / rowsPerFid;
+  TSKEY startKey = sfid * fidRange;
+
+  for (int fid = efid; fid >= sfid; fid--) {
+    for (int i = 0; i < rowsPerFid; i += 100) {
+      ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, startKey + ((fid - sfid) * rowsPerFid + i) * step, step,
+                           std::min(100, rowsPerFid - i)),
+                0);
+    }
+  }
+
+  tsCommitThreads = numOfThreads;
+  double stime = getCurTime();
+  while (tsdbCloseRepo(pRepo, 1) < 0) taosMsleep(10);
+  *elapsed = getCurTime() - stime;
+  tsCommitThreads = TSDB_DEFAULT_COMMIT_THREADS;
+
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  repo = (STsdbRepo *)pRepo;
+  ASSERT_EQ(repo->tsdbFileH->numOfFGroups, totalFids);
+
+  STable *pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  ASSERT_NE(pTable, nullptr);
+  checkCommittedRows(repo, pTable, startKey, step, (int64_t)totalFids * rowsPerFid);
+
+  tsdbCloseRepo(pRepo, 0);
+  tdFreeSchema(tCfg.schema);
+  tfree(tCfg.name);
+  tdFreeSchema(pSchema);
+  taosRemoveDir(rootDir);
+}
+
+}  // namespace
+
+TEST(TsdbCommitTest, parallelCommit) {
+  double elapsed = 0;
+  commitFileGroups(1, 6, 1000, &elapsed);
+  commitFileGroups(4, 6, 1000, &elapsed);
+  commitFileGroups(8, 3, 1000, &elapsed);
+}
+
+// Commit an out-of-order backfill spanning many file groups with different number of commit threads
+TEST(TsdbCommitTest, DISABLED_parallelCommitSpeed) {
+  int threadsList[] = {1, 2, 4, 8};
+
+  for (int i = 0; i < (int)(sizeof(threadsList) / sizeof(threadsList[0])); i++) {
+    double elapsed = 0;
+    commitFileGroups(threadsList[i], 16, 50000, &elapsed);
+    printf("%d commit threads: %d file groups committed in %.4f s\n", threadsList[i], 16, elapsed);
+  }
+}
@@ -0,0 +1,392 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "tdataformat.h"
+#include "tsdbMain.h"
+#include "ttime.h"
+#include "tutil.h"
+
+namespace {
+
+STSchema *createSchema(int nCols) {
+  STSchemaBuilder schemaBuilder;
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+
+  tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, 0, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP]);
+  for (int i = 1; i < nCols; i++) {
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_BIGINT, i, TYPE_BYTES[TSDB_DATA_TYPE_BIGINT]);
+  }
+
+  STSchema *pSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  return pSchema;
+}
+
+// Insert the rows with keys startKey, startKey + step, ... in one submit message, every column holds the key
+int insertRows(TsdbRepoT *pRepo, STableId tableId, STSchema *pSchema, TSKEY startKey, TSKEY step, int numOfRows) {
+  SSubmitMsg *pMsg =
+      (SSubmitMsg *)malloc(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pSchema) * numOfRows);
+  if (pMsg == NULL) return -1;
+
+  memset((void *)pMsg, 0, sizeof(SSubmitMsg) + sizeof(SSubmitBlk));
+  SSubmitBlk *pBlock = pMsg->blocks;
+
+  for (int i = 0; i < numOfRows; i++) {
+    TSKEY    key = startKey + step * i;
+    SDataRow row = (SDataRow)(pBlock->data + pBlock->len);
+    tdInitDataRow(row, pSchema);
+
+    for (int j = 0; j < schemaNCols(pSchema); j++) {
+      STColumn *pTCol = schemaColAt(pSchema, j);
+      tdAppendColVal(row, (void *)(&key), pTCol->type, pTCol->bytes, pTCol->offset);
+    }
+    pBlock->len += dataRowLen(row);
+  }
+
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->len);
+  pMsg->numOfBlocks = htonl(1);
+
+  pBlock->uid = htobe64(tableId.uid);
+  pBlock->tid = htonl(tableId.tid);
+  pBlock->sversion = htonl(schemaVersion(pSchema));
+  pBlock->numOfRows = htons(numOfRows);
+  pBlock->len = htonl(pBlock->len);
+
+  SShellSubmitRspMsg rsp = {0};
+  int                code = tsdbInsertData(pRepo, pMsg, &rsp);
+  free(pMsg);
+  return (code == TSDB_CODE_SUCCESS) ? 0 : -1;
+}
+
+// Read back all the rows of a table in a file group, check the keys and count the sub-blocks
+void checkFGroupRows(STsdbRepo *pRepo, STable *pTable, int fid, TSKEY startKey, TSKEY step, int expectedRows,
+                     int *numOfSubBlocks) {
+  SRWHelper rhelper;
+  ASSERT_EQ(tsdbInitReadHelper(&rhelper, pRepo), 0);
+
+  SFileGroup *pGroup = tsdbSearchFGroup(pRepo->tsdbFileH, fid);
+  ASSERT_NE(pGroup, nullptr);
+  ASSERT_GE(tsdbSetAndOpenHelperFile(&rhelper, pGroup), 0);
+  tsdbSetHelperTable(&rhelper, pTable, pRepo);
+  ASSERT_EQ(tsdbLoadCompInfo(&rhelper, NULL), 0);
+
+  int       numOfRows = 0;
+  TSKEY     nextKey = startKey;
+  SCompIdx *pIdx = rhelper.pCompIdx + pTable->tableId.tid;
+  *numOfSubBlocks = 0;
+  for (int blkIdx = 0; blkIdx < (int)pIdx->numOfBlocks; blkIdx++) {
+    SCompBlock *pBlock = blockAtIdx(&rhelper, blkIdx);
+    if (pBlock->numOfSubBlocks > 1) *numOfSubBlocks += pBlock->numOfSubBlocks;
+    ASSERT_EQ(tsdbLoadBlockData(&rhelper, pBlock, NULL), 0);
+
+    SDataCols *pCols = rhelper.pDataCols[0];
+    for (int row = 0; row < pCols->numOfRows; row++) {
+      for (int col = 0; col < pCols->numOfCols; col++) {
+        ASSERT_EQ(((TSKEY *)pCols->cols[col].pData)[row], nextKey);
+      }
+      nextKey += step;
+    }
+    numOfRows += pCols->numOfRows;
+  }
+
+  ASSERT_EQ(numOfRows, expectedRows);
+  tsdbDestroyHelper(&rhelper);
+}
+
+typedef struct {
+  STsdbRepo *pRepo;
+  STable *   pTable;
+  int        fid;
+  TSKEY      startKey;
+  int        numOfRows;
+  int32_t    stop;
+  int32_t    numOfReads;
+  int32_t    numOfErrors;
+} SReadInfo;
+
+// Open the file group and read all the rows of the table again and again, as the queries do
+void *readFGroupRows(void *param) {
+  SReadInfo *pInfo = (SReadInfo *)param;
+  SRWHelper  rhelper;
+  if (tsdbInitReadHelper(&rhelper, pInfo->pRepo) < 0) return NULL;
+  rhelper.pBlockCache = NULL;
+
+  while (!atomic_load_32(&pInfo->stop)) {
+    SFileGroup *pGroup = tsdbSearchFGroup(pInfo->pRepo->tsdbFileH, pInfo->fid);
+    int         numOfRows = 0;
+    bool        ok = (pGroup != NULL && tsdbSetAndOpenHelperFile(&rhelper, pGroup) >= 0);
+
+    if (ok) {
+      tsdbSetHelperTable(&rhelper, pInfo->pTable, pInfo->pRepo);
+      ok = (tsdbLoadCompInfo(&rhelper, NULL) == 0);
+    }
+
+    SCompIdx *pIdx = rhelper.pCompIdx + pInfo->pTable->tableId.tid;
+    for (int blkIdx = 0; ok && blkIdx < (int)pIdx->numOfBlocks; blkIdx++) {
+      ok = (tsdbLoadBlockData(&rhelper, blockAtIdx(&rhelper, blkIdx), NULL) == 0);
+
+      SDataCols *pCols = rhelper.pDataCols[0];
+      for (int row = 0; ok && row < pCols->numOfRows; row++) {
+        ok = (((TSKEY *)pCols->cols[0].pData)[row] == pInfo->startKey + numOfRows + row);
+      }
+      numOfRows += pCols->numOfRows;
+    }
+
+    if (!ok || numOfRows != pInfo->numOfRows) atomic_add_fetch_32(&pInfo->numOfErrors, 1);
+    atomic_add_fetch_32(&pInfo->numOfReads, 1);
+    tsdbCloseHelperFile(&rhelper, false);
+  }
+
+  tsdbDestroyHelper(&rhelper);
+  return NULL;
+}
+
+typedef struct {
+  STsdbRepo *pRepo;
+  int        fid;
+  int        code;
+} SCompactInfo;
+
+void *compactFGroup(void *param) {
+  SCompactInfo *pInfo = (SCompactInfo *)param;
+  pInfo->code = tsdbCompactFGroup(pInfo->pRepo, pInfo->fid);
+  return NULL;
+}
+
+}  // namespace
+
+// Fill the gaps of a file group with small commits to build sub-blocks, then compact the file group
+TEST(TsdbCompactTest, compactFileGroup) {
+  char rootDir[] = "/tmp/ttest/compact";
+
+  taosRemoveDir(rootDir);
+  mkdir("/tmp/ttest", 0755);
+
+  STsdbCfg config;
+  tsdbSetDefaultCfg(&config);
+  config.cacheBlockSize = 16;
+  config.totalBlocks = 32;
+  ASSERT_EQ(tsdbCreateRepo(rootDir, &config, NULL), 0);
+
+  tsCompactInterval = 0;
+  TsdbRepoT *pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  STsdbRepo *repo = (STsdbRepo *)pRepo;
+  STsdbCfg * pCfg = &(repo->config);
+
+  STableCfg tCfg;
+  char      tname[] = "compact";
+  ASSERT_EQ(tsdbInitTableCfg(&tCfg, TSDB_NORMAL_TABLE, 987607499877673L, 1), 0);
+  tsdbTableSetName(&tCfg, tname, true);
+
+  STSchema *pSchema = createSchema(8);
+  tsdbTableSetSchema(&tCfg, pSchema, true);
+  ASSERT_EQ(tsdbCreateTable(pRepo, &tCfg), 0);
+
+  // Every 4th key is committed first, the rest are committed round by round into the existing blocks
+  int   numOfRows = pCfg->maxRowsPerFileBlock * 3;
+  TSKEY fidRange = pCfg->daysPerFile * tsMsPerDay[pCfg->precision];
+  int   fid = tsdbGetKeyFileId(taosGetTimestampMs(), pCfg->daysPerFile, pCfg->precision) - 2;
+  TSKEY step = 4;
+  TSKEY startKey = fid * fidRange;
+
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < numOfRows / 4; i += 100) {
+      ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, startKey + round + i * step, step,
+                           std::min(100, numOfRows / 4 - i)),
+                0);
+    }
+    while (tsdbCloseRepo(pRepo, 1) < 0) taosMsleep(10);
+    pRepo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(pRepo, nullptr);
+  }
+  repo = (STsdbRepo *)pRepo;
+  STable *pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  ASSERT_NE(pTable, nullptr);
+
+  SFileGroup *pGroup = tsdbSearchFGroup(repo->tsdbFileH, fid);
+  ASSERT_NE(pGroup, nullptr);
+  STsdbFileInfo headInfo = pGroup->files[TSDB_FILE_TYPE_HEAD].info;
+  ASSERT_GT(headInfo.totalBlocks, 0u);
+
+  int numOfSubBlocks = 0;
+  checkFGroupRows(repo, pTable, fid, startKey, 1, numOfRows, &numOfSubBlocks);
+  ASSERT_EQ(headInfo.totalSubBlocks, (uint32_t)numOfSubBlocks);
+  ASSERT_GT(numOfSubBlocks + pGroup->files[TSDB_FILE_TYPE_DATA].info.tombSize, 0u);
+
+  uint32_t version = pGroup->version;
+  ASSERT_EQ(tsdbCompactFGroup(repo, fid), 0);
+
+  pGroup = tsdbSearchFGroup(repo->tsdbFileH, fid);
+  ASSERT_NE(pGroup->version, version);
+  ASSERT_EQ(pGroup->files[TSDB_FILE_TYPE_HEAD].info.totalSubBlocks, 0u);
+  ASSERT_EQ(pGroup->files[TSDB_FILE_TYPE_DATA].info.tombSize, 0u);
+  ASSERT_EQ(pGroup->files[TSDB_FILE_TYPE_HEAD].info.totalBlocks, 3u);
+  checkFGroupRows(repo, pTable, fid, startKey, 1, numOfRows, &numOfSubBlocks);
+  ASSERT_EQ(numOfSubBlocks, 0);
+
+  STsdbCompactStat stat;
+  tsdbGetCompactStat(pRepo, &stat);
+  ASSERT_EQ(stat.fid, -1);
+  ASSERT_EQ(stat.numOfCompactions, 1);
+  ASSERT_EQ(stat.numOfTables, 1);
+  ASSERT_EQ(stat.tablesDone, 1);
+  ASSERT_GT(stat.bytesRead, 0);
+  ASSERT_GT(stat.bytesWritten, 0);
+
+  // The compacted files are loaded after reopen
+  while (tsdbCloseRepo(pRepo, 1) < 0) taosMsleep(10);
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  repo = (STsdbRepo *)pRepo;
+  pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  checkFGroupRows(repo, pTable, fid, startKey, 1, numOfRows, &numOfSubBlocks);
+  ASSERT_EQ(numOfSubBlocks, 0);
+
+  tsdbCloseRepo(pRepo, 0);
+  tsCompactInterval = TSDB_DEFAULT_COMPACT_INTERVAL;
+  tdFreeSchema(tCfg.schema);
+  tfree(tCfg.name);
+  tdFreeSchema(pSchema);
+  taosRemoveDir(rootDir);
+}
+
+// A compaction interrupted after the marker file is created is finished on open, one without the marker is dropped
+TEST(TsdbCompactTest, recoverCompaction) {
+  char dataDir[] = "/tmp/ttest/compactRecover";
+  char fname[128] = "\0";
+
+  taosRemoveDir(dataDir);
+  mkdir("/tmp/ttest", 0755);
+  mkdir(dataDir, 0755);
+
+  const char *suffixes[] = {".head", ".data", ".last", TSDB_COMPACT_HEAD_SUFFIX, TSDB_COMPACT_DATA_SUFFIX,
+                            TSDB_COMPACT_LAST_SUFFIX};
+  for (int fid = 1; fid <= 2; fid++) {
+    for (int i = 0; i < 6; i++) {
+      tsdbGetFileName(dataDir, fid, suffixes[i], fname);
+      FILE *fp = fopen(fname, "w");
+      ASSERT_NE(fp, nullptr);
+      fputs(suffixes[i], fp);
+      fclose(fp);
+    }
+  }
+  tsdbGetFileName(dataDir, 1, TSDB_COMPACT_DONE_SUFFIX, fname);
+  fclose(fopen(fname, "w"));
+
+  ASSERT_EQ(tsdbRecoverCompaction(dataDir), 0);
+
+  for (int fid = 1; fid <= 2; fid++) {
+    for (int i = 0; i < 3; i++) {
+      char content[16] = "\0";
+      tsdbGetFileName(dataDir, fid, suffixes[i], fname);
+      FILE *fp = fopen(fname, "r");
+      ASSERT_NE(fp, nullptr);
+      ASSERT_NE(fgets(content, sizeof(content), fp), nullptr);
+      fclose(fp);
+      ASSERT_STREQ(content, (fid == 1) ? suffixes[i + 3] : suffixes[i]);
+
+      tsdbGetFileName(dataDir, fid, suffixes[i + 3], fname);
+      ASSERT_NE(access(fname, F_OK), 0);
+    }
+    tsdbGetFileName(dataDir, fid, TSDB_COMPACT_DONE_SUFFIX, fname);
+    ASSERT_NE(access(fname, F_OK), 0);
+  }
+
+  taosRemoveDir(dataDir);
+}
+
+// The compactor waits for the readers opening the files of the group to swap them, the readers always see all rows
+TEST(TsdbCompactTest, readWhileCompact) {
+  char rootDir[] = "/tmp/ttest/compactRead";
+
+  taosRemoveDir(rootDir);
+  mkdir("/tmp/ttest", 0755);
+
+  STsdbCfg config;
+  tsdbSetDefaultCfg(&config);
+  config.cacheBlockSize = 16;
+  config.totalBlocks = 32;
+  ASSERT_EQ(tsdbCreateRepo(rootDir, &config, NULL), 0);
+
+  tsCompactInterval = 0;
+  TsdbRepoT *pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  STsdbRepo *repo = (STsdbRepo *)pRepo;
+  STsdbCfg * pCfg = &(repo->config);
+
+  STableCfg tCfg;
+  char      tname[] = "compactRead";
+  ASSERT_EQ(tsdbInitTableCfg(&tCfg, TSDB_NORMAL_TABLE, 987607499877674L, 1), 0);
+  tsdbTableSetName(&tCfg, tname, true);
+
+  STSchema *pSchema = createSchema(4);
+  tsdbTableSetSchema(&tCfg, pSchema, true);
+  ASSERT_EQ(tsdbCreateTable(pRepo, &tCfg), 0);
+
+  // The odd keys are committed after the even ones, so the file group has sub-blocks and a .last to compact
+  int   numOfRows = pCfg->maxRowsPerFileBlock * 2 + 100;
+  TSKEY fidRange = pCfg->daysPerFile * tsMsPerDay[pCfg->precision];
+  int   fid = tsdbGetKeyFileId(taosGetTimestampMs(), pCfg->daysPerFile, pCfg->precision) - 2;
+  TSKEY startKey = fid * fidRange;
+
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < numOfRows / 2; i += 100) {
+      ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, startKey + round + i * 2, 2, std::min(100, numOfRows / 2 - i)),
+                0);
+    }
+    while (tsdbCloseRepo(pRepo, 1) < 0) taosMsleep(10);
+    pRepo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(pRepo, nullptr);
+  }
+  repo = (STsdbRepo *)pRepo;
+
+  SReadInfo info = {0};
+  info.pRepo = repo;
+  info.pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  info.fid = fid;
+  info.startKey = startKey;
+  info.numOfRows = numOfRows;
+  ASSERT_NE(info.pTable, nullptr);
+
+  // The files are not swapped while a reader is opening them
+  SCompactInfo compactInfo = {repo, fid, -1};
+  pthread_t    compactor;
+  SFileGroup * pGroup = tsdbSearchFGroup(repo->tsdbFileH, fid);
+  uint32_t     version = pGroup->version;
+
+  pthread_rwlock_rdlock(&(repo->tsdbFileH->fhlock));
+  pthread_create(&compactor, NULL, compactFGroup, &compactInfo);
+  taosMsleep(500);
+  EXPECT_EQ(pGroup->version, version);
+  pthread_rwlock_unlock(&(repo->tsdbFileH->fhlock));
+  pthread_join(compactor, NULL);
+  EXPECT_EQ(compactInfo.code, 0);
+  EXPECT_NE(pGroup->version, version);
+
+  const int numOfReaders = 4;
+  pthread_t readers[numOfReaders];
+  for (int i = 0; i < numOfReaders; i++) pthread_create(readers + i, NULL, readFGroupRows, &info);
+
+  // Each compaction rewrites the file group and swaps all of its files
+  int numOfCompactions = 0;
+  for (int i = 0; i < 50; i++) {
+    if (tsdbCompactFGroup(repo, fid) == 0) numOfCompactions++;
+  }
+
+  while (atomic_load_32(&info.numOfReads) < numOfReaders * 10) taosMsleep(1);
+  atomic_store_32(&info.stop, 1);
+  for (int i = 0; i < numOfReaders; i++) pthread_join(readers[i], NULL);
+
+  EXPECT_EQ(numOfCompactions, 50);
+  EXPECT_EQ(info.numOfErrors, 0);
+
+  tsdbCloseRepo(pRepo, 0);
+  tsCompactInterval = TSDB_DEFAULT_COMPACT_INTERVAL;
+  tdFreeSchema(tCfg.schema);
+  tfree(tCfg.name);
+  tdFreeSchema(pSchema);
+  taosRemoveDir(rootDir);
+}
@@ -0,0 +1,353 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "tdataformat.h"
+#include "tsdbMain.h"
+#include "ttime.h"
+#include "tutil.h"
+
+namespace {
+
+double getCurTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+STSchema *createSchema(int nCols) {
+  STSchemaBuilder schemaBuilder;
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+
+  tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, 0, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP]);
+  for (int i = 1; i < nCols; i++) {
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_BIGINT, i, TYPE_BYTES[TSDB_DATA_TYPE_BIGINT]);
+  }
+
+  STSchema *pSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  return pSchema;
+}
+
+// Insert the rows of keys in one submit message, the non-key columns of each row hold val
+int insertRows(TsdbRepoT *pRepo, STableId tableId, STSchema *pSchema, const TSKEY *keys, int numOfRows, int64_t val) {
+  SSubmitMsg *pMsg =
+      (SSubmitMsg *)malloc(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pSchema) * numOfRows);
+  if (pMsg == NULL) return -1;
+
+  memset((void *)pMsg, 0, sizeof(SSubmitMsg) + sizeof(SSubmitBlk));
+  SSubmitBlk *pBlock = pMsg->blocks;
+
+  for (int i = 0; i < numOfRows; i++) {
+    SDataRow row = (SDataRow)(pBlock->data + pBlock->len);
+    tdInitDataRow(row, pSchema);
+
+    for (int j = 0; j < schemaNCols(pSchema); j++) {
+      STColumn *pTCol = schemaColAt(pSchema, j);
+      void *    value = (j == 0) ? (void *)(keys + i) : (void *)(&val);
+      tdAppendColVal(row, value, pTCol->type, pTCol->bytes, pTCol->offset);
+    }
+    pBlock->len += dataRowLen(row);
+  }
+
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->len);
+  pMsg->numOfBlocks = htonl(1);
+
+  pBlock->uid = htobe64(tableId.uid);
+  pBlock->tid = htonl(tableId.tid);
+  pBlock->sversion = htonl(schemaVersion(pSchema));
+  pBlock->numOfRows = htons(numOfRows);
+  pBlock->len = htonl(pBlock->len);
+
+  SShellSubmitRspMsg rsp = {0};
+  int                code = tsdbInsertData(pRepo, pMsg, &rsp);
+  free(pMsg);
+  return (code == TSDB_CODE_SUCCESS) ? 0 : -1;
+}
+
+TsdbRepoT *createRepo(char *rootDir, int cacheBlockSize, int totalBlocks, STableCfg *pCfg, STSchema *pSchema) {
+  taosRemoveDir(rootDir);
+  mkdir("/tmp/ttest", 0755);
+
+  STsdbCfg config;
+  tsdbSetDefaultCfg(&config);
+  config.cacheBlockSize = cacheBlockSize;
+  config.totalBlocks = totalBlocks;
+  if (tsdbCreateRepo(rootDir, &config, NULL) < 0) return NULL;
+
+  TsdbRepoT *pRepo = tsdbOpenRepo(rootDir, NULL);
+  if (pRepo == NULL) return NULL;
+
+  char tname[] = "memtable";
+  tsdbInitTableCfg(pCfg, TSDB_NORMAL_TABLE, 987607499877672L, 1);
+  tsdbTableSetName(pCfg, tname, true);
+  tsdbTableSetSchema(pCfg, pSchema, true);
+  if (tsdbCreateTable(pRepo, pCfg) < 0) return NULL;
+
+  return pRepo;
+}
+
+void closeRepo(TsdbRepoT *pRepo, char *rootDir, STableCfg *pCfg) {
+  tsdbCloseRepo(pRepo, 0);
+  tdFreeSchema(pCfg->schema);
+  tfree(pCfg->name);
+  taosRemoveDir(rootDir);
+}
+
+// Iterate the memory table from key in the order and check the rows against expected
+void checkMemTableIter(SMemTable *pMem, TSKEY key, int order, const std::map<TSKEY, int64_t> &expected) {
+  SMemTableIter *pIter = tsdbCreateMemTableIter(pMem, key, order);
+  ASSERT_NE(pIter, nullptr);
+  ASSERT_EQ(tsdbMemTableIterGet(pIter), nullptr);
+
+  std::vector<std::pair<TSKEY, int64_t> > rows;
+  if (order == TSDB_ORDER_ASC) {
+    rows.assign(expected.lower_bound(key), expected.end());
+  } else {
+    rows.assign(std::map<TSKEY, int64_t>::const_reverse_iterator(expected.upper_bound(key)), expected.rend());
+  }
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    ASSERT_TRUE(tsdbMemTableIterNext(pIter));
+    SDataRow row = tsdbMemTableIterGet(pIter);
+    ASSERT_NE(row, nullptr);
+    ASSERT_EQ(dataRowKey(row), rows[i].first);
+    ASSERT_EQ(*(int64_t *)tdGetRowDataOfCol(row, TSDB_DATA_TYPE_BIGINT, TD_DATA_ROW_HEAD_SIZE + sizeof(TSKEY)),
+              rows[i].second);
+  }
+  ASSERT_FALSE(tsdbMemTableIterNext(pIter));
+  ASSERT_EQ(tsdbMemTableIterGet(pIter), nullptr);
+
+  tsdbDestroyMemTableIter(pIter);
+}
+
+void checkMemTable(int memTableType) {
+  char      rootDir[] = "/tmp/ttest/memtable";
+  STableCfg tCfg;
+  STSchema *pSchema = createSchema(4);
+
+  tsMemTableType = memTableType;
+  TsdbRepoT *pRepo = createRepo(rootDir, 16, 4, &tCfg, pSchema);
+  ASSERT_NE(pRepo, nullptr);
+
+  std::map<TSKEY, int64_t> expected;
+  std::vector<TSKEY>       keys;
+  TSKEY                    startKey = taosGetTimestampMs() - 3600 * 1000;
+
+  // In-order rows across several chunks of the row buffer
+  for (int i = 0; i < 1000; i++) keys.push_back(startKey + i * 10);
+  ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, keys.data(), (int)keys.size(), 1), 0);
+  for (size_t i = 0; i < keys.size(); i++) expected[keys[i]] = 1;
+
+  // Out-of-order rows, including keys before the first one
+  keys.clear();
+  for (int i = 0; i < 200; i++) keys.push_back(startKey + 9985 - i * 50);
+  ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, keys.data(), (int)keys.size(), 2), 0);
+  for (size_t i = 0; i < keys.size(); i++) expected[keys[i]] = 2;
+
+  // Duplicated keys both in the row buffer and the skiplist are dropped
+  keys.clear();
+  for (int i = 0; i < 100; i++) keys.push_back(startKey + i * 30);
+  keys.push_back(startKey + 9985);
+  keys.push_back(startKey + 9935);
+  ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, keys.data(), (int)keys.size(), 3), 0);
+
+  // In-order again after the out-of-order ones
+  keys.clear();
+  for (int i = 0; i < 100; i++) keys.push_back(startKey + 10000 + i);
+  ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, keys.data(), (int)keys.size(), 4), 0);
+  for (size_t i = 0; i < keys.size(); i++) expected[keys[i]] = 4;
+
+  STable *pTable = tsdbGetTableByUid(((STsdbRepo *)pRepo)->tsdbMeta, tCfg.tableId.uid);
+  ASSERT_NE(pTable, nullptr);
+  SMemTable *pMem = pTable->mem;
+  ASSERT_NE(pMem, nullptr);
+  ASSERT_EQ(pMem->numOfRows, (int32_t)expected.size());
+  ASSERT_EQ(pMem->keyFirst, expected.begin()->first);
+  ASSERT_EQ(pMem->keyLast, expected.rbegin()->first);
+  if (memTableType == TSDB_MEM_TABLE_SKIPLIST) {
+    ASSERT_EQ(pMem->numOfBufRows, 0);
+  } else {
+    ASSERT_EQ(pMem->numOfBufRows, 1100);
+  }
+
+  TSKEY fromKeys[] = {INT64_MIN, startKey - 100000, startKey, startKey + 5, startKey + 4995, startKey + 5000,
+                      startKey + 9999, startKey + 10099, startKey + 100000, INT64_MAX};
+  for (size_t i = 0; i < sizeof(fromKeys) / sizeof(fromKeys[0]); i++) {
+    checkMemTableIter(pMem, fromKeys[i], TSDB_ORDER_ASC, expected);
+    checkMemTableIter(pMem, fromKeys[i], TSDB_ORDER_DESC, expected);
+  }
+
+  tsMemTableType = TSDB_DEFAULT_MEM_TABLE_TYPE;
+  closeRepo(pRepo, rootDir, &tCfg);
+  tdFreeSchema(pSchema);
+}
+
+// Collect the keys of the table committed into the data files
+void getCommittedKeys(STsdbRepo *pRepo, STable *pTable, std::vector<TSKEY> *keys) {
+  SRWHelper rhelper;
+  ASSERT_EQ(tsdbInitReadHelper(&rhelper, pRepo), 0);
+
+  SFileGroupIter iter;
+  SFileGroup *   pGroup = NULL;
+  tsdbInitFileGroupIter(pRepo->tsdbFileH, &iter, TSDB_ORDER_ASC);
+
+  while ((pGroup = tsdbGetFileGroupNext(&iter)) != NULL) {
+    ASSERT_GE(tsdbSetAndOpenHelperFile(&rhelper, pGroup), 0);
+    tsdbSetHelperTable(&rhelper, pTable, pRepo);
+    ASSERT_EQ(tsdbLoadCompInfo(&rhelper, NULL), 0);
+
+    SCompIdx *pIdx = rhelper.pCompIdx + pTable->tableId.tid;
+    for (int blkIdx = 0; blkIdx < (int)pIdx->numOfBlocks; blkIdx++) {
+      SCompBlock *pBlock = blockAtIdx(&rhelper, blkIdx);
+      ASSERT_EQ(tsdbLoadBlockData(&rhelper, pBlock, NULL), 0);
+      for (int i = 0; i < rhelper.pDataCols[0]->numOfRows; i++) keys->push_back(dataColsKeyAt(rhelper.pDataCols[0], i));
+    }
+
+    tsdbCloseHelperFile(&rhelper, false);
+  }
+
+  tsdbDestroyHelper(&rhelper);
+}
+
+// Whether every row of the memory table lies in a cache block of the cache mem, rather than one of the imem given back
+// to the pool by the commit
+bool rowsInCacheMem(SMemTable *pMem, STsdbCache *pCache) {
+  SMemTableIter *pIter = tsdbCreateMemTableIter(pMem, INT64_MIN, TSDB_ORDER_ASC);
+  bool           found = true;
+
+  while (found && tsdbMemTableIterNext(pIter)) {
+    char *row = (char *)tsdbMemTableIterGet(pIter);
+    found = false;
+    for (SListNode *node = pCache->mem->list->head; node != NULL; node = node->next) {
+      STsdbCacheBlock *pBlock = NULL;
+      tdListNodeGetData(pCache->mem->list, node, (void *)(&pBlock));
+      if (row >= pBlock->data && row < pBlock->data + pBlock->offset) found = true;
+    }
+  }
+
+  tsdbDestroyMemTableIter(pIter);
+  return found;
+}
+
+// Insert submit blocks larger than half of the cache, so a commit is triggered in the middle of each, and check no
+// row is lost either in the memory table committed or the one taking the rest of the block
+void checkCommitInBlock(int memTableType) {
+  char      rootDir[] = "/tmp/ttest/memtable";
+  STableCfg tCfg;
+  STSchema *pSchema = createSchema(12);
+
+  tsMemTableType = memTableType;
+  TsdbRepoT *pRepo = createRepo(rootDir, 1, 4, &tCfg, pSchema);
+  ASSERT_NE(pRepo, nullptr);
+  STsdbRepo *repo = (STsdbRepo *)pRepo;
+
+  // every 4th row goes backward, so the skiplist runs are cut and the node pending when the commit fires as well
+  std::vector<TSKEY> keys;
+  TSKEY              startKey = taosGetTimestampMs() - 3600 * 1000;
+  STable *           pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  ASSERT_NE(pTable, nullptr);
+
+  for (int k = 0; k < 2; k++) {
+    std::vector<TSKEY> blkKeys;
+    for (int i = 0; i < 30000; i++) {
+      blkKeys.push_back(startKey + ((i % 4 == 3) ? (i - 2) * 10 + 5 : i * 10));
+    }
+    ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, blkKeys.data(), (int)blkKeys.size(), k), 0);
+    keys.insert(keys.end(), blkKeys.begin(), blkKeys.end());
+    startKey += 300000;
+
+    ASSERT_NE(pTable->mem, nullptr);
+    EXPECT_GT(pTable->mem->numOfRows, 0);
+    EXPECT_LT(pTable->mem->numOfRows, (int32_t)keys.size());
+    EXPECT_TRUE(rowsInCacheMem(pTable->mem, repo->tsdbCache)) << "block " << k;
+    while (repo->commit) taosMsleep(10);
+  }
+
+  std::vector<TSKEY> committed;
+  getCommittedKeys(repo, pTable, &committed);
+  EXPECT_GT(committed.size(), 0);
+  EXPECT_EQ(committed.size() + pTable->mem->numOfRows, keys.size());
+
+  std::set<TSKEY> expected(keys.begin(), keys.end());
+  std::set<TSKEY> actual(committed.begin(), committed.end());
+  SMemTableIter * pIter = tsdbCreateMemTableIter(pTable->mem, INT64_MIN, TSDB_ORDER_ASC);
+  ASSERT_NE(pIter, nullptr);
+  while (tsdbMemTableIterNext(pIter)) actual.insert(dataRowKey(tsdbMemTableIterGet(pIter)));
+  tsdbDestroyMemTableIter(pIter);
+  EXPECT_EQ(actual, expected);
+
+  tsMemTableType = TSDB_DEFAULT_MEM_TABLE_TYPE;
+  closeRepo(pRepo, rootDir, &tCfg);
+  tdFreeSchema(pSchema);
+}
+
+// Insert numOfRows in-order rows in batches of 100 and return rows/sec and memory taken per row
+void insertSpeed(int memTableType, int numOfRows, int nCols, double *rowsPerSec, double *bytesPerRow) {
+  char      rootDir[] = "/tmp/ttest/memtable";
+  STableCfg tCfg;
+  STSchema *pSchema = createSchema(nCols);
+
+  tsMemTableType = memTableType;
+  TsdbRepoT *pRepo = createRepo(rootDir, 16, 16, &tCfg, pSchema);
+  ASSERT_NE(pRepo, nullptr);
+  STsdbRepo *repo = (STsdbRepo *)pRepo;
+
+  TSKEY startKey = taosGetTimestampMs() - 10 * tsMsPerDay[0];
+  TSKEY keys[100];
+
+  double stime = getCurTime();
+  for (int i = 0; i < numOfRows; i += 100) {
+    for (int j = 0; j < 100; j++) keys[j] = startKey + i + j;
+    ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, keys, 100, i), 0);
+  }
+  *rowsPerSec = numOfRows / (getCurTime() - stime);
+
+  // Bytes taken in the cache blocks plus the row buffer chunks
+  ASSERT_EQ(repo->tsdbCache->imem, nullptr);
+  int64_t    bytes = 0;
+  SListNode *node = repo->tsdbCache->mem->list->head;
+  for (; node != NULL; node = node->next) {
+    STsdbCacheBlock *pBlock = NULL;
+    tdListNodeGetData(repo->tsdbCache->mem->list, node, (void *)(&pBlock));
+    bytes += pBlock->offset;
+  }
+
+  STable *pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  ASSERT_EQ(pTable->mem->numOfRows, numOfRows);
+  for (int k = 0; k < TSDB_MEM_MAX_CHUNKS; k++) {
+    if (pTable->mem->chunks[k] != NULL) bytes += sizeof(SDataRow) * TSDB_MEM_CHUNK_ROWS(k);
+  }
+  *bytesPerRow = (double)bytes / numOfRows;
+
+  tsMemTableType = TSDB_DEFAULT_MEM_TABLE_TYPE;
+  closeRepo(pRepo, rootDir, &tCfg);
+  tdFreeSchema(pSchema);
+}
+
+}  // namespace
+
+TEST(TsdbMemTableTest, skiplistMemTable) { checkMemTable(TSDB_MEM_TABLE_SKIPLIST); }
+
+TEST(TsdbMemTableTest, appendMemTable) { checkMemTable(TSDB_MEM_TABLE_APPEND); }
+
+TEST(TsdbMemTableTest, skiplistCommitInBlock) { checkCommitInBlock(TSDB_MEM_TABLE_SKIPLIST); }
+
+TEST(TsdbMemTableTest, appendCommitInBlock) { checkCommitInBlock(TSDB_MEM_TABLE_APPEND); }
+
+// Compare the write speed and memory usage of the skiplist and append memory tables with in-order rows
+TEST(TsdbMemTableTest, DISABLED_insertSpeed) {
+  int numOfRows = 1000000;
+  int nColsList[] = {2, 8};
+
+  for (int i = 0; i < (int)(sizeof(nColsList) / sizeof(nColsList[0])); i++) {
+    double skiplistSpeed = 0, skiplistBytes = 0, appendSpeed = 0, appendBytes = 0;
+    insertSpeed(TSDB_MEM_TABLE_SKIPLIST, numOfRows, nColsList[i], &skiplistSpeed, &skiplistBytes);
+    insertSpeed(TSDB_MEM_TABLE_APPEND, numOfRows, nColsList[i], &appendSpeed, &appendBytes);
+    printf("%d columns, skiplist: %.0f rows/s %.1f bytes/row, append: %.0f rows/s %.1f bytes/row\n", nColsList[i],
+           skiplistSpeed, skiplistBytes, appendSpeed, appendBytes);
+  }
+}
@@ -0,0 +1,384 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "tdataformat.h"
+#include "tglobal.h"
+#include "tsdbMain.h"
+#include "tskiplist.h"
+#include "ttime.h"
+#include "tutil.h"
+
+namespace {
+
+char           rootDir[] = "/tmp/ttest/metackp";
+const uint64_t superUid = 998877665544L;
+const int      maxTables = 1000;
+
+// the tids of the tables in each index of the super table, pIndex first
+typedef std::vector<std::vector<int32_t> > SIndexOrder;
+
+STSchema *createSchema(int type, int16_t firstColId, int nCols) {
+  STSchemaBuilder schemaBuilder;
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+
+  for (int i = 0; i < nCols; i++) {
+    int colType = (i == 0 && type == TSDB_DATA_TYPE_TIMESTAMP) ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT;
+    tdAddColToSchema(&schemaBuilder, colType, firstColId + i, TYPE_BYTES[colType]);
+  }
+
+  STSchema *pSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  return pSchema;
+}
+
+// Create the child tables of tids [startTid, endTid) with 3 int tags, t1 repeats itself and the second tag is not set
+// in every 5th table
+void createTables(TsdbRepoT *pRepo, int startTid, int endTid) {
+  STSchema *pSchema = createSchema(TSDB_DATA_TYPE_TIMESTAMP, 0, 2);
+  STSchema *pTagSchema = createSchema(TSDB_DATA_TYPE_INT, 10, 3);
+
+  for (int tid = startTid; tid < endTid; tid++) {
+    STableCfg *pCfg = (STableCfg *)calloc(1, sizeof(STableCfg));
+    ASSERT_EQ(tsdbInitTableCfg(pCfg, TSDB_CHILD_TABLE, superUid + tid, tid), 0);
+    tsdbTableSetSuperUid(pCfg, superUid);
+    tsdbTableSetSchema(pCfg, pSchema, true);
+    tsdbTableSetTagSchema(pCfg, pTagSchema, true);
+
+    char name[32];
+    snprintf(name, sizeof(name), "ckp%d", tid);
+    tsdbTableSetName(pCfg, name, true);
+    tsdbTableSetSName(pCfg, (char *)"ckpstb", true);
+
+    int32_t       tags[] = {(tid * 37) % 101, tid % 7, -tid};
+    SKVRowBuilder builder;
+    tdInitKVRowBuilder(&builder);
+    for (int i = 0; i < 3; i++) {
+      if (i == 1 && tid % 5 == 0) continue;
+      tdAddColToKVRow(&builder, 10 + i, TSDB_DATA_TYPE_INT, tags + i);
+    }
+    tsdbTableSetTagValue(pCfg, tdGetKVRowFromBuilder(&builder), false);
+    tdDestroyKVRowBuilder(&builder);
+
+    ASSERT_EQ(tsdbCreateTable(pRepo, pCfg), 0);
+    tsdbClearTableCfg(pCfg);
+  }
+
+  tdFreeSchema(pSchema);
+  tdFreeSchema(pTagSchema);
+}
+
+std::vector<int32_t> getIndexOrder(SSkipList *pIndex) {
+  std::vector<int32_t> tids;
+
+  SSkipListIterator *pIter = tSkipListCreateIter(pIndex);
+  while (tSkipListIterNext(pIter)) {
+    STableIndexElem *pElem = (STableIndexElem *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    tids.push_back(pElem->pTable->tableId.tid);
+  }
+  tSkipListDestroyIter(pIter);
+
+  return tids;
+}
+
+// Check every index of the super table is in key order and holds the tables of the tag, return the order of them
+SIndexOrder checkIndexes(TsdbRepoT *pRepo, int numOfTables) {
+  SIndexOrder order;
+  STable *    pSTable = tsdbGetTableByUid(((STsdbRepo *)pRepo)->tsdbMeta, superUid);
+  EXPECT_NE(pSTable, nullptr);
+  if (pSTable == NULL) return order;
+
+  EXPECT_EQ(pSTable->numOfTagIndex, MIN(tsTagIndexColumns, 3) - 1);
+
+  for (int i = 0; i <= pSTable->numOfTagIndex; i++) {
+    SSkipList *pIndex = (SSkipList *)((i == 0) ? pSTable->pIndex : pSTable->tagIndex[i - 1].pIndex);
+    int16_t    colId = (i == 0) ? 10 : pSTable->tagIndex[i - 1].colId;
+
+    order.push_back(getIndexOrder(pIndex));
+    std::vector<int32_t> &tids = order.back();
+
+    // the second tag is not set in every 5th table, which is not in the index of the tag
+    size_t numOfIndexed = (colId == 11) ? numOfTables - numOfTables / 5 : numOfTables;
+    EXPECT_EQ(tids.size(), numOfIndexed) << "index of tag " << colId;
+
+    int32_t prev = INT32_MIN;
+    for (size_t j = 0; j < tids.size(); j++) {
+      STable *pTable = ((STsdbRepo *)pRepo)->tsdbMeta->tables[tids[j]];
+      void *  val = tdGetKVRowValOfCol(pTable->tagVal, colId);
+      EXPECT_NE(val, nullptr);
+      if (val == NULL) continue;
+
+      EXPECT_LE(prev, *(int32_t *)val) << "index of tag " << colId << " at " << j;
+      prev = *(int32_t *)val;
+    }
+  }
+
+  return order;
+}
+
+TsdbRepoT *createRepo() {
+  taosRemoveDir(rootDir);
+  mkdir("/tmp/ttest", 0755);
+
+  STsdbCfg config;
+  tsdbSetDefaultCfg(&config);
+  config.maxTables = maxTables;
+  config.cacheBlockSize = 16;
+  config.totalBlocks = 32;
+  EXPECT_EQ(tsdbCreateRepo(rootDir, &config, NULL), 0);
+
+  return tsdbOpenRepo(rootDir, NULL);
+}
+
+SMetaFile *getMetaFile(TsdbRepoT *pRepo) { return ((STsdbRepo *)pRepo)->tsdbMeta->mfh; }
+
+void getCkpName(char *fname) { sprintf(fname, "%s/%s", rootDir, TSDB_META_CKP_FILE_NAME); }
+
+// Insert a row into the child table of tid, so there is something to commit
+int insertRow(TsdbRepoT *pRepo, int tid) {
+  STSchema *pSchema = createSchema(TSDB_DATA_TYPE_TIMESTAMP, 0, 2);
+  char      buf[sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + 64] = {0};
+
+  SSubmitMsg *pMsg = (SSubmitMsg *)buf;
+  SSubmitBlk *pBlock = pMsg->blocks;
+  SDataRow    row = (SDataRow)pBlock->data;
+  TSKEY       key = taosGetTimestampMs();
+  int32_t     val = tid;
+  tdInitDataRow(row, pSchema);
+  tdAppendColVal(row, (void *)(&key), TSDB_DATA_TYPE_TIMESTAMP, 8, schemaColAt(pSchema, 0)->offset);
+  tdAppendColVal(row, (void *)(&val), TSDB_DATA_TYPE_INT, 4, schemaColAt(pSchema, 1)->offset);
+
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowLen(row));
+  pMsg->numOfBlocks = htonl(1);
+  pBlock->uid = htobe64(superUid + tid);
+  pBlock->tid = htonl(tid);
+  pBlock->sversion = htonl(schemaVersion(pSchema));
+  pBlock->numOfRows = htons(1);
+  pBlock->len = htonl(dataRowLen(row));
+  tdFreeSchema(pSchema);
+
+  SShellSubmitRspMsg rsp = {0};
+  return tsdbInsertData(pRepo, pMsg, &rsp);
+}
+
+void copyFile(const char *src, const char *dst) {
+  char cmd[256];
+  snprintf(cmd, sizeof(cmd), "cp %s %s", src, dst);
+  ASSERT_EQ(system(cmd), 0);
+}
+
+}  // namespace
+
+// The checkpoint is written on close, the meta is restored from it with the indexes in the same order
+TEST(TsdbMetaCkpTest, writeAndOpen) {
+  tsTagIndexColumns = 3;
+  TsdbRepoT *pRepo = createRepo();
+  ASSERT_NE(pRepo, nullptr);
+
+  createTables(pRepo, 1, 501);
+  SIndexOrder order = checkIndexes(pRepo, 500);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  char ckpName[TSDB_FILENAME_LEN];
+  getCkpName(ckpName);
+  ASSERT_EQ(access(ckpName, F_OK), 0);
+
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  SMetaFile *mfh = getMetaFile(pRepo);
+  EXPECT_GT(mfh->ckpSize, 0);
+  EXPECT_EQ(mfh->ckpSize, mfh->size);
+  EXPECT_EQ(((STsdbRepo *)pRepo)->tsdbMeta->nTables, 500);
+  EXPECT_EQ(checkIndexes(pRepo, 500), order);
+
+  tsdbCloseRepo(pRepo, 0);
+  tsTagIndexColumns = TSDB_DEFAULT_TAG_INDEX_COLUMNS;
+  taosRemoveDir(rootDir);
+}
+
+// The tables created after the checkpoint are replayed from the meta file, and the checkpoint is taken again by the
+// commit
+TEST(TsdbMetaCkpTest, staleCheckpoint) {
+  tsTagIndexColumns = 3;
+  TsdbRepoT *pRepo = createRepo();
+  ASSERT_NE(pRepo, nullptr);
+
+  createTables(pRepo, 1, 301);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  // the repo is removed later in the test, the checkpoint is saved out of it
+  char ckpName[TSDB_FILENAME_LEN], savedName[] = "/tmp/ttest/meta.ckp.saved";
+  getCkpName(ckpName);
+  copyFile(ckpName, savedName);
+
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  createTables(pRepo, 301, 401);
+  SMetaFile *mfh = getMetaFile(pRepo);
+  EXPECT_LT(mfh->ckpSize, mfh->size);
+
+  ASSERT_EQ(insertRow(pRepo, 350), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(tsdbTriggerCommit(pRepo), 0);
+  while (((STsdbRepo *)pRepo)->commit) taosMsleep(10);
+  EXPECT_EQ(mfh->ckpSize, mfh->size);
+
+  // the checkpoint of the 300 tables covers the first part of the meta file only
+  SIndexOrder order = checkIndexes(pRepo, 400);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+  copyFile(savedName, ckpName);
+
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  mfh = getMetaFile(pRepo);
+  EXPECT_GT(mfh->ckpSize, 0);
+  EXPECT_LT(mfh->ckpSize, mfh->size);
+  EXPECT_EQ(((STsdbRepo *)pRepo)->tsdbMeta->nTables, 400);
+  SIndexOrder restored = checkIndexes(pRepo, 400);
+  EXPECT_EQ(restored[0], order[0]);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  // a checkpoint of a meta file larger than the one on disk is ignored
+  taosRemoveDir(rootDir);
+  pRepo = createRepo();
+  ASSERT_NE(pRepo, nullptr);
+  createTables(pRepo, 1, 101);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  getCkpName(ckpName);
+  copyFile(savedName, ckpName);
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  EXPECT_EQ(getMetaFile(pRepo)->ckpSize, 0);
+  EXPECT_EQ(((STsdbRepo *)pRepo)->tsdbMeta->nTables, 100);
+  checkIndexes(pRepo, 100);
+
+  tsdbCloseRepo(pRepo, 0);
+  remove(savedName);
+  tsTagIndexColumns = TSDB_DEFAULT_TAG_INDEX_COLUMNS;
+  taosRemoveDir(rootDir);
+}
+
+// A checkpoint failing the CRC or cut short is ignored, the meta file is restored in full
+TEST(TsdbMetaCkpTest, corruptedCheckpoint) {
+  tsTagIndexColumns = 3;
+  TsdbRepoT *pRepo = createRepo();
+  ASSERT_NE(pRepo, nullptr);
+
+  createTables(pRepo, 1, 201);
+  SIndexOrder order = checkIndexes(pRepo, 200);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  char ckpName[TSDB_FILENAME_LEN];
+  getCkpName(ckpName);
+  struct stat fstatus;
+  ASSERT_EQ(stat(ckpName, &fstatus), 0);
+
+  for (int k = 0; k < 2; k++) {
+    if (k == 0) {
+      // flip a byte of the tids of an index
+      FILE *fp = fopen(ckpName, "r+");
+      ASSERT_NE(fp, nullptr);
+      fseek(fp, fstatus.st_size - 8, SEEK_SET);
+      int c = fgetc(fp);
+      fseek(fp, fstatus.st_size - 8, SEEK_SET);
+      fputc(c ^ 0x5A, fp);
+      fclose(fp);
+    } else {
+      ASSERT_EQ(truncate(ckpName, fstatus.st_size / 2), 0);
+    }
+
+    pRepo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(pRepo, nullptr);
+    EXPECT_EQ(getMetaFile(pRepo)->ckpSize, 0) << "case " << k;
+    EXPECT_EQ(((STsdbRepo *)pRepo)->tsdbMeta->nTables, 200);
+    SIndexOrder restored = checkIndexes(pRepo, 200);
+    EXPECT_EQ(restored[0], order[0]);
+
+    // the checkpoint written on close is valid again
+    ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+    ASSERT_EQ(stat(ckpName, &fstatus), 0);
+  }
+
+  tsTagIndexColumns = TSDB_DEFAULT_TAG_INDEX_COLUMNS;
+  taosRemoveDir(rootDir);
+}
+
+// The indexes kept in the checkpoint are restored in order, the ones added by tagIndexColumns are built
+TEST(TsdbMetaCkpTest, tagIndexOrder) {
+  tsTagIndexColumns = 1;
+  TsdbRepoT *pRepo = createRepo();
+  ASSERT_NE(pRepo, nullptr);
+
+  createTables(pRepo, 1, 301);
+  SIndexOrder order = checkIndexes(pRepo, 300);
+  ASSERT_EQ(order.size(), 1);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  tsTagIndexColumns = 3;
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  EXPECT_GT(getMetaFile(pRepo)->ckpSize, 0);
+  SIndexOrder restored = checkIndexes(pRepo, 300);
+  ASSERT_EQ(restored.size(), 3);
+  EXPECT_EQ(restored[0], order[0]);
+
+  // the new tables are put in the indexes as well
+  createTables(pRepo, 301, 351);
+  order = checkIndexes(pRepo, 350);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  EXPECT_EQ(checkIndexes(pRepo, 350), order);
+  ASSERT_EQ(tsdbCloseRepo(pRepo, 0), 0);
+
+  // the indexes dropped by tagIndexColumns are left out of the checkpoint
+  tsTagIndexColumns = 1;
+  pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+  restored = checkIndexes(pRepo, 350);
+  ASSERT_EQ(restored.size(), 1);
+  EXPECT_EQ(restored[0], order[0]);
+
+  tsdbCloseRepo(pRepo, 0);
+  tsTagIndexColumns = TSDB_DEFAULT_TAG_INDEX_COLUMNS;
+  taosRemoveDir(rootDir);
+}
+
+// The checkpoint prepared by the writer is written later, the tables created in the meantime are left to replay, and
+// it is dropped if a record it covers is deleted before it is written
+TEST(TsdbMetaCkpTest, preparedCheckpoint) {
+  tsTagIndexColumns = 3;
+  TsdbRepoT *pRepo = createRepo();
+  ASSERT_NE(pRepo, nullptr);
+  STsdbMeta *pMeta = ((STsdbRepo *)pRepo)->tsdbMeta;
+  SMetaFile *mfh = getMetaFile(pRepo);
+
+  createTables(pRepo, 1, 101);
+  int64_t size = mfh->size;
+  ASSERT_EQ(tsdbPrepareMetaCheckpoint(pMeta), 0);
+  EXPECT_TRUE(tsdbMetaFileCheckpointed(mfh));
+  EXPECT_EQ(mfh->ckpSize, 0);
+
+  createTables(pRepo, 101, 111);
+  ASSERT_EQ(tsdbWriteMetaCheckpoint(pMeta), 0);
+  EXPECT_EQ(mfh->ckpSize, size);
+  EXPECT_LT(mfh->ckpSize, mfh->size);
+
+  char ckpName[TSDB_FILENAME_LEN];
+  getCkpName(ckpName);
+  EXPECT_EQ(access(ckpName, F_OK), 0);
+
+  ASSERT_EQ(tsdbPrepareMetaCheckpoint(pMeta), 0);
+  ASSERT_EQ(tsdbDeleteMetaRecord(mfh, superUid + 50), 0);
+  EXPECT_EQ(mfh->ckpSize, 0);
+  EXPECT_FALSE(tsdbMetaFileCheckpointed(mfh));
+  ASSERT_EQ(tsdbWriteMetaCheckpoint(pMeta), 0);
+  EXPECT_EQ(mfh->ckpSize, 0);
+  EXPECT_NE(access(ckpName, F_OK), 0);
+
+  tsdbCloseRepo(pRepo, 0);
+  tsTagIndexColumns = TSDB_DEFAULT_TAG_INDEX_COLUMNS;
+  taosRemoveDir(rootDir);
+}
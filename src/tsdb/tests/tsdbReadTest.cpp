@@ -0,0 +1,305 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "tchecksum.h"
+#include "tdataformat.h"
+#include "tsdbMain.h"
+#include "ttime.h"
+#include "tutil.h"
+
+namespace {
+
+double getCurTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+STSchema *createWideSchema(int nCols) {
+  STSchemaBuilder schemaBuilder;
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+
+  for (int i = 0; i < nCols; i++) {
+    if (i == 0) {
+      tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, i, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP]);
+    } else {
+      tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, i, TYPE_BYTES[TSDB_DATA_TYPE_INT]);
+    }
+  }
+
+  STSchema *pSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  return pSchema;
+}
+
+int insertRows(TsdbRepoT *pRepo, STableId tableId, STSchema *pSchema, TSKEY startTime, int totalRows,
+               int rowsPerSubmit) {
+  SSubmitMsg *pMsg = (SSubmitMsg *)malloc(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) +
+                                          dataRowMaxBytesFromSchema(pSchema) * rowsPerSubmit);
+  if (pMsg == NULL) return -1;
+
+  TSKEY key = startTime;
+  for (int k = 0; k < totalRows / rowsPerSubmit; k++) {
+    memset((void *)pMsg, 0, sizeof(SSubmitMsg) + sizeof(SSubmitBlk));
+    SSubmitBlk *pBlock = pMsg->blocks;
+
+    for (int i = 0; i < rowsPerSubmit; i++) {
+      SDataRow row = (SDataRow)(pBlock->data + pBlock->len);
+      tdInitDataRow(row, pSchema);
+
+      for (int j = 0; j < schemaNCols(pSchema); j++) {
+        STColumn *pTCol = schemaColAt(pSchema, j);
+        if (j == 0) {
+          tdAppendColVal(row, (void *)(&key), pTCol->type, pTCol->bytes, pTCol->offset);
+        } else {
+          int val = rand();
+          tdAppendColVal(row, (void *)(&val), pTCol->type, pTCol->bytes, pTCol->offset);
+        }
+      }
+      pBlock->len += dataRowLen(row);
+      key += 1000;
+    }
+
+    pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->len);
+    pMsg->numOfBlocks = htonl(1);
+
+    pBlock->uid = htobe64(tableId.uid);
+    pBlock->tid = htonl(tableId.tid);
+    pBlock->sversion = htonl(schemaVersion(pSchema));
+    pBlock->numOfRows = htons(rowsPerSubmit);
+    pBlock->len = htonl(pBlock->len);
+
+    SShellSubmitRspMsg rsp = {0};
+    if (tsdbInsertData(pRepo, pMsg, &rsp) != TSDB_CODE_SUCCESS) {
+      free(pMsg);
+      return -1;
+    }
+  }
+
+  free(pMsg);
+  return 0;
+}
+
+// Load all the blocks of a table, the whole block if colIds is NULL, else only the columns in colIds
+void loadTableBlocks(STsdbRepo *pRepo, STable *pTable, int16_t *colIds, int numOfColIds, int64_t *bytes,
+                     double *elapsed) {
+  SRWHelper rhelper;
+  ASSERT_EQ(tsdbInitReadHelper(&rhelper, pRepo), 0);
+
+  STSchema *pSchema = tsdbGetTableSchema(pRepo->tsdbMeta, pTable);
+
+  SFileGroupIter iter;
+  SFileGroup *   pGroup = NULL;
+  tsdbInitFileGroupIter(pRepo->tsdbFileH, &iter, TSDB_ORDER_ASC);
+
+  double stime = getCurTime();
+  while ((pGroup = tsdbGetFileGroupNext(&iter)) != NULL) {
+    ASSERT_GE(tsdbSetAndOpenHelperFile(&rhelper, pGroup), 0);
+    tsdbSetHelperTable(&rhelper, pTable, pRepo);
+    ASSERT_EQ(tsdbLoadCompInfo(&rhelper, NULL), 0);
+
+    SCompIdx *pIdx = rhelper.pCompIdx + pTable->tableId.tid;
+    for (int blkIdx = 0; blkIdx < (int)pIdx->numOfBlocks; blkIdx++) {
+      SCompBlock *pBlock = blockAtIdx(&rhelper, blkIdx);
+
+      if (colIds == NULL) {
+        ASSERT_EQ(tsdbLoadBlockData(&rhelper, pBlock, NULL), 0);
+        *bytes += pBlock->len;
+      } else {
+        tdInitDataCols(rhelper.pDataCols[0], pSchema);
+        tdInitDataCols(rhelper.pDataCols[1], pSchema);
+        ASSERT_EQ(tsdbLoadBlockDataCols(&rhelper, pBlock, colIds, numOfColIds), 0);
+        ASSERT_EQ(rhelper.pDataCols[0]->numOfCols, numOfColIds);
+
+        *bytes += sizeof(SCompData) + sizeof(SCompCol) * pBlock->numOfCols + sizeof(TSCKSUM);
+        for (int i = 0; i < rhelper.pCompData->numOfCols; i++) {
+          for (int j = 0; j < numOfColIds; j++) {
+            if (rhelper.pCompData->cols[i].colId == colIds[j]) *bytes += rhelper.pCompData->cols[i].len;
+          }
+        }
+      }
+
+      ASSERT_EQ(rhelper.pDataCols[0]->numOfRows, pBlock->numOfRows);
+    }
+
+    tsdbCloseHelperFile(&rhelper, false);
+  }
+  *elapsed = getCurTime() - stime;
+
+  tsdbDestroyHelper(&rhelper);
+}
+
+// Load the columns of colIds of all the blocks of a table, with the whole block load if project is false
+void loadTableCols(STsdbRepo *pRepo, STable *pTable, int16_t *colIds, int numOfColIds, bool project,
+                   std::vector<std::vector<int64_t> > *values) {
+  SRWHelper rhelper;
+  ASSERT_EQ(tsdbInitReadHelper(&rhelper, pRepo), 0);
+
+  STSchema *pSchema = tsdbGetTableSchema(pRepo->tsdbMeta, pTable);
+  values->assign(numOfColIds, std::vector<int64_t>());
+
+  SFileGroupIter iter;
+  SFileGroup *   pGroup = NULL;
+  tsdbInitFileGroupIter(pRepo->tsdbFileH, &iter, TSDB_ORDER_ASC);
+
+  while ((pGroup = tsdbGetFileGroupNext(&iter)) != NULL) {
+    ASSERT_GE(tsdbSetAndOpenHelperFile(&rhelper, pGroup), 0);
+    tsdbSetHelperTable(&rhelper, pTable, pRepo);
+    ASSERT_EQ(tsdbLoadCompInfo(&rhelper, NULL), 0);
+
+    SCompIdx *pIdx = rhelper.pCompIdx + pTable->tableId.tid;
+    for (int blkIdx = 0; blkIdx < (int)pIdx->numOfBlocks; blkIdx++) {
+      SCompBlock *pBlock = blockAtIdx(&rhelper, blkIdx);
+
+      tdInitDataCols(rhelper.pDataCols[0], pSchema);
+      tdInitDataCols(rhelper.pDataCols[1], pSchema);
+      if (project) {
+        ASSERT_EQ(tsdbLoadBlockDataCols(&rhelper, pBlock, colIds, numOfColIds), 0);
+        ASSERT_EQ(rhelper.pDataCols[0]->numOfCols, numOfColIds);
+      } else {
+        ASSERT_EQ(tsdbLoadBlockData(&rhelper, pBlock, NULL), 0);
+      }
+
+      SDataCols *pCols = rhelper.pDataCols[0];
+      ASSERT_EQ(pCols->numOfRows, pBlock->numOfRows);
+      for (int j = 0; j < numOfColIds; j++) {
+        SDataCol *pCol = NULL;
+        for (int i = 0; i < pCols->numOfCols; i++) {
+          if (pCols->cols[i].colId == colIds[j]) pCol = pCols->cols + i;
+        }
+        ASSERT_NE(pCol, nullptr);
+
+        for (int row = 0; row < pCols->numOfRows; row++) {
+          (*values)[j].push_back((j == 0) ? ((TSKEY *)pCol->pData)[row] : ((int32_t *)pCol->pData)[row]);
+        }
+      }
+    }
+
+    tsdbCloseHelperFile(&rhelper, false);
+  }
+
+  tsdbDestroyHelper(&rhelper);
+}
+
+}  // namespace
+
+// The columns projected by queries hold the same values as the ones of the whole block load
+TEST(TsdbReadTest, projectedBlockCols) {
+  char    rootDir[] = "/tmp/ttest/projectionCols";
+  int16_t colIds[] = {0, 3, 6};
+  int     nCols = 8;
+
+  taosRemoveDir(rootDir);
+  mkdir("/tmp/ttest", 0755);
+
+  STsdbCfg config;
+  tsdbSetDefaultCfg(&config);
+  config.cacheBlockSize = 16;
+  config.totalBlocks = 8;
+  ASSERT_EQ(tsdbCreateRepo(rootDir, &config, NULL), 0);
+
+  TsdbRepoT *pRepo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(pRepo, nullptr);
+
+  STableCfg tCfg;
+  char      tname[] = "projection";
+  ASSERT_EQ(tsdbInitTableCfg(&tCfg, TSDB_NORMAL_TABLE, 987607499877672L, 1), 0);
+  tsdbTableSetName(&tCfg, tname, true);
+
+  STSchema *pSchema = createWideSchema(nCols);
+  tsdbTableSetSchema(&tCfg, pSchema, true);
+  ASSERT_EQ(tsdbCreateTable(pRepo, &tCfg), 0);
+
+  // the rows of the second commit go to the file group of the first one, after its last block
+  TSKEY startTime = taosGetTimestampMs() - 100000L * 1000;
+  for (int round = 0; round < 2; round++) {
+    ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, startTime + round * 5000L * 1000, 5000, 100), 0);
+    while (tsdbCloseRepo(pRepo, 1) < 0) taosMsleep(10);
+    pRepo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(pRepo, nullptr);
+  }
+
+  STsdbRepo *repo = (STsdbRepo *)pRepo;
+  STable *   pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  ASSERT_NE(pTable, nullptr);
+
+  std::vector<std::vector<int64_t> > whole, projected;
+  loadTableCols(repo, pTable, colIds, 3, false, &whole);
+  loadTableCols(repo, pTable, colIds, 3, true, &projected);
+
+  ASSERT_EQ(whole[0].size(), 10000u);
+  for (int j = 0; j < 3; j++) {
+    EXPECT_TRUE(whole[j] == projected[j]) << "colId:" << colIds[j];
+  }
+  for (size_t row = 0; row < whole[0].size(); row++) {
+    ASSERT_EQ(whole[0][row], startTime + (TSKEY)row * 1000);
+  }
+
+  tsdbCloseRepo(pRepo, 0);
+  tdFreeSchema(tCfg.schema);
+  tfree(tCfg.name);
+  tdFreeSchema(pSchema);
+  taosRemoveDir(rootDir);
+}
+
+// Compare the whole block load with the column-projected load used by queries as the schema gets wider
+TEST(TsdbReadTest, DISABLED_projectedBlockLoad) {
+  char    rootDir[] = "/tmp/ttest/projection";
+  int     colsList[] = {4, 8, 16, 32, 64};
+  int16_t colIds[] = {0, 1};  // e.g. select avg(c1), only the timestamp and one metric column are touched
+  int     totalRows = 1000000;
+
+  for (int k = 0; k < (int)(sizeof(colsList) / sizeof(colsList[0])); k++) {
+    int nCols = colsList[k];
+
+    taosRemoveDir(rootDir);
+    mkdir("/tmp/ttest", 0755);
+
+    STsdbCfg config;
+    tsdbSetDefaultCfg(&config);
+    config.cacheBlockSize = 16;
+    config.totalBlocks = 8;
+    ASSERT_EQ(tsdbCreateRepo(rootDir, &config, NULL), 0);
+
+    TsdbRepoT *pRepo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(pRepo, nullptr);
+
+    STableCfg tCfg;
+    char      tname[] = "projection";
+    ASSERT_EQ(tsdbInitTableCfg(&tCfg, TSDB_NORMAL_TABLE, 987607499877672L, 1), 0);
+    tsdbTableSetName(&tCfg, tname, true);
+
+    STSchema *pSchema = createWideSchema(nCols);
+    tsdbTableSetSchema(&tCfg, pSchema, true);
+    ASSERT_EQ(tsdbCreateTable(pRepo, &tCfg), 0);
+
+    TSKEY startTime = taosGetTimestampMs() - (TSKEY)totalRows * 1000;
+    ASSERT_EQ(insertRows(pRepo, tCfg.tableId, pSchema, startTime, totalRows, 100), 0);
+
+    // Commit the data to files and open the repository again, wait if a background commit is still running
+    while (tsdbCloseRepo(pRepo, 1) < 0) taosMsleep(10);
+    pRepo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(pRepo, nullptr);
+
+    STsdbRepo *repo = (STsdbRepo *)pRepo;
+    STable *   pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+    ASSERT_NE(pTable, nullptr);
+
+    int64_t wholeBytes = 0, projBytes = 0;
+    double  wholeTime = 0, projTime = 0;
+    loadTableBlocks(repo, pTable, NULL, 0, &wholeBytes, &wholeTime);
+    loadTableBlocks(repo, pTable, colIds, 2, &projBytes, &projTime);
+
+    printf("%2d columns: whole block load %8.2f MB in %.4f s, projected load %8.2f MB in %.4f s, speedup %.2fx\n",
+           nCols, wholeBytes / 1048576.0, wholeTime, projBytes / 1048576.0, projTime, wholeTime / projTime);
+
+    tsdbCloseRepo(pRepo, 0);
+    tdFreeSchema(tCfg.schema);
+    tfree(tCfg.name);
+    tdFreeSchema(pSchema);
+  }
+
+  taosRemoveDir(rootDir);
+}
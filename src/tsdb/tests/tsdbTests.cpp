@@ -5,6 +5,24 @@
 #include "tdataformat.h"
 #include "tsdbMain.h"
 #include "tskiplist.h"
+#include "tutil.h"
+
+static STSchema *createSchema(int nCols) {
+  STSchemaBuilder schemaBuilder;
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+
+  for (int i = 0; i < nCols; i++) {
+    if (i == 0) {
+      tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, i, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP]);
+    } else {
+      tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, i, TYPE_BYTES[TSDB_DATA_TYPE_INT]);
+    }
+  }
+
+  STSchema *pSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  return pSchema;
+}
 
 static double getCurTime() {
   struct timeval tv;
@@ -61,12 +79,13 @@ static int insertData(SInsertInfo *pInfo) {
         }
       }
       pBlock->len += dataRowLen(row);
+      pBlock->numOfRows++;
     }
     pMsg->length = pMsg->length + sizeof(SSubmitBlk) + pBlock->len;
     pMsg->numOfBlocks = 1;
 
     pBlock->len = htonl(pBlock->len);
-    pBlock->numOfRows = htonl(pBlock->numOfRows);
+    pBlock->numOfRows = htons(pBlock->numOfRows);
     pBlock->uid = htobe64(pBlock->uid);
     pBlock->tid = htonl(pBlock->tid);
 
@@ -75,9 +94,9 @@ static int insertData(SInsertInfo *pInfo) {
 
     pMsg->length = htonl(pMsg->length);
     pMsg->numOfBlocks = htonl(pMsg->numOfBlocks);
-    pMsg->compressed = htonl(pMsg->numOfBlocks);
 
-    if (tsdbInsertData(pInfo->pRepo, pMsg) < 0) {
+    SShellSubmitRspMsg rsp = {0};
+    if (tsdbInsertData(pInfo->pRepo, pMsg, &rsp) < 0) {
       tfree(pMsg);
       return -1;
     }
@@ -98,24 +117,17 @@ TEST(TsdbTest, DISABLED_tableEncodeDecode) {
   pTable->tableId.uid = 987607499877672L;
   pTable->tableId.tid = 0;
   pTable->superUid = -1;
-  pTable->sversion = 0;
   pTable->tagSchema = NULL;
   pTable->tagVal = NULL;
   int nCols = 5;
-  STSchema *schema = tdNewSchema(nCols);
-
-  for (int i = 0; i < nCols; i++) {
-    if (i == 0) {
-      tdSchemaAddCol(schema, TSDB_DATA_TYPE_TIMESTAMP, i, -1);
-    } else {
-      tdSchemaAddCol(schema, TSDB_DATA_TYPE_INT, i, -1);
-    }
-  }
+  STSchema *schema = createSchema(nCols);
 
-  pTable->schema = schema;
+  pTable->numOfSchemas = 1;
+  pTable->schema = &schema;
 
-  int bufLen = 0;
-  void *buf = tsdbEncodeTable(pTable, &bufLen);
+  char buf[4096];
+  int  bufLen = 0;
+  tsdbEncodeTable(pTable, buf, &bufLen);
 
   STable *tTable = tsdbDecodeTable(buf, bufLen);
 
@@ -123,40 +135,39 @@ TEST(TsdbTest, DISABLED_tableEncodeDecode) {
   ASSERT_EQ(pTable->tableId.uid, tTable->tableId.uid);
   ASSERT_EQ(pTable->tableId.tid, tTable->tableId.tid);
   ASSERT_EQ(pTable->superUid, tTable->superUid);
-  ASSERT_EQ(pTable->sversion, tTable->sversion);
-  ASSERT_EQ(memcmp(pTable->schema, tTable->schema, sizeof(STSchema) + sizeof(STColumn) * nCols), 0);
+  ASSERT_EQ(schemaVersion(schema), schemaVersion(tTable->schema[0]));
+  ASSERT_EQ(memcmp(schema, tTable->schema[0], sizeof(STSchema) + sizeof(STColumn) * nCols), 0);
 }
 
 // TEST(TsdbTest, DISABLED_createRepo) {
 TEST(TsdbTest, createRepo) {
   STsdbCfg config;
   STsdbRepo *repo;
+  char       rootDir[] = "/tmp/ttest/vnode0";
+
+  taosRemoveDir(rootDir);
+  mkdir("/tmp/ttest", 0755);
 
   // 1. Create a tsdb repository
   tsdbSetDefaultCfg(&config);
-  ASSERT_EQ(tsdbCreateRepo("/home/ubuntu/work/ttest/vnode0", &config, NULL), 0);
+  config.cacheBlockSize = 16;
+  config.totalBlocks = 32;
+  ASSERT_EQ(tsdbCreateRepo(rootDir, &config, NULL), 0);
 
-  TsdbRepoT *pRepo = tsdbOpenRepo("/home/ubuntu/work/ttest/vnode0", NULL);
+  TsdbRepoT *pRepo = tsdbOpenRepo(rootDir, NULL);
   ASSERT_NE(pRepo, nullptr);
 
   // 2. Create a normal table
   STableCfg tCfg;
   ASSERT_EQ(tsdbInitTableCfg(&tCfg, TSDB_SUPER_TABLE, 987607499877672L, 0), -1);
   ASSERT_EQ(tsdbInitTableCfg(&tCfg, TSDB_NORMAL_TABLE, 987607499877672L, 0), 0);
-  tsdbTableSetName(&tCfg, "test", false);
+  char tname[] = "test";
+  tsdbTableSetName(&tCfg, tname, false);
 
   int       nCols = 5;
-  STSchema *schema = tdNewSchema(nCols);
-
-  for (int i = 0; i < nCols; i++) {
-    if (i == 0) {
-      tdSchemaAddCol(schema, TSDB_DATA_TYPE_TIMESTAMP, i, -1);
-    } else {
-      tdSchemaAddCol(schema, TSDB_DATA_TYPE_INT, i, -1);
-    }
-  }
+  STSchema *schema = createSchema(nCols);
 
-  tsdbTableSetSchema(&tCfg, schema, true);
+  tsdbTableSetSchema(&tCfg, schema, false);
 
   tsdbCreateTable(pRepo, &tCfg);
 
@@ -167,10 +178,10 @@ TEST(TsdbTest, createRepo) {
     .isAscend = false,
     .tid = tCfg.tableId.tid,
     .uid = tCfg.tableId.uid,
-    .sversion = tCfg.sversion,
+    .sversion = schemaVersion(schema),
     .startTime = 1584081000000,
     .interval = 1000,
-    .totalRows = 10000000,
+    .totalRows = 100000,
     .rowsPerSubmit = 1,
     .pSchema = schema
   };
@@ -178,13 +189,19 @@ TEST(TsdbTest, createRepo) {
   ASSERT_EQ(insertData(&iInfo), 0);
 
   // Close the repository
-  tsdbCloseRepo(pRepo);
+  tsdbCloseRepo(pRepo, 1);
 
   // Open the repository again
-  pRepo = tsdbOpenRepo("/home/ubuntu/work/ttest/vnode0", NULL);
+  pRepo = tsdbOpenRepo(rootDir, NULL);
   repo = (STsdbRepo *)pRepo;
   ASSERT_NE(pRepo, nullptr);
 
+  STable *pTable = tsdbGetTableByUid(repo->tsdbMeta, tCfg.tableId.uid);
+  ASSERT_NE(pTable, nullptr);
+
+  tsdbCloseRepo(pRepo, 0);
+  tdFreeSchema(schema);
+
   // // Insert more data
   // iInfo.startTime = iInfo.startTime + iInfo.interval * iInfo.totalRows;
   // iInfo.totalRows = 10;
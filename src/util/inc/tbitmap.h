@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TDENGINE_TBITMAP_H
+#define TDENGINE_TBITMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Bitmap of a fixed number of bits, such as the table ids of a vnode. The bits are kept in 64-bit words, so the
+ * bitmaps of the same size are combined a word at a time.
+ */
+typedef struct SBitmap {
+  int32_t   numOfBits;
+  int32_t   numOfWords;
+  uint64_t *words;
+} SBitmap;
+
+#define TBITMAP_WORD_BITS 64
+
+SBitmap *taosBitmapCreate(int32_t numOfBits);
+void     taosBitmapDestroy(SBitmap *pBitmap);
+void     taosBitmapClear(SBitmap *pBitmap);
+void     taosBitmapCopy(SBitmap *pDst, const SBitmap *pSrc);
+
+// the bitmaps combined shall be of the same number of bits
+void taosBitmapAnd(SBitmap *pDst, const SBitmap *pSrc);
+void taosBitmapOr(SBitmap *pDst, const SBitmap *pSrc);
+
+int32_t taosBitmapCount(const SBitmap *pBitmap);
+
+// the first bit set from bit on, -1 if there is none
+int32_t taosBitmapNext(const SBitmap *pBitmap, int32_t bit);
+
+static inline void taosBitmapSet(SBitmap *pBitmap, int32_t bit) {
+  pBitmap->words[bit / TBITMAP_WORD_BITS] |= (uint64_t)1 << (bit % TBITMAP_WORD_BITS);
+}
+
+static inline void taosBitmapUnset(SBitmap *pBitmap, int32_t bit) {
+  pBitmap->words[bit / TBITMAP_WORD_BITS] &= ~((uint64_t)1 << (bit % TBITMAP_WORD_BITS));
+}
+
+static inline bool taosBitmapGet(const SBitmap *pBitmap, int32_t bit) {
+  return (pBitmap->words[bit / TBITMAP_WORD_BITS] >> (bit % TBITMAP_WORD_BITS)) & 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TBITMAP_H
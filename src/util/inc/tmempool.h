@@ -29,6 +29,27 @@ void taosMemPoolFree(mpool_h handle, char *p);
 
 void taosMemPoolCleanUp(mpool_h handle);
 
+/*
+ * Size class allocator for the buffers passed between threads at a high rate, the queue items and the RPC
+ * messages. Each thread keeps the freed buffers of each class for its next allocations, the classes share
+ * the slabs taken from the system, which are kept for reuse. Buffers larger than the biggest class are
+ * malloced. A buffer of this allocator shall be freed by taosSlabFree, and may be freed by any thread.
+ */
+typedef struct {
+  int64_t numOfAllocs;    // allocations, including the large ones
+  int64_t numOfFrees;
+  int64_t numOfLarges;    // allocations larger than the biggest class
+  int64_t numOfRefills;   // thread caches refilled from the shared free lists
+  int64_t usedBytes;      // bytes of the class buffers in use
+  int64_t reservedBytes;  // bytes of the slabs taken from the system
+} SSlabStatis;
+
+void *taosSlabMalloc(size_t size);
+void *taosSlabCalloc(size_t size);
+void *taosSlabRealloc(void *p, size_t size);
+void  taosSlabFree(void *p);
+void  taosGetSlabStatis(SSlabStatis *pStatis);
+
 #ifdef __cplusplus
 }
 #endif
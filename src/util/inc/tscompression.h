@@ -33,6 +33,13 @@ extern "C" {
 #define NO_COMPRESSION 0
 #define ONE_STAGE_COMP 1
 #define TWO_STAGE_COMP 2
+// Instruction sets of the decompression kernels
+#define TAOS_SIMD_NONE  0
+#define TAOS_SIMD_SSE41 1
+#define TAOS_SIMD_AVX2  2
+
+// Select the decompression kernels of the highest level up to maxLevel the CPU supports, return the level selected
+extern int taosResolveDecompress(int maxLevel);
 
 extern int tsCompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type);
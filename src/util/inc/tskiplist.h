@@ -173,6 +173,18 @@ void tSkipListNewNodeInfo(SSkipList *pSkipList, int32_t *level, int32_t *headSiz
  */
 SSkipListNode *tSkipListPut(SSkipList *pSkipList, SSkipListNode *pNode);
 
+/**
+ * put a run of skip list nodes sorted by key in ascending order into the skip list.
+ * The search for each node starts from the position of the previous one, and nodes beyond the
+ * maximum key are appended at the tail directly. Nodes with identical key are discarded if dupKey is 0.
+ *
+ * @param pSkipList
+ * @param pNodes
+ * @param numOfNodes
+ * @return  the number of nodes put into the skip list
+ */
+int32_t tSkipListPutBatch(SSkipList *pSkipList, SSkipListNode **pNodes, int32_t numOfNodes);
+
 /**
  * get *all* nodes which key are equivalent to pKey
  *
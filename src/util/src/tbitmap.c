@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tbitmap.h"
+
+SBitmap *taosBitmapCreate(int32_t numOfBits) {
+  SBitmap *pBitmap = calloc(1, sizeof(SBitmap));
+  if (pBitmap == NULL) return NULL;
+
+  pBitmap->numOfBits = numOfBits;
+  pBitmap->numOfWords = (numOfBits + TBITMAP_WORD_BITS - 1) / TBITMAP_WORD_BITS;
+  pBitmap->words = calloc(MAX(pBitmap->numOfWords, 1), sizeof(uint64_t));
+  if (pBitmap->words == NULL) {
+    free(pBitmap);
+    return NULL;
+  }
+
+  return pBitmap;
+}
+
+void taosBitmapDestroy(SBitmap *pBitmap) {
+  if (pBitmap == NULL) return;
+
+  free(pBitmap->words);
+  free(pBitmap);
+}
+
+void taosBitmapClear(SBitmap *pBitmap) { memset(pBitmap->words, 0, sizeof(uint64_t) * pBitmap->numOfWords); }
+
+void taosBitmapCopy(SBitmap *pDst, const SBitmap *pSrc) {
+  assert(pDst->numOfWords == pSrc->numOfWords);
+  memcpy(pDst->words, pSrc->words, sizeof(uint64_t) * pSrc->numOfWords);
+}
+
+void taosBitmapAnd(SBitmap *pDst, const SBitmap *pSrc) {
+  assert(pDst->numOfWords == pSrc->numOfWords);
+
+  uint64_t *      dst = pDst->words;
+  const uint64_t *src = pSrc->words;
+  for (int32_t i = 0; i < pDst->numOfWords; ++i) dst[i] &= src[i];
+}
+
+void taosBitmapOr(SBitmap *pDst, const SBitmap *pSrc) {
+  assert(pDst->numOfWords == pSrc->numOfWords);
+
+  uint64_t *      dst = pDst->words;
+  const uint64_t *src = pSrc->words;
+  for (int32_t i = 0; i < pDst->numOfWords; ++i) dst[i] |= src[i];
+}
+
+int32_t taosBitmapCount(const SBitmap *pBitmap) {
+  int32_t count = 0;
+
+  for (int32_t i = 0; i < pBitmap->numOfWords; ++i) {
+    uint64_t w = pBitmap->words[i];
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    count += (int32_t)((w * 0x0101010101010101ULL) >> 56);
+  }
+
+  return count;
+}
+
+int32_t taosBitmapNext(const SBitmap *pBitmap, int32_t bit) {
+  if (bit < 0) bit = 0;
+  if (bit >= pBitmap->numOfBits) return -1;
+
+  int32_t  i = bit / TBITMAP_WORD_BITS;
+  uint64_t w = pBitmap->words[i] & (~(uint64_t)0 << (bit % TBITMAP_WORD_BITS));
+
+  while (w == 0) {
+    if (++i >= pBitmap->numOfWords) return -1;
+    w = pBitmap->words[i];
+  }
+
+  bit = i * TBITMAP_WORD_BITS + BUILDIN_CTZL(w);
+  return (bit < pBitmap->numOfBits) ? bit : -1;
+}
@@ -52,10 +52,26 @@
 #include "tscompression.h"
 #include "taosdef.h"
 
+#if defined(__GNUC__) && !defined(_TD_ARM_)
+#include <immintrin.h>
+#define TAOS_SIMD_DECOMPRESS
+#endif
+
 const int TEST_NUMBER = 1;
 #define is_bigendian() ((*(char *)&TEST_NUMBER) == 0)
 #define SIMPLE8B_MAX_INT64 ((uint64_t)2305843009213693951L)
 
+// Decode the first elems values of a simple8b word to output + pos, return the last value
+typedef int64_t (*__simple8b_decode_fn_t)(uint64_t w, int selector, int elems, int64_t prev_value, const char type,
+                                          char *const output, int pos);
+// Decode npairs delta-of-delta pairs of a timestamp stream from input + *ipos, return the number of values decoded
+typedef int (*__dod_decode_fn_t)(const char *input, int *ipos, int npairs, int64_t *prev_value, int64_t *prev_delta,
+                                 int64_t *out);
+
+// The vector kernels selected by taosResolveDecompress, the scalar loops are used when they are NULL
+static __simple8b_decode_fn_t tsDecodeSimple8bWordFp = NULL;
+static __dod_decode_fn_t      tsDecodeDodPairsFp = NULL;
+
 bool safeInt64Add(int64_t a, int64_t b) {
   if ((a > 0 && b > INT64_MAX - a) || (a < 0 && b < INT64_MIN - a)) return false;
   return true;
@@ -194,6 +210,108 @@ int tsCompressINTImp(const char *const input, const int nelements, char *const o
   return opos;
 }
 
+#ifdef TAOS_SIMD_DECOMPRESS
+/*
+ * The vector kernel shifts a word by the offsets of four values at once, zigzag decodes them and adds them up with a
+ * prefix sum. The last lane of the sum carries the previous value to the next vector, off the critical path of the
+ * stores, and the lanes are narrowed to the type in the registers. The setup of the vectors does not pay off for the
+ * words of less than 8 values, they are left to the scalar loop. With two lanes only, an SSE4.1 kernel is no faster
+ * than the scalar loop, so there is none.
+ */
+static const char simple8b_bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
+
+static FORCE_INLINE int64_t tsDecodeSimple8bTail(uint64_t w, int bit, int from, int elems, int64_t prev_value,
+                                                 const char type, char *const output, int pos) {
+  for (int i = from; i < elems; i++) {
+    uint64_t zigzag_value = (w >> (4 + bit * i)) & INT64MASK(bit);
+    prev_value += (int64_t)((zigzag_value >> 1) ^ -(zigzag_value & 1));
+    switch (type) {
+      case TSDB_DATA_TYPE_BIGINT:
+        *((int64_t *)output + pos + i) = prev_value;
+        break;
+      case TSDB_DATA_TYPE_INT:
+        *((int32_t *)output + pos + i) = prev_value;
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        *((int16_t *)output + pos + i) = prev_value;
+        break;
+      case TSDB_DATA_TYPE_TINYINT:
+        *((int8_t *)output + pos + i) = prev_value;
+        break;
+    }
+  }
+  return prev_value;
+}
+
+__attribute__((target("avx2"))) static FORCE_INLINE void tsStoreInteger256(__m256i v, const char type,
+                                                                            char *const output, int pos) {
+  if (type == TSDB_DATA_TYPE_BIGINT) {
+    _mm256_storeu_si256((__m256i *)((int64_t *)output + pos), v);
+    return;
+  }
+
+  // the low halves of the four lanes
+  __m128i v32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+  switch (type) {
+    case TSDB_DATA_TYPE_INT:
+      _mm_storeu_si128((__m128i *)((int32_t *)output + pos), v32);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      _mm_storel_epi64((__m128i *)((int16_t *)output + pos),
+                       _mm_shuffle_epi8(v32, _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1)));
+      break;
+    case TSDB_DATA_TYPE_TINYINT: {
+      int32_t packed = _mm_cvtsi128_si32(
+          _mm_shuffle_epi8(v32, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+      memcpy((int8_t *)output + pos, &packed, 4 * CHAR_BYTES);
+      break;
+    }
+  }
+}
+
+// Inclusive prefix sum of the four lanes
+__attribute__((target("avx2"))) static FORCE_INLINE __m256i tsPrefixSum256(__m256i v) {
+  __m256i zero = _mm256_setzero_si256();
+  v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x90), zero, 0x03));
+  v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x40), zero, 0x0F));
+  return v;
+}
+
+__attribute__((target("avx2"))) static int64_t tsDecodeSimple8bWordAVX2(uint64_t w, int selector, int elems,
+                                                                         int64_t prev_value, const char type,
+                                                                         char *const output, int pos) {
+  int     bit = simple8b_bit_per_integer[selector];
+  __m256i vprev = _mm256_set1_epi64x(prev_value);
+  int     i = 0;
+
+  if (selector <= 1) {
+    // a run of the same value
+    for (; i + 4 <= elems; i += 4) tsStoreInteger256(vprev, type, output, pos + i);
+    return tsDecodeSimple8bTail(0, bit, i, elems, prev_value, type, output, pos);
+  }
+
+  __m256i vw = _mm256_set1_epi64x(w);
+  __m256i vmask = _mm256_set1_epi64x(INT64MASK(bit));
+  __m256i vone = _mm256_set1_epi64x(1);
+  __m256i vshift = _mm256_setr_epi64x(4, 4 + bit, 4 + 2 * bit, 4 + 3 * bit);
+  __m256i vstep = _mm256_set1_epi64x(4 * bit);
+
+  for (; i + 4 <= elems; i += 4) {
+    __m256i zigzag = _mm256_and_si256(_mm256_srlv_epi64(vw, vshift), vmask);
+    __m256i diff = _mm256_xor_si256(_mm256_srli_epi64(zigzag, 1),
+                                    _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(zigzag, vone)));
+
+    diff = tsPrefixSum256(diff);
+    tsStoreInteger256(_mm256_add_epi64(diff, vprev), type, output, pos + i);
+    vprev = _mm256_add_epi64(vprev, _mm256_permute4x64_epi64(diff, 0xFF));
+    vshift = _mm256_add_epi64(vshift, vstep);
+  }
+
+  prev_value = _mm_cvtsi128_si64(_mm256_castsi256_si128(vprev));
+  return tsDecodeSimple8bTail(w, bit, i, elems, prev_value, type, output, pos);
+}
+#endif  // TAOS_SIMD_DECOMPRESS
+
 int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type) {
   int word_length = 0;
   switch (type) {
@@ -240,6 +358,16 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
     char bit = bit_per_integer[(int)selector];      // bit = 3
     int  elems = selector_to_elems[(int)selector];
 
+    // Decode the words of 8 values or more with the vector kernel.
+    if (tsDecodeSimple8bWordFp != NULL && elems >= 8) {
+      if (elems > nelements - count) elems = nelements - count;
+      prev_value = (*tsDecodeSimple8bWordFp)(w, selector, elems, prev_value, type, output, _pos);
+      _pos += elems;
+      count += elems;
+      ip += LONG_BYTES;
+      continue;
+    }
+
     for (int i = 0; i < elems; i++) {
       uint64_t zigzag_value;
 
@@ -526,6 +654,102 @@ _exit_over:
   return nelements * LONG_BYTES + 1;
 }
 
+#ifdef TAOS_SIMD_DECOMPRESS
+/*
+ * The vector kernels move the two zigzag encoded values of a pair into two lanes with a byte shuffle selected by the
+ * flags byte, then add up the deltas and the values with prefix sums. A pair with a corrupted flags byte is left to
+ * the scalar loop.
+ */
+static uint8_t tsDodShuffleMask[256][16];
+
+static void tsInitDodShuffleMask() {
+  for (int flags = 0; flags < 256; flags++) {
+    int n1 = flags & INT8MASK(4);
+    int n2 = (flags >> 4) & INT8MASK(4);
+    for (int i = 0; i < LONG_BYTES; i++) {
+      tsDodShuffleMask[flags][i] = (i < n1 && n1 <= LONG_BYTES) ? i : 0x80;
+      tsDodShuffleMask[flags][LONG_BYTES + i] = (i < n2 && n1 <= LONG_BYTES && n2 <= LONG_BYTES) ? n1 + i : 0x80;
+    }
+  }
+}
+
+__attribute__((target("sse4.1"))) static int tsDecodeDodPairsSSE41(const char *input, int *ipos, int npairs,
+                                                                    int64_t *prev_value, int64_t *prev_delta,
+                                                                    int64_t *out) {
+  __m128i vone = _mm_set1_epi64x(1);
+  __m128i vvalue = _mm_set1_epi64x(*prev_value);
+  __m128i vdelta = _mm_set1_epi64x(*prev_delta);
+  int     pos = *ipos;
+  int     i = 0;
+
+  for (; i < npairs; i++) {
+    uint8_t flags = input[pos];
+    int     n1 = flags & INT8MASK(4);
+    int     n2 = (flags >> 4) & INT8MASK(4);
+    if (n1 > LONG_BYTES || n2 > LONG_BYTES) break;
+
+    __m128i dd = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(input + pos + 1)),
+                                  _mm_loadu_si128((const __m128i *)tsDodShuffleMask[flags]));
+    dd = _mm_xor_si128(_mm_srli_epi64(dd, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(dd, vone)));
+
+    vdelta = _mm_add_epi64(vdelta, _mm_add_epi64(dd, _mm_slli_si128(dd, 8)));
+    __m128i value = _mm_add_epi64(vvalue, _mm_add_epi64(vdelta, _mm_slli_si128(vdelta, 8)));
+    _mm_storeu_si128((__m128i *)(out + 2 * i), value);
+
+    vvalue = _mm_unpackhi_epi64(value, value);
+    vdelta = _mm_unpackhi_epi64(vdelta, vdelta);
+    pos += 1 + n1 + n2;
+  }
+
+  *ipos = pos;
+  *prev_value = _mm_cvtsi128_si64(vvalue);
+  *prev_delta = _mm_cvtsi128_si64(vdelta);
+  return 2 * i;
+}
+
+__attribute__((target("avx2"))) static int tsDecodeDodPairsAVX2(const char *input, int *ipos, int npairs,
+                                                                 int64_t *prev_value, int64_t *prev_delta,
+                                                                 int64_t *out) {
+  __m256i vone = _mm256_set1_epi64x(1);
+  __m256i vvalue = _mm256_set1_epi64x(*prev_value);
+  __m256i vdelta = _mm256_set1_epi64x(*prev_delta);
+  int     pos = *ipos;
+  int     i = 0;
+
+  for (; i + 2 <= npairs; i += 2) {
+    uint8_t flags1 = input[pos];
+    int     n1 = flags1 & INT8MASK(4);
+    int     n2 = (flags1 >> 4) & INT8MASK(4);
+    int     pos2 = pos + 1 + n1 + n2;
+    uint8_t flags2 = input[pos2];
+    int     n3 = flags2 & INT8MASK(4);
+    int     n4 = (flags2 >> 4) & INT8MASK(4);
+    if (n1 > LONG_BYTES || n2 > LONG_BYTES || n3 > LONG_BYTES || n4 > LONG_BYTES) break;
+
+    __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(input + pos + 1)),
+                                  _mm_loadu_si128((const __m128i *)tsDodShuffleMask[flags1]));
+    __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(input + pos2 + 1)),
+                                  _mm_loadu_si128((const __m128i *)tsDodShuffleMask[flags2]));
+    __m256i dd = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    dd = _mm256_xor_si256(_mm256_srli_epi64(dd, 1), _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(dd, vone)));
+
+    vdelta = _mm256_add_epi64(vdelta, tsPrefixSum256(dd));
+    __m256i value = _mm256_add_epi64(vvalue, tsPrefixSum256(vdelta));
+    _mm256_storeu_si256((__m256i *)(out + 2 * i), value);
+
+    vvalue = _mm256_permute4x64_epi64(value, 0xFF);
+    vdelta = _mm256_permute4x64_epi64(vdelta, 0xFF);
+    pos = pos2 + 1 + n3 + n4;
+  }
+
+  *ipos = pos;
+  *prev_value = _mm_cvtsi128_si64(_mm256_castsi256_si128(vvalue));
+  *prev_delta = _mm_cvtsi128_si64(_mm256_castsi256_si128(vdelta));
+  if (i < npairs) i += tsDecodeDodPairsSSE41(input, ipos, npairs - i, prev_value, prev_delta, out + 2 * i) / 2;
+  return 2 * i;
+}
+#endif  // TAOS_SIMD_DECOMPRESS
+
 int tsDecompressTimestampImp(const char *const input, const int nelements, char *const output) {
   assert(nelements >= 0);
   if (nelements == 0) return 0;
@@ -543,6 +767,16 @@ int tsDecompressTimestampImp(const char *const input, const int nelements, char
     int64_t delta_of_delta = 0;
 
     while (1) {
+      // Decode the pairs after the first one with the vector kernel, the last 16 pairs are left to this loop so the
+      // 16 byte loads of the kernel stay within the input
+      if (opos > 0 && tsDecodeDodPairsFp != NULL) {
+        int npairs = (nelements - opos) / 2 - 16;
+        if (npairs > 0) {
+          opos += (*tsDecodeDodPairsFp)(input, &ipos, npairs, &prev_value, &prev_delta, ostream + opos);
+          if (opos == nelements) return nelements * LONG_BYTES;
+        }
+      }
+
       uint8_t flags = input[ipos++];
       // Decode dd1
       uint64_t dd1 = 0;
@@ -887,3 +1121,36 @@ int tsDecompressFloatImp(const char *const input, const int nelements, char *con
 
   return nelements * FLOAT_BYTES;
 }
+
+int taosResolveDecompress(int maxLevel) {
+  int level = TAOS_SIMD_NONE;
+
+#ifdef TAOS_SIMD_DECOMPRESS
+  __builtin_cpu_init();
+  if (maxLevel >= TAOS_SIMD_AVX2 && __builtin_cpu_supports("avx2")) {
+    level = TAOS_SIMD_AVX2;
+  } else if (maxLevel >= TAOS_SIMD_SSE41 && __builtin_cpu_supports("sse4.1")) {
+    level = TAOS_SIMD_SSE41;
+  }
+  if (level != TAOS_SIMD_NONE) tsInitDodShuffleMask();
+#endif
+
+  switch (level) {
+#ifdef TAOS_SIMD_DECOMPRESS
+    case TAOS_SIMD_AVX2:
+      tsDecodeSimple8bWordFp = tsDecodeSimple8bWordAVX2;
+      tsDecodeDodPairsFp = tsDecodeDodPairsAVX2;
+      break;
+    case TAOS_SIMD_SSE41:
+      tsDecodeSimple8bWordFp = NULL;
+      tsDecodeDodPairsFp = tsDecodeDodPairsSSE41;
+      break;
+#endif
+    default:
+      tsDecodeSimple8bWordFp = NULL;
+      tsDecodeDodPairsFp = NULL;
+      break;
+  }
+
+  return level;
+}
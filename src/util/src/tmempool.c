@@ -13,11 +13,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <pthread.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
+#include "os.h"
 #include "tulog.h"
 #include "tmempool.h"
 #include "tutil.h"
@@ -129,3 +125,267 @@ void taosMemPoolCleanUp(mpool_h handle) {
   memset(pool_p, 0, sizeof(*pool_p));
   free(pool_p);
 }
+
+#define SLAB_MIN_SHIFT    6   // the smallest class is 64 bytes, header included
+#define SLAB_CLASSES      11  // the biggest class is 64KB
+#define SLAB_SIZE         (256 * 1024)
+#define SLAB_CACHE_BYTES  (64 * 1024)  // buffers of a class kept by a thread, at least SLAB_CACHE_MIN of them
+#define SLAB_CACHE_MIN    4
+#define SLAB_LARGE        -1
+
+// in front of each buffer, 16 bytes to keep the buffer aligned as malloc does
+typedef struct {
+  int32_t sizeClass;  // SLAB_LARGE for the malloced ones
+  int32_t reserved;
+  int64_t size;       // bytes requested, for the large ones
+} SSlabHead;
+
+typedef struct SSlabItem {
+  struct SSlabItem *next;
+} SSlabItem;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  SSlabItem *     freeList;
+  int32_t         numOfFree;
+} SSlabClass;
+
+typedef struct SSlabCache {
+  SSlabItem *        freeList[SLAB_CLASSES];
+  int32_t            numOfFree[SLAB_CLASSES];
+  int64_t            numOfAllocs;
+  int64_t            numOfFrees;
+  int64_t            numOfLarges;
+  int64_t            usedBytes;
+  struct SSlabCache *prev;
+  struct SSlabCache *next;
+  int8_t             registered;
+} SSlabCache;
+
+static SSlabClass            tsSlabClasses[SLAB_CLASSES];
+static SSlabCache            tsSlabExited;  // the counters of the threads exited
+static SSlabCache *          tsSlabCaches;  // the caches of the running threads, for the statistics
+static pthread_mutex_t       tsSlabMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t        tsSlabOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t         tsSlabKey;
+static int64_t               tsSlabRefills;
+static int64_t               tsSlabReserved;
+static threadlocal SSlabCache tsSlabCache;
+
+static inline int32_t taosSlabClassSize(int32_t sizeClass) { return 1 << (sizeClass + SLAB_MIN_SHIFT); }
+
+static inline int32_t taosSlabCacheLimit(int32_t sizeClass) {
+  int32_t limit = SLAB_CACHE_BYTES / taosSlabClassSize(sizeClass);
+  return limit < SLAB_CACHE_MIN ? SLAB_CACHE_MIN : limit;
+}
+
+static int32_t taosSlabGetClass(size_t size) {
+  size_t  total = size + sizeof(SSlabHead);
+  int32_t sizeClass = 0;
+  while (sizeClass < SLAB_CLASSES && (size_t)taosSlabClassSize(sizeClass) < total) sizeClass++;
+  return sizeClass < SLAB_CLASSES ? sizeClass : SLAB_LARGE;
+}
+
+// moves num buffers of the thread cache to the shared free list
+static void taosSlabFlushCache(SSlabCache *pCache, int32_t sizeClass, int32_t num) {
+  SSlabClass *pClass = tsSlabClasses + sizeClass;
+  SSlabItem * pHead = pCache->freeList[sizeClass];
+  SSlabItem * pTail = pHead;
+
+  int32_t     moved = 1;
+
+  if (num <= 0 || pHead == NULL) return;
+  while (moved < num && pTail->next != NULL) {
+    pTail = pTail->next;
+    moved++;
+  }
+  pCache->freeList[sizeClass] = pTail->next;
+  pCache->numOfFree[sizeClass] -= moved;
+
+  pthread_mutex_lock(&pClass->mutex);
+  pTail->next = pClass->freeList;
+  pClass->freeList = pHead;
+  pClass->numOfFree += moved;
+  pthread_mutex_unlock(&pClass->mutex);
+}
+
+static void taosSlabDestroyCache(void *param) {
+  SSlabCache *pCache = (SSlabCache *)param;
+
+  for (int32_t c = 0; c < SLAB_CLASSES; ++c) taosSlabFlushCache(pCache, c, pCache->numOfFree[c]);
+
+  pthread_mutex_lock(&tsSlabMutex);
+  if (pCache->prev) {
+    pCache->prev->next = pCache->next;
+  } else {
+    tsSlabCaches = pCache->next;
+  }
+  if (pCache->next) pCache->next->prev = pCache->prev;
+  tsSlabExited.numOfAllocs += pCache->numOfAllocs;
+  tsSlabExited.numOfFrees += pCache->numOfFrees;
+  tsSlabExited.numOfLarges += pCache->numOfLarges;
+  tsSlabExited.usedBytes += pCache->usedBytes;
+  pthread_mutex_unlock(&tsSlabMutex);
+
+  memset(pCache, 0, sizeof(SSlabCache));
+}
+
+static void taosSlabInit() {
+  for (int32_t c = 0; c < SLAB_CLASSES; ++c) pthread_mutex_init(&tsSlabClasses[c].mutex, NULL);
+  pthread_key_create(&tsSlabKey, taosSlabDestroyCache);
+}
+
+// the cache is given back at the exit of the thread, and its counters are kept
+static void taosSlabRegisterCache(SSlabCache *pCache) {
+  pthread_once(&tsSlabOnce, taosSlabInit);
+  pthread_setspecific(tsSlabKey, pCache);
+
+  pthread_mutex_lock(&tsSlabMutex);
+  pCache->prev = NULL;
+  pCache->next = tsSlabCaches;
+  if (tsSlabCaches) tsSlabCaches->prev = pCache;
+  tsSlabCaches = pCache;
+  pCache->registered = 1;
+  pthread_mutex_unlock(&tsSlabMutex);
+}
+
+// takes half of the cache limit from the shared free list, cutting a new slab if it is empty
+static bool taosSlabRefillCache(SSlabCache *pCache, int32_t sizeClass) {
+  SSlabClass *pClass = tsSlabClasses + sizeClass;
+  int32_t     classSize = taosSlabClassSize(sizeClass);
+  int32_t     num = taosSlabCacheLimit(sizeClass) / 2;
+
+  pthread_mutex_lock(&pClass->mutex);
+
+  if (pClass->freeList == NULL) {
+    char *slab = malloc(SLAB_SIZE);
+    if (slab == NULL) {
+      pthread_mutex_unlock(&pClass->mutex);
+      return false;
+    }
+
+    for (int32_t offset = SLAB_SIZE - classSize; offset >= 0; offset -= classSize) {
+      SSlabItem *pItem = (SSlabItem *)(slab + offset);
+      pItem->next = pClass->freeList;
+      pClass->freeList = pItem;
+      pClass->numOfFree++;
+    }
+    atomic_add_fetch_64(&tsSlabReserved, SLAB_SIZE);
+  }
+
+  SSlabItem *pHead = pClass->freeList;
+  SSlabItem *pTail = pHead;
+  int32_t    taken = 1;
+  while (taken < num && pTail->next != NULL) {
+    pTail = pTail->next;
+    taken++;
+  }
+  pClass->freeList = pTail->next;
+  pClass->numOfFree -= taken;
+
+  pthread_mutex_unlock(&pClass->mutex);
+
+  pTail->next = pCache->freeList[sizeClass];
+  pCache->freeList[sizeClass] = pHead;
+  pCache->numOfFree[sizeClass] += taken;
+  atomic_add_fetch_64(&tsSlabRefills, 1);
+
+  return true;
+}
+
+void *taosSlabMalloc(size_t size) {
+  SSlabCache *pCache = &tsSlabCache;
+  SSlabHead * pHead;
+  int32_t     sizeClass = taosSlabGetClass(size);
+
+  if (!pCache->registered) taosSlabRegisterCache(pCache);
+
+  if (sizeClass == SLAB_LARGE) {
+    pHead = malloc(sizeof(SSlabHead) + size);
+    if (pHead == NULL) return NULL;
+    pHead->size = size;
+    pCache->numOfLarges++;
+  } else {
+    if (pCache->freeList[sizeClass] == NULL && !taosSlabRefillCache(pCache, sizeClass)) return NULL;
+    pHead = (SSlabHead *)pCache->freeList[sizeClass];
+    pCache->freeList[sizeClass] = ((SSlabItem *)pHead)->next;
+    pCache->numOfFree[sizeClass]--;
+    pCache->usedBytes += taosSlabClassSize(sizeClass);
+    pHead->size = size;
+  }
+
+  pHead->sizeClass = sizeClass;
+  pCache->numOfAllocs++;
+
+  return pHead + 1;
+}
+
+void *taosSlabCalloc(size_t size) {
+  void *p = taosSlabMalloc(size);
+  if (p != NULL) memset(p, 0, size);
+  return p;
+}
+
+void *taosSlabRealloc(void *p, size_t size) {
+  if (p == NULL) return taosSlabMalloc(size);
+
+  SSlabHead *pHead = (SSlabHead *)p - 1;
+  if (pHead->sizeClass != SLAB_LARGE && (size_t)taosSlabClassSize(pHead->sizeClass) >= size + sizeof(SSlabHead)) {
+    pHead->size = size;
+    return p;
+  }
+
+  void *pNew = taosSlabMalloc(size);
+  if (pNew == NULL) return NULL;
+  memcpy(pNew, p, (size_t)pHead->size < size ? (size_t)pHead->size : size);
+  taosSlabFree(p);
+
+  return pNew;
+}
+
+void taosSlabFree(void *p) {
+  if (p == NULL) return;
+
+  SSlabCache *pCache = &tsSlabCache;
+  SSlabHead * pHead = (SSlabHead *)p - 1;
+  int32_t     sizeClass = pHead->sizeClass;
+
+  if (!pCache->registered) taosSlabRegisterCache(pCache);
+  pCache->numOfFrees++;
+
+  if (sizeClass == SLAB_LARGE) {
+    free(pHead);
+    return;
+  }
+
+  SSlabItem *pItem = (SSlabItem *)pHead;
+  pItem->next = pCache->freeList[sizeClass];
+  pCache->freeList[sizeClass] = pItem;
+  pCache->numOfFree[sizeClass]++;
+  pCache->usedBytes -= taosSlabClassSize(sizeClass);
+
+  // the buffers allocated by one thread and freed by another go back to the shared list
+  int32_t limit = taosSlabCacheLimit(sizeClass);
+  if (pCache->numOfFree[sizeClass] > limit) taosSlabFlushCache(pCache, sizeClass, limit / 2);
+}
+
+// the counters of the running threads are read without lock, they are for the monitor only
+void taosGetSlabStatis(SSlabStatis *pStatis) {
+  pthread_mutex_lock(&tsSlabMutex);
+
+  pStatis->numOfAllocs = tsSlabExited.numOfAllocs;
+  pStatis->numOfFrees = tsSlabExited.numOfFrees;
+  pStatis->numOfLarges = tsSlabExited.numOfLarges;
+  pStatis->usedBytes = tsSlabExited.usedBytes;
+  for (SSlabCache *pCache = tsSlabCaches; pCache != NULL; pCache = pCache->next) {
+    pStatis->numOfAllocs += pCache->numOfAllocs;
+    pStatis->numOfFrees += pCache->numOfFrees;
+    pStatis->numOfLarges += pCache->numOfLarges;
+    pStatis->usedBytes += pCache->usedBytes;
+  }
+
+  pthread_mutex_unlock(&tsSlabMutex);
+
+  pStatis->numOfRefills = atomic_load_64(&tsSlabRefills);
+  pStatis->reservedBytes = atomic_load_64(&tsSlabReserved);
+}
@@ -16,6 +16,7 @@
 #include "os.h"
 #include "tulog.h"
 #include "taoserror.h"
+#include "tmempool.h"
 #include "tqueue.h"
 
 typedef struct STaosQnode {
@@ -24,32 +25,53 @@ typedef struct STaosQnode {
   char                item[];
 } STaosQnode;
 
+/*
+ * The writers put the items in without lock: a writer swaps the tail and then links the previous tail to its
+ * item. The readers take the items out from the head holding the mutex, so the queue is multi-producer and
+ * single-consumer at a time. The stub node keeps the list from being empty, the last item is left in the list
+ * till the next item is linked after it or the stub is put back behind it.
+ */
 typedef struct STaosQueue {
   int32_t             itemSize;
-  int32_t             numOfItems;
-  struct STaosQnode  *head;
-  struct STaosQnode  *tail;
+  int32_t             numOfItems; // counted after the item is put in, so a counted item is always reachable
+  struct STaosQnode  *head;    // read end, moved by the reader holding the mutex
+  struct STaosQnode  *tail;    // write end, swapped by the writers
+  struct STaosQnode  *stub;
   struct STaosQueue  *next;    // for queue set
   struct STaosQset   *qset;    // for queue set
   void               *ahandle; // for queue set
-  pthread_mutex_t     mutex;  
+  int8_t              claimed; // a reader of the queue set owns the queue, see taosClaimAllQitemsFromQset
+  int8_t              lowPriority; // read from the queue set only when the other queues are empty
+  pthread_mutex_t     mutex;   // taken by the readers only
 } STaosQueue;
 
+/*
+ * The readers sleep on the semaphore only when no queue has items for them. A writer posts the semaphore
+ * only if a reader is sleeping, and takes the reader off the waiters as it posts, so a burst of items wakes
+ * up each sleeping reader once rather than posting for every item.
+ */
 typedef struct STaosQset {
   STaosQueue        *head;
   STaosQueue        *current;
   pthread_mutex_t    mutex;
   int32_t            numOfQueues;
-  int32_t            numOfItems;
+  int32_t            highReads; // items read from the other queues while the low priority queues have items
+  int32_t            numOfWaiters; // readers going to sleep and not waked up yet
+  int32_t            numOfResumes; // readers to return with nothing, see taosQsetThreadResume
   tsem_t             sem;
 } STaosQset;
 
+// a waiting item of the low priority queues is read after this number of items from the other queues
+#define TAOS_QSET_MAX_HIGH_READS 4
+
 typedef struct STaosQall {
   STaosQnode   *current;
   STaosQnode   *start;
   int32_t       itemSize;
   int32_t       numOfItems;
 } STaosQall; 
+
+static void taosWakeQsetReader(STaosQset *qset);
   
 taos_queue taosOpenQueue() {
   
@@ -59,35 +81,112 @@ taos_queue taosOpenQueue() {
     return NULL;
   }
 
+  queue->stub = (STaosQnode *) calloc(sizeof(STaosQnode), 1);
+  if (queue->stub == NULL) {
+    free(queue);
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  queue->head = queue->stub;
+  queue->tail = queue->stub;
   pthread_mutex_init(&queue->mutex, NULL);
 
   return queue;
 }
 
+static void taosPushQnode(STaosQueue *queue, STaosQnode *pNode) {
+  pNode->next = NULL;
+  STaosQnode *prev = atomic_exchange_ptr(&queue->tail, pNode);
+  atomic_store_ptr(&prev->next, pNode);
+}
+
+// the reader holds the mutex of the queue, it returns NULL if the queue is empty or the next item is not linked yet
+static STaosQnode *taosPopQnode(STaosQueue *queue) {
+  STaosQnode *head = queue->head;
+  STaosQnode *next = atomic_load_ptr(&head->next);
+
+  if (head == queue->stub) {
+    if (next == NULL) return NULL;
+    queue->head = next;
+    head = next;
+    next = atomic_load_ptr(&head->next);
+  }
+
+  if (next != NULL) {
+    queue->head = next;
+    return head;
+  }
+
+  // a writer has swapped the tail but not linked its item yet
+  if (head != atomic_load_ptr(&queue->tail)) return NULL;
+
+  // the last item, the stub takes its place in the list
+  taosPushQnode(queue, queue->stub);
+  next = atomic_load_ptr(&head->next);
+  if (next != NULL) {
+    queue->head = next;
+    return head;
+  }
+
+  return NULL;
+}
+
+// the reader holds the mutex of the queue and there is a counted item, which may be still being linked
+static STaosQnode *taosTakeQnode(STaosQueue *queue) {
+  STaosQnode *pNode;
+  while ((pNode = taosPopQnode(queue)) == NULL) sched_yield();
+  pNode->next = NULL;
+  return pNode;
+}
+
+// the reader holds the mutex of the queue
+static int taosTakeAllQnodes(STaosQueue *queue, STaosQall *qall) {
+  int32_t     num = atomic_load_32(&queue->numOfItems);
+  STaosQnode *pTail = NULL;
+
+  memset(qall, 0, sizeof(STaosQall));
+  for (int32_t i = 0; i < num; ++i) {
+    STaosQnode *pNode = taosTakeQnode(queue);
+    if (pTail) {
+      pTail->next = pNode;
+    } else {
+      qall->start = pNode;
+    }
+    pTail = pNode;
+  }
+
+  qall->current = qall->start;
+  qall->numOfItems = num;
+  qall->itemSize = queue->itemSize;
+  atomic_sub_fetch_32(&queue->numOfItems, num);
+
+  return num;
+}
+
 void taosCloseQueue(taos_queue param) {
   if (param == NULL) return;
   STaosQueue *queue = (STaosQueue *)param;
-  STaosQnode *pTemp;
-  STaosQnode *pNode = queue->head;  
-  queue->head = NULL;
+  STaosQnode *pNode;
 
   if (queue->qset) taosRemoveFromQset(queue->qset, queue); 
 
   pthread_mutex_lock(&queue->mutex);
 
-  while (pNode) {
-    pTemp = pNode;
-    pNode = pNode->next;
-    free (pTemp);
+  while (atomic_load_32(&queue->numOfItems) > 0) {
+    pNode = taosTakeQnode(queue);
+    atomic_sub_fetch_32(&queue->numOfItems, 1);
+    taosSlabFree(pNode);
   }
 
   pthread_mutex_unlock(&queue->mutex);
   pthread_mutex_destroy(&queue->mutex);
+  free(queue->stub);
   free(queue);
 }
 
 void *taosAllocateQitem(int size) {
-  STaosQnode *pNode = (STaosQnode *)calloc(sizeof(STaosQnode) + size, 1);
+  STaosQnode *pNode = (STaosQnode *)taosSlabCalloc(sizeof(STaosQnode) + size);
   if (pNode == NULL) return NULL;
   return (void *)pNode->item;
 }
@@ -98,32 +197,21 @@ void taosFreeQitem(void *param) {
   uTrace("item:%p is freed", param);
   char *temp = (char *)param;
   temp -= sizeof(STaosQnode);
-  free(temp);
+  taosSlabFree(temp);
 }
 
 int taosWriteQitem(taos_queue param, int type, void *item) {
   STaosQueue *queue = (STaosQueue *)param;
   STaosQnode *pNode = (STaosQnode *)(((char *)item) - sizeof(STaosQnode));
   pNode->type = type;
-  pNode->next = NULL;
-
-  pthread_mutex_lock(&queue->mutex);
-
-  if (queue->tail) {
-    queue->tail->next = pNode;
-    queue->tail = pNode;
-  } else {
-    queue->head = pNode;
-    queue->tail = pNode; 
-  }
 
-  queue->numOfItems++;
-  if (queue->qset) atomic_add_fetch_32(&queue->qset->numOfItems, 1);
-  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, queue->numOfItems);
-
-  pthread_mutex_unlock(&queue->mutex);
+  taosPushQnode(queue, pNode);
+  int32_t num = atomic_add_fetch_32(&queue->numOfItems, 1);
+  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, num);
 
-  if (queue->qset) tsem_post(&queue->qset->sem);
+  // the items of a claimed queue are read by the owner, or wake up a reader when the claim is released
+  STaosQset *qset = atomic_load_ptr(&queue->qset);
+  if (qset && !atomic_load_8(&queue->claimed)) taosWakeQsetReader(qset);
 
   return 0;
 }
@@ -135,17 +223,13 @@ int taosReadQitem(taos_queue param, int *type, void **pitem) {
 
   pthread_mutex_lock(&queue->mutex);
 
-  if (queue->head) {
-      pNode = queue->head;
+  if (atomic_load_32(&queue->numOfItems) > 0) {
+      pNode = taosTakeQnode(queue);
       *pitem = pNode->item;
       *type = pNode->type;
-      queue->head = pNode->next;
-      if (queue->head == NULL) 
-        queue->tail = NULL;
-      queue->numOfItems--;
-      if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, 1);
+      int32_t num = atomic_sub_fetch_32(&queue->numOfItems, 1);
       code = 1;
-      uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, queue->numOfItems);
+      uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, num);
   } 
 
   pthread_mutex_unlock(&queue->mutex);
@@ -169,18 +253,8 @@ int taosReadAllQitems(taos_queue param, taos_qall p2) {
 
   pthread_mutex_lock(&queue->mutex);
 
-  if (queue->head) {
-    memset(qall, 0, sizeof(STaosQall));
-    qall->current = queue->head;
-    qall->start = queue->head;
-    qall->numOfItems = queue->numOfItems;
-    qall->itemSize = queue->itemSize;
-    code = qall->numOfItems;
-
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->numOfItems = 0;
-    if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, qall->numOfItems);
+  if (atomic_load_32(&queue->numOfItems) > 0) {
+    code = taosTakeAllQnodes(queue, qall);
   } 
 
   pthread_mutex_unlock(&queue->mutex);
@@ -234,12 +308,12 @@ void taosCloseQset(taos_qset param) {
   free(qset);
 }
 
-// tsem_post 'qset->sem', so that reader threads waiting for it
-// resumes execution and return, should only be used to signal the
-// thread to exit.
+// a reader of the queue set returns with nothing once no queue has items for it,
+// waking up a sleeping one if there is, should only be used to signal the thread to exit.
 void taosQsetThreadResume(taos_qset param) {
   STaosQset *qset = (STaosQset *)param;
-  tsem_post(&qset->sem);
+  atomic_add_fetch_32(&qset->numOfResumes, 1);
+  taosWakeQsetReader(qset);
 }
 
 int taosAddIntoQset(taos_qset p1, taos_queue p2, void *ahandle) {
@@ -254,14 +328,13 @@ int taosAddIntoQset(taos_qset p1, taos_queue p2, void *ahandle) {
   queue->ahandle = ahandle;
   qset->head = queue;
   qset->numOfQueues++;
-
-  pthread_mutex_lock(&queue->mutex);
-  atomic_add_fetch_32(&qset->numOfItems, queue->numOfItems);
-  queue->qset = qset;
-  pthread_mutex_unlock(&queue->mutex);
+  atomic_store_ptr(&queue->qset, qset);
 
   pthread_mutex_unlock(&qset->mutex);
 
+  // the items written before are not known by the readers
+  if (atomic_load_32(&queue->numOfItems) > 0) taosWakeQsetReader(qset);
+
   return 0;
 }
 
@@ -294,11 +367,7 @@ void taosRemoveFromQset(taos_qset p1, taos_queue p2) {
     if (tqueue) {
       if (qset->current == queue) qset->current = tqueue->next;
       qset->numOfQueues--;
-
-      pthread_mutex_lock(&queue->mutex);
-      atomic_sub_fetch_32(&qset->numOfItems, queue->numOfItems);
-      queue->qset = NULL;
-      pthread_mutex_unlock(&queue->mutex);
+      atomic_store_ptr(&queue->qset, NULL);
     }
   } 
   
@@ -309,14 +378,103 @@ int taosGetQueueNumber(taos_qset param) {
   return ((STaosQset *)param)->numOfQueues;
 }
 
-int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phandle) {
-  STaosQset  *qset = (STaosQset *)param;
+void taosSetQueueLowPriority(taos_queue param) {
+  STaosQueue *queue = (STaosQueue *)param;
+  queue->lowPriority = 1;
+}
+
+// wake up one of the sleeping readers, if there is any
+static void taosWakeQsetReader(STaosQset *qset) {
+  int32_t waiters = atomic_load_32(&qset->numOfWaiters);
+  while (waiters > 0) {
+    int32_t old = atomic_val_compare_exchange_32(&qset->numOfWaiters, waiters, waiters - 1);
+    if (old == waiters) {
+      tsem_post(&qset->sem);
+      break;
+    }
+    waiters = old;
+  }
+}
+
+// the caller holds the mutex of the queue set
+static bool taosQsetHasReadyItems(STaosQset *qset) {
+  for (STaosQueue *queue = qset->head; queue != NULL; queue = queue->next) {
+    if (atomic_load_32(&queue->numOfItems) > 0 && !atomic_load_8(&queue->claimed)) return true;
+  }
+
+  return false;
+}
+
+// the caller holds the mutex of the queue set, it returns true if the reader shall return with nothing
+static bool taosQsetTakeResume(STaosQset *qset) {
+  int32_t resumes = atomic_load_32(&qset->numOfResumes);
+  while (resumes > 0) {
+    int32_t old = atomic_val_compare_exchange_32(&qset->numOfResumes, resumes, resumes - 1);
+    if (old == resumes) return true;
+    resumes = old;
+  }
+
+  return false;
+}
+
+/*
+ * The caller holds the mutex of the queue set and has found nothing to read, the mutex is released while it
+ * sleeps. The reader is counted as a waiter before it checks the queues and the resumes once more: a writer
+ * counts its item, and taosQsetThreadResume its resume, before checking the waiters, so either the reader
+ * sees the item or the writer sees the reader.
+ */
+static void taosWaitQsetItems(STaosQset *qset) {
+  atomic_add_fetch_32(&qset->numOfWaiters, 1);
+
+  if (taosQsetHasReadyItems(qset) || atomic_load_32(&qset->numOfResumes) > 0) {
+    // give up the wait, or take the post of the writer which has taken the reader off the waiters
+    int32_t waiters = atomic_load_32(&qset->numOfWaiters);
+    while (waiters > 0) {
+      int32_t old = atomic_val_compare_exchange_32(&qset->numOfWaiters, waiters, waiters - 1);
+      if (old == waiters) return;
+      waiters = old;
+    }
+  }
+
+  pthread_mutex_unlock(&qset->mutex);
+  tsem_wait(&qset->sem);
+  pthread_mutex_lock(&qset->mutex);
+}
+
+static int taosReadQitemFromQsetQueue(STaosQset *qset, STaosQueue *queue, int *type, void **pitem, void **phandle) {
   STaosQnode *pNode = NULL;
   int         code = 0;
-   
-  tsem_wait(&qset->sem);
 
-  pthread_mutex_lock(&qset->mutex);
+  pthread_mutex_lock(&queue->mutex);
+
+  if (atomic_load_32(&queue->numOfItems) > 0) {
+    pNode = taosTakeQnode(queue);
+    *pitem = pNode->item;
+    *type = pNode->type;
+    *phandle = queue->ahandle;
+    int32_t num = atomic_sub_fetch_32(&queue->numOfItems, 1);
+    code = 1;
+    uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, num);
+  } 
+
+  pthread_mutex_unlock(&queue->mutex);
+
+  return code; 
+}
+
+// the caller holds the mutex of the queue set
+static bool taosQsetHasLowItems(STaosQset *qset) {
+  for (STaosQueue *queue = qset->head; queue != NULL; queue = queue->next) {
+    if (queue->lowPriority && atomic_load_32(&queue->numOfItems) > 0) return true;
+  }
+
+  return false;
+}
+
+// the caller holds the mutex of the queue set
+static int taosReadQitemFromQsetQueues(STaosQset *qset, int *type, void **pitem, void **phandle) {
+  STaosQueue *lowQueue = NULL;
+  int         code = 0;
 
   for(int i=0; i<qset->numOfQueues; ++i) {
     if (qset->current == NULL) 
@@ -324,26 +482,43 @@ int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phand
     STaosQueue *queue = qset->current;
     if (queue) qset->current = queue->next;
     if (queue == NULL) break;
-    if (queue->head == NULL) continue;
+    if (atomic_load_32(&queue->numOfItems) == 0) continue;
 
-    pthread_mutex_lock(&queue->mutex);
+    // a low priority queue gives way to the other queues, unless its items have waited long enough
+    if (queue->lowPriority && qset->highReads < TAOS_QSET_MAX_HIGH_READS) {
+      if (lowQueue == NULL) lowQueue = queue;
+      continue;
+    }
 
-    if (queue->head) {
-        pNode = queue->head;
-        *pitem = pNode->item;
-        *type = pNode->type;
-        *phandle = queue->ahandle;
-        queue->head = pNode->next;
-        if (queue->head == NULL) 
-          queue->tail = NULL;
-        queue->numOfItems--;
-        atomic_sub_fetch_32(&qset->numOfItems, 1);
-        code = 1;
-        uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, queue->numOfItems);
-    } 
+    code = taosReadQitemFromQsetQueue(qset, queue, type, pitem, phandle);
+    if (code != 0) {
+      if (queue->lowPriority) {
+        qset->highReads = 0;
+      } else if (lowQueue != NULL || taosQsetHasLowItems(qset)) {
+        qset->highReads++;
+      }
+      break;
+    }
+  }
 
-    pthread_mutex_unlock(&queue->mutex);
-    if (pNode) break;
+  if (code == 0 && lowQueue != NULL) {
+    code = taosReadQitemFromQsetQueue(qset, lowQueue, type, pitem, phandle);
+    if (code != 0) qset->highReads = 0;
+  }
+
+  return code;
+}
+
+int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phandle) {
+  STaosQset  *qset = (STaosQset *)param;
+  int         code = 0;
+   
+  pthread_mutex_lock(&qset->mutex);
+
+  while (1) {
+    code = taosReadQitemFromQsetQueues(qset, type, pitem, phandle);
+    if (code != 0 || taosQsetTakeResume(qset)) break;
+    taosWaitQsetItems(qset);
   }
 
   pthread_mutex_unlock(&qset->mutex);
@@ -351,38 +526,28 @@ int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phand
   return code; 
 }
 
-int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
-  STaosQset  *qset = (STaosQset *)param;
+// the caller holds the mutex of the queue set, the queue read is claimed if pqueue is not NULL
+static int taosReadAllQitemsFromQsetQueues(STaosQset *qset, STaosQall *qall, void **phandle, taos_queue *pqueue) {
   STaosQueue *queue;
-  STaosQall  *qall = (STaosQall *)p2;
   int         code = 0;
 
-  tsem_wait(&qset->sem);
-  pthread_mutex_lock(&qset->mutex);
-
   for(int i=0; i<qset->numOfQueues; ++i) {
     if (qset->current == NULL) 
       qset->current = qset->head;   
     queue = qset->current;
     if (queue) qset->current = queue->next;
     if (queue == NULL) break;
-    if (queue->head == NULL) continue;
+    if (atomic_load_32(&queue->numOfItems) == 0 || queue->claimed) continue;
 
     pthread_mutex_lock(&queue->mutex);
 
-    if (queue->head) {
-      qall->current = queue->head;
-      qall->start = queue->head;
-      qall->numOfItems = queue->numOfItems;
-      qall->itemSize = queue->itemSize;
-      code = qall->numOfItems;
+    if (atomic_load_32(&queue->numOfItems) > 0) {
+      if (pqueue) {
+        atomic_store_8(&queue->claimed, 1);
+        *pqueue = queue;
+      }
+      code = taosTakeAllQnodes(queue, qall);
       *phandle = queue->ahandle;
-          
-      queue->head = NULL;
-      queue->tail = NULL;
-      queue->numOfItems = 0;
-      atomic_sub_fetch_32(&qset->numOfItems, qall->numOfItems);
-      for (int j=1; j<qall->numOfItems; ++j) tsem_wait(&qset->sem);
     } 
 
     pthread_mutex_unlock(&queue->mutex);
@@ -390,16 +555,75 @@ int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
     if (code != 0) break;  
   }
 
+  return code;
+}
+
+int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
+  STaosQset  *qset = (STaosQset *)param;
+  STaosQall  *qall = (STaosQall *)p2;
+  int         code = 0;
+
+  pthread_mutex_lock(&qset->mutex);
+
+  while (1) {
+    code = taosReadAllQitemsFromQsetQueues(qset, qall, phandle, NULL);
+    if (code != 0 || taosQsetTakeResume(qset)) break;
+    taosWaitQsetItems(qset);
+  }
+
+  pthread_mutex_unlock(&qset->mutex);
+  return code;
+}
+
+/*
+ * Like taosReadAllQitemsFromQset, but for several readers sharing the queue set: the queue read is claimed
+ * and skipped by the other readers, so the items of a queue are processed by one reader at a time and in
+ * order. The claim is given up by taosReleaseQueueClaim, any reader may claim the queue after that.
+ * It returns 0 if the reader is waked up with nothing to read, by taosQsetThreadResume for example.
+ */
+int taosClaimAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle, taos_queue *pqueue) {
+  STaosQset  *qset = (STaosQset *)param;
+  STaosQall  *qall = (STaosQall *)p2;
+  int         code = 0;
+
+  pthread_mutex_lock(&qset->mutex);
+
+  while (1) {
+    code = taosReadAllQitemsFromQsetQueues(qset, qall, phandle, pqueue);
+    if (code != 0 || taosQsetTakeResume(qset)) break;
+    taosWaitQsetItems(qset);
+  }
+
   pthread_mutex_unlock(&qset->mutex);
+
   return code;
 }
 
+void taosReleaseQueueClaim(taos_qset p1, taos_queue p2) {
+  STaosQset  *qset = (STaosQset *)p1;
+  STaosQueue *queue = (STaosQueue *)p2;
+
+  atomic_store_8(&queue->claimed, 0);
+
+  // the writers do not wake up a reader for the items arrived during the claim
+  if (atomic_load_32(&queue->numOfItems) > 0) taosWakeQsetReader(qset);
+}
+
 int taosGetQueueItemsNumber(taos_queue param) {
   STaosQueue *queue = (STaosQueue *)param;
-  return queue->numOfItems;
+  return atomic_load_32(&queue->numOfItems);
 }
 
+// the items are counted by the queues only, the writers of different queues do not share a counter
 int taosGetQsetItemsNumber(taos_qset param) {
   STaosQset *qset = (STaosQset *)param;
-  return qset->numOfItems;
+  int        num = 0;
+
+  pthread_mutex_lock(&qset->mutex);
+  for (STaosQueue *queue = qset->head; queue != NULL; queue = queue->next) {
+    num += atomic_load_32(&queue->numOfItems);
+  }
+  pthread_mutex_unlock(&qset->mutex);
+
+  return num;
 }
@@ -238,14 +238,16 @@ SSkipListNode *tSkipListPut(SSkipList *pSkipList, SSkipListNode *pNode) {
   // if the new key is greater than the maximum key of skip list, push back this node at the end of skip list
   char *newDatakey = SL_GET_NODE_KEY(pSkipList, pNode);
   if (pSkipList->size == 0 || pSkipList->comparFn(pSkipList->lastKey, newDatakey) < 0) {
-    return tSkipListPushBack(pSkipList, pNode);
+    tSkipListPushBack(pSkipList, pNode);
+    goto _exit;
   }
   
   // if the new key is less than the minimum key of skip list, push front this node at the front of skip list
   assert(pSkipList->size > 0);
   char* minKey = SL_GET_SL_MIN_KEY(pSkipList);
   if (pSkipList->comparFn(newDatakey, minKey) < 0) {
-    return tSkipListPushFront(pSkipList, pNode);
+    tSkipListPushFront(pSkipList, pNode);
+    goto _exit;
   }
   
   // find the appropriated position to insert data
@@ -273,17 +275,85 @@ SSkipListNode *tSkipListPut(SSkipList *pSkipList, SSkipListNode *pNode) {
 
   // if the skip list does not allowed identical key inserted, the new data will be discarded.
   if (pSkipList->keyInfo.dupKey == 0 && ret == 0) {
-    if (pSkipList->lock) {
-      pthread_rwlock_unlock(pSkipList->lock);
-    }
-
-    return forward[0];
+    pNode = forward[0];
+    goto _exit;
   }
   
   tSkipListDoInsert(pSkipList, forward, pNode);
+
+_exit:
+  if (pSkipList->lock) {
+    pthread_rwlock_unlock(pSkipList->lock);
+  }
+
   return pNode;
 }
 
+int32_t tSkipListPutBatch(SSkipList *pSkipList, SSkipListNode **pNodes, int32_t numOfNodes) {
+  if (pSkipList == NULL || pNodes == NULL || numOfNodes <= 0) {
+    return 0;
+  }
+
+  if (pSkipList->lock) {
+    pthread_rwlock_wrlock(pSkipList->lock);
+  }
+
+  // forward[i] is the last node on level i whose key is not greater than the key of the previous node in the run. Since
+  // the run is sorted, the search for the next node can start from there instead of from the head.
+  SSkipListNode *forward[MAX_SKIP_LIST_LEVEL] = {0};
+  for (int32_t i = 0; i < pSkipList->maxLevel; ++i) {
+    forward[i] = pSkipList->pHead;
+  }
+
+  int32_t numOfPut = 0;
+  for (int32_t n = 0; n < numOfNodes; ++n) {
+    SSkipListNode *pNode = pNodes[n];
+    char *         newDatakey = SL_GET_NODE_KEY(pSkipList, pNode);
+
+    // the node is not less than the maximum key, so are the rest of the run. Append it at the tail without searching,
+    // the nodes of a duplicated key are kept in the order of the run
+    int32_t ret = (pSkipList->size == 0) ? -1 : pSkipList->comparFn(pSkipList->lastKey, newDatakey);
+    if (ret < 0 || (ret == 0 && pSkipList->keyInfo.dupKey)) {
+      tSkipListPushBack(pSkipList, pNode);
+      numOfPut++;
+      continue;
+    }
+
+    SSkipListNode *px = forward[pSkipList->level - 1];
+    for (int32_t i = pSkipList->level - 1; i >= 0; --i) {
+      // the node found on the upper level may still be behind the one found for the previous node on this level
+      if (forward[i] != pSkipList->pHead &&
+          (px == pSkipList->pHead ||
+           pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, forward[i]), SL_GET_NODE_KEY(pSkipList, px)) > 0)) {
+        px = forward[i];
+      }
+
+      SSkipListNode *p = SL_GET_FORWARD_POINTER(px, i);
+      while (p != pSkipList->pTail && pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, p), newDatakey) <= 0) {
+        px = p;
+        p = SL_GET_FORWARD_POINTER(px, i);
+      }
+
+      forward[i] = px;
+    }
+
+    // identical key is discarded as in tSkipListPut
+    if (pSkipList->keyInfo.dupKey == 0 && forward[0] != pSkipList->pHead &&
+        pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, forward[0]), newDatakey) == 0) {
+      continue;
+    }
+
+    tSkipListDoInsert(pSkipList, forward, pNode);
+    numOfPut++;
+  }
+
+  if (pSkipList->lock) {
+    pthread_rwlock_unlock(pSkipList->lock);
+  }
+
+  return numOfPut;
+}
+
 
 
 SArray* tSkipListGet(SSkipList *pSkipList, SSkipListKey key) {
@@ -670,9 +740,6 @@ void tSkipListDoInsert(SSkipList *pSkipList, SSkipListNode **forward, SSkipListN
   }
   
   atomic_add_fetch_32(&pSkipList->size, 1);
-  if (pSkipList->lock) {
-    pthread_rwlock_unlock(pSkipList->lock);
-  }
 }
 
 SSkipListNode* tSkipListPushFront(SSkipList* pSkipList, SSkipListNode *pNode) {
@@ -701,10 +768,6 @@ SSkipListNode* tSkipListPushBack(SSkipList *pSkipList, SSkipListNode *pNode) {
   pSkipList->lastKey = SL_GET_NODE_KEY(pSkipList, pNode);
   
   atomic_add_fetch_32(&pSkipList->size, 1);
-  if (pSkipList->lock) {
-    pthread_rwlock_unlock(pSkipList->lock);
-  }
-  
   return pNode;
 }
 
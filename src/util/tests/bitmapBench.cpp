@@ -0,0 +1,245 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "os.h"
+#include "tbitmap.h"
+#include "ttime.h"
+
+/*
+ * Time to find the child tables satisfying multi-term tag conditions, in ms. Each table has 4 tags of different
+ * cardinalities, and an index on each of them gives the tables of a tag value. The conditions are answered by:
+ *   filter: the tables of the first term got from its index, the rest of the terms applied on each of them
+ *   array:  the tables of each term got from its index, sorted and merged, or intersected
+ *   bitmap: the tables of each term set in a bitmap, and the bitmaps combined a word at a time
+ *
+ * usage: bitmapBench [numOfTables] [rounds]
+ */
+
+namespace {
+
+const int numOfTags = 4;
+const int cardinality[numOfTags] = {10, 100, 1000, 16};
+
+typedef struct {
+  int32_t tag[numOfTags];
+} STableTags;
+
+typedef struct {
+  int32_t *ids;  // the tables of each value, the index on the tag
+  int32_t *offset;
+} STagIndex;
+
+// a term is tag = value, or tag < value
+typedef struct {
+  int tag;
+  int value;
+  bool less;
+} STerm;
+
+// terms[0] op terms[1] op terms[2], where op is AND or OR, the first term is always ANDed with the rest
+typedef struct {
+  const char *name;
+  int         numOfTerms;
+  STerm       terms[3];
+  bool        orRest;  // t0 AND (t1 OR t2)
+} SCond;
+
+const SCond conds[] = {
+    {"t0 = 3 and t1 = 7", 2, {{0, 3, false}, {1, 7, false}}, false},
+    {"t0 = 3 and t3 < 8 and t2 < 500", 3, {{0, 3, false}, {3, 8, true}, {2, 500, true}}, false},
+    {"t3 < 8 and (t1 = 7 or t2 < 100)", 3, {{3, 8, true}, {1, 7, false}, {2, 100, true}}, true},
+    {"t0 < 9 and t3 < 15", 2, {{0, 9, true}, {3, 15, true}}, false},
+};
+
+STableTags *tables;
+STagIndex   indexes[numOfTags];
+int32_t     numOfTables;
+
+void buildIndexes() {
+  for (int t = 0; t < numOfTags; ++t) {
+    STagIndex *pIndex = indexes + t;
+    pIndex->ids = (int32_t *)malloc(sizeof(int32_t) * numOfTables);
+    pIndex->offset = (int32_t *)calloc(cardinality[t] + 1, sizeof(int32_t));
+
+    for (int32_t i = 0; i < numOfTables; ++i) pIndex->offset[tables[i].tag[t] + 1]++;
+    for (int v = 0; v < cardinality[t]; ++v) pIndex->offset[v + 1] += pIndex->offset[v];
+
+    int32_t *pos = (int32_t *)malloc(sizeof(int32_t) * cardinality[t]);
+    memcpy(pos, pIndex->offset, sizeof(int32_t) * cardinality[t]);
+    for (int32_t i = 0; i < numOfTables; ++i) pIndex->ids[pos[tables[i].tag[t]]++] = i;
+    free(pos);
+  }
+}
+
+// the tables of the term are indexes[tag].ids[*start, *end), in the order of the tag value
+void lookup(const STerm *pTerm, int32_t *start, int32_t *end) {
+  STagIndex *pIndex = indexes + pTerm->tag;
+  *start = pTerm->less ? 0 : pIndex->offset[pTerm->value];
+  *end = pIndex->offset[pTerm->less ? pTerm->value : pTerm->value + 1];
+}
+
+bool match(const STerm *pTerm, int32_t id) {
+  int32_t v = tables[id].tag[pTerm->tag];
+  return pTerm->less ? (v < pTerm->value) : (v == pTerm->value);
+}
+
+int32_t runFilter(const SCond *pCond) {
+  int32_t start, end, num = 0;
+  lookup(pCond->terms, &start, &end);
+
+  for (int32_t i = start; i < end; ++i) {
+    int32_t id = indexes[pCond->terms[0].tag].ids[i];
+    bool    rest = pCond->orRest ? (match(pCond->terms + 1, id) || match(pCond->terms + 2, id)) : true;
+    for (int t = 1; !pCond->orRest && t < pCond->numOfTerms; ++t) rest = rest && match(pCond->terms + t, id);
+    if (rest) num++;
+  }
+
+  return num;
+}
+
+int compareId(const void *p1, const void *p2) { return *(int32_t *)p1 - *(int32_t *)p2; }
+
+int32_t *sortedIds(const STerm *pTerm, int32_t *num) {
+  int32_t start, end;
+  lookup(pTerm, &start, &end);
+
+  *num = end - start;
+  int32_t *ids = (int32_t *)malloc(sizeof(int32_t) * (*num + 1));
+  memcpy(ids, indexes[pTerm->tag].ids + start, sizeof(int32_t) * (*num));
+  qsort(ids, *num, sizeof(int32_t), compareId);
+  return ids;
+}
+
+int32_t intersect(int32_t *left, int32_t numOfLeft, const int32_t *right, int32_t numOfRight) {
+  int32_t i = 0, j = 0, num = 0;
+  while (i < numOfLeft && j < numOfRight) {
+    if (left[i] < right[j]) {
+      i++;
+    } else if (left[i] > right[j]) {
+      j++;
+    } else {
+      left[num++] = left[i++];
+      j++;
+    }
+  }
+  return num;
+}
+
+int32_t merge(const int32_t *left, int32_t numOfLeft, const int32_t *right, int32_t numOfRight, int32_t *res) {
+  int32_t i = 0, j = 0, num = 0;
+  while (i < numOfLeft || j < numOfRight) {
+    if (j == numOfRight || (i < numOfLeft && left[i] < right[j])) {
+      res[num++] = left[i++];
+    } else if (i == numOfLeft || left[i] > right[j]) {
+      res[num++] = right[j++];
+    } else {
+      res[num++] = left[i++];
+      j++;
+    }
+  }
+  return num;
+}
+
+int32_t runArray(const SCond *pCond) {
+  int32_t  num, numOfRight, numOfOther;
+  int32_t *ids = sortedIds(pCond->terms, &num);
+  int32_t *right = sortedIds(pCond->terms + 1, &numOfRight);
+
+  if (pCond->orRest) {
+    int32_t *other = sortedIds(pCond->terms + 2, &numOfOther);
+    int32_t *merged = (int32_t *)malloc(sizeof(int32_t) * (numOfRight + numOfOther + 1));
+    int32_t  numOfMerged = merge(right, numOfRight, other, numOfOther, merged);
+    num = intersect(ids, num, merged, numOfMerged);
+    free(merged);
+    free(other);
+  } else {
+    num = intersect(ids, num, right, numOfRight);
+    for (int t = 2; t < pCond->numOfTerms; ++t) {
+      int32_t *other = sortedIds(pCond->terms + t, &numOfOther);
+      num = intersect(ids, num, other, numOfOther);
+      free(other);
+    }
+  }
+
+  free(right);
+  free(ids);
+  return num;
+}
+
+void setBits(const STerm *pTerm, SBitmap *pBitmap) {
+  int32_t start, end;
+  lookup(pTerm, &start, &end);
+
+  taosBitmapClear(pBitmap);
+  for (int32_t i = start; i < end; ++i) taosBitmapSet(pBitmap, indexes[pTerm->tag].ids[i]);
+}
+
+int32_t runBitmap(const SCond *pCond) {
+  SBitmap *pResult = taosBitmapCreate(numOfTables);
+  SBitmap *pTerm = taosBitmapCreate(numOfTables);
+
+  setBits(pCond->terms, pResult);
+  if (pCond->orRest) {
+    SBitmap *pOther = taosBitmapCreate(numOfTables);
+    setBits(pCond->terms + 1, pTerm);
+    setBits(pCond->terms + 2, pOther);
+    taosBitmapOr(pTerm, pOther);
+    taosBitmapAnd(pResult, pTerm);
+    taosBitmapDestroy(pOther);
+  } else {
+    for (int t = 1; t < pCond->numOfTerms; ++t) {
+      setBits(pCond->terms + t, pTerm);
+      taosBitmapAnd(pResult, pTerm);
+    }
+  }
+
+  int32_t num = taosBitmapCount(pResult);
+  taosBitmapDestroy(pTerm);
+  taosBitmapDestroy(pResult);
+  return num;
+}
+
+double timeIt(int32_t (*fp)(const SCond *), const SCond *pCond, int rounds, int32_t *num) {
+  int64_t start = taosGetTimestampUs();
+  for (int r = 0; r < rounds; ++r) *num = fp(pCond);
+  return (taosGetTimestampUs() - start) / 1000.0 / rounds;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  numOfTables = (argc > 1) ? atoi(argv[1]) : 1000000;
+  int rounds = (argc > 2) ? atoi(argv[2]) : 10;
+
+  srand(0);
+  tables = (STableTags *)malloc(sizeof(STableTags) * numOfTables);
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    for (int t = 0; t < numOfTags; ++t) tables[i].tag[t] = rand() % cardinality[t];
+  }
+  buildIndexes();
+
+  printf("%-36s %10s %10s %10s %10s  (ms, %d tables)\n", "condition", "tables", "filter", "array", "bitmap",
+         numOfTables);
+
+  for (int c = 0; c < sizeof(conds) / sizeof(conds[0]); ++c) {
+    int32_t numOfFilter, numOfArray, numOfBitmap;
+    double  filter = timeIt(runFilter, conds + c, rounds, &numOfFilter);
+    double  array = timeIt(runArray, conds + c, rounds, &numOfArray);
+    double  bitmap = timeIt(runBitmap, conds + c, rounds, &numOfBitmap);
+
+    if (numOfFilter != numOfArray || numOfFilter != numOfBitmap) {
+      printf("%s: mismatched results %d %d %d\n", conds[c].name, numOfFilter, numOfArray, numOfBitmap);
+      return 1;
+    }
+    printf("%-36s %10d %10.3f %10.3f %10.3f\n", conds[c].name, numOfFilter, filter, array, bitmap);
+  }
+
+  for (int t = 0; t < numOfTags; ++t) {
+    free(indexes[t].ids);
+    free(indexes[t].offset);
+  }
+  free(tables);
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "os.h"
+#include "tbitmap.h"
+
+// The bits out of the last word are never set, so the bitmap of any number of bits is counted and iterated correctly
+TEST(BitmapTest, setAndNext) {
+  const int32_t sizes[] = {1, 63, 64, 65, 1000};
+
+  for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+    SBitmap *pBitmap = taosBitmapCreate(sizes[s]);
+    ASSERT_TRUE(pBitmap != NULL);
+    EXPECT_EQ(taosBitmapCount(pBitmap), 0);
+    EXPECT_EQ(taosBitmapNext(pBitmap, 0), -1);
+
+    int32_t num = 0;
+    for (int32_t i = 0; i < sizes[s]; i += 3, ++num) taosBitmapSet(pBitmap, i);
+    EXPECT_EQ(taosBitmapCount(pBitmap), num);
+
+    int32_t expected = 0;
+    for (int32_t i = taosBitmapNext(pBitmap, 0); i >= 0; i = taosBitmapNext(pBitmap, i + 1), expected += 3) {
+      EXPECT_EQ(i, expected);
+      EXPECT_TRUE(taosBitmapGet(pBitmap, i));
+    }
+    EXPECT_EQ(expected, num * 3);
+
+    taosBitmapUnset(pBitmap, 0);
+    EXPECT_FALSE(taosBitmapGet(pBitmap, 0));
+    EXPECT_EQ(taosBitmapNext(pBitmap, 0), (sizes[s] > 3) ? 3 : -1);
+
+    taosBitmapClear(pBitmap);
+    EXPECT_EQ(taosBitmapCount(pBitmap), 0);
+    taosBitmapDestroy(pBitmap);
+  }
+}
+
+TEST(BitmapTest, andOr) {
+  const int32_t numOfBits = 200;
+  SBitmap      *pEven = taosBitmapCreate(numOfBits);
+  SBitmap      *pThree = taosBitmapCreate(numOfBits);
+  SBitmap      *pResult = taosBitmapCreate(numOfBits);
+
+  for (int32_t i = 0; i < numOfBits; ++i) {
+    if (i % 2 == 0) taosBitmapSet(pEven, i);
+    if (i % 3 == 0) taosBitmapSet(pThree, i);
+  }
+
+  taosBitmapCopy(pResult, pEven);
+  taosBitmapAnd(pResult, pThree);
+  for (int32_t i = 0; i < numOfBits; ++i) EXPECT_EQ(taosBitmapGet(pResult, i), i % 6 == 0) << "bit:" << i;
+  EXPECT_EQ(taosBitmapCount(pResult), 34);
+
+  taosBitmapCopy(pResult, pEven);
+  taosBitmapOr(pResult, pThree);
+  for (int32_t i = 0; i < numOfBits; ++i) EXPECT_EQ(taosBitmapGet(pResult, i), i % 2 == 0 || i % 3 == 0) << "bit:" << i;
+  EXPECT_EQ(taosBitmapCount(pResult), 133);
+
+  taosBitmapDestroy(pEven);
+  taosBitmapDestroy(pThree);
+  taosBitmapDestroy(pResult);
+}
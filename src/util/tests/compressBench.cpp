@@ -0,0 +1,130 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#include "tscompression.h"
+#include "ttime.h"
+
+/*
+ * Decompression throughput of the integer and timestamp kernels, in GB/s of decompressed data.
+ *
+ * usage: compressBench [numOfRows] [rounds]
+ */
+
+namespace {
+
+const char *levelNames[] = {"scalar", "sse4.1", "avx2"};
+
+typedef struct {
+  const char *name;
+  char        type;
+  int         bytes;
+  int64_t     maxDelta;
+} SBenchCase;
+
+void genData(const SBenchCase *pCase, int numOfRows, std::mt19937_64 &rng, char *data) {
+  int64_t value = 1500000000000L;
+  for (int i = 0; i < numOfRows; i++) {
+    int64_t delta = (int64_t)(rng() % (2 * pCase->maxDelta + 1)) - pCase->maxDelta;
+    if (pCase->type == TSDB_DATA_TYPE_TIMESTAMP) {
+      value += 1000;
+      ((int64_t *)data)[i] = value + ((rng() % 4 == 0) ? delta : 0);
+      continue;
+    }
+
+    value += delta;
+    switch (pCase->type) {
+      case TSDB_DATA_TYPE_TINYINT:
+        ((int8_t *)data)[i] = (int8_t)value;
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        ((int16_t *)data)[i] = (int16_t)value;
+        break;
+      case TSDB_DATA_TYPE_INT:
+        ((int32_t *)data)[i] = (int32_t)value;
+        break;
+      default:
+        ((int64_t *)data)[i] = value;
+        break;
+    }
+  }
+}
+
+int compress(const SBenchCase *pCase, const char *data, int numOfRows, char *comp) {
+  if (pCase->type == TSDB_DATA_TYPE_TIMESTAMP) return tsCompressTimestampImp(data, numOfRows, comp);
+  return tsCompressINTImp(data, numOfRows, comp, pCase->type);
+}
+
+int decompress(const SBenchCase *pCase, const char *comp, int numOfRows, char *output) {
+  if (pCase->type == TSDB_DATA_TYPE_TIMESTAMP) return tsDecompressTimestampImp(comp, numOfRows, output);
+  return tsDecompressINTImp(comp, numOfRows, output, pCase->type);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int numOfRows = (argc > 1) ? atoi(argv[1]) : 4096;
+  int rounds = (argc > 2) ? atoi(argv[2]) : 5000;
+
+  // the deltas decide the values per simple8b word, from 60 values with delta 1 down to 3 with delta 100000
+  SBenchCase cases[] = {
+      {"tinyint", TSDB_DATA_TYPE_TINYINT, CHAR_BYTES, 3},
+      {"smallint", TSDB_DATA_TYPE_SMALLINT, SHORT_BYTES, 100},
+      {"int", TSDB_DATA_TYPE_INT, INT_BYTES, 1},
+      {"int", TSDB_DATA_TYPE_INT, INT_BYTES, 1000},
+      {"bigint", TSDB_DATA_TYPE_BIGINT, LONG_BYTES, 1},
+      {"bigint", TSDB_DATA_TYPE_BIGINT, LONG_BYTES, 30},
+      {"bigint", TSDB_DATA_TYPE_BIGINT, LONG_BYTES, 100000},
+      {"timestamp", TSDB_DATA_TYPE_TIMESTAMP, LONG_BYTES, 50},
+  };
+
+  std::mt19937_64 rng(20170714);
+  char *data = (char *)malloc((size_t)numOfRows * LONG_BYTES);
+  char *comp = (char *)malloc((size_t)numOfRows * LONG_BYTES * 2 + 16);
+  char *output = (char *)malloc((size_t)numOfRows * LONG_BYTES);
+
+  printf("%-10s %8s %8s %8s", "type", "delta", "rows", "ratio");
+  for (int level = TAOS_SIMD_NONE; level <= TAOS_SIMD_AVX2; level++) printf(" %10s", levelNames[level]);
+  printf("  (GB/s)\n");
+
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    SBenchCase *pCase = cases + c;
+    genData(pCase, numOfRows, rng, data);
+    int compSize = compress(pCase, data, numOfRows, comp);
+    int rawSize = numOfRows * pCase->bytes;
+
+    printf("%-10s %8" PRId64 " %8d %8.2f", pCase->name, pCase->maxDelta, numOfRows, (double)rawSize / compSize);
+    for (int level = TAOS_SIMD_NONE; level <= TAOS_SIMD_AVX2; level++) {
+      if (taosResolveDecompress(level) != level) {
+        printf(" %10s", "-");
+        continue;
+      }
+
+      decompress(pCase, comp, numOfRows, output);
+      if (memcmp(data, output, rawSize) != 0) {
+        printf(" %10s", "mismatch");
+        continue;
+      }
+
+      // the best of several runs, to filter out the noise of the other processes
+      int64_t elapsed = INT64_MAX;
+      for (int run = 0; run < 5; run++) {
+        int64_t start = taosGetTimestampUs();
+        for (int r = 0; r < rounds; r++) decompress(pCase, comp, numOfRows, output);
+        int64_t runTime = taosGetTimestampUs() - start;
+        if (runTime < elapsed) elapsed = runTime;
+      }
+      printf(" %10.3f", (double)rawSize * rounds / (elapsed > 0 ? elapsed : 1) / 1000.0);
+    }
+    printf("\n");
+  }
+
+  taosResolveDecompress(TAOS_SIMD_NONE);
+  free(data);
+  free(comp);
+  free(output);
+  return 0;
+}
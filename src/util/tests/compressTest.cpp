@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#include "tscompression.h"
+
+namespace {
+
+const int levels[] = {TAOS_SIMD_NONE, TAOS_SIMD_SSE41, TAOS_SIMD_AVX2};
+
+// Values of the integer type with deltas up to maxDelta, so that the words of all the selectors are produced
+void genIntegers(char type, int nelements, int64_t maxDelta, std::mt19937_64 &rng, char *data) {
+  int64_t value = 0;
+  for (int i = 0; i < nelements; i++) {
+    int64_t delta = (maxDelta == 0) ? 0 : (int64_t)(rng() % (2 * maxDelta + 1)) - maxDelta;
+    if (rng() % 8 == 0) delta = 0;
+    value += delta;
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT:
+        ((int8_t *)data)[i] = (int8_t)value;
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        ((int16_t *)data)[i] = (int16_t)value;
+        break;
+      case TSDB_DATA_TYPE_INT:
+        ((int32_t *)data)[i] = (int32_t)value;
+        break;
+      default:
+        ((int64_t *)data)[i] = value;
+        break;
+    }
+  }
+}
+
+// Timestamps with a fixed interval and jitter up to maxJitter
+void genTimestamps(int nelements, int64_t maxJitter, std::mt19937_64 &rng, int64_t *data) {
+  int64_t ts = 1500000000000L;
+  for (int i = 0; i < nelements; i++) {
+    int64_t jitter = (maxJitter == 0) ? 0 : (int64_t)(rng() % (2 * maxJitter + 1)) - maxJitter;
+    data[i] = ts + jitter;
+    ts += 1000;
+  }
+}
+
+}  // namespace
+
+// The vector kernels decode the same values as the scalar kernel
+TEST(CompressTest, decompressIntegerKernels) {
+  const char types[] = {TSDB_DATA_TYPE_TINYINT, TSDB_DATA_TYPE_SMALLINT, TSDB_DATA_TYPE_INT, TSDB_DATA_TYPE_BIGINT};
+  const int  bytes[] = {CHAR_BYTES, SHORT_BYTES, INT_BYTES, LONG_BYTES};
+  const int64_t deltas[] = {0, 1, 3, 100, 1000, 1L << 20, 1L << 40, 1L << 56};
+  const int  sizes[] = {1, 3, 7, 239, 240, 241, 4096};
+
+  std::mt19937_64 rng(20170714);
+  char *data = (char *)malloc(4096 * LONG_BYTES);
+  char *comp = (char *)malloc(4096 * LONG_BYTES * 2 + 16);
+  char *expected = (char *)malloc(4096 * LONG_BYTES);
+  char *output = (char *)malloc(4096 * LONG_BYTES);
+
+  for (int t = 0; t < 4; t++) {
+    for (int64_t maxDelta : deltas) {
+      for (int nelements : sizes) {
+        genIntegers(types[t], nelements, maxDelta, rng, data);
+        tsCompressINTImp(data, nelements, comp, types[t]);
+
+        taosResolveDecompress(TAOS_SIMD_NONE);
+        ASSERT_EQ(tsDecompressINTImp(comp, nelements, expected, types[t]), nelements * bytes[t]);
+        ASSERT_EQ(memcmp(data, expected, nelements * bytes[t]), 0);
+
+        for (int level : levels) {
+          int used = taosResolveDecompress(level);
+          ASSERT_LE(used, level);
+          memset(output, 0, nelements * bytes[t]);
+          ASSERT_EQ(tsDecompressINTImp(comp, nelements, output, types[t]), nelements * bytes[t]);
+          ASSERT_EQ(memcmp(expected, output, nelements * bytes[t]), 0)
+              << "type:" << (int)types[t] << " delta:" << maxDelta << " elements:" << nelements << " level:" << used;
+        }
+      }
+    }
+  }
+
+  taosResolveDecompress(TAOS_SIMD_NONE);
+  free(data);
+  free(comp);
+  free(expected);
+  free(output);
+}
+
+TEST(CompressTest, decompressTimestampKernels) {
+  const int64_t jitters[] = {0, 1, 100, 1L << 20, 1L << 40};
+  const int     sizes[] = {1, 2, 3, 33, 34, 35, 36, 37, 1000, 4097};
+
+  std::mt19937_64 rng(20170715);
+  int64_t *data = (int64_t *)malloc(4097 * LONG_BYTES);
+  char    *comp = (char *)malloc(4097 * LONG_BYTES + 16);
+  int64_t *expected = (int64_t *)malloc(4097 * LONG_BYTES);
+  int64_t *output = (int64_t *)malloc(4097 * LONG_BYTES);
+
+  for (int64_t maxJitter : jitters) {
+    for (int nelements : sizes) {
+      genTimestamps(nelements, maxJitter, rng, data);
+      int compSize = tsCompressTimestampImp((char *)data, nelements, comp);
+
+      // the vector loads must stay within the compressed data, check it with an exact copy
+      char *exact = (char *)malloc(compSize);
+      memcpy(exact, comp, compSize);
+
+      taosResolveDecompress(TAOS_SIMD_NONE);
+      ASSERT_EQ(tsDecompressTimestampImp(exact, nelements, (char *)expected), nelements * LONG_BYTES);
+      ASSERT_EQ(memcmp(data, expected, nelements * LONG_BYTES), 0);
+
+      for (int level : levels) {
+        int used = taosResolveDecompress(level);
+        memset(output, 0, nelements * LONG_BYTES);
+        ASSERT_EQ(tsDecompressTimestampImp(exact, nelements, (char *)output), nelements * LONG_BYTES);
+        ASSERT_EQ(memcmp(expected, output, nelements * LONG_BYTES), 0)
+            << "jitter:" << maxJitter << " elements:" << nelements << " level:" << used;
+      }
+      free(exact);
+    }
+  }
+
+  taosResolveDecompress(TAOS_SIMD_NONE);
+  free(data);
+  free(comp);
+  free(expected);
+  free(output);
+}
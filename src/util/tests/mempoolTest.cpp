@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "os.h"
+#include "tmempool.h"
+
+namespace {
+
+const int numOfBuffers = 10000;
+
+// the buffers are allocated by one thread and freed by another, as the queue items are
+void *freeBuffers(void *param) {
+  char **buffers = (char **)param;
+  for (int i = 0; i < numOfBuffers; ++i) {
+    if (buffers[i][0] != (char)i) buffers[i] = NULL;
+    taosSlabFree(buffers[i]);
+  }
+  return NULL;
+}
+
+}  // namespace
+
+TEST(MempoolTest, slabAllocFree) {
+  SSlabStatis before, after;
+  taosGetSlabStatis(&before);
+
+  char **buffers = (char **)malloc(sizeof(char *) * numOfBuffers);
+  for (int i = 0; i < numOfBuffers; ++i) {
+    buffers[i] = (char *)taosSlabCalloc(1 + i % 5000);
+    ASSERT_NE(buffers[i], (char *)NULL);
+    EXPECT_EQ(buffers[i][i % 5000], 0);
+    buffers[i][0] = (char)i;
+  }
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, freeBuffers, buffers);
+  pthread_join(thread, NULL);
+  for (int i = 0; i < numOfBuffers; ++i) EXPECT_NE(buffers[i], (char *)NULL) << "buffer:" << i;
+  free(buffers);
+
+  taosGetSlabStatis(&after);
+  EXPECT_EQ(after.numOfAllocs - before.numOfAllocs, numOfBuffers);
+  EXPECT_EQ(after.numOfFrees - before.numOfFrees, numOfBuffers);
+  EXPECT_EQ(after.usedBytes, before.usedBytes);
+  EXPECT_GT(after.reservedBytes, 0);
+}
+
+TEST(MempoolTest, slabRealloc) {
+  char *p = (char *)taosSlabMalloc(10);
+  memcpy(p, "0123456789", 10);
+
+  // within the size class, then to a bigger class, then to a large buffer
+  p = (char *)taosSlabRealloc(p, 20);
+  p = (char *)taosSlabRealloc(p, 1000);
+  p = (char *)taosSlabRealloc(p, 1024 * 1024);
+  ASSERT_NE(p, (char *)NULL);
+  EXPECT_EQ(memcmp(p, "0123456789", 10), 0);
+
+  p = (char *)taosSlabRealloc(p, 5);
+  EXPECT_EQ(memcmp(p, "01234", 5), 0);
+  taosSlabFree(p);
+}
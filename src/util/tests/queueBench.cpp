@@ -0,0 +1,126 @@
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "os.h"
+#include "tqueue.h"
+#include "ttime.h"
+
+/*
+ * Throughput of a queue written by 1 to 64 threads, in million items per second. The items are read out of the
+ * queue set one by one, all at once, and one by one by several readers.
+ *
+ * usage: queueBench [numOfItems] [maxProducers]
+ */
+
+namespace {
+
+const int numOfModes = 3;
+const char *modeNames[] = {"read", "readAll", "4 readers"};
+const int readersOfMode[] = {1, 1, 4};
+
+typedef struct {
+  taos_queue queue;
+  void     **items;
+  int32_t    numOfItems;
+} SProducer;
+
+typedef struct {
+  taos_qset qset;
+  int       mode;
+  int32_t   total;
+  int32_t   processed;
+} SConsumer;
+
+void *produce(void *param) {
+  SProducer *pProducer = (SProducer *)param;
+  for (int32_t i = 0; i < pProducer->numOfItems; ++i) taosWriteQitem(pProducer->queue, 0, pProducer->items[i]);
+  return NULL;
+}
+
+void *consume(void *param) {
+  SConsumer *pConsumer = (SConsumer *)param;
+  taos_qall  qall = taosAllocateQall();
+  void      *ahandle, *item;
+  int        type;
+
+  while (atomic_load_32(&pConsumer->processed) < pConsumer->total) {
+    int num;
+    if (pConsumer->mode == 1) {
+      num = taosReadAllQitemsFromQset(pConsumer->qset, qall, &ahandle);
+    } else {
+      num = taosReadQitemFromQset(pConsumer->qset, &type, &item, &ahandle);
+    }
+    if (num == 0) break;
+    atomic_add_fetch_32(&pConsumer->processed, num);
+  }
+
+  taosFreeQall(qall);
+  return NULL;
+}
+
+// the items are allocated before, only the queue is timed
+double run(int numOfProducers, int mode, void **items, int32_t numOfItems) {
+  SProducer *producers = (SProducer *)calloc(numOfProducers, sizeof(SProducer));
+  pthread_t *pthreads = (pthread_t *)calloc(numOfProducers, sizeof(pthread_t));
+  pthread_t  cthreads[4];
+  SConsumer  consumer = {0};
+  taos_queue queue = taosOpenQueue();
+
+  consumer.qset = taosOpenQset();
+  consumer.mode = mode;
+  consumer.total = numOfItems / numOfProducers * numOfProducers;
+  taosAddIntoQset(consumer.qset, queue, NULL);
+
+  for (int i = 0; i < readersOfMode[mode]; ++i) pthread_create(cthreads + i, NULL, consume, &consumer);
+
+  int64_t start = taosGetTimestampUs();
+  for (int i = 0; i < numOfProducers; ++i) {
+    producers[i].queue = queue;
+    producers[i].numOfItems = numOfItems / numOfProducers;
+    producers[i].items = items + (int64_t)i * producers[i].numOfItems;
+    pthread_create(pthreads + i, NULL, produce, producers + i);
+  }
+  for (int i = 0; i < numOfProducers; ++i) pthread_join(pthreads[i], NULL);
+  while (atomic_load_32(&consumer.processed) < consumer.total) sched_yield();
+  int64_t elapsed = taosGetTimestampUs() - start;
+
+  for (int i = 0; i < readersOfMode[mode]; ++i) taosQsetThreadResume(consumer.qset);
+  for (int i = 0; i < readersOfMode[mode]; ++i) pthread_join(cthreads[i], NULL);
+
+  taosRemoveFromQset(consumer.qset, queue);
+  taosCloseQset(consumer.qset);
+  free(pthreads);
+  free(producers);
+
+  // the queue frees the items left, none is left here
+  taosCloseQueue(queue);
+
+  return (double)consumer.total / (elapsed > 0 ? elapsed : 1);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int32_t numOfItems = (argc > 1) ? atoi(argv[1]) : 2000000;
+  int     maxProducers = (argc > 2) ? atoi(argv[2]) : 64;
+
+  void **items = (void **)malloc(sizeof(void *) * numOfItems);
+  for (int32_t i = 0; i < numOfItems; ++i) items[i] = taosAllocateQitem(sizeof(int64_t));
+
+  printf("%-10s %10s", "producers", "items");
+  for (int mode = 0; mode < numOfModes; ++mode) printf(" %10s", modeNames[mode]);
+  printf("  (M items/s)\n");
+
+  for (int producers = 1; producers <= maxProducers; producers *= 2) {
+    printf("%-10d %10d", producers, numOfItems);
+    for (int mode = 0; mode < numOfModes; ++mode) printf(" %10.3f", run(producers, mode, items, numOfItems));
+    printf("\n");
+  }
+
+  for (int32_t i = 0; i < numOfItems; ++i) taosFreeQitem(items[i]);
+  free(items);
+  return 0;
+}
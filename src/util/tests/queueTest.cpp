@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "os.h"
+#include "tqueue.h"
+
+namespace {
+
+const int numOfQueues = 8;
+const int numOfReaders = 4;
+const int itemsPerQueue = 20000;
+
+typedef struct {
+  taos_queue queue;
+  int32_t    expected;  // sequence of the next item
+  int32_t    owner;     // readers processing the queue, it shall never be more than one
+  int32_t    errors;
+} SQueueInfo;
+
+typedef struct {
+  taos_qset   qset;
+  SQueueInfo *queues;
+  int32_t     stop;
+  int32_t     processed;
+} SQsetInfo;
+
+void *claimItems(void *param) {
+  SQsetInfo *pInfo = (SQsetInfo *)param;
+  taos_qall  qall = taosAllocateQall();
+  taos_queue queue;
+  void      *ahandle, *item;
+  int        type;
+
+  while (1) {
+    int num = taosClaimAllQitemsFromQset(pInfo->qset, qall, &ahandle, &queue);
+    if (num == 0) {
+      if (atomic_load_32(&pInfo->stop)) break;
+      continue;
+    }
+
+    SQueueInfo *pQueue = (SQueueInfo *)ahandle;
+    if (atomic_add_fetch_32(&pQueue->owner, 1) != 1) atomic_add_fetch_32(&pQueue->errors, 1);
+
+    for (int i = 0; i < num; ++i) {
+      taosGetQitem(qall, &type, &item);
+      if (*(int32_t *)item != pQueue->expected) atomic_add_fetch_32(&pQueue->errors, 1);
+      pQueue->expected = *(int32_t *)item + 1;
+      taosFreeQitem(item);
+    }
+
+    atomic_sub_fetch_32(&pQueue->owner, 1);
+    taosReleaseQueueClaim(pInfo->qset, queue);
+    atomic_add_fetch_32(&pInfo->processed, num);
+  }
+
+  taosFreeQall(qall);
+  return NULL;
+}
+
+void *writeItems(void *param) {
+  SQueueInfo *pQueue = (SQueueInfo *)param;
+  for (int32_t i = 0; i < itemsPerQueue; ++i) {
+    int32_t *item = (int32_t *)taosAllocateQitem(sizeof(int32_t));
+    *item = i;
+    taosWriteQitem(pQueue->queue, 0, item);
+  }
+  return NULL;
+}
+
+const int numOfProducers = 8;
+
+typedef struct {
+  taos_queue queue;
+  int32_t    producer;
+} SProducerInfo;
+
+typedef struct {
+  taos_qset qset;
+  int32_t   ordered;                   // a single reader, which gets the items of each producer in order
+  int32_t   expected[numOfProducers];  // sequence of the next item of each producer
+  int32_t   errors;
+  int32_t   processed;
+} SConsumerInfo;
+
+// an item holds the producer and its sequence
+void *produceItems(void *param) {
+  SProducerInfo *pInfo = (SProducerInfo *)param;
+  for (int32_t i = 0; i < itemsPerQueue; ++i) {
+    int32_t *item = (int32_t *)taosAllocateQitem(sizeof(int32_t) * 2);
+    item[0] = pInfo->producer;
+    item[1] = i;
+    taosWriteQitem(pInfo->queue, 0, item);
+  }
+  return NULL;
+}
+
+void *consumeItems(void *param) {
+  SConsumerInfo *pInfo = (SConsumerInfo *)param;
+  void          *ahandle, *item;
+  int            type;
+
+  while (taosReadQitemFromQset(pInfo->qset, &type, &item, &ahandle) != 0) {
+    int32_t *pItem = (int32_t *)item;
+    if (pInfo->ordered) {
+      if (pItem[1] != pInfo->expected[pItem[0]]) atomic_add_fetch_32(&pInfo->errors, 1);
+      pInfo->expected[pItem[0]] = pItem[1] + 1;
+    }
+    taosFreeQitem(item);
+    atomic_add_fetch_32(&pInfo->processed, 1);
+  }
+
+  return NULL;
+}
+
+}  // namespace
+
+// The readers sharing a queue set never process a queue at the same time, and get the items of it in order
+TEST(QueueTest, claimAllQitemsFromQset) {
+  SQsetInfo  info = {0};
+  SQueueInfo queues[numOfQueues] = {{0}};
+  pthread_t  readers[numOfReaders], writers[numOfQueues];
+
+  info.qset = taosOpenQset();
+  info.queues = queues;
+  for (int i = 0; i < numOfQueues; ++i) {
+    queues[i].queue = taosOpenQueue();
+    taosAddIntoQset(info.qset, queues[i].queue, queues + i);
+  }
+
+  for (int i = 0; i < numOfReaders; ++i) pthread_create(readers + i, NULL, claimItems, &info);
+  for (int i = 0; i < numOfQueues; ++i) pthread_create(writers + i, NULL, writeItems, queues + i);
+  for (int i = 0; i < numOfQueues; ++i) pthread_join(writers[i], NULL);
+
+  // all the items are read out, none of them is left without a reader waked up
+  for (int i = 0; i < 1000 && atomic_load_32(&info.processed) < numOfQueues * itemsPerQueue; ++i) usleep(10000);
+  EXPECT_EQ(atomic_load_32(&info.processed), numOfQueues * itemsPerQueue);
+
+  atomic_store_32(&info.stop, 1);
+  for (int i = 0; i < numOfReaders; ++i) taosQsetThreadResume(info.qset);
+  for (int i = 0; i < numOfReaders; ++i) pthread_join(readers[i], NULL);
+
+  for (int i = 0; i < numOfQueues; ++i) {
+    EXPECT_EQ(queues[i].errors, 0);
+    EXPECT_EQ(queues[i].expected, itemsPerQueue);
+    taosCloseQueue(queues[i].queue);
+  }
+
+  EXPECT_EQ(taosGetQsetItemsNumber(info.qset), 0);
+  taosCloseQset(info.qset);
+}
+
+// An item of the low priority queue waits for the other queues, but no longer than TAOS_QSET_MAX_HIGH_READS items
+TEST(QueueTest, lowPriorityQueue) {
+  taos_qset  qset = taosOpenQset();
+  taos_queue high = taosOpenQueue();
+  taos_queue low = taosOpenQueue();
+  int        highHandle = 0, lowHandle = 1;
+  void      *ahandle, *item;
+  int        type;
+
+  taosSetQueueLowPriority(low);
+  taosAddIntoQset(qset, low, &lowHandle);
+  taosAddIntoQset(qset, high, &highHandle);
+
+  for (int i = 0; i < 2; ++i) taosWriteQitem(low, 0, taosAllocateQitem(sizeof(int32_t)));
+  for (int i = 0; i < 10; ++i) taosWriteQitem(high, 0, taosAllocateQitem(sizeof(int32_t)));
+
+  // 4 high, 1 low, 4 high, 1 low, then the rest of the high ones
+  const int expected[] = {0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0};
+  for (int i = 0; i < 12; ++i) {
+    ASSERT_EQ(taosReadQitemFromQset(qset, &type, &item, &ahandle), 1);
+    EXPECT_EQ(*(int *)ahandle, expected[i]) << "read:" << i;
+    taosFreeQitem(item);
+  }
+
+  taosCloseQueue(high);
+  taosCloseQueue(low);
+  taosCloseQset(qset);
+}
+
+// The writers of a queue do not lock each other out, the items of each writer are still read in order
+TEST(QueueTest, multiProducers) {
+  SConsumerInfo info = {0};
+  SProducerInfo producers[numOfProducers];
+  pthread_t     reader, writers[numOfProducers];
+  taos_queue    queue = taosOpenQueue();
+
+  info.qset = taosOpenQset();
+  info.ordered = 1;
+  taosAddIntoQset(info.qset, queue, NULL);
+
+  pthread_create(&reader, NULL, consumeItems, &info);
+  for (int i = 0; i < numOfProducers; ++i) {
+    producers[i].queue = queue;
+    producers[i].producer = i;
+    pthread_create(writers + i, NULL, produceItems, producers + i);
+  }
+  for (int i = 0; i < numOfProducers; ++i) pthread_join(writers[i], NULL);
+
+  for (int i = 0; i < 1000 && atomic_load_32(&info.processed) < numOfProducers * itemsPerQueue; ++i) usleep(10000);
+  EXPECT_EQ(atomic_load_32(&info.processed), numOfProducers * itemsPerQueue);
+
+  taosQsetThreadResume(info.qset);
+  pthread_join(reader, NULL);
+
+  EXPECT_EQ(info.errors, 0);
+  for (int i = 0; i < numOfProducers; ++i) EXPECT_EQ(info.expected[i], itemsPerQueue);
+  EXPECT_EQ(taosGetQueueItemsNumber(queue), 0);
+
+  taosCloseQueue(queue);
+  taosCloseQset(info.qset);
+}
+
+// The readers sleeping on a queue set are waked up for the items, and return with nothing once resumed
+TEST(QueueTest, multiConsumers) {
+  SConsumerInfo info = {0};
+  SProducerInfo producers[numOfProducers];
+  pthread_t     readers[numOfReaders], writers[numOfProducers];
+  taos_queue    queues[2] = {taosOpenQueue(), taosOpenQueue()};
+
+  info.qset = taosOpenQset();
+  for (int i = 0; i < 2; ++i) taosAddIntoQset(info.qset, queues[i], NULL);
+
+  for (int i = 0; i < numOfReaders; ++i) pthread_create(readers + i, NULL, consumeItems, &info);
+  for (int i = 0; i < numOfProducers; ++i) {
+    producers[i].queue = queues[i % 2];
+    producers[i].producer = i;
+    pthread_create(writers + i, NULL, produceItems, producers + i);
+  }
+  for (int i = 0; i < numOfProducers; ++i) pthread_join(writers[i], NULL);
+
+  for (int i = 0; i < 1000 && atomic_load_32(&info.processed) < numOfProducers * itemsPerQueue; ++i) usleep(10000);
+  EXPECT_EQ(atomic_load_32(&info.processed), numOfProducers * itemsPerQueue);
+  EXPECT_EQ(taosGetQsetItemsNumber(info.qset), 0);
+
+  for (int i = 0; i < numOfReaders; ++i) taosQsetThreadResume(info.qset);
+  for (int i = 0; i < numOfReaders; ++i) pthread_join(readers[i], NULL);
+
+  for (int i = 0; i < 2; ++i) taosCloseQueue(queues[i]);
+  taosCloseQset(info.qset);
+}
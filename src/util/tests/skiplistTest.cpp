@@ -332,6 +332,89 @@ void duplicatedKeyTest() {
   tSkipListDestroy(pSkipList);
 }
 
+void batchPutTest() {
+  SSkipList* pSkipList = tSkipListCreate(10, TSDB_DATA_TYPE_INT, sizeof(int32_t), 0, false, true, getkey);
+
+  // even keys are put one by one, and the odd ones as a sorted run in batches, together with some duplicated keys
+  const int32_t size = 10000;
+  for (int32_t i = 0; i < size; i += 2) {
+    int32_t level = 0, s = 0;
+    tSkipListNewNodeInfo(pSkipList, &level, &s);
+    auto d = (SSkipListNode*)calloc(1, s + sizeof(int32_t));
+    d->level = level;
+    *(int32_t*)SL_GET_NODE_KEY(pSkipList, d) = i;
+    tSkipListPut(pSkipList, d);
+  }
+
+  const int32_t batchSize = 1000;
+  SSkipListNode* pNodes[batchSize] = {0};
+  bool           discarded[batchSize] = {0};
+  for (int32_t key = 1; key < size * 2;) {
+    for (int32_t j = 0; j < batchSize; ++j) {
+      int32_t k = 0;
+      if (j % 100 == 99) {  // the same key as the previous node of the run
+        k = key - 2;
+        discarded[j] = true;
+      } else if (j % 100 == 49) {  // the key of a node put one by one
+        k = key - 1;
+        discarded[j] = (k < size);
+      } else {
+        k = key;
+        key += 2;
+        discarded[j] = false;
+      }
+
+      int32_t level = 0, s = 0;
+      tSkipListNewNodeInfo(pSkipList, &level, &s);
+      pNodes[j] = (SSkipListNode*)calloc(1, s + sizeof(int32_t));
+      pNodes[j]->level = level;
+      *(int32_t*)SL_GET_NODE_KEY(pSkipList, pNodes[j]) = k;
+    }
+
+    int32_t num = tSkipListPutBatch(pSkipList, pNodes, batchSize);
+    for (int32_t j = 0; j < batchSize; ++j) {
+      if (discarded[j]) {
+        free(pNodes[j]);
+        num++;
+      }
+    }
+    ASSERT_EQ(num, batchSize);
+  }
+
+  // every key is put once, and the keys are in order on every level
+  SSkipListIterator* iter = tSkipListCreateIter(pSkipList);
+  int32_t            prev = -2;
+  int32_t            count = 0;
+  while (tSkipListIterNext(iter)) {
+    int32_t key = *(int32_t*)SL_GET_NODE_KEY(pSkipList, tSkipListIterGet(iter));
+    ASSERT_LT(prev, key);
+    prev = key;
+    count++;
+  }
+  tSkipListDestroyIter(iter);
+  ASSERT_EQ(count, tSkipListGetSize(pSkipList));
+
+  for (int32_t l = 0; l < pSkipList->level; ++l) {
+    SSkipListNode* p = SL_GET_FORWARD_POINTER(pSkipList->pHead, l);
+    prev = -2;
+    while (p != pSkipList->pTail) {
+      int32_t key = *(int32_t*)SL_GET_NODE_KEY(pSkipList, p);
+      ASSERT_LT(prev, key);
+      ASSERT_EQ(SL_GET_FORWARD_POINTER(SL_GET_BACKWARD_POINTER(p, l), l), p);
+      prev = key;
+      p = SL_GET_FORWARD_POINTER(p, l);
+    }
+  }
+
+  for (int32_t i = 0; i < size; ++i) {
+    SArray* nodes = tSkipListGet(pSkipList, (char*)(&i));
+    ASSERT_EQ(taosArrayGetSize(nodes), 1);
+    taosArrayDestroy(nodes);
+  }
+
+  tSkipListDestroy(pSkipList);
+}
+
 }  // namespace
 
 TEST(testCase, skiplist_test) {
@@ -342,6 +425,7 @@ TEST(testCase, skiplist_test) {
   doubleSkipListTest();
   skiplistPerformanceTest();
   duplicatedKeyTest();
+  batchPutTest();
   randKeyTest();
 
   //  tSKipListQueryCond q;
@@ -55,6 +55,7 @@ typedef struct {
 } SVnodeObj;
 
 int  vnodeWriteToQueue(void *param, void *pHead, int type);
+int  vnodeRestoreWal(SVnodeObj *pVnode);
 void vnodeInitWriteFp(void);
 void vnodeInitReadFp(void);
 
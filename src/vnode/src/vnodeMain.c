@@ -26,6 +26,7 @@
 #include "cJSON.h"
 #include "tglobal.h"
 #include "dnode.h"
+#include "query.h"
 #include "vnode.h"
 #include "vnodeInt.h"
 
@@ -250,7 +251,7 @@ int32_t vnodeOpen(int32_t vnode, char *rootDir) {
     return terrno;
   }
 
-  walRestore(pVnode->wal, pVnode, vnodeWriteToQueue);
+  vnodeRestoreWal(pVnode);
 
   SSyncInfo syncInfo;
   syncInfo.vgId = pVnode->vgId;
@@ -352,6 +353,7 @@ void vnodeRelease(void *pVnodeRaw) {
 
   if (count <= 0) {
     taosHashCleanup(tsDnodeVnodesHash);
+    qCleanupScanThreads();
     vnodeModuleInit = PTHREAD_ONCE_INIT;
     tsDnodeVnodesHash = NULL;
   }
@@ -397,8 +399,8 @@ void *vnodeGetWal(void *pVnode) {
 static void vnodeBuildVloadMsg(SVnodeObj *pVnode, SDMStatusMsg *pStatus) {
   if (pVnode->status == TAOS_VN_STATUS_DELETING) return;
   if (pStatus->openVnodes >= TSDB_MAX_VNODES) return;
-  int64_t totalStorage, compStorage, pointsWritten = 0;
-  tsdbReportStat(pVnode->tsdb, &pointsWritten, &totalStorage, &compStorage);
+  int64_t totalStorage, compStorage, pointsWritten = 0, cacheHits, cacheMisses;
+  tsdbReportStat(pVnode->tsdb, &pointsWritten, &totalStorage, &compStorage, &cacheHits, &cacheMisses);
 
   SVnodeLoad *pLoad = &pStatus->load[pStatus->openVnodes++];
   pLoad->vgId = htonl(pVnode->vgId);
@@ -426,6 +428,25 @@ void vnodeBuildStatusMsg(void *param) {
   taosHashDestroyIter(pIter);
 }
 
+void vnodeGetBlockCacheStatis(int64_t *hits, int64_t *misses) {
+  SHashMutableIterator *pIter = taosHashCreateIter(tsDnodeVnodesHash);
+  int64_t totalStorage, compStorage, pointsWritten, cacheHits, cacheMisses;
+
+  *hits = 0;
+  *misses = 0;
+  while (taosHashIterNext(pIter)) {
+    SVnodeObj **pVnode = taosHashIterGet(pIter);
+    if (pVnode == NULL) continue;
+    if (*pVnode == NULL || (*pVnode)->tsdb == NULL) continue;
+
+    tsdbReportStat((*pVnode)->tsdb, &pointsWritten, &totalStorage, &compStorage, &cacheHits, &cacheMisses);
+    *hits += cacheHits;
+    *misses += cacheMisses;
+  }
+
+  taosHashDestroyIter(pIter);
+}
+
 static void vnodeCleanUp(SVnodeObj *pVnode) {
   // remove from hash, so new messages wont be consumed
   taosHashRemove(tsDnodeVnodesHash, (const char *)&pVnode->vgId, sizeof(int32_t));
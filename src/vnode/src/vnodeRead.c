@@ -22,6 +22,7 @@
 #include "tsdb.h"
 #include "twal.h"
 #include "tdataformat.h"
+#include "tglobal.h"
 #include "vnode.h"
 #include "vnodeInt.h"
 #include "vnodeLog.h"
@@ -78,7 +79,11 @@ static int32_t vnodeProcessQueryMsg(SVnodeObj *pVnode, SReadMsg *pReadMsg) {
   SRspRet *pRet = &pReadMsg->rspRet;
 
   SQueryTableMsg* pQueryTableMsg = (SQueryTableMsg*) pCont;
-  memset(pRet, 0, sizeof(SRspRet));
+
+  // a query continued after it yields carries the response of the query msg, sent once the results are ready
+  if (contLen != 0) {
+    memset(pRet, 0, sizeof(SRspRet));
+  }
 
   // qHandle needs to be freed correctly
   if (pReadMsg->rpcMsg.code == TSDB_CODE_RPC_NETWORK_UNAVAIL) {
@@ -122,13 +127,20 @@ static int32_t vnodeProcessQueryMsg(SVnodeObj *pVnode, SReadMsg *pReadMsg) {
   } else {
     assert(pCont != NULL);
     pQInfo = pCont;
-    code = TSDB_CODE_VND_ACTION_IN_PROGRESS;
+    code = (pRet->rsp != NULL) ? TSDB_CODE_SUCCESS : TSDB_CODE_VND_ACTION_IN_PROGRESS;
     vTrace("vgId:%d, QInfo:%p, dnode query msg in progress", pVnode->vgId, pQInfo);
   }
 
   if (pQInfo != NULL) {
+    // only yield before the response is sent, so that no retrieve msg is blocked by a query waiting in the queue
+    int32_t timeSlice = (pRet->rsp != NULL) ? tsQueryTimeSlice : 0;
+
     vTrace("vgId:%d, QInfo:%p, do qTableQuery", pVnode->vgId, pQInfo);
-    qTableQuery(pQInfo); // do execute query
+    if (qTableQuery(pQInfo, timeSlice, tsParallelQueryThreads)) {  // do execute query
+      vTrace("vgId:%d, QInfo:%p, query yields after time slice:%d ms", pVnode->vgId, pQInfo, timeSlice);
+      pRet->qhandle = pQInfo;
+      code = TSDB_CODE_VND_ACTION_NEED_REPROCESSED;
+    }
   }
 
   return code;
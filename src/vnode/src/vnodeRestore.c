@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+#include "taosmsg.h"
+#include "taoserror.h"
+#include "tqueue.h"
+#include "trpc.h"
+#include "tutil.h"
+#include "ttime.h"
+#include "tsdb.h"
+#include "twal.h"
+#include "tglobal.h"
+#include "vnode.h"
+#include "vnodeInt.h"
+
+// A WAL record shared by the blocks of the submit message, freed with the last block
+typedef struct {
+  int32_t  refCount;
+  int32_t  padding;
+  SWalHead head;
+} SRestoreMsg;
+
+typedef struct {
+  SRestoreMsg *pMsg;
+  SSubmitBlk  *pBlock;
+} SRestoreBlk;
+
+struct SRestoreCtx;
+
+typedef struct {
+  pthread_t           thread;
+  taos_qset           qset;
+  taos_queue          queue;
+  struct SRestoreCtx *pCtx;
+} SRestoreWorker;
+
+typedef struct SRestoreCtx {
+  SVnodeObj      *pVnode;
+  int32_t         numOfWorkers;
+  SRestoreWorker *workers;
+  int64_t         maxPendingBytes;  // bound of the records dispatched but not inserted
+  int64_t         pendingBytes;
+  int32_t         pendingBlocks;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  int64_t         numOfRecords;
+  int64_t         numOfBlocks;
+  int64_t         numOfRows;        // updated by the workers
+  int64_t         numOfFailedBlocks;
+} SRestoreCtx;
+
+static int   vnodeRestoreRecord(void *param, void *data, int type);
+static void *vnodeRestoreWorkerFp(void *param);
+static int   vnodeOpenRestoreCtx(SRestoreCtx *pCtx, SVnodeObj *pVnode);
+static void  vnodeCloseRestoreCtx(SRestoreCtx *pCtx);
+static void  vnodeWaitRestoreWorkers(SRestoreCtx *pCtx);
+static void  vnodeReleaseRestoreMsg(SRestoreMsg *pMsg);
+
+/*
+ * Replay the WAL left by the last run. The WAL module decodes the records in this thread, the blocks of the submit
+ * messages are sharded by table id to the restore workers which insert them into the memtables directly. The other
+ * records are applied in order once all the blocks before them are inserted.
+ */
+int vnodeRestoreWal(SVnodeObj *pVnode) {
+  if (tsWalRestoreThreads <= 0) return walRestore(pVnode->wal, pVnode, vnodeWriteToQueue);
+
+  SRestoreCtx ctx;
+  if (vnodeOpenRestoreCtx(&ctx, pVnode) < 0) {
+    vError("vgId:%d, failed to start WAL restore workers, restore through the write queue", pVnode->vgId);
+    return walRestore(pVnode->wal, pVnode, vnodeWriteToQueue);
+  }
+
+  int64_t stime = taosGetTimestampMs();
+  tsdbSetParallelInsert(pVnode->tsdb, true);
+
+  int code = walRestore(pVnode->wal, &ctx, vnodeRestoreRecord);
+
+  vnodeWaitRestoreWorkers(&ctx);
+  tsdbSetParallelInsert(pVnode->tsdb, false);
+  vnodeCloseRestoreCtx(&ctx);
+  walFsync(pVnode->wal);
+
+  if (ctx.numOfRecords > 0) {
+    vPrint("vgId:%d, %" PRId64 " WAL records are restored by %d threads in %" PRId64 " ms, blocks:%" PRId64
+           " rows:%" PRId64 " failed blocks:%" PRId64 " version:%" PRId64,
+           pVnode->vgId, ctx.numOfRecords, ctx.numOfWorkers, taosGetTimestampMs() - stime, ctx.numOfBlocks,
+           ctx.numOfRows, ctx.numOfFailedBlocks, pVnode->version);
+  }
+
+  return code;
+}
+
+static int vnodeRestoreRecord(void *param, void *data, int type) {
+  SRestoreCtx *pCtx = param;
+  SVnodeObj   *pVnode = pCtx->pVnode;
+  SWalHead    *pHead = data;
+
+  if (pHead->version <= pVnode->version) return 0;
+  pCtx->numOfRecords++;
+
+  // create, drop and alter records change the tables, apply them when all the blocks before are inserted
+  if (pHead->msgType != TSDB_MSG_TYPE_SUBMIT) {
+    vnodeWaitRestoreWorkers(pCtx);
+    tsdbCommitIfWanted(pVnode->tsdb);
+
+    SRspRet ret = {0};
+    vnodeProcessWrite(pVnode, type, pHead, &ret);
+    rpcFreeCont(ret.rsp);
+    return 0;
+  }
+
+  int32_t      size = sizeof(SWalHead) + pHead->len;
+  SRestoreMsg *pMsg = malloc(sizeof(SRestoreMsg) + pHead->len);
+  if (pMsg == NULL) {
+    // keep the order, insert it in this thread
+    vnodeWaitRestoreWorkers(pCtx);
+
+    SRspRet ret = {0};
+    vnodeProcessWrite(pVnode, type, pHead, &ret);
+    rpcFreeCont(ret.rsp);
+    return 0;
+  }
+
+  // the record goes into the new WAL before the message is converted by the submit iterator
+  memcpy(&pMsg->head, pHead, size);
+  pVnode->version = pHead->version;
+  walWrite(pVnode->wal, &pMsg->head);
+
+  // the memtables must not be swapped while the workers insert, so a commit is only triggered between the records
+  pthread_mutex_lock(&pCtx->mutex);
+  while (pCtx->pendingBytes > pCtx->maxPendingBytes || (pCtx->pendingBlocks > 0 && tsdbCommitWanted(pVnode->tsdb))) {
+    pthread_cond_wait(&pCtx->cond, &pCtx->mutex);
+  }
+  pthread_mutex_unlock(&pCtx->mutex);
+  tsdbCommitIfWanted(pVnode->tsdb);
+
+  SSubmitMsgIter msgIter;
+  SSubmitBlk    *pBlock;
+
+  pMsg->refCount = 1;
+  tsdbInitSubmitMsgIter((SSubmitMsg *)pMsg->head.cont, &msgIter);
+  while ((pBlock = tsdbGetSubmitMsgNext(&msgIter)) != NULL) {
+    SRestoreBlk *pBlk = taosAllocateQitem(sizeof(SRestoreBlk));
+    if (pBlk == NULL) {
+      atomic_add_fetch_64(&pCtx->numOfFailedBlocks, 1);
+      continue;
+    }
+
+    pBlk->pMsg = pMsg;
+    pBlk->pBlock = pBlock;
+    atomic_add_fetch_32(&pMsg->refCount, 1);
+
+    pthread_mutex_lock(&pCtx->mutex);
+    pCtx->pendingBlocks++;
+    pCtx->pendingBytes += sizeof(SSubmitBlk) + pBlock->len;
+    pthread_mutex_unlock(&pCtx->mutex);
+
+    pCtx->numOfBlocks++;
+    taosWriteQitem(pCtx->workers[pBlock->tid % pCtx->numOfWorkers].queue, TAOS_QTYPE_WAL, pBlk);
+  }
+
+  vnodeReleaseRestoreMsg(pMsg);
+  return 0;
+}
+
+static void *vnodeRestoreWorkerFp(void *param) {
+  SRestoreWorker *pWorker = param;
+  SRestoreCtx    *pCtx = pWorker->pCtx;
+  SRestoreBlk    *pBlk;
+  void           *ahandle;
+  int             type;
+
+  while (taosReadQitemFromQset(pWorker->qset, &type, (void **)&pBlk, &ahandle) > 0) {
+    int32_t rows = 0;
+    int32_t bytes = sizeof(SSubmitBlk) + pBlk->pBlock->len;
+
+    if (tsdbInsertSubmitBlk(pCtx->pVnode->tsdb, pBlk->pBlock, &rows) != TSDB_CODE_SUCCESS) {
+      atomic_add_fetch_64(&pCtx->numOfFailedBlocks, 1);
+    }
+    atomic_add_fetch_64(&pCtx->numOfRows, rows);
+
+    vnodeReleaseRestoreMsg(pBlk->pMsg);
+    taosFreeQitem(pBlk);
+
+    pthread_mutex_lock(&pCtx->mutex);
+    pCtx->pendingBlocks--;
+    pCtx->pendingBytes -= bytes;
+    pthread_cond_broadcast(&pCtx->cond);
+    pthread_mutex_unlock(&pCtx->mutex);
+  }
+
+  return NULL;
+}
+
+static int vnodeOpenRestoreCtx(SRestoreCtx *pCtx, SVnodeObj *pVnode) {
+  memset(pCtx, 0, sizeof(SRestoreCtx));
+  pCtx->pVnode = pVnode;
+
+  // the rows of the pending blocks are allocated after the commit is due, keep them within a part of a cache block
+  pCtx->maxPendingBytes = (int64_t)pVnode->tsdbCfg.cacheBlockSize * 1024 * 1024 / 8;
+  if (pCtx->maxPendingBytes <= 0) pCtx->maxPendingBytes = 1024 * 1024;
+
+  pCtx->workers = calloc(tsWalRestoreThreads, sizeof(SRestoreWorker));
+  if (pCtx->workers == NULL) return -1;
+
+  pthread_mutex_init(&pCtx->mutex, NULL);
+  pthread_cond_init(&pCtx->cond, NULL);
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  for (int32_t i = 0; i < tsWalRestoreThreads; ++i) {
+    SRestoreWorker *pWorker = pCtx->workers + i;
+    pWorker->pCtx = pCtx;
+    pWorker->qset = taosOpenQset();
+    pWorker->queue = taosOpenQueue();
+    if (pWorker->qset == NULL || pWorker->queue == NULL) {
+      taosCloseQueue(pWorker->queue);
+      taosCloseQset(pWorker->qset);
+      break;
+    }
+
+    taosAddIntoQset(pWorker->qset, pWorker->queue, pVnode);
+    if (pthread_create(&pWorker->thread, &thAttr, vnodeRestoreWorkerFp, pWorker) != 0) {
+      vError("vgId:%d, failed to create WAL restore thread, reason:%s", pVnode->vgId, strerror(errno));
+      taosCloseQueue(pWorker->queue);
+      taosCloseQset(pWorker->qset);
+      break;
+    }
+
+    pCtx->numOfWorkers++;
+  }
+
+  pthread_attr_destroy(&thAttr);
+
+  if (pCtx->numOfWorkers == 0) {
+    vnodeCloseRestoreCtx(pCtx);
+    return -1;
+  }
+
+  return 0;
+}
+
+static void vnodeCloseRestoreCtx(SRestoreCtx *pCtx) {
+  for (int32_t i = 0; i < pCtx->numOfWorkers; ++i) {
+    taosQsetThreadResume(pCtx->workers[i].qset);
+  }
+
+  for (int32_t i = 0; i < pCtx->numOfWorkers; ++i) {
+    SRestoreWorker *pWorker = pCtx->workers + i;
+    pthread_join(pWorker->thread, NULL);
+    taosCloseQueue(pWorker->queue);
+    taosCloseQset(pWorker->qset);
+  }
+
+  pthread_cond_destroy(&pCtx->cond);
+  pthread_mutex_destroy(&pCtx->mutex);
+  tfree(pCtx->workers);
+}
+
+static void vnodeWaitRestoreWorkers(SRestoreCtx *pCtx) {
+  pthread_mutex_lock(&pCtx->mutex);
+  while (pCtx->pendingBlocks > 0) {
+    pthread_cond_wait(&pCtx->cond, &pCtx->mutex);
+  }
+  pthread_mutex_unlock(&pCtx->mutex);
+}
+
+static void vnodeReleaseRestoreMsg(SRestoreMsg *pMsg) {
+  if (atomic_sub_fetch_32(&pMsg->refCount, 1) == 0) free(pMsg);
+}
@@ -45,11 +45,8 @@ void vnodeInitWriteFp(void) {
   vnodeProcessWriteMsgFp[TSDB_MSG_TYPE_UPDATE_TAG_VAL]  = vnodeProcessUpdateTagValMsg;
 }
 
-int32_t vnodeProcessWrite(void *param1, int qtype, void *param2, void *item) {
-  int32_t    code = 0;
-  SVnodeObj *pVnode = (SVnodeObj *)param1;
-  SWalHead  *pHead = param2;
-
+// check the message and assign its version, it returns 1 if the message is already written
+static int32_t vnodePrepareWrite(SVnodeObj *pVnode, SWalHead *pHead) {
   if (vnodeProcessWriteMsgFp[pHead->msgType] == NULL) 
     return TSDB_CODE_VND_MSG_NOT_PROCESSED; 
 
@@ -65,22 +62,51 @@ int32_t vnodeProcessWrite(void *param1, int qtype, void *param2, void *item) {
     pHead->version = pVnode->version;
   } else { // from wal or forward 
     // for data from WAL or forward, version may be smaller
-    if (pHead->version <= pVnode->version) return 0;
+    if (pHead->version <= pVnode->version) return 1;
   }
 
   pVnode->version = pHead->version;
+  return 0;
+}
+
+int32_t vnodeProcessWrite(void *param1, int qtype, void *param2, void *item) {
+  int32_t    code = 0;
+  SVnodeObj *pVnode = (SVnodeObj *)param1;
+  SWalHead  *pHead = param2;
+
+  code = vnodePrepareWrite(pVnode, pHead);
+  if (code != 0) return (code > 0) ? 0 : code;
 
   // write into WAL
   code = walWrite(pVnode->wal, pHead);
   if (code < 0) return code;
 
+  return vnodeApplyWrite(pVnode, qtype, pHead, item);
+}
+
+int32_t vnodeAppendWrite(void *param1, void *param2) {
+  int32_t    code = 0;
+  SVnodeObj *pVnode = (SVnodeObj *)param1;
+  SWalHead  *pHead = param2;
+
+  code = vnodePrepareWrite(pVnode, pHead);
+  if (code != 0) return code;
+
+  // the message is not copied, it must stay unchanged till it is written out
+  return walWriteRef(pVnode->wal, pHead);
+}
+
+int32_t vnodeApplyWrite(void *param1, int qtype, void *param2, void *item) {
+  SVnodeObj *pVnode = (SVnodeObj *)param1;
+  SWalHead  *pHead = param2;
+
   // forward to peers, even it is WAL/FWD, it shall be called to update version in sync 
   int32_t syncCode = 0;
   syncCode = syncForwardToPeer(pVnode->sync, pHead, item, qtype);
   if (syncCode < 0) return syncCode;
 
   // write data locally 
-  code = (*vnodeProcessWriteMsgFp[pHead->msgType])(pVnode, pHead->cont, item);
+  int32_t code = (*vnodeProcessWriteMsgFp[pHead->msgType])(pVnode, pHead->cont, item);
   if (code < 0) return code;
 
   return syncCode;
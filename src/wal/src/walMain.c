@@ -20,21 +20,33 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <fcntl.h> 
+#include <sys/uio.h>
 
 #include "os.h"
 #include "tlog.h"
 #include "tchecksum.h"
 #include "tutil.h"
+#include "ttime.h"
 #include "taoserror.h"
 #include "twal.h"
 #include "tqueue.h"
 
 #define walPrefix "wal"
+#define walBufferSize (1024 * 1024)  // appended records are written out once the buffer reaches it
+#define walRestoreBufSize (8 * 1024 * 1024)  // the WAL files are read in chunks of half of it on restore
+#define walMaxIovecs 1024  // records written by one writev
 #define wError(...) if (wDebugFlag & DEBUG_ERROR) {taosPrintLog("ERROR WAL ", wDebugFlag, __VA_ARGS__);}
 #define wWarn(...) if (wDebugFlag & DEBUG_WARN) {taosPrintLog("WARN WAL ", wDebugFlag, __VA_ARGS__);}
 #define wTrace(...) if (wDebugFlag & DEBUG_TRACE) {taosPrintLog("WAL ", wDebugFlag, __VA_ARGS__);}
 #define wPrint(...) {taosPrintLog("WAL ", 255, __VA_ARGS__);}
 
+// a record appended, copied into the buffer at offset if data is NULL, or kept in the caller's memory
+typedef struct {
+  char    *data;
+  int32_t  offset;
+  int32_t  len;
+} SWalRec;
+
 typedef struct {
   uint64_t version;
   int      fd;
@@ -45,7 +57,21 @@ typedef struct {
   int      num;  // number of wal files
   char     path[TSDB_FILENAME_LEN];
   char     name[TSDB_FILENAME_LEN+16];
+  char    *buffer;      // records copied since the last flush
+  int32_t  bufLen;
+  int32_t  bufSize;
+  SWalRec *recs;        // records appended since the last flush, in order
+  int32_t  numOfRecs;
+  int32_t  maxRecs;
+  int32_t  pendingLen;  // bytes of the records appended, copied or not
+  char    *flushBuf;    // records being written out by the flush
+  int32_t  flushBufSize;
+  SWalRec *flushRecs;
+  int32_t  flushMaxRecs;
+  int      unsynced;    // records are written to fd but not synced yet
+  SWalStat stat;
   pthread_mutex_t mutex;
+  pthread_mutex_t fmutex;  // serializes the flushes of the buffer into fd
 } SWal;
 
 int wDebugFlag = 135;
@@ -54,6 +80,9 @@ static uint32_t walSignature = 0xFAFBFDFE;
 static int walHandleExistingFiles(const char *path);
 static int walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp);
 static int walRemoveWalFiles(const char *path);
+static int walFlush(SWal *pWal, int sync);
+static void walFreeWal(SWal *pWal);
+static void walPrintStat(SWal *pWal);
 
 void *walOpen(const char *path, const SWalCfg *pCfg) {
   SWal *pWal = calloc(sizeof(SWal), 1);
@@ -70,14 +99,14 @@ void *walOpen(const char *path, const SWalCfg *pCfg) {
   pWal->keep = pCfg->keep;
   tstrncpy(pWal->path, path, sizeof(pWal->path));
   pthread_mutex_init(&pWal->mutex, NULL);
+  pthread_mutex_init(&pWal->fmutex, NULL);
 
   if (access(path, F_OK) != 0) {
     if (mkdir(path, 0755) != 0) {
       terrno = TAOS_SYSTEM_ERROR(errno);
       wError("wal:%s, failed to create directory(%s)", path, strerror(errno));
-      pthread_mutex_destroy(&pWal->mutex);
-      free(pWal);
-      pWal = NULL;
+      walFreeWal(pWal);
+      return NULL;
     }
   }
      
@@ -89,8 +118,7 @@ void *walOpen(const char *path, const SWalCfg *pCfg) {
   if (pWal->fd <0) {
     terrno = TAOS_SYSTEM_ERROR(errno);
     wError("wal:%s, failed to open(%s)", path, strerror(errno));
-    pthread_mutex_destroy(&pWal->mutex);
-    free(pWal);
+    walFreeWal(pWal);
     pWal = NULL;
   } else {
     wTrace("wal:%s, it is open, level:%d", path, pWal->level);
@@ -103,6 +131,8 @@ void walClose(void *handle) {
   if (handle == NULL) return;
   
   SWal *pWal = handle;  
+  walFlush(pWal, pWal->level == TAOS_WAL_FSYNC);
+  walPrintStat(pWal);
   close(pWal->fd);
 
   if (pWal->keep == 0) {
@@ -119,9 +149,7 @@ void walClose(void *handle) {
     wTrace("wal:%s, it is closed and kept", pWal->name);
   }
 
-  pthread_mutex_destroy(&pWal->mutex);
-
-  free(pWal);
+  walFreeWal(pWal);
 }
 
 int walRenew(void *handle) {
@@ -130,6 +158,10 @@ int walRenew(void *handle) {
 
   terrno = 0;
 
+  // the buffered records belong to the current file, write them out before it is closed
+  pthread_mutex_lock(&pWal->fmutex);
+  walFlush(pWal, pWal->level == TAOS_WAL_FSYNC);
+
   pthread_mutex_lock(&pWal->mutex);
 
   if (pWal->fd >=0) {
@@ -164,14 +196,12 @@ int walRenew(void *handle) {
   }  
   
   pthread_mutex_unlock(&pWal->mutex);
+  pthread_mutex_unlock(&pWal->fmutex);
 
   return terrno;
 }
 
-int walWrite(void *handle, SWalHead *pHead) {
-  SWal *pWal = handle;
-  if (pWal == NULL) return -1;
-
+static int walAppend(SWal *pWal, SWalHead *pHead, bool byRef) {
   terrno = 0;
 
   // no wal  
@@ -182,26 +212,263 @@ int walWrite(void *handle, SWalHead *pHead) {
   taosCalcChecksumAppend(0, (uint8_t *)pHead, sizeof(SWalHead));
   int contLen = pHead->len + sizeof(SWalHead);
 
-  if(write(pWal->fd, pHead, contLen) != contLen) {
-    wError("wal:%s, failed to write(%s)", pWal->name, strerror(errno));
-    terrno = TAOS_SYSTEM_ERROR(errno);
+  // the record is only appended, walFsync writes out all the records of a batch at once
+  pthread_mutex_lock(&pWal->mutex);
+
+  if (pWal->numOfRecs >= pWal->maxRecs) {
+    int32_t  maxRecs = MAX(pWal->maxRecs * 2, walMaxIovecs);
+    SWalRec *recs = realloc(pWal->recs, sizeof(SWalRec) * maxRecs);
+    if (recs == NULL) {
+      pthread_mutex_unlock(&pWal->mutex);
+      wError("wal:%s, failed to allocate records, num:%d", pWal->name, maxRecs);
+      terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+      return terrno;
+    }
+    pWal->recs = recs;
+    pWal->maxRecs = maxRecs;
+  }
+
+  SWalRec *pRec = pWal->recs + pWal->numOfRecs;
+  pRec->len = contLen;
+
+  if (byRef) {
+    pRec->data = (char *)pHead;
+    pRec->offset = 0;
   } else {
-    pWal->version = pHead->version;
+    if (pWal->bufLen + contLen > pWal->bufSize) {
+      int32_t size = MAX(MAX(pWal->bufSize * 2, walBufferSize), pWal->bufLen + contLen);
+      char   *buffer = realloc(pWal->buffer, size);
+      if (buffer == NULL) {
+        pthread_mutex_unlock(&pWal->mutex);
+        wError("wal:%s, failed to allocate buffer, size:%d", pWal->name, size);
+        terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+        return terrno;
+      }
+      pWal->buffer = buffer;
+      pWal->bufSize = size;
+    }
+
+    memcpy(pWal->buffer + pWal->bufLen, pHead, contLen);
+    pRec->data = NULL;
+    pRec->offset = pWal->bufLen;
+    pWal->bufLen += contLen;
+  }
+
+  pWal->numOfRecs++;
+  pWal->pendingLen += contLen;
+  pWal->version = pHead->version;
+  int full = (pWal->pendingLen >= walBufferSize);
+
+  pthread_mutex_unlock(&pWal->mutex);
+
+  if (full) {
+    pthread_mutex_lock(&pWal->fmutex);
+    walFlush(pWal, 0);
+    pthread_mutex_unlock(&pWal->fmutex);
   }
 
   return terrno;
 }
 
-void walFsync(void *handle) {
+int walWrite(void *handle, SWalHead *pHead) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return -1;
+
+  return walAppend(pWal, pHead, false);
+}
+
+int walWriteRef(void *handle, SWalHead *pHead) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return -1;
+
+  return walAppend(pWal, pHead, true);
+}
+
+int walFsync(void *handle) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return 0;
+
+  terrno = 0;
+  if (pWal->level == TAOS_WAL_NOLOG) return 0;
+
+  pthread_mutex_lock(&pWal->fmutex);
+  int code = walFlush(pWal, pWal->level == TAOS_WAL_FSYNC);
+  pthread_mutex_unlock(&pWal->fmutex);
+
+  return code;
+}
+
+int walWriteOut(void *handle) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return 0;
+
+  terrno = 0;
+  if (pWal->level == TAOS_WAL_NOLOG) return 0;
+
+  pthread_mutex_lock(&pWal->fmutex);
+  int code = walFlush(pWal, 0);
+  pthread_mutex_unlock(&pWal->fmutex);
+
+  return code;
+}
 
+void walGetStat(void *handle, SWalStat *pStat) {
   SWal *pWal = handle;
+
+  memset(pStat, 0, sizeof(SWalStat));
   if (pWal == NULL) return;
 
-  if (pWal->level == TAOS_WAL_FSYNC && pWal->fd >=0) {
-    if (fsync(pWal->fd) < 0) {
+  pthread_mutex_lock(&pWal->fmutex);
+  *pStat = pWal->stat;
+  pthread_mutex_unlock(&pWal->fmutex);
+}
+
+static int walHistBucket(int64_t value) {
+  int bucket = 0;
+  while (value > 1 && bucket < TAOS_WAL_HIST_BUCKETS - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+// writev till all the bytes are written, it returns 0 or the errno
+static int walWritev(int fd, struct iovec *iov, int num) {
+  while (num > 0) {
+    ssize_t ret = writev(fd, iov, num);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return errno;
+    }
+
+    while (num > 0 && ret >= (ssize_t)iov->iov_len) {
+      ret -= iov->iov_len;
+      iov++;
+      num--;
+    }
+
+    if (num > 0) {
+      iov->iov_base = (char *)iov->iov_base + ret;
+      iov->iov_len -= ret;
+    }
+  }
+
+  return 0;
+}
+
+// Write the appended records into the file and sync it if required, the copied records are written from the
+// buffer and the others from the caller's memory. The caller holds fmutex, so walWrite keeps appending into the
+// other buffer while the file is synced.
+static int walFlush(SWal *pWal, int sync) {
+  int code = 0;
+
+  pthread_mutex_lock(&pWal->mutex);
+  char    *buffer = pWal->buffer;
+  int32_t  bufSize = pWal->bufSize;
+  SWalRec *recs = pWal->recs;
+  int32_t  maxRecs = pWal->maxRecs;
+  int32_t  records = pWal->numOfRecs;
+  int      fd = pWal->fd;
+  pWal->buffer = pWal->flushBuf;
+  pWal->bufSize = pWal->flushBufSize;
+  pWal->recs = pWal->flushRecs;
+  pWal->maxRecs = pWal->flushMaxRecs;
+  pWal->flushBuf = buffer;
+  pWal->flushBufSize = bufSize;
+  pWal->flushRecs = recs;
+  pWal->flushMaxRecs = maxRecs;
+  pWal->bufLen = 0;
+  pWal->numOfRecs = 0;
+  pWal->pendingLen = 0;
+  pthread_mutex_unlock(&pWal->mutex);
+
+  struct iovec iov[walMaxIovecs];
+  int          num = 0;
+
+  for (int32_t i = 0; i < records && code == 0; ++i) {
+    SWalRec *pRec = recs + i;
+    char    *data = pRec->data ? pRec->data : buffer + pRec->offset;
+
+    if (pRec->data) {
+      pWal->stat.numOfRefs++;
+      pWal->stat.bytesReferenced += pRec->len;
+    } else {
+      pWal->stat.numOfCopies++;
+      pWal->stat.bytesCopied += pRec->len;
+    }
+
+    // the copied records next to each other are written as one
+    if (num > 0 && pRec->data == NULL && recs[i - 1].data == NULL &&
+        (char *)iov[num - 1].iov_base + iov[num - 1].iov_len == data) {
+      iov[num - 1].iov_len += pRec->len;
+    } else {
+      iov[num].iov_base = data;
+      iov[num].iov_len = pRec->len;
+      num++;
+    }
+
+    if (num == walMaxIovecs || i == records - 1) {
+      code = walWritev(fd, iov, num);
+      num = 0;
+    }
+  }
+
+  if (code != 0) {
+    wError("wal:%s, failed to write(%s)", pWal->name, strerror(code));
+    code = TAOS_SYSTEM_ERROR(code);
+  } else if (records > 0) {
+    pWal->unsynced = 1;
+  }
+
+  if (sync && pWal->unsynced && code == 0) {
+    int64_t stime = taosGetTimestampUs();
+    if (fdatasync(fd) < 0) {
       wError("wal:%s, fsync failed(%s)", pWal->name, strerror(errno));
+      code = TAOS_SYSTEM_ERROR(errno);
+    } else {
+      pWal->unsynced = 0;
+      pWal->stat.fsyncHist[walHistBucket(taosGetTimestampUs() - stime)]++;
     }
   }
+
+  if (records > 0) {
+    pWal->stat.numOfFlushes++;
+    pWal->stat.numOfRecords += records;
+    pWal->stat.batchHist[walHistBucket(records)]++;
+  }
+
+  if (code != 0) terrno = code;
+  return code;
+}
+
+static void walPrintHist(char *buf, int size, const char *name, int64_t *hist) {
+  int len = snprintf(buf, size, "%s:", name);
+  for (int i = 0; i < TAOS_WAL_HIST_BUCKETS && len < size; ++i) {
+    if (hist[i] > 0) len += snprintf(buf + len, size - len, " %" PRId64 "+:%" PRId64, (int64_t)1 << i, hist[i]);
+  }
+}
+
+static void walPrintStat(SWal *pWal) {
+  char batch[512], fsync[512];
+
+  if (pWal->stat.numOfFlushes == 0) return;
+
+  walPrintHist(batch, sizeof(batch), "batch", pWal->stat.batchHist);
+  walPrintHist(fsync, sizeof(fsync), "fsync(us)", pWal->stat.fsyncHist);
+  wTrace("wal:%s, flushes:%" PRId64 " records:%" PRId64 " copied:%" PRId64 "/%" PRId64 "B referenced:%" PRId64
+         "/%" PRId64 "B %s %s",
+         pWal->path, pWal->stat.numOfFlushes, pWal->stat.numOfRecords, pWal->stat.numOfCopies, pWal->stat.bytesCopied,
+         pWal->stat.numOfRefs, pWal->stat.bytesReferenced, batch, fsync);
+}
+
+static void walFreeWal(SWal *pWal) {
+  pthread_mutex_destroy(&pWal->mutex);
+  pthread_mutex_destroy(&pWal->fmutex);
+  tfree(pWal->buffer);
+  tfree(pWal->flushBuf);
+  tfree(pWal->recs);
+  tfree(pWal->flushRecs);
+  free(pWal);
 }
 
 int walRestore(void *handle, void *pVnode, int (*writeFp)(void *, void *, int)) {
@@ -253,6 +520,11 @@ int walRestore(void *handle, void *pVnode, int (*writeFp)(void *, void *, int))
 
   if (terrno == 0) {
     if (pWal->keep == 0) {
+      // the records written again by writeFp are in the new file before the old ones are removed
+      pthread_mutex_lock(&pWal->fmutex);
+      walFlush(pWal, pWal->level == TAOS_WAL_FSYNC);
+      pthread_mutex_unlock(&pWal->fmutex);
+
       terrno = walRemoveWalFiles(opath);
       if (terrno == 0) {
         if (remove(opath) < 0) {
@@ -305,14 +577,13 @@ static int walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp) {
   char *name = pWal->name;
 
   terrno = 0;
-  char *buffer = malloc(1024000);  // size for one record
+  int32_t size = walRestoreBufSize;
+  char   *buffer = malloc(size);
   if (buffer == NULL) {
     terrno = TAOS_SYSTEM_ERROR(errno);   
     return terrno;
   }
 
-  SWalHead *pHead = (SWalHead *)buffer;
-
   int fd = open(name, O_RDONLY);
   if (fd < 0) {
     wError("wal:%s, failed to open for restore(%s)", name, strerror(errno));
@@ -321,33 +592,86 @@ static int walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp) {
     return terrno;
   }
 
+#ifdef LINUX
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
   wTrace("wal:%s, start to restore", name);
 
+  // the file is read in large chunks, the records are decoded from the buffer and a record cut by the end of the
+  // chunk is moved to the front before the next read
+  int32_t len = 0;
+  int32_t pos = 0;
+  int     eof = 0;
+
   while (1) {
-    int ret = read(fd, pHead, sizeof(SWalHead));
-    if ( ret == 0)  break;  
+    if (!eof && len - pos < size / 2) {
+      memmove(buffer, buffer + pos, len - pos);
+      len -= pos;
+      pos = 0;
+
+      int ret = read(fd, buffer + len, size - len);
+      if (ret < 0) {
+        wError("wal:%s, failed to read(%s)", name, strerror(errno));
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        break;
+      }
+      if (ret == 0) eof = 1;
+      len += ret;
+    }
 
-    if (ret != sizeof(SWalHead)) {
-      wWarn("wal:%s, failed to read head, skip, ret:%d(%s)", name, ret, strerror(errno));
-      terrno = TAOS_SYSTEM_ERROR(errno);
+    if (pos == len) break;
+
+    SWalHead *pHead = (SWalHead *)(buffer + pos);
+    if (len - pos < sizeof(SWalHead)) {
+      wWarn("wal:%s, failed to read head, skip, ret:%d", name, len - pos);
+      terrno = TAOS_SYSTEM_ERROR(EIO);
       break;
     }
 
     if (!taosCheckChecksumWhole((uint8_t *)pHead, sizeof(SWalHead))) {
       wWarn("wal:%s, cksum is messed up, skip the rest of file", name);
-      terrno = TAOS_SYSTEM_ERROR(errno);
+      terrno = TAOS_SYSTEM_ERROR(EIO);
       break;
     } 
 
-    ret = read(fd, pHead->cont, pHead->len);
-    if ( ret != pHead->len) {
-      wWarn("wal:%s, failed to read body, skip, len:%d ret:%d", name, pHead->len, ret);
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      break;
+    int32_t contLen = sizeof(SWalHead) + pHead->len;
+    if (len - pos < contLen) {
+      if (eof) {
+        wWarn("wal:%s, failed to read body, skip, len:%d ret:%d", name, pHead->len, len - pos - (int)sizeof(SWalHead));
+        terrno = TAOS_SYSTEM_ERROR(EIO);
+        break;
+      }
+
+      // a record larger than half of the buffer, make room for it
+      if (contLen > size / 2) {
+        char *temp = realloc(buffer, contLen * 2);
+        if (temp == NULL) {
+          terrno = TAOS_SYSTEM_ERROR(errno);
+          break;
+        }
+        buffer = temp;
+        size = contLen * 2;
+      }
+
+      // force the next read
+      memmove(buffer, buffer + pos, len - pos);
+      len -= pos;
+      pos = 0;
+      int ret = read(fd, buffer + len, size - len);
+      if (ret < 0) {
+        wError("wal:%s, failed to read(%s)", name, strerror(errno));
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        break;
+      }
+      if (ret == 0) eof = 1;
+      len += ret;
+      continue;
     }
 
     if (pWal->keep) pWal->version = pHead->version;
     (*writeFp)(pVnode, pHead, TAOS_QTYPE_WAL);
+    pos += contLen;
   }
 
   close(fd);
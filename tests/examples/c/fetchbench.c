@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Fetch throughput of taos_fetch_row against taos_fetch_block_columns, the values of every column are read out in
+// both ways, and the sums of them shall be the same.
+// to compile: gcc -O3 -o fetchbench fetchbench.c -ltaos
+// usage: fetchbench [-c configDir] [-r rounds] "select * from test.meters"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <taos.h>  // TAOS header file
+#include <unistd.h>
+
+typedef struct {
+  int64_t rows;
+  int64_t nulls;
+  int64_t sum;  // of the integers, the integral part of the floats, and the lengths of the binaries
+} SFetchStat;
+
+static int64_t nowUs() {
+  struct timeval t = {0};
+  gettimeofday(&t, NULL);
+  return t.tv_sec * 1000000L + t.tv_usec;
+}
+
+static int64_t valueOf(int type, const void *val, int length) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:   return *(int8_t *)val;
+    case TSDB_DATA_TYPE_SMALLINT:  return *(int16_t *)val;
+    case TSDB_DATA_TYPE_INT:       return *(int32_t *)val;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP: return *(int64_t *)val;
+    case TSDB_DATA_TYPE_FLOAT:     return (int64_t)*(float *)val;
+    case TSDB_DATA_TYPE_DOUBLE:    return (int64_t)*(double *)val;
+    case TSDB_DATA_TYPE_BINARY:    return length;
+    default:                       return 0;  // NCHAR is converted by taos_fetch_row only
+  }
+}
+
+static TAOS_RES *runQuery(TAOS *taos, const char *sql) {
+  TAOS_RES *res = taos_query(taos, sql);
+  if (taos_errno(res) != 0) {
+    printf("failed to execute query, reason:%s\n", taos_errstr(res));
+    taos_free_result(res);
+    return NULL;
+  }
+
+  return res;
+}
+
+static int64_t fetchByRows(TAOS *taos, const char *sql, SFetchStat *pStat) {
+  TAOS_RES *res = runQuery(taos, sql);
+  if (res == NULL) return -1;
+
+  int         numOfFields = taos_num_fields(res);
+  TAOS_FIELD *fields = taos_fetch_fields(res);
+  int64_t     st = nowUs();
+
+  TAOS_ROW row = NULL;
+  while ((row = taos_fetch_row(res)) != NULL) {
+    int *length = taos_fetch_lengths(res);
+    for (int i = 0; i < numOfFields; ++i) {
+      if (row[i] == NULL) {
+        pStat->nulls++;
+      } else {
+        pStat->sum += valueOf(fields[i].type, row[i], length[i]);
+      }
+    }
+    pStat->rows++;
+  }
+
+  int64_t elapsed = nowUs() - st;
+  taos_free_result(res);
+  return elapsed;
+}
+
+static int64_t fetchByColumns(TAOS *taos, const char *sql, SFetchStat *pStat) {
+  TAOS_RES *res = runQuery(taos, sql);
+  if (res == NULL) return -1;
+
+  int     numOfFields = taos_num_fields(res);
+  int64_t st = nowUs();
+
+  TAOS_COLUMN *columns = NULL;
+  int          numOfRows = 0;
+  while ((numOfRows = taos_fetch_block_columns(res, &columns)) > 0) {
+    for (int i = 0; i < numOfFields; ++i) {
+      TAOS_COLUMN *pCol = &columns[i];
+      for (int j = 0; j < numOfRows; ++j) {
+        if (pCol->nullBitmap[j >> 3] & (1u << (j & 7))) {
+          pStat->nulls++;
+        } else {
+          pStat->sum += valueOf(pCol->type, pCol->data + j * pCol->bytes, pCol->length ? pCol->length[j] : 0);
+        }
+      }
+    }
+    pStat->rows += numOfRows;
+  }
+
+  int64_t elapsed = nowUs() - st;
+  if (numOfRows < 0) {
+    printf("failed to fetch the columns, the query is fetched by rows only\n");
+    elapsed = -1;
+  }
+
+  taos_free_result(res);
+  return elapsed;
+}
+
+static void printResult(const char *name, SFetchStat *pStat, int64_t elapsed) {
+  printf("%-8s rows:%" PRId64 ", nulls:%" PRId64 ", sum:%" PRId64 ", elapsed:%.3f s, %.0f rows/s\n", name, pStat->rows,
+         pStat->nulls, pStat->sum, elapsed / 1000000.0, pStat->rows * 1000000.0 / (elapsed > 0 ? elapsed : 1));
+}
+
+int main(int argc, char *argv[]) {
+  const char *configDir = NULL;
+  int         rounds = 3;
+  int         opt;
+
+  while ((opt = getopt(argc, argv, "c:r:")) != -1) {
+    switch (opt) {
+      case 'c': configDir = optarg; break;
+      case 'r': rounds = atoi(optarg); break;
+      default:
+        printf("usage: %s [-c configDir] [-r rounds] sql\n", argv[0]);
+        exit(1);
+    }
+  }
+
+  if (optind >= argc) {
+    printf("usage: %s [-c configDir] [-r rounds] sql\n", argv[0]);
+    exit(1);
+  }
+
+  const char *sql = argv[optind];
+  if (configDir != NULL) taos_options(TSDB_OPTION_CONFIGDIR, configDir);
+  taos_init();
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    printf("failed to connect to server, reason:%s\n", taos_errstr(taos));
+    exit(1);
+  }
+
+  // the first round warms up the cache of the server
+  for (int r = 0; r <= rounds; ++r) {
+    SFetchStat rowStat = {0}, colStat = {0};
+    int64_t    rowElapsed = fetchByRows(taos, sql, &rowStat);
+    int64_t    colElapsed = fetchByColumns(taos, sql, &colStat);
+    if (rowElapsed < 0 || colElapsed < 0) break;
+    if (r == 0) continue;
+
+    printf("round %d\n", r);
+    printResult("rows", &rowStat, rowElapsed);
+    printResult("columns", &colStat, colElapsed);
+    if (rowStat.rows != colStat.rows || rowStat.nulls != colStat.nulls || rowStat.sum != colStat.sum) {
+      printf("the values fetched by rows and by columns are different\n");
+    }
+  }
+
+  taos_close(taos);
+  return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Ingestion throughput of the http server, in points/s, of the metrics of telegraf in json posted to /telegraf against
+// the same points in line protocol posted to /influxdb, on a keep-alive connection with the same points per request.
+// The points written are counted by the client library after each round.
+// to compile: gcc -O3 -o linebench linebench.c -ltaos
+// usage: linebench [-c configDir] [-h host] [-P httpPort] [-t tables] [-r rowsPerTable] [-b pointsPerRequest]
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <taos.h>  // TAOS header file
+#include <unistd.h>
+
+#define MAX_BODY_LEN  60000  // the body of a request shall fit in the buffer of the http server
+#define MAX_RESP_LEN  (1024 * 1024)
+#define START_TS      1500000000000L
+#define AUTH_ROOT     "cm9vdDp0YW9zZGF0YQ=="  // root:taosdata in base64
+
+static const char *host = "127.0.0.1";
+static int         httpPort = 6020;
+static int         numOfTables = 100;
+static int         rowsPerTable = 1000;
+static int         pointsPerRequest = 100;
+
+static char *respBuf = NULL;
+static int   numOfErrors = 0;
+
+static int64_t nowUs() {
+  struct timeval t = {0};
+  gettimeofday(&t, NULL);
+  return t.tv_sec * 1000000L + t.tv_usec;
+}
+
+static int connectServer() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  struct sockaddr_in addr = {0};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)httpPort);
+  addr.sin_addr.s_addr = inet_addr(host);
+
+  if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    printf("failed to connect to %s:%d\n", host, httpPort);
+    exit(1);
+  }
+
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+static int readMore(int fd, int len) {
+  if (len >= MAX_RESP_LEN - 1) {
+    printf("response is too long\n");
+    exit(1);
+  }
+
+  int n = (int)read(fd, respBuf + len, (size_t)(MAX_RESP_LEN - 1 - len));
+  if (n <= 0) {
+    printf("connection is closed by the server\n");
+    exit(1);
+  }
+
+  respBuf[len + n] = 0;
+  return len + n;
+}
+
+// read a response of content-length or chunked, and the body of it is left in respBuf
+static void readResponse(int fd) {
+  int   len = 0;
+  char *body = NULL;
+  while ((body = strstr(respBuf, "\r\n\r\n")) == NULL || len == 0) {
+    len = readMore(fd, len);
+  }
+  body += 4;
+
+  char *contentLength = strstr(respBuf, "Content-Length:");
+  if (contentLength != NULL && contentLength < body) {
+    int bodyLen = atoi(contentLength + strlen("Content-Length:"));
+    while (respBuf + len < body + bodyLen) {
+      len = readMore(fd, len);
+    }
+    memmove(respBuf, body, (size_t)bodyLen);
+    respBuf[bodyLen] = 0;
+    return;
+  }
+
+  // chunked, the chunks end with the one of size 0
+  while (strstr(body, "\r\n0\r\n\r\n") == NULL && strncmp(body, "0\r\n\r\n", 5) != 0) {
+    len = readMore(fd, len);
+  }
+
+  char *src = body;
+  char *dst = respBuf;
+  int   size = 0;
+  while ((size = (int)strtol(src, NULL, 16)) > 0) {
+    src = strstr(src, "\r\n") + 2;
+    memmove(dst, src, (size_t)size);
+    dst += size;
+    src += size + 2;
+  }
+  *dst = 0;
+}
+
+static void post(int fd, const char *path, const char *body, int bodyLen) {
+  char head[512];
+  int  headLen = sprintf(head,
+                        "POST %s HTTP/1.1\r\nHost: %s\r\nAuthorization: Basic " AUTH_ROOT
+                        "\r\nConnection: keep-alive\r\nContent-Length: %d\r\n\r\n",
+                        path, host, bodyLen);
+
+  if (write(fd, head, (size_t)headLen) != headLen || write(fd, body, (size_t)bodyLen) != bodyLen) {
+    printf("failed to send the request\n");
+    exit(1);
+  }
+
+  respBuf[0] = 0;
+  readResponse(fd);
+  if (strstr(respBuf, "\"status\":\"error\"") != NULL) {
+    if (numOfErrors++ == 0) {
+      printf("request failed: %.300s\n", respBuf);
+    }
+  }
+}
+
+static int appendJson(char *buf, int len, int t, int r, int first) {
+  return len + sprintf(buf + len,
+                       "%s{\"name\":\"cpu\",\"tags\":{\"host\":\"h%d\",\"region\":\"r%d\"},\"fields\":{\"usage_user\":%.2f,"
+                       "\"usage_system\":%.2f,\"usage_idle\":%.2f},\"timestamp\":%" PRId64 "}",
+                       first ? "" : ",", t, t % 4, r * 0.01, t * 0.1, 90.5, START_TS + r);
+}
+
+static int appendLine(char *buf, int len, int t, int r) {
+  return len + sprintf(buf + len, "cpu,host=h%d,region=r%d usage_user=%.2f,usage_system=%.2f,usage_idle=%.2f %" PRId64 "\n",
+                       t, t % 4, r * 0.01, t * 0.1, 90.5, START_TS + r);
+}
+
+// the points are posted in the order of rows, a point per table in each row as telegraf reports the hosts
+static int64_t postPoints(const char *path, int isJson) {
+  char *body = malloc(MAX_BODY_LEN + 1024);
+  int   fd = connectServer();
+  int   len = 0;
+  int   numOfPoints = 0;
+
+  int64_t st = nowUs();
+  for (int r = 0; r < rowsPerTable; ++r) {
+    for (int t = 0; t < numOfTables; ++t) {
+      if (len == 0 && isJson) {
+        len = sprintf(body, "{\"metrics\":[");
+      }
+
+      len = isJson ? appendJson(body, len, t, r, numOfPoints == 0) : appendLine(body, len, t, r);
+      if (++numOfPoints >= pointsPerRequest || len >= MAX_BODY_LEN) {
+        if (isJson) len += sprintf(body + len, "]}");
+        post(fd, path, body, len);
+        len = 0;
+        numOfPoints = 0;
+      }
+    }
+  }
+
+  if (numOfPoints > 0) {
+    if (isJson) len += sprintf(body + len, "]}");
+    post(fd, path, body, len);
+  }
+
+  int64_t elapsed = nowUs() - st;
+  close(fd);
+  free(body);
+  return elapsed;
+}
+
+static void execSql(TAOS *taos, const char *sql) {
+  TAOS_RES *res = taos_query(taos, sql);
+  if (taos_errno(res) != 0) {
+    printf("failed to execute: %s, reason:%s\n", sql, taos_errstr(res));
+  }
+  taos_free_result(res);
+}
+
+static int64_t countRows(TAOS *taos) {
+  TAOS_RES *res = taos_query(taos, "select count(*) from linebench.cpu");
+  TAOS_ROW  row = (taos_errno(res) == 0) ? taos_fetch_row(res) : NULL;
+  int64_t   count = (row != NULL) ? *(int64_t *)row[0] : -1;
+
+  taos_free_result(res);
+  return count;
+}
+
+static void runCase(TAOS *taos, const char *name, const char *path, int isJson) {
+  execSql(taos, "drop database if exists linebench");
+  execSql(taos, "create database linebench");
+  numOfErrors = 0;
+
+  int64_t elapsed = postPoints(path, isJson);
+  int64_t rows = countRows(taos);
+  int64_t expected = (int64_t)numOfTables * rowsPerTable;
+  printf("%-9s points:%" PRId64 ", expected:%" PRId64 ", failed requests:%d, elapsed:%.3f s, %.0f points/s\n", name,
+         rows, expected, numOfErrors, elapsed / 1000000.0, expected * 1000000.0 / (elapsed > 0 ? elapsed : 1));
+}
+
+int main(int argc, char *argv[]) {
+  const char *configDir = NULL;
+  int         opt;
+
+  while ((opt = getopt(argc, argv, "c:h:P:t:r:b:")) != -1) {
+    switch (opt) {
+      case 'c': configDir = optarg; break;
+      case 'h': host = optarg; break;
+      case 'P': httpPort = atoi(optarg); break;
+      case 't': numOfTables = atoi(optarg); break;
+      case 'r': rowsPerTable = atoi(optarg); break;
+      case 'b': pointsPerRequest = atoi(optarg); break;
+      default:
+        printf("usage: %s [-c configDir] [-h host] [-P httpPort] [-t tables] [-r rowsPerTable] [-b pointsPerRequest]\n",
+               argv[0]);
+        exit(1);
+    }
+  }
+
+  // /telegraf generates 2 sql strings of each metric, which are 1024 at most
+  if (numOfTables <= 0 || rowsPerTable <= 0 || pointsPerRequest <= 0 || pointsPerRequest > 500) {
+    printf("invalid options, pointsPerRequest shall be in [1, 500]\n");
+    exit(1);
+  }
+
+  if (configDir != NULL) taos_options(TSDB_OPTION_CONFIGDIR, configDir);
+  taos_init();
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    printf("failed to connect to server, reason:%s\n", taos_errstr(taos));
+    exit(1);
+  }
+
+  respBuf = malloc(MAX_RESP_LEN);
+  runCase(taos, "telegraf", "/telegraf/linebench", 1);
+  runCase(taos, "influxdb", "/influxdb/linebench/ms", 0);
+
+  free(respBuf);
+  taos_close(taos);
+  return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Insertion throughput of the sql strings, as taosdemo builds them, against the prepared statement which binds the
+// columns of many tables and submits them in one execution. The tables are created on the fly in both ways.
+// to compile: gcc -O3 -o stmtbench stmtbench.c -ltaos
+// usage: stmtbench [-c configDir] [-t tables] [-r rowsPerTable] [-b tablesPerBatch]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <taos.h>  // TAOS header file
+#include <unistd.h>
+
+#define MAX_SQL_LEN 64000
+#define START_TS    1500000000000L
+
+static int numOfTables = 1000;
+static int rowsPerTable = 1000;
+static int tablesPerBatch = 100;
+
+static int64_t nowUs() {
+  struct timeval t = {0};
+  gettimeofday(&t, NULL);
+  return t.tv_sec * 1000000L + t.tv_usec;
+}
+
+static int execSql(TAOS *taos, const char *sql) {
+  TAOS_RES *res = taos_query(taos, sql);
+  int       code = taos_errno(res);
+  if (code != 0) {
+    printf("failed to execute: %.80s, reason:%s\n", sql, taos_errstr(res));
+  }
+
+  taos_free_result(res);
+  return code;
+}
+
+static void prepareDb(TAOS *taos) {
+  execSql(taos, "drop database if exists stmtbench");
+  execSql(taos, "create database stmtbench");
+  execSql(taos, "create table stmtbench.st (ts timestamp, v1 int, v2 double, v3 binary(16)) tags (gid int, loc binary(16))");
+}
+
+static int64_t countRows(TAOS *taos) {
+  TAOS_RES *res = taos_query(taos, "select count(*) from stmtbench.st");
+  TAOS_ROW  row = (taos_errno(res) == 0) ? taos_fetch_row(res) : NULL;
+  int64_t   count = (row != NULL) ? *(int64_t *)row[0] : -1;
+
+  taos_free_result(res);
+  return count;
+}
+
+static int64_t insertBySql(TAOS *taos) {
+  char *sql = malloc(MAX_SQL_LEN + 256);
+  int   len = 0;
+
+  int64_t st = nowUs();
+  for (int t = 0; t < numOfTables; ++t) {
+    int r = 0;
+    while (r < rowsPerTable) {
+      if (len == 0) {
+        len = sprintf(sql, "insert into");
+      }
+
+      len += sprintf(sql + len, " stmtbench.t%d using stmtbench.st tags(%d, 'loc%d') values", t, t % 10, t % 7);
+      do {
+        len += sprintf(sql + len, "(%" PRId64 ", %d, %f, 'b%d')", START_TS + r, r, r * 0.5, r % 100);
+      } while (++r < rowsPerTable && len < MAX_SQL_LEN);
+
+      if (len >= MAX_SQL_LEN) {
+        if (execSql(taos, sql) != 0) goto _end;
+        len = 0;
+      }
+    }
+  }
+
+  if (len > 0 && execSql(taos, sql) != 0) goto _end;
+
+_end:
+  free(sql);
+  return nowUs() - st;
+}
+
+static int64_t insertByStmt(TAOS *taos) {
+  int64_t *ts = malloc(sizeof(int64_t) * rowsPerTable);
+  int32_t *v1 = malloc(sizeof(int32_t) * rowsPerTable);
+  double * v2 = malloc(sizeof(double) * rowsPerTable);
+  char *   v3 = malloc(16 * rowsPerTable);
+  int32_t *v3Len = malloc(sizeof(int32_t) * rowsPerTable);
+
+  for (int r = 0; r < rowsPerTable; ++r) {
+    ts[r] = START_TS + r;
+    v1[r] = r;
+    v2[r] = r * 0.5;
+    v3Len[r] = sprintf(v3 + 16 * r, "b%d", r % 100);
+  }
+
+  TAOS_MULTI_BIND cols[4] = {
+      {TSDB_DATA_TYPE_TIMESTAMP, ts, sizeof(int64_t), NULL, NULL, rowsPerTable},
+      {TSDB_DATA_TYPE_INT, v1, sizeof(int32_t), NULL, NULL, rowsPerTable},
+      {TSDB_DATA_TYPE_DOUBLE, v2, sizeof(double), NULL, NULL, rowsPerTable},
+      {TSDB_DATA_TYPE_BINARY, v3, 16, v3Len, NULL, rowsPerTable},
+  };
+
+  int           gid = 0;
+  char          loc[16] = {0};
+  unsigned long locLen = 0;
+  TAOS_BIND     tags[2] = {{0}};
+  tags[0].buffer_type = TSDB_DATA_TYPE_INT;
+  tags[0].buffer = &gid;
+  tags[1].buffer_type = TSDB_DATA_TYPE_BINARY;
+  tags[1].buffer = loc;
+  tags[1].length = &locLen;
+
+  int64_t    st = nowUs();
+  TAOS_STMT *stmt = taos_stmt_init(taos);
+
+  const char *sql = "insert into ? using stmtbench.st tags(?, ?) values(?, ?, ?, ?)";
+  int         code = taos_stmt_prepare(stmt, sql, 0);
+  if (code != 0) {
+    printf("failed to prepare: %s, code:0x%x\n", sql, code);
+    goto _end;
+  }
+
+  for (int t = 0; t < numOfTables; ++t) {
+    char name[32] = {0};
+    sprintf(name, "stmtbench.t%d", t);
+
+    gid = t % 10;
+    locLen = sprintf(loc, "loc%d", t % 7);
+    if ((code = taos_stmt_set_tbname_tags(stmt, name, tags)) != 0 ||
+        (code = taos_stmt_bind_param_batch(stmt, cols)) != 0) {
+      printf("failed to bind table %s, code:0x%x\n", name, code);
+      goto _end;
+    }
+
+    if ((t + 1) % tablesPerBatch == 0 || t == numOfTables - 1) {
+      if ((code = taos_stmt_execute(stmt)) != 0) {
+        printf("failed to execute the statement, code:0x%x\n", code);
+        goto _end;
+      }
+    }
+  }
+
+_end:
+  taos_stmt_close(stmt);
+  int64_t elapsed = nowUs() - st;
+
+  free(ts);
+  free(v1);
+  free(v2);
+  free(v3);
+  free(v3Len);
+  return elapsed;
+}
+
+static void printResult(const char *name, TAOS *taos, int64_t elapsed) {
+  int64_t rows = countRows(taos);
+  printf("%-6s rows:%" PRId64 ", expected:%" PRId64 ", elapsed:%.3f s, %.0f rows/s\n", name, rows,
+         (int64_t)numOfTables * rowsPerTable, elapsed / 1000000.0, rows * 1000000.0 / (elapsed > 0 ? elapsed : 1));
+}
+
+int main(int argc, char *argv[]) {
+  const char *configDir = NULL;
+  int         opt;
+
+  while ((opt = getopt(argc, argv, "c:t:r:b:")) != -1) {
+    switch (opt) {
+      case 'c': configDir = optarg; break;
+      case 't': numOfTables = atoi(optarg); break;
+      case 'r': rowsPerTable = atoi(optarg); break;
+      case 'b': tablesPerBatch = atoi(optarg); break;
+      default:
+        printf("usage: %s [-c configDir] [-t tables] [-r rowsPerTable] [-b tablesPerBatch]\n", argv[0]);
+        exit(1);
+    }
+  }
+
+  if (numOfTables <= 0 || rowsPerTable <= 0 || rowsPerTable > 32767 || tablesPerBatch <= 0) {
+    printf("invalid options, rowsPerTable shall be in [1, 32767]\n");
+    exit(1);
+  }
+
+  if (configDir != NULL) taos_options(TSDB_OPTION_CONFIGDIR, configDir);
+  taos_init();
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    printf("failed to connect to server, reason:%s\n", taos_errstr(taos));
+    exit(1);
+  }
+
+  prepareDb(taos);
+  printResult("sql", taos, insertBySql(taos));
+
+  prepareDb(taos);
+  printResult("stmt", taos, insertByStmt(taos));
+
+  taos_close(taos);
+  return 0;
+}
@@ -0,0 +1,95 @@
+#!/bin/bash
+
+# Coloured Echoes
+function red_echo      { echo -e "\033[31m$@\033[0m";   }
+function green_echo    { echo -e "\033[32m$@\033[0m";   }
+function yellow_echo   { echo -e "\033[33m$@\033[0m";   }
+function white_echo    { echo -e "\033[1;37m$@\033[0m"; }
+# Coloured Printfs
+function red_printf    { printf "\033[31m$@\033[0m";    }
+function green_printf  { printf "\033[32m$@\033[0m";    }
+function yellow_printf { printf "\033[33m$@\033[0m";    }
+function white_printf  { printf "\033[1;37m$@\033[0m";  }
+# Debugging Outputs
+function white_brackets { local args="$@"; white_printf "["; printf "${args}"; white_printf "]"; }
+function echoInfo   { local args="$@"; white_brackets $(green_printf "INFO") && echo " ${args}"; }
+function echoWarn   { local args="$@";  echo "$(white_brackets "$(yellow_printf "WARN")" && echo " ${args}";)" 1>&2; }
+function echoError  { local args="$@"; echo "$(white_brackets "$(red_printf    "ERROR")" && echo " ${args}";)" 1>&2; }
+
+dataDir=/mnt/var/lib/taos
+
+queries=(
+	"select count(*), sum(f1), max(f2), min(f3) from test.meters;"
+	"select count(*), avg(f1), max(f2) from test.meters interval(1m);"
+	"select count(*), avg(f1), last(f2) from test.meters group by areaid;"
+	"select top(f1, 10) from test.meters where f2 > 5;"
+)
+
+function setParallelQueryThreads {
+	echo "/etc/taos/taos.cfg parallelQueryThreads will be set to $1"
+
+	hasText=`grep "parallelQueryThreads" /etc/taos/taos.cfg`
+	if [[ -z "$hasText" ]]; then
+		echo "parallelQueryThreads $1" >> /etc/taos/taos.cfg
+	else
+		sed -i 's/^parallelQueryThreads.*$/parallelQueryThreads '"$1"'/g' /etc/taos/taos.cfg
+	fi
+}
+
+function stopTaosd {
+	systemctl stop taosd
+	pkill -KILL -x taosd
+	sleep 10
+}
+
+function startTaosd {
+	stopTaosd
+	taosd 2>&1 > /dev/null &
+	sleep 10
+}
+
+function prepareData {
+	stopTaosd
+	rm -rf /mnt/var/log/taos/*
+	rm -rf $dataDir/*
+
+	startTaosd
+	yes | taosdemo -t 1000 -n 10000 2>&1 | tee query-parallel-prepare-$today.log
+}
+
+# Elapsed time of the query in ms, as reported by the shell
+function queryTime {
+	taos -s "$1" 2>&1 | grep "in set" | sed 's/.*(\([0-9.]*\)s).*/\1/' | awk '{printf "%d", $1 * 1000}'
+}
+
+# The average elapsed time of each query, the first run warms up the cache and is not counted
+function runQueries {
+	setParallelQueryThreads $1
+	startTaosd
+
+	for query in "${queries[@]}"; do
+		queryTime "$query" > /dev/null
+
+		total=0
+		for ((i = 0; i < $rounds; i++)); do
+			total=$(( total + `queryTime "$query"` ))
+		done
+
+		echo "${today}, parallelQueryThreads: $1, average: $(( total / rounds )) ms, query: ${query}" | tee -a query-parallel-$today.log
+	done
+}
+
+today=`date +"%Y%m%d"`
+maxThreads=${1:-`nproc`}
+rounds=${2:-5}
+
+cd /root
+echoInfo "Prepare the data"
+prepareData
+for ((threads = 1; threads <= $maxThreads; threads++)); do
+	echoInfo "Query with $threads threads"
+	runQueries $threads
+done
+stopTaosd
+setParallelQueryThreads 0
+echoInfo "End of Parallel Query Test"
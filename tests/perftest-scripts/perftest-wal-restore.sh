@@ -0,0 +1,97 @@
+#!/bin/bash
+
+# Coloured Echoes
+function red_echo      { echo -e "\033[31m$@\033[0m";   }
+function green_echo    { echo -e "\033[32m$@\033[0m";   }
+function yellow_echo   { echo -e "\033[33m$@\033[0m";   }
+function white_echo    { echo -e "\033[1;37m$@\033[0m"; }
+# Coloured Printfs
+function red_printf    { printf "\033[31m$@\033[0m";    }
+function green_printf  { printf "\033[32m$@\033[0m";    }
+function yellow_printf { printf "\033[33m$@\033[0m";    }
+function white_printf  { printf "\033[1;37m$@\033[0m";  }
+# Debugging Outputs
+function white_brackets { local args="$@"; white_printf "["; printf "${args}"; white_printf "]"; }
+function echoInfo   { local args="$@"; white_brackets $(green_printf "INFO") && echo " ${args}"; }
+function echoWarn   { local args="$@";  echo "$(white_brackets "$(yellow_printf "WARN")" && echo " ${args}";)" 1>&2; }
+function echoError  { local args="$@"; echo "$(white_brackets "$(red_printf    "ERROR")" && echo " ${args}";)" 1>&2; }
+
+dataDir=/mnt/var/lib/taos
+snapDir=/mnt/var/lib/taos-wal-snap
+
+function setWalRestoreThreads {
+	echo "/etc/taos/taos.cfg walRestoreThreads will be set to $1"
+
+	hasText=`grep "walRestoreThreads" /etc/taos/taos.cfg`
+	if [[ -z "$hasText" ]]; then
+		echo "walRestoreThreads $1" >> /etc/taos/taos.cfg
+	else
+		sed -i 's/^walRestoreThreads.*$/walRestoreThreads '"$1"'/g' /etc/taos/taos.cfg
+	fi
+}
+
+function stopTaosd {
+	systemctl stop taosd
+	pkill -KILL -x taosd
+	sleep 10
+}
+
+# Insert the rows and kill taosd before they are committed, the data files and the WAL are kept as the snapshot
+function prepareWal {
+	stopTaosd
+	rm -rf /mnt/var/log/taos/*
+	rm -rf $dataDir/*
+
+	taosd 2>&1 > /dev/null &
+	sleep 10
+
+	yes | taosdemo -t 100 -n 30000 2>&1 | tee wal-restore-prepare-$today.log
+	pkill -KILL -x taosd
+	sleep 5
+
+	rm -rf $snapDir
+	cp -a $dataDir $snapDir
+}
+
+function queryCount {
+	taos -s "select count(*), sum(f1) from test.meters;" 2>&1 | grep -A2 "count(\*)" | tail -n1
+}
+
+# Start taosd on a copy of the snapshot, the restore is done once the query result no longer changes
+function runRestore {
+	setWalRestoreThreads $1
+	stopTaosd
+	rm -rf $dataDir
+	cp -a $snapDir $dataDir
+
+	startTime=`date +%s%N`
+	taosd 2>&1 > /dev/null &
+
+	lastResult=""
+	while true; do
+		result=`queryCount`
+		endTime=`date +%s%N`
+		if [[ -n "$result" && "$result" == "$lastResult" ]]; then
+			break
+		fi
+		lastResult=$result
+		sleep 0.5
+	done
+
+	restoreTime=$(( (endTime - startTime) / 1000000 ))
+	echo "${today}, walRestoreThreads: $1, restore: ${restoreTime} ms, result: ${result}" | tee -a wal-restore-$today.log
+}
+
+today=`date +"%Y%m%d"`
+threads=${1:-4}
+
+cd /root
+echoInfo "Prepare the WAL"
+prepareWal
+echoInfo "Restore through the write queue"
+runRestore 0
+echoInfo "Restore with $threads threads"
+runRestore $threads
+stopTaosd
+setWalRestoreThreads 0
+echoInfo "End of WAL Restore Test"
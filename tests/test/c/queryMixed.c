@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Latency of the short queries while long super table queries keep the vnode read workers busy.
+ * The long query threads run until all the short query threads finish, the short query latency
+ * is reported in percentiles, run it with queryTimeSlice set to 0 and then to the default to compare.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+#include "taos.h"
+#include "tulog.h"
+#include "ttime.h"
+#include "tutil.h"
+#include "tglobal.h"
+
+#define GREEN "\033[1;32m"
+#define NC "\033[0m"
+
+typedef struct {
+  int       threadIndex;
+  int       numOfQueries;
+  int       numOfDone;
+  int64_t * latency;  // latency of each query in us
+  pthread_t thread;
+} SInfo;
+
+void  shellParseArgument(int argc, char *argv[]);
+void *longQuery(void *param);
+void *shortQuery(void *param);
+
+char    dbName[32] = "test";
+char    longSql[1024] = "select count(*), avg(f1), max(f2) from meters interval(1m)";
+char    shortSql[1024] = "select last_row(*) from t0";
+int32_t longThreads = 4;
+int32_t shortThreads = 2;
+int32_t shortQueries = 200;
+int32_t stopLongQuery = 0;
+
+int compareLatency(const void *p1, const void *p2) {
+  int64_t l1 = *(int64_t *)p1;
+  int64_t l2 = *(int64_t *)p2;
+  return (l1 < l2) ? -1 : ((l1 > l2) ? 1 : 0);
+}
+
+TAOS *connectDb(int threadIndex) {
+  char     fqdn[TSDB_FQDN_LEN];
+  uint16_t port;
+
+  taosGetFqdnPortFromEp(tsFirst, fqdn, &port);
+
+  TAOS *con = taos_connect(fqdn, tsDefaultUser, tsDefaultPass, dbName, port);
+  if (con == NULL) {
+    pError("thread:%d, failed to connect to DB, reason:%s", threadIndex, taos_errstr(con));
+    exit(1);
+  }
+
+  return con;
+}
+
+// run the query and fetch all its rows, return the number of rows or -1 on error
+int64_t runQuery(TAOS *con, const char *sql, int threadIndex) {
+  TAOS_RES *pSql = taos_query(con, sql);
+  if (taos_errno(pSql) != 0) {
+    pError("thread:%d, failed to run query:%s, reason:%s", threadIndex, sql, taos_errstr(pSql));
+    taos_free_result(pSql);
+    return -1;
+  }
+
+  int64_t rows = 0;
+  while (taos_fetch_row(pSql) != NULL) rows++;
+  taos_free_result(pSql);
+  return rows;
+}
+
+int main(int argc, char *argv[]) {
+  shellParseArgument(argc, argv);
+  taos_init();
+
+  pthread_attr_t thattr;
+  pthread_attr_init(&thattr);
+  pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_JOINABLE);
+
+  SInfo *pLong = calloc(longThreads, sizeof(SInfo));
+  SInfo *pShort = calloc(shortThreads, sizeof(SInfo));
+
+  for (int i = 0; i < longThreads; ++i) {
+    pLong[i].threadIndex = i;
+    pthread_create(&pLong[i].thread, &thattr, longQuery, pLong + i);
+  }
+
+  // let the long queries occupy the read workers first
+  taosMsleep(1000);
+
+  int64_t st = taosGetTimestampUs();
+  for (int i = 0; i < shortThreads; ++i) {
+    pShort[i].threadIndex = longThreads + i;
+    pShort[i].numOfQueries = shortQueries;
+    pShort[i].latency = calloc(shortQueries, sizeof(int64_t));
+    pthread_create(&pShort[i].thread, &thattr, shortQuery, pShort + i);
+  }
+
+  for (int i = 0; i < shortThreads; ++i) {
+    pthread_join(pShort[i].thread, NULL);
+  }
+  int64_t usedTime = taosGetTimestampUs() - st;
+
+  atomic_store_32(&stopLongQuery, 1);
+  for (int i = 0; i < longThreads; ++i) {
+    pthread_join(pLong[i].thread, NULL);
+  }
+
+  int64_t total = 0;
+  int64_t longDone = 0;
+  int64_t *latency = malloc(sizeof(int64_t) * ((int64_t)shortThreads * shortQueries + 1));
+  for (int i = 0; i < shortThreads; ++i) {
+    memcpy(latency + total, pShort[i].latency, pShort[i].numOfDone * sizeof(int64_t));
+    total += pShort[i].numOfDone;
+  }
+  for (int i = 0; i < longThreads; ++i) {
+    longDone += pLong[i].numOfDone;
+  }
+
+  if (total > 0) {
+    qsort(latency, total, sizeof(int64_t), compareLatency);
+    pPrint("%slong threads:%d long queries:%" PRId64 " short threads:%d short queries:%" PRId64 " in %.1f seconds%s",
+           GREEN, longThreads, longDone, shortThreads, total, usedTime / 1000000.0, NC);
+    pPrint("%sshort query latency(ms): p50:%.2f p90:%.2f p99:%.2f max:%.2f%s", GREEN, latency[total / 2] / 1000.0,
+           latency[total * 90 / 100] / 1000.0, latency[total * 99 / 100] / 1000.0, latency[total - 1] / 1000.0, NC);
+  } else {
+    pError("no short query is finished");
+  }
+
+  for (int i = 0; i < shortThreads; ++i) {
+    free(pShort[i].latency);
+  }
+  free(latency);
+  free(pShort);
+  free(pLong);
+  pthread_attr_destroy(&thattr);
+
+  return 0;
+}
+
+void *longQuery(void *param) {
+  SInfo *pInfo = (SInfo *)param;
+  TAOS * con = connectDb(pInfo->threadIndex);
+
+  while (!atomic_load_32(&stopLongQuery)) {
+    if (runQuery(con, longSql, pInfo->threadIndex) < 0) break;
+    pInfo->numOfDone++;
+  }
+
+  taos_close(con);
+  return NULL;
+}
+
+void *shortQuery(void *param) {
+  SInfo *pInfo = (SInfo *)param;
+  TAOS * con = connectDb(pInfo->threadIndex);
+
+  for (int i = 0; i < pInfo->numOfQueries; ++i) {
+    int64_t st = taosGetTimestampUs();
+    if (runQuery(con, shortSql, pInfo->threadIndex) < 0) break;
+    pInfo->latency[pInfo->numOfDone++] = taosGetTimestampUs() - st;
+  }
+
+  taos_close(con);
+  return NULL;
+}
+
+void printHelp() {
+  char indent[10] = "        ";
+  printf("Used to test the latency of the short queries while the long queries are running\n");
+
+  printf("%s%s\n", indent, "-c");
+  printf("%s%s%s%s\n", indent, indent, "Configuration directory, default is ", configDir);
+  printf("%s%s\n", indent, "-d");
+  printf("%s%s%s%s\n", indent, indent, "The name of the database, default is ", dbName);
+  printf("%s%s\n", indent, "-l");
+  printf("%s%s%s%s\n", indent, indent, "The long query, default is ", longSql);
+  printf("%s%s\n", indent, "-s");
+  printf("%s%s%s%s\n", indent, indent, "The short query, default is ", shortSql);
+  printf("%s%s\n", indent, "-L");
+  printf("%s%s%s%d\n", indent, indent, "Number of threads running the long query, default is ", longThreads);
+  printf("%s%s\n", indent, "-S");
+  printf("%s%s%s%d\n", indent, indent, "Number of threads running the short query, default is ", shortThreads);
+  printf("%s%s\n", indent, "-n");
+  printf("%s%s%s%d\n", indent, indent, "Number of short queries per thread, default is ", shortQueries);
+
+  exit(EXIT_SUCCESS);
+}
+
+void shellParseArgument(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      printHelp();
+      exit(0);
+    } else if (strcmp(argv[i], "-c") == 0) {
+      strcpy(configDir, argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0) {
+      strcpy(dbName, argv[++i]);
+    } else if (strcmp(argv[i], "-l") == 0) {
+      tstrncpy(longSql, argv[++i], sizeof(longSql));
+    } else if (strcmp(argv[i], "-s") == 0) {
+      tstrncpy(shortSql, argv[++i], sizeof(shortSql));
+    } else if (strcmp(argv[i], "-L") == 0) {
+      longThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-S") == 0) {
+      shortThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0) {
+      shortQueries = atoi(argv[++i]);
+    } else {
+    }
+  }
+
+  pPrint("%slong query:%s%s", GREEN, longSql, NC);
+  pPrint("%sshort query:%s%s", GREEN, shortSql, NC);
+  pPrint("%slongThreads:%d shortThreads:%d shortQueries:%d%s", GREEN, longThreads, shortThreads, shortQueries, NC);
+  pPrint("%sstart to run%s", GREEN, NC);
+}